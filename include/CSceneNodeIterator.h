@@ -0,0 +1,92 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_SCENE_NODE_ITERATOR_H_INCLUDED__
+#define __C_SCENE_NODE_ITERATOR_H_INCLUDED__
+
+#include "ISceneNode.h"
+#include "irrArray.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! Iterates over a scene node and all its descendants without recursion.
+	/** The nodes are returned depth first, in the same order as a recursive
+	traversal of the children would visit them, starting with the root. The
+	pending nodes are kept on an explicit stack which keeps its memory when
+	the iterator is reset, so a traversal per frame does not allocate.
+	The children of a node are read when the node after it is requested, so
+	the subtree must not be changed during the traversal.
+	\code
+	scene::CSceneNodeIterator it(smgr->getRootSceneNode());
+	while (scene::ISceneNode* node = it.next())
+	{
+		if (!node->isVisible())
+			it.skipChildren();
+	}
+	\endcode */
+	class CSceneNodeIterator
+	{
+	public:
+
+		//! Constructor
+		/** \param root First node of the traversal, may be 0. */
+		CSceneNodeIterator(ISceneNode* root=0)
+			: Current(0)
+		{
+			reset(root);
+		}
+
+		//! Starts a new traversal
+		/** \param root First node of the traversal, may be 0. */
+		void reset(ISceneNode* root)
+		{
+			Stack.set_used(0);
+			Current = 0;
+
+			if (root)
+				Stack.push_back(root);
+		}
+
+		//! Returns the next node of the traversal
+		/** \return The next node, or 0 if all nodes were visited. */
+		ISceneNode* next()
+		{
+			// push the children in reverse order to pop them in order
+			if (Current)
+			{
+				for (u32 i=Current->getChildCount(); i>0; --i)
+					Stack.push_back(Current->getChild(i-1));
+			}
+
+			if (Stack.empty())
+			{
+				Current = 0;
+				return 0;
+			}
+
+			Current = Stack.getLast();
+			Stack.set_used(Stack.size()-1);
+			return Current;
+		}
+
+		//! Leaves out the descendants of the node returned by the last next() call
+		void skipChildren()
+		{
+			Current = 0;
+		}
+
+	private:
+
+		core::array<ISceneNode*> Stack;
+		ISceneNode* Current;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
@@ -51,7 +51,10 @@ namespace scene
 		EAMT_MDL_HALFLIFE,
 
 		//! generic skinned mesh
-		EAMT_SKINNED
+		EAMT_SKINNED,
+
+		//! chain of meshes with decreasing level of detail, see SLODMesh
+		EAMT_LOD
 	};
 
 	//! Interface for an animated mesh.
@@ -34,7 +34,12 @@ class IFileSystem : public virtual IReferenceCounted
 public:
 
 	//! Opens a file for read access.
-	/** \param filename: Name of file to open.
+	/** Other threads than the one which created the file system may open
+	files as well. The entries of an archive share its file, each read of
+	an entry locks that file for the seek and the read. Archives from
+	user archive loaders have to allow concurrent opens to be used from
+	several threads.
+	\param filename: Name of file to open.
 	\return Pointer to the created file interface.
 	The returned pointer should be dropped when no longer needed.
 	See IReferenceCounted::drop() for more information. */
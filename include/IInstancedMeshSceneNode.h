@@ -0,0 +1,84 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __I_INSTANCED_MESH_SCENE_NODE_H_INCLUDED__
+#define __I_INSTANCED_MESH_SCENE_NODE_H_INCLUDED__
+
+#include "ISceneNode.h"
+
+namespace irr
+{
+namespace scene
+{
+
+class IMesh;
+
+
+//! A scene node drawing many copies of one static mesh
+/** Each instance has its own transformation relative to the node and a
+color which is multiplied with the vertex colors. The instances are culled
+one by one with the automatic culling type of the node and all visible
+instances of a mesh buffer are drawn with a single call to
+video::IVideoDriver::drawMeshBufferInstanced(). The node is a lot cheaper
+than one mesh scene node per instance, but the instances can't have
+children, animators or materials of their own. */
+class IInstancedMeshSceneNode : public ISceneNode
+{
+public:
+
+	//! Constructor
+	IInstancedMeshSceneNode(ISceneNode* parent, ISceneManager* mgr, s32 id,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1,1,1))
+		: ISceneNode(parent, mgr, id, position, rotation, scale) {}
+
+	//! Sets a new mesh to display
+	/** \param mesh Mesh to draw for each instance. */
+	virtual void setMesh(IMesh* mesh) = 0;
+
+	//! Get the currently defined mesh for display.
+	/** \return Pointer to mesh which is drawn for each instance. */
+	virtual IMesh* getMesh(void) = 0;
+
+	//! Adds an instance
+	/** \param transform Transformation of the instance relative to the node.
+	\param color Color which is multiplied with the vertex colors.
+	\return Index of the new instance. */
+	virtual u32 addInstance(const core::matrix4& transform,
+		video::SColor color = video::SColor(255,255,255,255)) = 0;
+
+	//! Removes an instance
+	/** The last instance is moved to the index of the removed one.
+	\param index Index of the instance to remove. */
+	virtual void removeInstance(u32 index) = 0;
+
+	//! Removes all instances
+	virtual void removeAllInstances() = 0;
+
+	//! Get the number of instances
+	virtual u32 getInstanceCount() const = 0;
+
+	//! Sets the transformation of an instance, relative to the node
+	virtual void setInstanceTransform(u32 index, const core::matrix4& transform) = 0;
+
+	//! Get the transformation of an instance, relative to the node
+	virtual const core::matrix4& getInstanceTransform(u32 index) const = 0;
+
+	//! Sets the color of an instance
+	virtual void setInstanceColor(u32 index, video::SColor color) = 0;
+
+	//! Get the color of an instance
+	virtual video::SColor getInstanceColor(u32 index) const = 0;
+
+	//! Get the number of instances which passed the culling in the last drawn frame
+	virtual u32 getVisibleInstanceCount() const = 0;
+};
+
+} // end namespace scene
+} // end namespace irr
+
+
+#endif
+
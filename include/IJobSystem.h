@@ -0,0 +1,83 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __I_JOB_SYSTEM_H_INCLUDED__
+#define __I_JOB_SYSTEM_H_INCLUDED__
+
+#include "IReferenceCounted.h"
+#include "irrTypes.h"
+
+namespace irr
+{
+
+	//! Schedules small jobs on a pool of worker threads.
+	/** Each worker has its own queue of ready jobs. Jobs added by a
+	worker go into its own queue and are taken from there last in first
+	out, idle workers steal the oldest jobs of the other queues. Jobs added
+	by other threads, like the main thread, are queued for all workers.
+	Threads which wait for a job run other ready jobs in the meantime.
+
+	A job system without worker threads runs every job inline, as soon as
+	its dependencies are finished. The engine uses the job system of the
+	device for its own parallel loops, so jobs should be short and must not
+	block on anything but other jobs. The reference counting of engine
+	objects is not thread safe, so jobs must not grab or drop them. */
+	class IJobSystem : public virtual IReferenceCounted
+	{
+	public:
+
+		//! Identifies a job returned by addJob.
+		/** 0 is never used for a job. Handles of finished jobs are
+		recycled eventually, but only after thousands of other jobs. */
+		typedef u32 JobHandle;
+
+		//! Function run by a job.
+		typedef void (*JobFunction)(void* userData);
+
+		//! Function called for each index of parallelFor.
+		/** \param userData Pointer passed to parallelFor.
+		\param index Index of the work item, in the range [0,count).
+		\param workerIndex Index of the executing thread, in the range
+		[0,getWorkerCount()). Can be used to address per thread data as
+		long as the function does not wait for other jobs itself. */
+		typedef void (*ParallelForFunction)(void* userData, u32 index, u32 workerIndex);
+
+		//! Returns the number of workers, including index 0 for all other threads.
+		/** This is the number of worker threads plus one. */
+		virtual u32 getWorkerCount() const = 0;
+
+		//! Returns the worker index of the calling thread.
+		/** \return Index in the range [1,getWorkerCount()) for the worker
+		threads, 0 for all other threads. */
+		virtual u32 getCurrentWorkerIndex() const = 0;
+
+		//! Adds a job which runs after some other jobs finished.
+		/** \param func Function to run.
+		\param userData Pointer passed to func.
+		\param dependencies Array of jobs which have to be finished before
+		this job starts. Jobs which are already finished are ignored.
+		\param dependencyCount Number of entries in dependencies.
+		\return Handle of the new job, to wait for it or to use it as
+		dependency of other jobs. */
+		virtual JobHandle addJob(JobFunction func, void* userData,
+			const JobHandle* dependencies=0, u32 dependencyCount=0) = 0;
+
+		//! Returns true if the job has finished.
+		virtual bool isJobDone(JobHandle job) const = 0;
+
+		//! Blocks until a job has finished.
+		/** The calling thread runs other ready jobs while waiting. */
+		virtual void waitForJob(JobHandle job) = 0;
+
+		//! Calls func for each index in [0,count) and blocks until all calls returned.
+		/** Indices are handed out dynamically, so the order and the
+		distribution among the threads is undefined. The calling thread
+		takes part in the work. Can be called from jobs as well. */
+		virtual void parallelFor(u32 count, ParallelForFunction func, void* userData) = 0;
+	};
+
+} // end namespace irr
+
+#endif
+
@@ -0,0 +1,39 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __I_MESH_LOAD_CALLBACK_H_INCLUDED__
+#define __I_MESH_LOAD_CALLBACK_H_INCLUDED__
+
+#include "IReferenceCounted.h"
+#include "path.h"
+
+namespace irr
+{
+namespace scene
+{
+	class IAnimatedMesh;
+
+//! Interface receiving meshes which were loaded in the background.
+/** Implement this interface in an own class and pass it to
+ISceneManager::getMeshAsync(). The scene manager grabs the callback until
+the mesh was delivered. */
+class IMeshLoadCallBack : public virtual IReferenceCounted
+{
+public:
+
+	//! Called when a mesh requested with ISceneManager::getMeshAsync() is available.
+	/** This is always called on the thread which draws the scene, from
+	within ISceneManager::drawAll(), so the mesh can be used right away.
+	\param filename Name of the mesh file as passed to getMeshAsync().
+	\param mesh The loaded mesh, or 0 if it could not be loaded. The mesh is
+	in the mesh cache already, so it should not be dropped. */
+	virtual void OnMeshLoaded(const io::path& filename, IAnimatedMesh* mesh) = 0;
+};
+
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
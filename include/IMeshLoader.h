@@ -43,6 +43,13 @@ public:
 	If you no longer need the mesh, you should call IAnimatedMesh::drop().
 	See IReferenceCounted::drop() for more information. */
 	virtual IAnimatedMesh* createMesh(io::IReadFile* file) = 0;
+
+	//! Returns true if the loader may parse files on the worker thread of ISceneManager::getMeshAsync().
+	/** Loaders which add scene nodes or put meshes into the mesh cache
+	while they parse have to return false. Files they might load are
+	then loaded on the thread calling getMeshAsync().
+	eturn True by default. */
+	virtual bool isLoadableOnWorkerThread() const { return true; }
 };
 
 
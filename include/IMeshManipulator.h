@@ -264,6 +264,26 @@ namespace scene
 		IReferenceCounted::drop() for more information. */
 		virtual IMesh* createMeshWelded(IMesh* mesh, f32 tolerance=core::ROUNDING_ERROR_f32) const = 0;
 
+		//! Creates a copy of a mesh with fewer triangles
+		/** Edges are collapsed in the order of their quadric error, the
+		sum of squared distances to the planes of the removed triangles.
+		A collapse removes a vertex and keeps the others unchanged, so
+		normals, texture coordinates and all other vertex attributes stay
+		valid. Each mesh buffer is simplified on its own and keeps its
+		border, so material boundaries don't open. Vertices on texture
+		and normal seams only collapse along the seam. This can be used
+		to create the levels of a SLODMesh at load time.
+		\param mesh Input mesh, all vertex types and 32 bit indices are supported.
+		\param targetRatio Fraction of the triangles to keep, between 0 and 1.
+		\param maxError Largest allowed distance between the original and the
+		simplified surface, in the units of the mesh. The simplification stops
+		before the ratio is reached if the next collapse would exceed it. 0
+		for no limit.
+		\return Simplified mesh with the same number of mesh buffers. If you
+		no longer need it, you should call IMesh::drop(). See
+		IReferenceCounted::drop() for more information. */
+		virtual IMesh* createSimplifiedMesh(IMesh* mesh, f32 targetRatio, f32 maxError=0.f) const = 0;
+
 		//! Get amount of polygons in mesh.
 		/** \param mesh Input mesh
 		\return Number of polygons in mesh. */
@@ -28,7 +28,7 @@ public:
 			const core::vector3df& position = core::vector3df(0,0,0),
 			const core::vector3df& rotation = core::vector3df(0,0,0),
 			const core::vector3df& scale = core::vector3df(1,1,1))
-		: ISceneNode(parent, mgr, id, position, rotation, scale) {}
+		: ISceneNode(parent, mgr, id, position, rotation, scale), MeshVisible(true) {}
 
 	//! Sets a new mesh to display
 	/** \param mesh Mesh to display. */
@@ -69,6 +69,22 @@ public:
 	/** This flag can be set by setReadOnlyMaterials().
 	\return Whether the materials are read-only. */
 	virtual bool isReadOnlyMaterials() const = 0;
+
+	//! Sets if the node draws its mesh
+	/** Unlike setVisible() this does not hide the children of the node.
+	ISceneManager::addStaticBatchSceneNode() switches it off for merged
+	nodes whose children were not merged.
+	\param visible False to render only the children of the node. */
+	void setMeshVisible(bool visible) { MeshVisible = visible; }
+
+	//! Check if the node draws its mesh
+	/** \return False if only the children are rendered. */
+	bool isMeshVisible() const { return MeshVisible; }
+
+protected:
+
+	//! if the node draws its mesh
+	bool MeshVisible;
 };
 
 } // end namespace scene
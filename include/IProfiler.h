@@ -0,0 +1,130 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __I_PROFILER_H_INCLUDED__
+#define __I_PROFILER_H_INCLUDED__
+
+#include "IReferenceCounted.h"
+#include "irrArray.h"
+
+namespace irr
+{
+namespace io
+{
+	class IWriteFile;
+} // end namespace io
+
+	//! A timed section of code recorded by the profiler
+	struct SProfileEvent
+	{
+		//! Name of the section, always points to static text
+		const c8* Name;
+
+		//! Start in microseconds since the profiler was created
+		u64 Start;
+
+		//! Duration in microseconds
+		u32 Duration;
+
+		//! Index of the recording thread, in the order the threads recorded their first event
+		u32 Thread;
+
+		//! sorts by start time, enclosing sections first
+		bool operator<(const SProfileEvent& other) const
+		{
+			return Start < other.Start || (Start == other.Start && Duration > other.Duration);
+		}
+	};
+
+	//! Records timed sections of the engine and the application
+	/** The engine times the passes of ISceneManager::drawAll(), the draw
+	calls of the drivers, the culling, the skinning of animated meshes and
+	the loading of meshes and textures. Every thread records into its own
+	ring buffer, which keeps the most recent events, so recording costs
+	no locks. Nested sections are nested in time, trace viewers show them
+	as a hierarchy.
+	Recording is disabled by default. When the engine is compiled without
+	_IRR_COMPILE_WITH_PROFILING_ there are no timers in the engine at all
+	and IrrlichtDevice::getProfiler() returns 0. */
+	class IProfiler : public virtual IReferenceCounted
+	{
+	public:
+
+		//! Enables or disables the recording of events
+		virtual void setEnabled(bool enable) = 0;
+
+		//! Returns if events are recorded
+		virtual bool isEnabled() const = 0;
+
+		//! Returns the current time in microseconds since the profiler was created
+		virtual u64 getTime() const = 0;
+
+		//! Records a timed section of the calling thread
+		/** Usually done by CProfileScope.
+		\param name Name of the section, must be static text like a
+		string literal, only the pointer is stored.
+		\param start Start of the section as returned by getTime().
+		\param end End of the section as returned by getTime(). */
+		virtual void addEvent(const c8* name, u64 start, u64 end) = 0;
+
+		//! Returns the events of all threads which are still in the ring buffers
+		/** Should not be called while other threads are recording.
+		\param outEvents Receives the events, sorted by start time. */
+		virtual void getEvents(core::array<SProfileEvent>& outEvents) const = 0;
+
+		//! Removes all recorded events
+		virtual void clear() = 0;
+
+		//! Writes the recorded events as JSON in the Chrome trace event format
+		/** The file can be opened with chrome://tracing and similar
+		tools. Should not be called while other threads are recording.
+		\param file File to write to.
+		\return True if successful. */
+		virtual bool writeChromeTrace(io::IWriteFile* file) const = 0;
+	};
+
+
+	//! Times the scope it lives in and adds it to a profiler
+	/** \code
+	{
+		CProfileScope scope(device->getProfiler(), "update physics");
+		updatePhysics();
+	}
+	\endcode */
+	class CProfileScope
+	{
+	public:
+
+		//! Starts the timer if the profiler is enabled
+		/** \param profiler Profiler to add the event to, may be 0.
+		\param name Name of the section, must be static text. */
+		CProfileScope(IProfiler* profiler, const c8* name)
+			: Profiler((profiler && profiler->isEnabled()) ? profiler : 0), Name(name), Start(0)
+		{
+			if (Profiler)
+				Start = Profiler->getTime();
+		}
+
+		//! Stops the timer and adds the event
+		~CProfileScope()
+		{
+			if (Profiler)
+				Profiler->addEvent(Name, Start, Profiler->getTime());
+		}
+
+	private:
+
+		// not copyable
+		CProfileScope(const CProfileScope&);
+		CProfileScope& operator=(const CProfileScope&);
+
+		IProfiler* Profiler;
+		const c8* Name;
+		u64 Start;
+	};
+
+} // end namespace irr
+
+#endif
+
@@ -42,6 +42,15 @@ namespace io
 		//! Get name of file.
 		/** \return File name as zero terminated character string. */
 		virtual const io::path& getFileName() const = 0;
+
+		//! Get the whole content of the file, if it is available in memory.
+		/** Files in memory and files mapped into memory by the operating
+		system can be parsed in place instead of copying them with read().
+		The data must not be changed and stays valid until the file is
+		dropped. The position in the file is neither used nor changed.
+		\return Pointer to getSize() bytes, or 0 if the file can only be
+		accessed with read(). */
+		virtual const void* getMappedData() const { return 0; }
 	};
 
 	//! Internal function, please do not use.
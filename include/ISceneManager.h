@@ -10,6 +10,8 @@
 #include "irrString.h"
 #include "path.h"
 #include "vector3d.h"
+#include "aabbox3d.h"
+#include "line3d.h"
 #include "dimension2d.h"
 #include "SColor.h"
 #include "ETerrainElements.h"
@@ -99,6 +101,7 @@ namespace scene
 	class IBillboardSceneNode;
 	class IBillboardTextSceneNode;
 	class ICameraSceneNode;
+	struct SViewFrustum;
 	class IDummyTransformationSceneNode;
 	class ILightManager;
 	class ILightSceneNode;
@@ -106,8 +109,10 @@ namespace scene
 	class IMeshBuffer;
 	class IMeshCache;
 	class IMeshLoader;
+	class IMeshLoadCallBack;
 	class IMeshManipulator;
 	class IMeshSceneNode;
+	class IInstancedMeshSceneNode;
 	class IMeshWriter;
 	class IMetaTriangleSelector;
 	class IParticleSystemSceneNode;
@@ -407,6 +412,44 @@ namespace scene
 		IReferenceCounted::drop() for more information. */
 		virtual IAnimatedMesh* getMesh(io::IReadFile* file) = 0;
 
+		//! Loads a mesh in the background.
+		/** The file is opened and read into memory right away, the mesh
+		loader parses it on a worker thread. The finished mesh is added to
+		the mesh cache and handed to the callback during the next drawAll().
+		Meshes which are in the cache already are delivered in the next
+		drawAll() as well. Requests for a file which is still loading are
+		merged with the pending load, so the file is parsed only once and
+		all callbacks receive the same mesh.
+
+		The mesh loaders are used by one thread at a time, getMesh() waits
+		while the worker parses a file. Textures which a loader requests or
+		turns into normal maps are created on the thread which owns the
+		video driver, in its next IVideoDriver::beginScene(), so the
+		application has to keep rendering while meshes load. The loader
+		starts with the texture creation flags the driver had when the mesh
+		was requested, changes of them only apply to its own textures.
+		Further files like materials are opened through the file system,
+		which serializes the reads of each archive. Log messages
+		of the loader are passed on in the next drawAll() or beginScene().
+
+		The COLLADA loader adds meshes to the mesh cache and nodes to the
+		scene while it parses, so its files are loaded right away on the
+		calling thread, like with getMesh(), and only delivered in the next
+		drawAll(). The same happens for loaders added with
+		addExternalMeshLoader() which return false from
+		IMeshLoader::isLoadableOnWorkerThread(). Other loaders have to
+		restrict themselves to the calls above: textures and texture
+		creation flags of the video driver, the file system, the parameters
+		of the scene manager and logging.
+		\param filename Name of the mesh file. It is also the name of the
+		mesh in the cache.
+		\param callback Receives the mesh. Can be 0 to only fill the mesh
+		cache. */
+		virtual void getMeshAsync(const io::path& filename, IMeshLoadCallBack* callback) = 0;
+
+		//! Returns the number of background mesh loads which were not delivered yet.
+		virtual u32 getPendingMeshLoadCount() const = 0;
+
 		//! Get interface to the mesh cache which is shared beween all existing scene managers.
 		/** With this interface, it is possible to manually add new loaded
 		meshes (if ISceneManager::getMesh() is not sufficient), to remove them and to iterate
@@ -522,6 +565,75 @@ namespace scene
 			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f),
 			bool alsoAddIfMeshPointerZero=false) = 0;
 
+		//! Adds a scene node for drawing many instances of a static mesh.
+		/** Add the instances with IInstancedMeshSceneNode::addInstance().
+		\param mesh: Pointer to the loaded static mesh drawn for each instance.
+		\param parent: Parent of the scene node. Can be NULL if no parent.
+		\param id: Id of the node. This id can be used to identify the scene node.
+		\param position: Position of the space relative to its parent where the
+		scene node will be placed.
+		\param rotation: Initital rotation of the scene node.
+		\param scale: Initial scale of the scene node.
+		\param alsoAddIfMeshPointerZero: Add the scene node even if a 0 pointer is passed.
+		\return Pointer to the created scene node.
+		This pointer should not be dropped. See IReferenceCounted::drop() for more information. */
+		virtual IInstancedMeshSceneNode* addInstancedMeshSceneNode(IMesh* mesh, ISceneNode* parent=0, s32 id=-1,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f),
+			bool alsoAddIfMeshPointerZero=false) = 0;
+
+		//! Adds a scene node showing one level of a LOD chain.
+		/** Each frame the node selects a level of the chain by its size on
+		the screen or its distance to the active camera, see SLODMesh. The
+		chain can be added to the mesh cache with IMeshCache::addMesh(), so
+		all nodes which get it from there by name share its levels, also
+		when a scene is loaded from a file. getMesh() of the node returns
+		the shown level.
+		\param mesh: LOD chain, an SLODMesh. Other meshes are shown
+		without switching levels.
+		\param parent: Parent of the scene node. Can be NULL if no parent.
+		\param id: Id of the node. This id can be used to identify the scene node.
+		\param position: Position of the space relative to its parent where the
+		scene node will be placed.
+		\param rotation: Initital rotation of the scene node.
+		\param scale: Initial scale of the scene node.
+		\param alsoAddIfMeshPointerZero: Add the scene node even if a 0 pointer is passed.
+		\return Pointer to the created scene node.
+		This pointer should not be dropped. See IReferenceCounted::drop() for more information. */
+		virtual IMeshSceneNode* addLODMeshSceneNode(IAnimatedMesh* mesh, ISceneNode* parent=0, s32 id=-1,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f),
+			bool alsoAddIfMeshPointerZero=false) = 0;
+
+		//! Merges the static mesh scene nodes of a subtree into a single scene node.
+		/** The absolute transformations of the mesh, cube and sphere scene
+		nodes below root are baked into the vertices. Mesh buffers with equal
+		materials and vertex types are merged into chunks, which are split
+		along the longest axis of their geometry until each has at most
+		maxChunkVertices vertices. Each chunk keeps its own bounding box and
+		is culled on its own, so thousands of small nodes are drawn with a
+		few draw calls. Nodes which are invisible, or which have mesh buffers
+		with 32 bit indices or more vertices than a chunk, are not merged.
+		Later changes of the merged nodes are not reflected by the batch.
+		\param root: Root of the subtree to merge, it is merged as well.
+		\param parent: Parent of the new scene node. As the vertices are
+		in world space it should have no transformation. If 0, the root
+		scene node is used.
+		\param id: Id of the node. This id can be used to identify the scene node.
+		\param maxChunkVertices: Maximal number of vertices in a mesh buffer
+		of the batch, at most 65535.
+		\param hideMergedNodes: If true, the merged nodes no longer draw
+		their meshes. Merged nodes whose children were all merged as well
+		are made invisible, the others stay visible for their children and
+		only their mesh is switched off with IMeshSceneNode::setMeshVisible().
+		\return Pointer to the created scene node, or 0 if nothing could be
+		merged. The mesh is not added to the mesh cache.
+		This pointer should not be dropped. See IReferenceCounted::drop() for more information. */
+		virtual IMeshSceneNode* addStaticBatchSceneNode(ISceneNode* root, ISceneNode* parent=0,
+			s32 id=-1, u32 maxChunkVertices=16384, bool hideMergedNodes=true) = 0;
+
 		//! Adds a scene node for rendering a animated water surface mesh.
 		/** Looks really good when the Material type EMT_TRANSPARENT_REFLECTION
 		is used.
@@ -1144,10 +1256,61 @@ namespace scene
 		\param pass: Specifies when the node wants to be drawn in relation to the other nodes.
 		For example, if the node is a shadow, it usually wants to be drawn after all other nodes
 		and will use ESNRP_SHADOW for this. See scene::E_SCENE_NODE_RENDER_PASS for details.
-		\return scene will be rendered ( passed culling ) */
+		During drawAll() the frustum culling of all registered nodes is done
+		in one batch after the registration, nodes using EAC_OCC_QUERY are
+		still culled immediately.
+		\return scene will be rendered ( passed culling ). For nodes culled
+		in the batch it only tells that the node was accepted for culling. */
 		virtual u32 registerNodeForRendering(ISceneNode* node,
 			E_SCENE_NODE_RENDER_PASS pass = ESNRP_AUTOMATIC) = 0;
 
+		//! Enables or disables the mesh buffer render queue.
+		/** When enabled, scene nodes which support it don't draw their solid
+		mesh buffers in their own render() call but submit them with
+		registerMeshBufferForRendering() instead. The scene manager culls
+		each mesh buffer by its own bounding box and draws the mesh buffers
+		of all nodes sorted by material, so the render states only change
+		where the materials differ, even across nodes. Nodes with shadows or
+		visible debug data still render themselves. Disabled by default.
+		\param enable True to enable the queue. */
+		virtual void setMeshBufferQueueEnabled(bool enable) = 0;
+
+		//! Returns if the mesh buffer render queue is enabled.
+		virtual bool isMeshBufferQueueEnabled() const = 0;
+
+		//! Registers a solid mesh buffer of a node for rendering.
+		/** This method should only be used by scene nodes in their
+		ISceneNode::OnRegisterSceneNode() call when
+		isMeshBufferQueueEnabled() returns true. The mesh buffer is drawn in
+		the ESNRP_SOLID pass with the absolute transformation of the node,
+		node->render() is not called for it. It is culled with the automatic
+		culling of the node, using the bounding box of the mesh buffer.
+		\param node Node the mesh buffer belongs to.
+		\param mb Mesh buffer in object space of the node.
+		\param material Material to draw the mesh buffer with. The mesh
+		buffer and the material must stay valid until drawAll() finished.
+		\return False if the mesh buffer was culled immediately, else true. */
+		virtual bool registerMeshBufferForRendering(ISceneNode* node,
+			const IMeshBuffer* mb, const video::SMaterial& material) = 0;
+
+		//! Sets the number of threads which update the absolute transformations.
+		/** When more than one thread is used, drawAll() updates the absolute
+		transformations of all visible nodes before the animators run,
+		splitting the scene graph into independent subtrees which are
+		processed in parallel. Nodes whose transformation did not change
+		are skipped in any case. Only ISceneNode::updateAbsolutePosition()
+		itself runs in the worker threads, overrides of it are still called
+		from the main thread while animating.
+		\param count Number of threads including the calling thread. 0
+		uses the job system of the device, which is the default, see
+		SIrrlichtCreationParameters::JobThreads. 1 updates the nodes
+		while animating them, without any threads. Larger values start a
+		separate set of threads for the scene manager. */
+		virtual void setTransformThreadCount(u32 count) = 0;
+
+		//! Returns the number of threads which update the absolute transformations.
+		virtual u32 getTransformThreadCount() const = 0;
+
 		//! Draws all the scene nodes.
 		/** This can only be invoked between
 		IVideoDriver::beginScene() and IVideoDriver::endScene(). Please note that
@@ -1638,6 +1801,24 @@ namespace scene
 			current callbacks manager and restore the default behavior. */
 		virtual void setLightManager(ILightManager* lightManager) = 0;
 
+		//! Creates a light manager which only enables the lights reaching each node.
+		/** Without a light manager drawAll enables the lights nearest to
+		the camera for the whole scene, up to the amount the driver
+		supports. This light manager bins the point and spot lights into
+		a grid of clusters along the view frustum every frame. Before a
+		node is rendered it enables the lights whose radius intersects the
+		bounding box of the node, the nearest ones first if there are more
+		than the driver supports. Directional lights stay enabled. Set it
+		with setLightManager().
+		\param tilesX Number of cluster columns on the screen.
+		\param tilesY Number of cluster rows on the screen.
+		\param slices Number of depth slices between the near and far
+		plane of the camera, thinner close to the camera.
+		\return The light manager. This pointer should be dropped,
+		when no longer needed. See IReferenceCounted::drop() for more
+		information. */
+		virtual ILightManager* createClusteredLightManager(u32 tilesX=16, u32 tilesY=9, u32 slices=24) = 0;
+
 		//! Get an instance of a geometry creator.
 		/** The geometry creator provides some helper methods to create various types of
 		basic geometry. This can be useful for custom scene nodes. */
@@ -1653,6 +1834,83 @@ namespace scene
 		\return True if node is not visible in the current scene, else
 		false. */
 		virtual bool isCulled(const ISceneNode* node) const =0;
+
+		//! Adds a scene node to the spatial index of the scene manager.
+		/** The spatial index is a bounding volume hierarchy over the world
+		space bounding boxes of its nodes. Nodes in the index are skipped by
+		the OnRegisterSceneNode() traversal of their parents. Instead drawAll()
+		queries the index with the view frustum of the active camera and
+		registers only the nodes which may be visible, together with their
+		children which are not indexed. The bounding box picking of the
+		collision manager queries the index in the same way. So large scenes
+		of mostly static nodes, of which only a few are visible at once, are
+		culled and picked in logarithmic instead of linear time.
+		The index is updated in drawAll() for nodes whose absolute
+		transformation changed. Nodes which change their bounding box
+		without moving have to be removed and added again. Indexed nodes
+		are always culled by their bounding box, so only nodes with a
+		meaningful bounding box should be added. Indexed nodes removed from
+		the scene are removed from the index in the next drawAll(), unless
+		they were added to the scene again, like by setParent().
+		\param node Scene node to add. It must be part of the scene graph of
+		this scene manager. */
+		virtual void addToSpatialIndex(ISceneNode* node) = 0;
+
+		//! Removes a scene node from the spatial index.
+		/** \param node Scene node to remove. */
+		virtual void removeFromSpatialIndex(ISceneNode* node) = 0;
+
+		//! Get the scene nodes of the spatial index which may be inside a view frustum.
+		/** The test uses the enlarged boxes of the index, so nodes close
+		to the frustum may be returned as well. Nodes which are not visible
+		or were removed from the scene are returned too.
+		\param outNodes The nodes are appended to this array.
+		\param frustum View frustum to test. */
+		virtual void getSpatialIndexNodes(core::array<ISceneNode*>& outNodes,
+			const SViewFrustum& frustum) const = 0;
+
+		//! Get the scene nodes of the spatial index which may intersect a box.
+		/** \param outNodes The nodes are appended to this array.
+		\param box Axis aligned box in world space. */
+		virtual void getSpatialIndexNodes(core::array<ISceneNode*>& outNodes,
+			const core::aabbox3d<f32>& box) const = 0;
+
+		//! Get the scene nodes of the spatial index which may intersect a line.
+		/** \param outNodes The nodes are appended to this array.
+		\param ray Line in world space. */
+		virtual void getSpatialIndexNodes(core::array<ISceneNode*>& outNodes,
+			const core::line3d<f32>& ray) const = 0;
+
+		//! Adds an occluder for the software occlusion culling.
+		/** Each frame drawAll() rasterizes the meshes of all occluders
+		into a small depth buffer on the CPU, before the nodes register
+		themselves. The bounding boxes of the nodes with automatic culling
+		are then tested against it, and nodes hidden behind the occluders
+		are not rendered. This works with every driver, including the null
+		driver, and needs no occlusion queries. Only the active camera is
+		used, and only if it has a perspective projection.
+		Good occluders are large, closed and have few triangles, like walls,
+		buildings and terrain. The occluder mesh must not reach outside of
+		the surface it stands for, otherwise visible nodes are culled, so
+		usually it is a simplified version of the mesh of the node.
+		\param node Scene node whose absolute transformation places the
+		occluder. Occluders of nodes which are not visible are ignored.
+		\param mesh Mesh which is rasterized, without textures or
+		materials. The occluder grabs the node and the mesh. */
+		virtual void addOccluder(ISceneNode* node, IMesh* mesh) = 0;
+
+		//! Removes the occluders of a scene node.
+		/** \param node Scene node passed to addOccluder(). */
+		virtual void removeOccluder(ISceneNode* node) = 0;
+
+		//! Removes all occluders, disables the software occlusion culling.
+		virtual void removeAllOccluders() = 0;
+
+		//! Sets the size of the depth buffer of the software occlusion culling.
+		/** Larger buffers occlude more exactly but rasterize slower. The
+		default is 256x128 pixels.
+		\param size Size of the depth buffer in pixels. */
+		virtual void setOcclusionBufferSize(const core::dimension2d<u32>& size) = 0;
 	};
 
 
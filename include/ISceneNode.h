@@ -16,6 +16,7 @@
 #include "aabbox3d.h"
 #include "matrix4.h"
 #include "irrList.h"
+#include "irrArray.h"
 #include "IAttributes.h"
 
 namespace irr
@@ -49,6 +50,8 @@ namespace scene
 			: RelativeTranslation(position), RelativeRotation(rotation), RelativeScale(scale),
 				Parent(0), SceneManager(mgr), TriangleSelector(0), ID(id),
 				AutomaticCullingState(EAC_BOX), DebugDataVisible(EDS_OFF),
+				SpatialIndexId(-1), AbsoluteTransformationRevision(0),
+				ParentTransformationRevision(0), RelativeTransformationChanged(true),
 				IsVisible(true), IsDebugObject(false)
 		{
 			if (parent)
@@ -87,14 +90,19 @@ namespace scene
 
 		ISceneNode::OnRegisterSceneNode();
 		\endcode
+		Children which are in the spatial index of the scene manager are
+		skipped, the scene manager registers them itself when they may be
+		visible. See ISceneManager::addToSpatialIndex().
 		*/
 		virtual void OnRegisterSceneNode()
 		{
 			if (IsVisible)
 			{
-				ISceneNodeList::Iterator it = Children.begin();
-				for (; it != Children.end(); ++it)
-					(*it)->OnRegisterSceneNode();
+				for (u32 i=0; i<ChildArray.size(); ++i)
+				{
+					if (ChildArray[i]->SpatialIndexId < 0)
+						ChildArray[i]->OnRegisterSceneNode();
+				}
 			}
 		}
 
@@ -127,9 +135,8 @@ namespace scene
 
 				// perform the post render process on all children
 
-				ISceneNodeList::Iterator it = Children.begin();
-				for (; it != Children.end(); ++it)
-					(*it)->OnAnimate(timeMs);
+				for (u32 i=0; i<ChildArray.size(); ++i)
+					ChildArray[i]->OnAnimate(timeMs);
 			}
 		}
 
@@ -288,7 +295,9 @@ namespace scene
 				child->grab();
 				child->remove(); // remove from old parent
 				Children.push_back(child);
+				ChildArray.push_back(child);
 				child->Parent = this;
+				child->RelativeTransformationChanged = true;
 			}
 		}
 
@@ -301,18 +310,25 @@ namespace scene
 		e.g. because it couldn't be found in the children list. */
 		virtual bool removeChild(ISceneNode* child)
 		{
+			const s32 index = ChildArray.linear_search(child);
+			if (index < 0)
+			{
+				_IRR_IMPLEMENT_MANAGED_MARSHALLING_BUGFIX;
+				return false;
+			}
+
+			ChildArray.erase(index);
+
 			ISceneNodeList::Iterator it = Children.begin();
-			for (; it != Children.end(); ++it)
-				if ((*it) == child)
-				{
-					(*it)->Parent = 0;
-					(*it)->drop();
-					Children.erase(it);
-					return true;
-				}
+			for (; (*it) != child; ++it)
+				;
+			Children.erase(it);
 
-			_IRR_IMPLEMENT_MANAGED_MARSHALLING_BUGFIX;
-			return false;
+			child->Parent = 0;
+			child->RelativeTransformationChanged = true;
+			getRoot()->OnSubtreeRemoved(child);
+			child->drop();
+			return true;
 		}
 
 
@@ -322,14 +338,17 @@ namespace scene
 		*/
 		virtual void removeAll()
 		{
-			ISceneNodeList::Iterator it = Children.begin();
-			for (; it != Children.end(); ++it)
+			ISceneNode* root = getRoot();
+			for (u32 i=0; i<ChildArray.size(); ++i)
 			{
-				(*it)->Parent = 0;
-				(*it)->drop();
+				ChildArray[i]->Parent = 0;
+				ChildArray[i]->RelativeTransformationChanged = true;
+				root->OnSubtreeRemoved(ChildArray[i]);
+				ChildArray[i]->drop();
 			}
 
 			Children.clear();
+			ChildArray.clear();
 		}
 
 
@@ -468,6 +487,7 @@ namespace scene
 		virtual void setScale(const core::vector3df& scale)
 		{
 			RelativeScale = scale;
+			RelativeTransformationChanged = true;
 		}
 
 
@@ -488,6 +508,7 @@ namespace scene
 		virtual void setRotation(const core::vector3df& rotation)
 		{
 			RelativeRotation = rotation;
+			RelativeTransformationChanged = true;
 		}
 
 
@@ -507,6 +528,7 @@ namespace scene
 		virtual void setPosition(const core::vector3df& newpos)
 		{
 			RelativeTranslation = newpos;
+			RelativeTransformationChanged = true;
 		}
 
 
@@ -583,14 +605,59 @@ namespace scene
 		}
 
 
+		//! Sets the id of this node in the spatial index of the scene manager.
+		/** This is done by ISceneManager::addToSpatialIndex() and
+		ISceneManager::removeFromSpatialIndex(), don't call it directly.
+		\param id Id of the leaf in the index, -1 if the node is not indexed. */
+		void setSpatialIndexId(s32 id)
+		{
+			SpatialIndexId = id;
+		}
+
+
+		//! Returns the id of this node in the spatial index of the scene manager.
+		/** \return Id of the leaf in the index, -1 if the node is not indexed. */
+		s32 getSpatialIndexId() const
+		{
+			return SpatialIndexId;
+		}
+
+
+		//! Returns a number which changes whenever the absolute transformation is recalculated.
+		/** \return Revision of the absolute transformation. */
+		u32 getAbsoluteTransformationRevision() const
+		{
+			return AbsoluteTransformationRevision;
+		}
+
+
 		//! Returns a const reference to the list of all children.
-		/** \return The list of all children of this node. */
+		/** Iterating with getChildCount() and getChild() is faster.
+		\return The list of all children of this node. */
 		const core::list<ISceneNode*>& getChildren() const
 		{
 			return Children;
 		}
 
 
+		//! Returns the number of children of this node.
+		u32 getChildCount() const
+		{
+			return ChildArray.size();
+		}
+
+
+		//! Returns a child of this node.
+		/** The children are stored in one array, in the same order as
+		in getChildren().
+		\param index Index of the child, smaller than getChildCount().
+		\return The child. */
+		ISceneNode* getChild(u32 index) const
+		{
+			return ChildArray[index];
+		}
+
+
 		//! Changes the parent of the scene node.
 		/** \param newParent The new parent to be used. */
 		virtual void setParent(ISceneNode* newParent)
@@ -648,16 +715,43 @@ namespace scene
 
 		//! Updates the absolute position based on the relative and the parents position
 		/** Note: This does not recursively update the parents absolute positions, so if you have a deeper
-			hierarchy you might want to update the parents first.*/
+			hierarchy you might want to update the parents first.
+			The matrix is only recalculated if the relative transformation
+			or the absolute transformation of the parent changed since the
+			last update, so static hierarchies are almost free. */
 		virtual void updateAbsolutePosition()
 		{
 			if (Parent)
 			{
+				if (!RelativeTransformationChanged &&
+					ParentTransformationRevision == Parent->AbsoluteTransformationRevision)
+					return;
+
 				AbsoluteTransformation =
 					Parent->getAbsoluteTransformation() * getRelativeTransformation();
+				ParentTransformationRevision = Parent->AbsoluteTransformationRevision;
 			}
 			else
+			{
+				if (!RelativeTransformationChanged)
+					return;
+
 				AbsoluteTransformation = getRelativeTransformation();
+			}
+
+			RelativeTransformationChanged = false;
+			++AbsoluteTransformationRevision;
+		}
+
+
+		//! Forces the recalculation of the absolute transformation in the next updateAbsolutePosition()
+		/** The setters of ISceneNode call this already. Derived nodes
+		which write the relative translation, rotation or scale members
+		directly, or override getRelativeTransformation(), have to call it
+		whenever their relative transformation changes. */
+		void setRelativeTransformationChanged()
+		{
+			RelativeTransformationChanged = true;
 		}
 
 
@@ -761,6 +855,7 @@ namespace scene
 			RelativeTranslation = toCopyFrom->RelativeTranslation;
 			RelativeRotation = toCopyFrom->RelativeRotation;
 			RelativeScale = toCopyFrom->RelativeScale;
+			RelativeTransformationChanged = true;
 			ID = toCopyFrom->ID;
 			setTriangleSelector(toCopyFrom->TriangleSelector);
 			AutomaticCullingState = toCopyFrom->AutomaticCullingState;
@@ -799,9 +894,24 @@ namespace scene
 		{
 			SceneManager = newManager;
 
-			ISceneNodeList::Iterator it = Children.begin();
-			for (; it != Children.end(); ++it)
-				(*it)->setSceneManager(newManager);
+			for (u32 i=0; i<ChildArray.size(); ++i)
+				ChildArray[i]->setSceneManager(newManager);
+		}
+
+		//! Called on the root of the scene graph when a subtree was removed from it.
+		/** The scene manager, which is the root, takes the nodes of the
+		subtree out of its spatial index in the next drawAll() unless they
+		were added to the scene again.
+		\param node Root of the removed subtree. */
+		virtual void OnSubtreeRemoved(ISceneNode* node) {}
+
+		//! Returns the topmost parent of this node, or the node itself
+		ISceneNode* getRoot()
+		{
+			ISceneNode* root = this;
+			while (root->Parent)
+				root = root->Parent;
+			return root;
 		}
 
 		//! Name of the scene node.
@@ -825,6 +935,9 @@ namespace scene
 		//! List of all children of this node
 		core::list<ISceneNode*> Children;
 
+		//! The same children in one array, for fast traversal
+		core::array<ISceneNode*> ChildArray;
+
 		//! List of all animator nodes
 		core::list<ISceneNodeAnimator*> Animators;
 
@@ -843,6 +956,18 @@ namespace scene
 		//! Flag if debug data should be drawn, such as Bounding Boxes.
 		u32 DebugDataVisible;
 
+		//! Id in the spatial index of the scene manager, -1 if not indexed
+		s32 SpatialIndexId;
+
+		//! Incremented whenever the absolute transformation is recalculated
+		u32 AbsoluteTransformationRevision;
+
+		//! Revision of the parent transformation the absolute transformation is based on
+		u32 ParentTransformationRevision;
+
+		//! Has the relative transformation changed since the last update?
+		bool RelativeTransformationChanged;
+
 		//! Is the node visible?
 		bool IsVisible;
 
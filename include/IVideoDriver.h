@@ -9,6 +9,7 @@
 #include "SColor.h"
 #include "ITexture.h"
 #include "irrArray.h"
+#include "irrArenaAllocator.h"
 #include "matrix4.h"
 #include "plane3d.h"
 #include "dimension2d.h"
@@ -384,6 +385,26 @@ namespace video
 		IReferenceCounted::drop() for more information. */
 		virtual ITexture* getTexture(io::IReadFile* file) =0;
 
+		//! Loads a texture in the background.
+		/** Works like getTexture(), but only the file is read on the
+		calling thread. The image is decoded on worker threads and until it
+		is done the returned texture is a small white placeholder, which is
+		in the texture cache under the name of the file already. The next
+		beginScene() or processQueuedCalls() after the decoding uploads the
+		image into the same texture object, so materials which use the
+		placeholder show the image from then on without any change. Textures
+		which were loaded before are returned directly.
+		\param filename Filename of the texture to be loaded.
+		\return Pointer to the placeholder or the loaded texture, or 0 if
+		the file could not be read. This pointer should not be dropped. See
+		IReferenceCounted::drop() for more information. */
+		virtual ITexture* getTextureAsync(const io::path& filename) =0;
+
+		//! Returns the number of textures which are still decoded in the background.
+		/** Includes textures which are decoded but not uploaded yet by
+		beginScene() or processQueuedCalls(). */
+		virtual u32 getPendingTextureLoadCount() const =0;
+
 		//! Returns a texture by index
 		/** \param index: Index of the texture, must be smaller than
 		getTextureCount() Please note that this index might change when
@@ -1018,6 +1039,22 @@ namespace video
 		/** \param mb Buffer to draw */
 		virtual void drawMeshBuffer(const scene::IMeshBuffer* mb) =0;
 
+		//! Draws a mesh buffer once for each of several transformations
+		/** Each instance is drawn with the current world transformation
+		multiplied by its own transformation. Drivers without native
+		instancing copy the transformed instances into one vertex list and
+		draw as many instances at once as 16 bit indices can address. Mesh
+		buffers with more than 65536 vertices are drawn once per instance,
+		without the instance colors.
+		\param mb Buffer to draw
+		\param transforms Transformation of each instance, relative to the
+		world transformation.
+		\param colors Optional color of each instance, which is multiplied
+		with the vertex colors. Can be 0.
+		\param instanceCount Number of instances to draw */
+		virtual void drawMeshBufferInstanced(const scene::IMeshBuffer* mb,
+			const core::matrix4* transforms, const SColor* colors, u32 instanceCount) =0;
+
 		//! Draws normals of a mesh buffer
 		/** \param mb Buffer to draw the normals of
 		\param length length scale factor of the normals
@@ -1082,6 +1119,31 @@ namespace video
 		\return Amount of primitives drawn in the last frame. */
 		virtual u32 getPrimitiveCountDrawn( u32 mode =0 ) const =0;
 
+		//! Returns the arena for temporary data of the current frame.
+		/** The arena is reset in endScene(), so everything allocated
+		from it has to be released until then. It is meant for scratch
+		arrays inside a function, which then don't allocate heap memory
+		once the arena has grown to the size of a frame:
+		\code
+		core::array<u16, core::irrArenaAllocator<u16> > indices;
+		indices.setAllocator(driver->getFrameArena());
+		\endcode
+		Must only be used from the thread which renders the scene.
+		\return Arena of the current frame. */
+		virtual core::memoryArena* getFrameArena() =0;
+
+		//! Runs the texture calls which other threads wait for.
+		/** Textures can only be created on the thread which created the
+		driver. When another thread, e.g. the background mesh loader of the
+		scene manager, asks for a texture, the call is queued and this thread
+		blocks until the owning thread runs it. The same goes for
+		makeNormalMapTexture(). The images decoded for getTextureAsync() are
+		uploaded here as well, and messages which other threads logged are
+		passed to the logger. beginScene() does so once per frame, this
+		method allows it at other points. Does nothing when called from
+		another thread than the owning one. */
+		virtual void processQueuedCalls() =0;
+
 		//! Deletes all dynamic lights which were previously added with addDynamicLight().
 		virtual void deleteAllDynamicLights() =0;
 
@@ -1145,6 +1207,9 @@ namespace video
 		this value only as recommendation. It could happen that you
 		enable the ETCF_ALWAYS_16_BIT mode, but the driver still creates
 		32 bit textures.
+		Other threads than the one which created the driver share a second
+		set of flags, which their queued texture calls are run with. So
+		they don't change the flags of the owning thread.
 		\param flag Texture creation flag.
 		\param enabled Specifies if the given flag should be enabled or
 		disabled. */
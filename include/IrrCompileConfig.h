@@ -113,6 +113,16 @@
 #endif
 
 
+//! Define _IRR_COMPILE_WITH_SSE2_ to use SSE2 intrinsics in some performance critical engine code.
+/** It is enabled automatically when the compiler targets a CPU with SSE2. */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define _IRR_COMPILE_WITH_SSE2_
+#endif
+#ifdef NO_IRR_COMPILE_WITH_SSE2_
+#undef _IRR_COMPILE_WITH_SSE2_
+#endif
+
+
 //! Maximum number of texture an SMaterial can have, up to 8 are supported by Irrlicht.
 #define _IRR_MATERIAL_MAX_TEXTURES_ 4
 
@@ -228,6 +238,15 @@ you will not be able to use anything provided by the GUI Environment, including
 #undef _IRR_COMPILE_WITH_GUI_
 #endif
 
+//! Define _IRR_COMPILE_WITH_PROFILING_ to compile the engine with the built-in frame profiler
+/** The engine then times its scene passes, draw calls, culling, skinning and loaders, see IProfiler.
+The timers cost a check of a flag as long as recording is disabled. Disable this to remove them
+completely, IrrlichtDevice::getProfiler() returns 0 then. */
+#define _IRR_COMPILE_WITH_PROFILING_
+#ifdef NO_IRR_COMPILE_WITH_PROFILING_
+#undef _IRR_COMPILE_WITH_PROFILING_
+#endif
+
 //! Define _IRR_WCHAR_FILESYSTEM to enable unicode filesystem support for the engine.
 /** This enables the engine to read/write from unicode filesystem. If you
 disable this feature, the engine behave as before (ansi). This is currently only supported
@@ -20,6 +20,8 @@ namespace irr
 {
 	class ILogger;
 	class IEventReceiver;
+	class IProfiler;
+	class IJobSystem;
 	class IRandomizer;
 
 	namespace io {
@@ -107,6 +109,20 @@ namespace irr
 		/** \return Pointer to the logger. */
 		virtual ILogger* getLogger() = 0;
 
+		//! Provides access to the frame profiler.
+		/** The profiler is shared by all devices and records nothing
+		until it is enabled with IProfiler::setEnabled().
+		\return Pointer to the profiler, or 0 if the engine was compiled
+		without _IRR_COMPILE_WITH_PROFILING_. */
+		virtual IProfiler* getProfiler() = 0;
+
+		//! Provides access to the job system of the device.
+		/** The engine runs its own parallel work on it as well, the
+		number of worker threads is set with
+		SIrrlichtCreationParameters::JobThreads.
+		\return Pointer to the job system. */
+		virtual IJobSystem* getJobSystem() = 0;
+
 		//! Gets a list with all video modes available.
 		/** If you are confused now, because you think you have to
 		create an Irrlicht Device with a video mode before being able
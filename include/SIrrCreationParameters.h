@@ -45,6 +45,8 @@ namespace irr
 			DisplayAdapter(0),
 			DriverMultithreaded(false),
 			UsePerformanceTimer(true),
+			RasterizerThreads(0),
+			JobThreads(0),
 			SDK_version_do_not_use(IRRLICHT_SDK_VERSION)
 		{
 		}
@@ -76,6 +78,8 @@ namespace irr
 			DriverMultithreaded = other.DriverMultithreaded;
 			DisplayAdapter = other.DisplayAdapter;
 			UsePerformanceTimer = other.UsePerformanceTimer;
+			RasterizerThreads = other.RasterizerThreads;
+			JobThreads = other.JobThreads;
 			return *this;
 		}
 
@@ -283,6 +287,23 @@ namespace irr
 		*/
 		bool UsePerformanceTimer;
 
+		//! Number of threads rasterizing triangles in software.
+		/** The render target is split into bands of scanlines which are
+		drawn in parallel. The image is exactly the same as with one thread.
+		0 uses the job system of the device if it has worker threads,
+		1 disables the additional threads, larger values start a separate
+		set of threads for the rasterizer.
+		So far only supported by Burning's Video. Default: 0. */
+		u32 RasterizerThreads;
+
+		//! Number of worker threads of the job system.
+		/** The job system is returned by IrrlichtDevice::getJobSystem()
+		and shared by the engine's own parallel work, like the transform
+		update of the scene manager and the rasterizer of Burning's Video.
+		With 0 all jobs run inline on the thread which adds them, usually
+		the number of processors minus one is a good choice. Default: 0. */
+		u32 JobThreads;
+
 		//! Don't use or change this parameter.
 		/** Always set it to IRRLICHT_SDK_VERSION, which is done by default.
 		This is needed for sdk version checks. */
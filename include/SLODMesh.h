@@ -0,0 +1,238 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __S_LOD_MESH_H_INCLUDED__
+#define __S_LOD_MESH_H_INCLUDED__
+
+#include "IAnimatedMesh.h"
+#include "IMesh.h"
+#include "aabbox3d.h"
+#include "irrArray.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! Measure by which a level of detail is selected
+	enum E_LOD_METRIC
+	{
+		//! Height of the bounding sphere on the screen, as a fraction of the screen height.
+		/** A level is used while the projected size is at least its threshold. */
+		ELM_SCREEN_SIZE = 0,
+
+		//! Distance between the camera and the center of the bounding box.
+		/** A level is used while the distance is at most its threshold. */
+		ELM_DISTANCE
+	};
+
+	//! Chain of meshes with decreasing level of detail.
+	/** The chain is an animated mesh of type EAMT_LOD, so it can be added
+	to the mesh cache and is shared by all LOD mesh scene nodes which use it,
+	see ISceneManager::addLODMeshSceneNode(). Level 0 is the most detailed
+	one. Each level has a threshold for the metric of the chain, a node
+	shows the first level whose threshold is passed and nothing if no
+	threshold is passed. */
+	struct SLODMesh : public IAnimatedMesh
+	{
+		//! constructor
+		SLODMesh(E_LOD_METRIC metric=ELM_SCREEN_SIZE) : IAnimatedMesh(),
+			Metric(metric), Hysteresis(0.1f)
+		{
+			#ifdef _DEBUG
+			setDebugName("SLODMesh");
+			#endif
+		}
+
+		//! destructor
+		virtual ~SLODMesh()
+		{
+			for (u32 i=0; i<Meshes.size(); ++i)
+				Meshes[i]->drop();
+		}
+
+		//! Adds a level behind the existing ones.
+		/** \param mesh Mesh of the level, it should have less detail than
+		the previous level.
+		\param threshold Minimal screen size or maximal distance at which
+		the level is used, depending on the metric of the chain. Use 0 for
+		the screen size or FLT_MAX for the distance to never hide the node. */
+		void addLevel(IMesh* mesh, f32 threshold)
+		{
+			if (mesh)
+			{
+				mesh->grab();
+				Meshes.push_back(mesh);
+				Thresholds.push_back(threshold);
+				recalculateBoundingBox();
+			}
+		}
+
+		//! Returns the number of levels.
+		u32 getLevelCount() const
+		{
+			return Meshes.size();
+		}
+
+		//! Returns the mesh of a level, 0 if there is no such level.
+		IMesh* getLevel(u32 level) const
+		{
+			return level < Meshes.size() ? Meshes[level] : 0;
+		}
+
+		//! Selects a level for a value of the metric.
+		/** The threshold of the current level is widened and the thresholds
+		of the more detailed levels are narrowed by the hysteresis, so a
+		value close to a threshold doesn't switch the level every frame.
+		\param value Screen size or distance.
+		\param current Level used so far, getLevelCount() if the node was hidden.
+		\return The level to use, getLevelCount() if nothing should be shown. */
+		u32 selectLevel(f32 value, u32 current) const
+		{
+			for (u32 i=0; i<Thresholds.size(); ++i)
+			{
+				f32 t = Thresholds[i];
+				if (i < current)
+					t *= (Metric == ELM_SCREEN_SIZE) ? 1.f + Hysteresis : 1.f - Hysteresis;
+				else if (i == current)
+					t *= (Metric == ELM_SCREEN_SIZE) ? 1.f - Hysteresis : 1.f + Hysteresis;
+
+				if ((Metric == ELM_SCREEN_SIZE) ? (value >= t) : (value <= t))
+					return i;
+			}
+			return Thresholds.size();
+		}
+
+		//! Gets the frame count of the animated mesh.
+		virtual u32 getFrameCount() const
+		{
+			return 1;
+		}
+
+		//! Gets the default animation speed of the animated mesh.
+		virtual f32 getAnimationSpeed() const
+		{
+			return 0.f;
+		}
+
+		//! A LOD chain is not animated.
+		virtual void setAnimationSpeed(f32 fps)
+		{
+		}
+
+		//! Returns the mesh of a level.
+		/** \param frame Ignored.
+		\param detailLevel 255 returns the most detailed level, 0 the least
+		detailed one. */
+		virtual IMesh* getMesh(s32 frame, s32 detailLevel=255, s32 startFrameLoop=-1, s32 endFrameLoop=-1)
+		{
+			if (Meshes.empty())
+				return 0;
+
+			const s32 level = ((255 - core::s32_clamp(detailLevel, 0, 255)) * (s32)Meshes.size()) / 256;
+			return Meshes[level];
+		}
+
+		//! Returns an axis aligned bounding box enclosing all levels.
+		virtual const core::aabbox3d<f32>& getBoundingBox() const
+		{
+			return Box;
+		}
+
+		//! set user axis aligned bounding box
+		virtual void setBoundingBox(const core::aabbox3df& box)
+		{
+			Box = box;
+		}
+
+		//! Recalculates the bounding box.
+		void recalculateBoundingBox()
+		{
+			Box.reset(0,0,0);
+
+			if (Meshes.empty())
+				return;
+
+			Box = Meshes[0]->getBoundingBox();
+
+			for (u32 i=1; i<Meshes.size(); ++i)
+				Box.addInternalBox(Meshes[i]->getBoundingBox());
+		}
+
+		//! Returns the type of the animated mesh.
+		virtual E_ANIMATED_MESH_TYPE getMeshType() const
+		{
+			return EAMT_LOD;
+		}
+
+		//! returns amount of mesh buffers of the most detailed level.
+		virtual u32 getMeshBufferCount() const
+		{
+			if (Meshes.empty())
+				return 0;
+
+			return Meshes[0]->getMeshBufferCount();
+		}
+
+		//! returns pointer to a mesh buffer of the most detailed level
+		virtual IMeshBuffer* getMeshBuffer(u32 nr) const
+		{
+			if (Meshes.empty())
+				return 0;
+
+			return Meshes[0]->getMeshBuffer(nr);
+		}
+
+		//! Returns pointer to a mesh buffer of the most detailed level which fits a material
+		virtual IMeshBuffer* getMeshBuffer( const video::SMaterial &material) const
+		{
+			if (Meshes.empty())
+				return 0;
+
+			return Meshes[0]->getMeshBuffer(material);
+		}
+
+		//! Set a material flag for all meshbuffers of all levels.
+		virtual void setMaterialFlag(video::E_MATERIAL_FLAG flag, bool newvalue)
+		{
+			for (u32 i=0; i<Meshes.size(); ++i)
+				Meshes[i]->setMaterialFlag(flag, newvalue);
+		}
+
+		//! set the hardware mapping hint, for driver
+		virtual void setHardwareMappingHint( E_HARDWARE_MAPPING newMappingHint, E_BUFFER_TYPE buffer=EBT_VERTEX_AND_INDEX )
+		{
+			for (u32 i=0; i<Meshes.size(); ++i)
+				Meshes[i]->setHardwareMappingHint(newMappingHint, buffer);
+		}
+
+		//! flags the meshbuffer as changed, reloads hardware buffers
+		virtual void setDirty(E_BUFFER_TYPE buffer=EBT_VERTEX_AND_INDEX)
+		{
+			for (u32 i=0; i<Meshes.size(); ++i)
+				Meshes[i]->setDirty(buffer);
+		}
+
+		//! Meshes of the levels, the most detailed one first
+		core::array<IMesh*> Meshes;
+
+		//! Threshold of each level
+		core::array<f32> Thresholds;
+
+		//! The bounding box of all levels
+		core::aabbox3d<f32> Box;
+
+		//! Metric by which the levels are selected
+		E_LOD_METRIC Metric;
+
+		//! Relative margin around the thresholds, 0.1 by default
+		f32 Hysteresis;
+	};
+
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
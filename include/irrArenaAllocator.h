@@ -0,0 +1,190 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __IRR_ARENA_ALLOCATOR_H_INCLUDED__
+#define __IRR_ARENA_ALLOCATOR_H_INCLUDED__
+
+#include "irrTypes.h"
+#include "irrMath.h"
+#include <new>
+
+namespace irr
+{
+namespace core
+{
+
+//! Linear allocator for short living data
+/** Allocations only move a pointer forward in a large block, deallocations
+are free and all memory is released at once with reset(). When a block is
+full, another one is added. On the next reset() all blocks are replaced
+by one block large enough for everything allocated since the last reset,
+so a steady workload doesn't touch the heap anymore. Not thread safe. */
+class memoryArena
+{
+public:
+
+	//! Constructor
+	/** \param blockSize Size of the first block in bytes. */
+	explicit memoryArena(size_t blockSize=65536)
+		: Blocks(0), Top(0), End(0), LastAllocation(0),
+		BlockSize(blockSize), UsedSize(0), PeakSize(0)
+	{
+	}
+
+	//! Destructor, frees all blocks
+	~memoryArena()
+	{
+		freeBlocks();
+	}
+
+	//! Allocates memory aligned to 16 bytes
+	void* allocate(size_t size)
+	{
+		size = (size + 15) & ~(size_t)15;
+
+		if (!Top || size > (size_t)(End - Top))
+			addBlock(core::max_(BlockSize, size));
+
+		LastAllocation = Top;
+		Top += size;
+		UsedSize += size;
+		PeakSize = core::max_(PeakSize, UsedSize);
+		return LastAllocation;
+	}
+
+	//! Releases memory
+	/** Only the most recent allocation is given back to the arena, all
+	other memory is released by reset(). */
+	void deallocate(void* ptr)
+	{
+		if (ptr && ptr == LastAllocation)
+		{
+			UsedSize -= Top - LastAllocation;
+			Top = LastAllocation;
+			LastAllocation = 0;
+		}
+	}
+
+	//! Releases all allocations at once
+	/** Memory allocated before must not be used afterwards. */
+	void reset()
+	{
+		if (Blocks && Blocks->Next)
+		{
+			// merge into one block for the next round
+			BlockSize = core::max_(BlockSize, PeakSize);
+			freeBlocks();
+			addBlock(BlockSize);
+		}
+		else if (Blocks)
+			Top = (u8*)(Blocks + 1);
+
+		LastAllocation = 0;
+		UsedSize = 0;
+		PeakSize = 0;
+	}
+
+	//! Returns the number of bytes allocated since the last reset
+	size_t getUsedSize() const
+	{
+		return UsedSize;
+	}
+
+private:
+
+	// not copyable
+	memoryArena(const memoryArena&);
+	memoryArena& operator=(const memoryArena&);
+
+	//! header in front of the memory of each block, 16 bytes to keep the alignment
+	struct SBlock
+	{
+		SBlock* Next;
+		u8 Padding[16 - sizeof(SBlock*)];
+	};
+
+	void addBlock(size_t size)
+	{
+		SBlock* block = (SBlock*)operator new(sizeof(SBlock) + size);
+		block->Next = Blocks;
+		Blocks = block;
+		Top = (u8*)(block + 1);
+		End = Top + size;
+	}
+
+	void freeBlocks()
+	{
+		while (Blocks)
+		{
+			SBlock* next = Blocks->Next;
+			operator delete(Blocks);
+			Blocks = next;
+		}
+		Top = End = LastAllocation = 0;
+	}
+
+	SBlock* Blocks;
+	u8* Top;
+	u8* End;
+	u8* LastAllocation;
+	size_t BlockSize;
+	size_t UsedSize;
+	size_t PeakSize;
+};
+
+
+//! Allocator taking its memory from a memoryArena
+/** Set it with array::setAllocator() before the array allocates. Without
+an arena it falls back to the heap like irrAllocatorFast. Containers using
+it must not live longer than the memory of the arena, i.e. until its next
+reset(). */
+template<typename T>
+class irrArenaAllocator
+{
+public:
+
+	//! Constructor
+	/** \param arena Arena to allocate from, 0 for the heap. */
+	irrArenaAllocator(memoryArena* arena=0) : Arena(arena) {}
+
+	//! Allocate memory for an array of objects
+	T* allocate(size_t cnt)
+	{
+		if (Arena)
+			return (T*)Arena->allocate(cnt* sizeof(T));
+		return (T*)operator new(cnt* sizeof(T));
+	}
+
+	//! Deallocate memory for an array of objects
+	void deallocate(T* ptr)
+	{
+		if (Arena)
+			Arena->deallocate(ptr);
+		else
+			operator delete(ptr);
+	}
+
+	//! Construct an element
+	void construct(T* ptr, const T&e)
+	{
+		new ((void*)ptr) T(e);
+	}
+
+	//! Destruct an element
+	void destruct(T* ptr)
+	{
+		ptr->~T();
+	}
+
+private:
+
+	memoryArena* Arena;
+};
+
+
+} // end namespace core
+} // end namespace irr
+
+#endif
+
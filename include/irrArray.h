@@ -106,6 +106,17 @@ public:
 	}
 
 
+	//! set the allocator instance
+	/** Only needed for allocators with a state, like irrArenaAllocator.
+	Must be called before the array allocates any memory.
+	\param newAllocator Allocator used for all further allocations. */
+	void setAllocator(const TAlloc& newAllocator)
+	{
+		_IRR_DEBUG_BREAK_IF(data) // memory of the old allocator
+		allocator = newAllocator;
+	}
+
+
 	//! Adds an element at back of array.
 	/** If the array is too small to add this new element it is made bigger.
 	\param element: Element to add at the back of the array. */
@@ -34,6 +34,7 @@
 #include "CDynamicMeshBuffer.h"
 #include "CIndexBuffer.h"
 #include "CMeshBuffer.h"
+#include "CSceneNodeIterator.h"
 #include "coreutil.h"
 #include "CVertexBuffer.h"
 #include "dimension2d.h"
@@ -101,6 +102,8 @@
 #include "IImageLoader.h"
 #include "IImageWriter.h"
 #include "IIndexBuffer.h"
+#include "IInstancedMeshSceneNode.h"
+#include "IJobSystem.h"
 #include "ILightSceneNode.h"
 #include "ILogger.h"
 #include "IMaterialRenderer.h"
@@ -109,12 +112,14 @@
 #include "IMeshBuffer.h"
 #include "IMeshCache.h"
 #include "IMeshLoader.h"
+#include "IMeshLoadCallBack.h"
 #include "IMeshManipulator.h"
 #include "IMeshSceneNode.h"
 #include "IMeshWriter.h"
 #include "IColladaMeshWriter.h"
 #include "IMetaTriangleSelector.h"
 #include "IOSOperator.h"
+#include "IProfiler.h"
 #include "IParticleSystemSceneNode.h" // also includes all emitters and attractors
 #include "IQ3LevelMesh.h"
 #include "IQ3Shader.h"
@@ -167,6 +172,7 @@
 #include "rect.h"
 #include "S3DVertex.h"
 #include "SAnimatedMesh.h"
+#include "SLODMesh.h"
 #include "SceneParameters.h"
 #include "SColor.h"
 #include "SExposedVideoData.h"
@@ -516,6 +516,9 @@ public:
 
 	virtual void setMaterial ( const SBurningShaderMaterial &material );
 
+	//! reference rasterizer, always runs on the calling thread
+	virtual bool canRenderTiled () const { return false; }
+
 
 private:
 	void scanline ();
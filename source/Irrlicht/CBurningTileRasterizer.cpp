@@ -0,0 +1,357 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt / Thomas Alten
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "IrrCompileConfig.h"
+#ifdef _IRR_COMPILE_WITH_BURNINGSVIDEO_
+
+#include "CBurningTileRasterizer.h"
+#include "CSoftwareDriver2.h"
+#include "CSoftwareTexture2.h"
+
+namespace irr
+{
+namespace video
+{
+
+//! shader the driver draws into, queues everything into the tile rasterizer
+class CBurningShaderRecorder : public IBurningShader
+{
+public:
+
+	//! constructor
+	CBurningShaderRecorder(CBurningVideoDriver* driver, CBurningTileRasterizer* rasterizer, u32 shader, const IBurningShader* worker)
+		: IBurningShader(driver), Rasterizer(rasterizer), Shader(shader),
+		DepthTest(worker->hasDepthTest()), DepthWrite(worker->hasDepthWrite()),
+		FullDepthWrite(worker->hasFullDepthWrite())
+	{
+		#ifdef _DEBUG
+		setDebugName("CBurningShaderRecorder");
+		#endif
+	}
+
+	virtual void setRenderTarget(video::IImage* surface, const core::rect<s32>& viewPort)
+	{
+		IBurningShader::setRenderTarget(surface, viewPort);
+		Rasterizer->setRenderTarget(surface, viewPort);
+	}
+
+	virtual void setTextureParam( u32 stage, video::CSoftwareTexture2* texture, s32 lodLevel)
+	{
+		// the workers already sample this mipmap
+		const sInternalTexture& it = IT[stage];
+		if ( it.Texture == texture && ( 0 == texture || it.lodLevel == lodLevel ) )
+			return;
+
+		IBurningShader::setTextureParam(stage, texture, lodLevel);
+		Rasterizer->addTexture(Shader, stage, texture, lodLevel);
+	}
+
+	virtual void drawTriangle ( const s4DVertex *a,const s4DVertex *b,const s4DVertex *c )
+	{
+		Rasterizer->addTriangle(Shader, a, b, c);
+	}
+
+	virtual void setParam ( u32 index, f32 value)
+	{
+		Rasterizer->addParam(Shader, index, value);
+	}
+
+	virtual void setZCompareFunc ( u32 func)
+	{
+		Rasterizer->addZCompareFunc(Shader, func);
+	}
+
+	virtual void setMaterial ( const SBurningShaderMaterial &material )
+	{
+		Rasterizer->addMaterial(Shader, material);
+	}
+
+	virtual bool hasDepthTest () const
+	{
+		return DepthTest;
+	}
+
+	virtual bool hasDepthWrite () const
+	{
+		return DepthWrite;
+	}
+
+	virtual bool hasFullDepthWrite () const
+	{
+		return FullDepthWrite;
+	}
+
+private:
+	CBurningTileRasterizer* Rasterizer;
+	u32 Shader;
+	bool DepthTest;
+	bool DepthWrite;
+	bool FullDepthWrite;
+};
+
+
+//! constructor
+CBurningTileRasterizer::CBurningTileRasterizer(CBurningVideoDriver* driver, IJobSystem* jobSystem)
+: Driver(driver), Jobs(jobSystem), WorkerCount(0), RenderTarget(0)
+{
+	#ifdef _DEBUG
+	setDebugName("CBurningTileRasterizer");
+	#endif
+
+	Jobs->grab();
+	WorkerCount = Jobs->getWorkerCount();
+
+	// every worker gets its own instance of each shader, they hold the scanline state
+	Shaders.set_used(WorkerCount * ETR2_COUNT);
+	for (u32 w=0; w != WorkerCount; ++w)
+	{
+		for (u32 i=0; i != ETR2_COUNT; ++i)
+		{
+			IBurningShader* shader = createBurningShader((EBurningFFShader) i, driver);
+			if (shader && !shader->canRenderTiled())
+			{
+				shader->drop();
+				shader = 0;
+			}
+			if (shader)
+			{
+				shader->setTileWorker(true);
+				shader->setTile(w, WorkerCount);
+			}
+			Shaders[w * ETR2_COUNT + i] = shader;
+		}
+	}
+
+	Bins.reallocate(WorkerCount);
+	for (u32 w=0; w != WorkerCount; ++w)
+		Bins.push_back(core::array<u32>());
+}
+
+
+//! destructor
+CBurningTileRasterizer::~CBurningTileRasterizer()
+{
+	flush();
+
+	for (u32 i=0; i != Shaders.size(); ++i)
+	{
+		if (Shaders[i])
+			Shaders[i]->drop();
+	}
+
+	if (RenderTarget)
+		RenderTarget->drop();
+
+	Jobs->drop();
+}
+
+
+//! returns a shader which queues into this rasterizer, 0 if the shader can't be tiled
+IBurningShader* CBurningTileRasterizer::createRecorder(EBurningFFShader type)
+{
+	if (0 == Shaders[type])
+		return 0;
+
+	return new CBurningShaderRecorder(Driver, this, type, Shaders[type]);
+}
+
+
+//! switches the render target of the workers
+void CBurningTileRasterizer::setRenderTarget(video::IImage* surface, const core::rect<s32>& viewPort)
+{
+	if (RenderTarget == surface)
+		return;
+
+	flush();
+
+	if (RenderTarget)
+		RenderTarget->drop();
+
+	RenderTarget = (video::CImage*) surface;
+	ViewPort = viewPort;
+
+	if (RenderTarget)
+		RenderTarget->grab();
+
+	for (u32 i=0; i != Shaders.size(); ++i)
+	{
+		if (Shaders[i])
+			Shaders[i]->setRenderTarget(RenderTarget, ViewPort);
+	}
+}
+
+
+//! queues a triangle into the bins of the workers owning one of its tiles
+void CBurningTileRasterizer::addTriangle(u32 shader, const s4DVertex *a, const s4DVertex *b, const s4DVertex *c)
+{
+	SCommand cmd;
+	cmd.Type = ECMD_TRIANGLE;
+	cmd.Shader = shader;
+	cmd.Index = Vertices.size();
+
+	Vertices.push_back(*a);
+	Vertices.push_back(*b);
+	Vertices.push_back(*c);
+
+	const u32 index = Commands.size();
+	Commands.push_back(cmd);
+
+	// conservative scanline range of the triangle
+	const f32 yMin = core::min_(a->Pos.y, b->Pos.y, c->Pos.y);
+	const f32 yMax = core::max_(a->Pos.y, b->Pos.y, c->Pos.y);
+	const s32 tile0 = core::s32_max(core::floor32(yMin), 0) >> SOFTWARE_DRIVER_2_TILE_HEIGHT_LOG2;
+	const s32 tile1 = core::s32_max(core::ceil32(yMax), 0) >> SOFTWARE_DRIVER_2_TILE_HEIGHT_LOG2;
+
+	if ((u32)(tile1 - tile0) + 1 >= WorkerCount)
+	{
+		for (u32 w=0; w != WorkerCount; ++w)
+			Bins[w].push_back(index);
+	}
+	else
+	{
+		for (s32 t=tile0; t <= tile1; ++t)
+			Bins[t % WorkerCount].push_back(index);
+	}
+
+	if (Vertices.size() >= SOFTWARE_DRIVER_2_TILE_TRIANGLE_BUDGET * 3)
+		flush();
+}
+
+
+//! queues a texture change
+void CBurningTileRasterizer::addTexture(u32 shader, u32 stage, video::CSoftwareTexture2* texture, s32 lodLevel)
+{
+	SCommand cmd;
+	cmd.Type = ECMD_TEXTURE;
+	cmd.Shader = shader;
+	cmd.Stage = stage;
+	cmd.Index = Textures.size();
+	cmd.Value = lodLevel;
+
+	// keep the texture alive until it is rasterized
+	if (texture)
+		texture->grab();
+	Textures.push_back(texture);
+
+	addState(cmd);
+}
+
+
+//! queues a shader parameter
+void CBurningTileRasterizer::addParam(u32 shader, u32 index, f32 value)
+{
+	SCommand cmd;
+	cmd.Type = ECMD_PARAM;
+	cmd.Shader = shader;
+	cmd.Stage = index;
+	cmd.Param = value;
+	addState(cmd);
+}
+
+
+//! queues a z compare function
+void CBurningTileRasterizer::addZCompareFunc(u32 shader, u32 func)
+{
+	SCommand cmd;
+	cmd.Type = ECMD_ZCOMPARE_FUNC;
+	cmd.Shader = shader;
+	cmd.Value = func;
+	addState(cmd);
+}
+
+
+//! queues a material
+void CBurningTileRasterizer::addMaterial(u32 shader, const SBurningShaderMaterial& material)
+{
+	SCommand cmd;
+	cmd.Type = ECMD_MATERIAL;
+	cmd.Shader = shader;
+	cmd.Index = Materials.size();
+	Materials.push_back(material);
+	addState(cmd);
+}
+
+
+//! adds a state change to the queue of every worker
+void CBurningTileRasterizer::addState(const SCommand& cmd)
+{
+	const u32 index = Commands.size();
+	Commands.push_back(cmd);
+
+	for (u32 w=0; w != WorkerCount; ++w)
+		Bins[w].push_back(index);
+}
+
+
+//! rasterizes all queued triangles and waits until they are finished
+void CBurningTileRasterizer::flush()
+{
+	if (Commands.empty())
+		return;
+
+	// each worker has to see every state change, also when it got no triangle
+	Jobs->parallelFor(WorkerCount, renderWorkerJob, this);
+
+	for (u32 i=0; i != Textures.size(); ++i)
+	{
+		if (Textures[i])
+			Textures[i]->drop();
+	}
+
+	for (u32 w=0; w != WorkerCount; ++w)
+		Bins[w].set_used(0);
+
+	Commands.set_used(0);
+	Vertices.set_used(0);
+	Textures.set_used(0);
+	Materials.clear();
+}
+
+
+void CBurningTileRasterizer::renderWorkerJob(void* userData, u32 index, u32 workerIndex)
+{
+	((CBurningTileRasterizer*) userData)->renderWorker(index);
+}
+
+
+//! replays the queue of one worker
+void CBurningTileRasterizer::renderWorker(u32 worker)
+{
+	IBurningShader** shaders = &Shaders[worker * ETR2_COUNT];
+	const core::array<u32>& bin = Bins[worker];
+
+	for (u32 i=0; i != bin.size(); ++i)
+	{
+		const SCommand& cmd = Commands[bin[i]];
+		IBurningShader* shader = shaders[cmd.Shader];
+
+		switch (cmd.Type)
+		{
+			case ECMD_TRIANGLE:
+			{
+				const s4DVertex* v = &Vertices[cmd.Index];
+				shader->drawTriangle(v + 0, v + 1, v + 2);
+			} break;
+			case ECMD_TEXTURE:
+				shader->setTextureParam(cmd.Stage, Textures[cmd.Index], cmd.Value);
+				break;
+			case ECMD_PARAM:
+				shader->setParam(cmd.Stage, cmd.Param);
+				break;
+			case ECMD_ZCOMPARE_FUNC:
+				shader->setZCompareFunc(cmd.Value);
+				break;
+			case ECMD_MATERIAL:
+				shader->setMaterial(Materials[cmd.Index]);
+				break;
+		}
+	}
+}
+
+
+} // end namespace video
+} // end namespace irr
+
+#endif // _IRR_COMPILE_WITH_BURNINGSVIDEO_
+
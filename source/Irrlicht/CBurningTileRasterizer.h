@@ -0,0 +1,102 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt / Thomas Alten
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_BURNING_TILE_RASTERIZER_H_INCLUDED__
+#define __C_BURNING_TILE_RASTERIZER_H_INCLUDED__
+
+#include "IBurningShader.h"
+#include "IJobSystem.h"
+
+namespace irr
+{
+namespace video
+{
+
+	//! Rasterizes the triangles of Burning's Video on several threads.
+	/** The driver draws into recorder shaders, which only queue their state
+	changes and triangles. On flush every queued triangle is binned into the
+	scanline tiles it touches. Tile i belongs to worker i % workerCount, and
+	every worker replays the queue with its own set of shader instances,
+	skipping triangles outside its tiles and scanlines outside its tiles.
+	As each pixel is still computed by the same code in the same triangle
+	order, the image is bit-identical to the single threaded rasterizer.
+	There is one worker per worker of the job system. */
+	class CBurningTileRasterizer : public virtual IReferenceCounted
+	{
+	public:
+
+		//! constructor
+		CBurningTileRasterizer(CBurningVideoDriver* driver, IJobSystem* jobSystem);
+
+		//! destructor
+		virtual ~CBurningTileRasterizer();
+
+		//! returns a shader which queues into this rasterizer, 0 if the shader can't be tiled
+		IBurningShader* createRecorder(EBurningFFShader type);
+
+		//! rasterizes all queued triangles and waits until they are finished
+		void flush();
+
+	private:
+
+		friend class CBurningShaderRecorder;
+
+		enum ECommand
+		{
+			ECMD_TRIANGLE = 0,
+			ECMD_TEXTURE,
+			ECMD_PARAM,
+			ECMD_ZCOMPARE_FUNC,
+			ECMD_MATERIAL
+		};
+
+		struct SCommand
+		{
+			u16 Type;
+			u16 Shader;
+			u32 Stage;	// texture stage, parameter index
+			u32 Index;	// first vertex, texture or material
+			s32 Value;	// lod level, compare function
+			f32 Param;
+		};
+
+		// called by the recorders
+		void setRenderTarget(video::IImage* surface, const core::rect<s32>& viewPort);
+		void addTriangle(u32 shader, const s4DVertex *a, const s4DVertex *b, const s4DVertex *c);
+		void addTexture(u32 shader, u32 stage, video::CSoftwareTexture2* texture, s32 lodLevel);
+		void addParam(u32 shader, u32 index, f32 value);
+		void addZCompareFunc(u32 shader, u32 func);
+		void addMaterial(u32 shader, const SBurningShaderMaterial& material);
+
+		//! adds a state change to the queue of every worker
+		void addState(const SCommand& cmd);
+
+		//! replays the queue of one worker
+		void renderWorker(u32 worker);
+		static void renderWorkerJob(void* userData, u32 index, u32 workerIndex);
+
+		CBurningVideoDriver* Driver;
+		IJobSystem* Jobs;
+		u32 WorkerCount;
+
+		video::CImage* RenderTarget;
+		core::rect<s32> ViewPort;
+
+		// shader instances of the workers, WorkerCount * ETR2_COUNT
+		core::array<IBurningShader*> Shaders;
+
+		core::array<SCommand> Commands;
+		core::array<s4DVertex> Vertices;
+		core::array<video::CSoftwareTexture2*> Textures;
+		core::array<SBurningShaderMaterial> Materials;
+
+		// command indices per worker
+		core::array< core::array<u32> > Bins;
+	};
+
+} // end namespace video
+} // end namespace irr
+
+#endif
+
@@ -0,0 +1,343 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CClusteredLightManager.h"
+#include "ISceneManager.h"
+#include "ILightSceneNode.h"
+#include "ICameraSceneNode.h"
+#include "IVideoDriver.h"
+#include "CProfiler.h"
+
+namespace irr
+{
+namespace scene
+{
+
+namespace
+{
+	//! maps a normalized device coordinate to a tile
+	inline u32 getTile(f32 ndc, u32 tiles)
+	{
+		const f32 t = (ndc * 0.5f + 0.5f) * tiles;
+		if (t <= 0.f)
+			return 0;
+		if (t >= (f32)tiles)
+			return tiles - 1;
+		return (u32)t;
+	}
+
+	//! squared distance of a point to a box
+	inline f32 getDistanceSQ(const core::aabbox3d<f32>& box, const core::vector3df& p)
+	{
+		const core::vector3df d(
+			core::max_(box.MinEdge.X - p.X, 0.f, p.X - box.MaxEdge.X),
+			core::max_(box.MinEdge.Y - p.Y, 0.f, p.Y - box.MaxEdge.Y),
+			core::max_(box.MinEdge.Z - p.Z, 0.f, p.Z - box.MaxEdge.Z));
+		return d.getLengthSQ();
+	}
+}
+
+
+//! constructor
+CClusteredLightManager::CClusteredLightManager(ISceneManager* sceneManager,
+		u32 tilesX, u32 tilesY, u32 slices)
+: SceneManager(sceneManager), Near(1.f), Far(3000.f), SliceScale(1.f),
+	TilesX(core::max_(tilesX, 1u)), TilesY(core::max_(tilesY, 1u)), Slices(core::max_(slices, 1u)),
+	MaxLights(0), Stamp(0), HasCamera(false), Orthogonal(false), LightsCreated(false)
+{
+	#ifdef _DEBUG
+	setDebugName("CClusteredLightManager");
+	#endif
+
+	ProjectionX[0] = ProjectionX[1] = 0.f;
+	ProjectionY[0] = ProjectionY[1] = 0.f;
+}
+
+
+//! Bins the lights into the clusters
+void CClusteredLightManager::OnPreRender(core::array<ISceneNode*> & lightList)
+{
+	_IRR_PROFILE("lights: cluster");
+
+	LightsCreated = false;
+	EnabledLights.set_used(0);
+
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+	MaxLights = driver ? driver->getMaximalDynamicLightAmount() : 0;
+
+	// only point and spot lights are managed, directional lights reach everything
+	Lights.set_used(0);
+	for (u32 i=0; i<lightList.size(); ++i)
+	{
+		if (lightList[i]->getType() != ESNT_LIGHT)
+			continue;
+
+		ILightSceneNode* light = static_cast<ILightSceneNode*>(lightList[i]);
+		if (light->getLightType() == video::ELT_DIRECTIONAL)
+			continue;
+
+		SLightEntry e;
+		e.Node = light;
+		e.Position = light->getAbsolutePosition();
+		e.Radius = light->getRadius();
+		e.Stamp = Stamp;
+		e.On = true;
+		Lights.push_back(e);
+	}
+
+	const ICameraSceneNode* camera = SceneManager->getActiveCamera();
+	HasCamera = camera != 0;
+	if (!HasCamera || Lights.empty())
+		return;
+
+	View = camera->getViewMatrix();
+	const core::matrix4& projection = camera->getProjectionMatrix();
+	Orthogonal = camera->isOrthogonal();
+	ProjectionX[0] = projection[0];
+	ProjectionX[1] = Orthogonal ? projection[12] : projection[8];
+	ProjectionY[0] = projection[5];
+	ProjectionY[1] = Orthogonal ? projection[13] : projection[9];
+	Near = core::max_(camera->getNearValue(), 0.001f);
+	Far = core::max_(camera->getFarValue(), Near * 1.01f);
+	SliceScale = Orthogonal ? Slices / (Far - Near) : Slices / logf(Far / Near);
+
+	// count the lights per cluster
+	const u32 clusterCount = TilesX * TilesY * Slices;
+	ClusterOffsets.set_used(clusterCount + 1);
+	for (u32 c=0; c<=clusterCount; ++c)
+		ClusterOffsets[c] = 0;
+
+	LightRanges.set_used(Lights.size() * 6);
+	for (u32 i=0; i<Lights.size(); ++i)
+	{
+		const SLightEntry& e = Lights[i];
+		core::vector3df center;
+		View.transformVect(center, e.Position);
+		const core::aabbox3d<f32> viewBox(center.X - e.Radius, center.Y - e.Radius, center.Z - e.Radius,
+			center.X + e.Radius, center.Y + e.Radius, center.Z + e.Radius);
+
+		u32* r = &LightRanges[i * 6];
+		if (!getClusterRange(viewBox, r))
+		{
+			// empty range, the light is behind the camera
+			r[0] = 1;
+			r[1] = 0;
+			continue;
+		}
+
+		for (u32 z=r[4]; z<=r[5]; ++z)
+			for (u32 y=r[2]; y<=r[3]; ++y)
+				for (u32 x=r[0]; x<=r[1]; ++x)
+					++ClusterOffsets[(z * TilesY + y) * TilesX + x];
+	}
+
+	// prefix sum, then fill backwards so each offset ends up at the start of its cluster
+	for (u32 c=1; c<=clusterCount; ++c)
+		ClusterOffsets[c] += ClusterOffsets[c-1];
+	ClusterLights.set_used(ClusterOffsets[clusterCount]);
+
+	for (s32 i=(s32)Lights.size()-1; i>=0; --i)
+	{
+		const u32* r = &LightRanges[i * 6];
+		for (u32 z=r[4]; z<=r[5] && r[0]<=r[1]; ++z)
+			for (u32 y=r[2]; y<=r[3]; ++y)
+				for (u32 x=r[0]; x<=r[1]; ++x)
+					ClusterLights[--ClusterOffsets[(z * TilesY + y) * TilesX + x]] = (u32)i;
+	}
+}
+
+
+//! Switches all lights on again
+void CClusteredLightManager::OnPostRender(void)
+{
+	// lights which stay off would not register themselves next frame
+	for (u32 i=0; i<Lights.size(); ++i)
+		setLightOn(i, true);
+
+	Lights.set_used(0);
+	EnabledLights.set_used(0);
+	LightsCreated = false;
+}
+
+
+void CClusteredLightManager::OnRenderPassPreRender(E_SCENE_NODE_RENDER_PASS renderPass)
+{
+}
+
+
+//! Switches the local lights off after they have been created
+void CClusteredLightManager::OnRenderPassPostRender(E_SCENE_NODE_RENDER_PASS renderPass)
+{
+	if (renderPass != ESNRP_LIGHT)
+		return;
+
+	// the lights have their driver lights now, each node switches on what it needs
+	for (u32 i=0; i<Lights.size(); ++i)
+		setLightOn(i, false);
+
+	LightsCreated = true;
+}
+
+
+//! Switches on the lights which reach the node
+void CClusteredLightManager::OnNodePreRender(ISceneNode* node)
+{
+	if (!LightsCreated || Lights.empty())
+		return;
+
+	const core::aabbox3d<f32> box = node->getTransformedBoundingBox();
+
+	// collect the lights intersecting the box, once each
+	++Stamp;
+	Candidates.set_used(0);
+	CandidateDistances.set_used(0);
+
+	if (HasCamera)
+	{
+		core::aabbox3d<f32> viewBox(box);
+		View.transformBoxEx(viewBox);
+
+		u32 r[6];
+		if (getClusterRange(viewBox, r))
+		{
+			for (u32 z=r[4]; z<=r[5]; ++z)
+				for (u32 y=r[2]; y<=r[3]; ++y)
+					for (u32 x=r[0]; x<=r[1]; ++x)
+					{
+						const u32 c = (z * TilesY + y) * TilesX + x;
+						for (u32 j=ClusterOffsets[c]; j<ClusterOffsets[c+1]; ++j)
+						{
+							SLightEntry& e = Lights[ClusterLights[j]];
+							if (e.Stamp == Stamp)
+								continue;
+							e.Stamp = Stamp;
+
+							const f32 d = getDistanceSQ(box, e.Position);
+							if (d <= e.Radius * e.Radius)
+							{
+								Candidates.push_back(ClusterLights[j]);
+								CandidateDistances.push_back(d);
+							}
+						}
+					}
+		}
+	}
+	else
+	{
+		for (u32 i=0; i<Lights.size(); ++i)
+		{
+			const f32 d = getDistanceSQ(box, Lights[i].Position);
+			if (d <= Lights[i].Radius * Lights[i].Radius)
+			{
+				Candidates.push_back(i);
+				CandidateDistances.push_back(d);
+			}
+		}
+	}
+
+	// keep the nearest lights if the driver can't enable all of them
+	if (MaxLights && Candidates.size() > MaxLights)
+	{
+		for (u32 k=0; k<MaxLights; ++k)
+		{
+			u32 best = k;
+			for (u32 j=k+1; j<Candidates.size(); ++j)
+				if (CandidateDistances[j] < CandidateDistances[best])
+					best = j;
+			core::swap(Candidates[k], Candidates[best]);
+			core::swap(CandidateDistances[k], CandidateDistances[best]);
+		}
+		Candidates.set_used(MaxLights);
+	}
+
+	// switch off the lights of the previous node first, so their hardware lights are free again
+	++Stamp;
+	for (u32 i=0; i<Candidates.size(); ++i)
+		Lights[Candidates[i]].Stamp = Stamp;
+
+	for (u32 i=0; i<EnabledLights.size(); ++i)
+		if (Lights[EnabledLights[i]].Stamp != Stamp)
+			setLightOn(EnabledLights[i], false);
+
+	EnabledLights.set_used(0);
+	for (u32 i=0; i<Candidates.size(); ++i)
+	{
+		setLightOn(Candidates[i], true);
+		EnabledLights.push_back(Candidates[i]);
+	}
+}
+
+
+void CClusteredLightManager::OnNodePostRender(ISceneNode* node)
+{
+}
+
+
+//! computes the cluster range of a view space box, false if it is behind the camera
+bool CClusteredLightManager::getClusterRange(const core::aabbox3d<f32>& viewBox, u32* range) const
+{
+	f32 x0, x1, y0, y1;
+	if (Orthogonal)
+	{
+		x0 = ProjectionX[0] * viewBox.MinEdge.X + ProjectionX[1];
+		x1 = ProjectionX[0] * viewBox.MaxEdge.X + ProjectionX[1];
+		y0 = ProjectionY[0] * viewBox.MinEdge.Y + ProjectionY[1];
+		y1 = ProjectionY[0] * viewBox.MaxEdge.Y + ProjectionY[1];
+	}
+	else
+	{
+		if (viewBox.MaxEdge.Z < Near)
+			return false;
+
+		// x/z is monotonic in z, so the extremes are at the nearest or farthest depth
+		const f32 zMin = 1.f / core::max_(viewBox.MinEdge.Z, Near);
+		const f32 zMax = 1.f / viewBox.MaxEdge.Z;
+		x0 = ProjectionX[0] * core::min_(viewBox.MinEdge.X * zMin, viewBox.MinEdge.X * zMax) + ProjectionX[1];
+		x1 = ProjectionX[0] * core::max_(viewBox.MaxEdge.X * zMin, viewBox.MaxEdge.X * zMax) + ProjectionX[1];
+		y0 = ProjectionY[0] * core::min_(viewBox.MinEdge.Y * zMin, viewBox.MinEdge.Y * zMax) + ProjectionY[1];
+		y1 = ProjectionY[0] * core::max_(viewBox.MaxEdge.Y * zMin, viewBox.MaxEdge.Y * zMax) + ProjectionY[1];
+	}
+
+	// a mirrored projection swaps the extremes
+	if (x0 > x1)
+		core::swap(x0, x1);
+	if (y0 > y1)
+		core::swap(y0, y1);
+
+	range[0] = getTile(x0, TilesX);
+	range[1] = getTile(x1, TilesX);
+	range[2] = getTile(y0, TilesY);
+	range[3] = getTile(y1, TilesY);
+	range[4] = getSlice(viewBox.MinEdge.Z);
+	range[5] = getSlice(viewBox.MaxEdge.Z);
+	return true;
+}
+
+
+//! returns the depth slice of a view space depth
+u32 CClusteredLightManager::getSlice(f32 z) const
+{
+	if (z <= Near)
+		return 0;
+
+	const f32 s = Orthogonal ? (z - Near) * SliceScale : logf(z / Near) * SliceScale;
+	return s < (f32)Slices ? (u32)s : Slices - 1;
+}
+
+
+//! switches a local light on or off
+void CClusteredLightManager::setLightOn(u32 index, bool on)
+{
+	SLightEntry& e = Lights[index];
+	if (e.On != on)
+	{
+		e.Node->setVisible(on);
+		e.On = on;
+	}
+}
+
+
+} // end namespace scene
+} // end namespace irr
+
@@ -0,0 +1,102 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_CLUSTERED_LIGHT_MANAGER_H_INCLUDED__
+#define __C_CLUSTERED_LIGHT_MANAGER_H_INCLUDED__
+
+#include "ISceneManager.h"
+#include "ILightManager.h"
+#include "matrix4.h"
+
+namespace irr
+{
+namespace scene
+{
+	class ILightSceneNode;
+
+	//! Light manager which enables only the lights reaching the node being rendered
+	/** The view frustum is split into a grid of clusters, screen tiles
+	times depth slices which grow exponentially with the distance. Each
+	frame the point and spot lights are binned into the clusters their
+	sphere of influence touches. Before a node is rendered the lights of
+	the clusters covered by its bounding box are tested against the box,
+	and the nearest of the intersecting ones are switched on, up to the
+	number of dynamic lights the driver supports. Directional lights stay
+	on for all nodes. */
+	class CClusteredLightManager : public ILightManager
+	{
+	public:
+
+		//! constructor
+		CClusteredLightManager(ISceneManager* sceneManager, u32 tilesX, u32 tilesY, u32 slices);
+
+		//! Bins the lights into the clusters
+		virtual void OnPreRender(core::array<ISceneNode*> & lightList);
+
+		//! Switches all lights on again
+		virtual void OnPostRender(void);
+
+		//! Switches the local lights off after they have been created
+		virtual void OnRenderPassPreRender(E_SCENE_NODE_RENDER_PASS renderPass);
+
+		//! Switches the local lights off after they have been created
+		virtual void OnRenderPassPostRender(E_SCENE_NODE_RENDER_PASS renderPass);
+
+		//! Switches on the lights which reach the node
+		virtual void OnNodePreRender(ISceneNode* node);
+
+		//! Does nothing, the next node switches its lights
+		virtual void OnNodePostRender(ISceneNode* node);
+
+	private:
+
+		struct SLightEntry
+		{
+			ILightSceneNode* Node;
+			core::vector3df Position;
+			f32 Radius;
+			u32 Stamp;
+			bool On;
+		};
+
+		//! computes the cluster range of a view space box, false if it is behind the camera
+		bool getClusterRange(const core::aabbox3d<f32>& viewBox, u32* range) const;
+
+		//! returns the depth slice of a view space depth
+		u32 getSlice(f32 z) const;
+
+		//! switches a local light on or off
+		void setLightOn(u32 index, bool on);
+
+		ISceneManager* SceneManager;
+
+		core::array<SLightEntry> Lights;
+		core::array<u32> LightRanges;
+		core::array<u32> ClusterOffsets;
+		core::array<u32> ClusterLights;
+		core::array<u32> Candidates;
+		core::array<f32> CandidateDistances;
+		core::array<u32> EnabledLights;
+
+		core::matrix4 View;
+		f32 ProjectionX[2];
+		f32 ProjectionY[2];
+		f32 Near;
+		f32 Far;
+		f32 SliceScale;
+		u32 TilesX;
+		u32 TilesY;
+		u32 Slices;
+		u32 MaxLights;
+		u32 Stamp;
+		bool HasCamera;
+		bool Orthogonal;
+		bool LightsCreated;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
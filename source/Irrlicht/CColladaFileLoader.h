@@ -195,6 +195,9 @@ public:
 	//! See IReferenceCounted::drop() for more information.
 	virtual IAnimatedMesh* createMesh(io::IReadFile* file);
 
+	//! the loader adds nodes to the scene and meshes to the mesh cache
+	virtual bool isLoadableOnWorkerThread() const { return false; }
+
 private:
 
 	//! skips an (unknown) section in the collada document
@@ -699,6 +699,20 @@ video::ITexture* CD3D8Driver::createDeviceDependentTexture(IImage* surface,const
 }
 
 
+//! replaces the content of a texture created by createDeviceDependentTexture
+bool CD3D8Driver::replaceTextureImage(ITexture* texture, IImage* image)
+{
+	// the stages must not keep the released Direct3D texture
+	for (u32 i=0; i<MATERIAL_MAX_TEXTURES; ++i)
+	{
+		if (CurrentTexture[i] == texture)
+			setActiveTexture(i, 0);
+	}
+
+	return static_cast<CD3D8Texture*>(texture)->replaceImage(image, TextureCreationFlags);
+}
+
+
 //! Enables or disables a texture creation flag.
 void CD3D8Driver::setTextureCreationFlag(E_TEXTURE_CREATION_FLAG flag,
 		bool enabled)
@@ -80,6 +80,29 @@ HasMipMaps(false), IsRenderTarget(false)
 }
 
 
+//! replaces the image of the texture
+bool CD3D8Texture::replaceImage(IImage* image, u32 flags)
+{
+	if (Texture)
+	{
+		Texture->Release();
+		Texture = 0;
+	}
+
+	HasMipMaps = Driver->getTextureCreationFlag(video::ETCF_CREATE_MIP_MAPS);
+
+	if (!createTexture(flags, image))
+	{
+		os::Printer::log("Could not create DIRECT3D8 Texture.", ELL_WARNING);
+		return false;
+	}
+
+	if (copyTexture(image))
+		regenerateMipMapLevels(0);
+	return true;
+}
+
+
 //! destructor
 CD3D8Texture::~CD3D8Texture()
 {
@@ -37,6 +37,9 @@ public:
 	//! destructor
 	virtual ~CD3D8Texture();
 
+	//! replaces the image of the texture
+	bool replaceImage(IImage* image, u32 flags);
+
 	//! lock function
 	virtual void* lock(E_TEXTURE_LOCK_MODE mode=ETLM_READ_WRITE, u32 mipmapLevel=0);
 
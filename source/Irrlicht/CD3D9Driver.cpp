@@ -8,6 +8,7 @@
 #ifdef _IRR_COMPILE_WITH_DIRECT3D_9_
 
 #include "os.h"
+#include "CProfiler.h"
 #include "S3DVertex.h"
 #include "CD3D9Texture.h"
 #include "CD3D9MaterialRenderer.h"
@@ -779,6 +780,20 @@ video::ITexture* CD3D9Driver::createDeviceDependentTexture(IImage* surface,const
 }
 
 
+//! replaces the content of a texture created by createDeviceDependentTexture
+bool CD3D9Driver::replaceTextureImage(ITexture* texture, IImage* image)
+{
+	// the stages must not keep the released Direct3D texture
+	for (u32 i=0; i<MATERIAL_MAX_TEXTURES; ++i)
+	{
+		if (CurrentTexture[i] == texture)
+			setActiveTexture(i, 0);
+	}
+
+	return static_cast<CD3D9Texture*>(texture)->replaceImage(image, TextureCreationFlags);
+}
+
+
 //! Enables or disables a texture creation flag.
 void CD3D9Driver::setTextureCreationFlag(E_TEXTURE_CREATION_FLAG flag,
 		bool enabled)
@@ -1270,6 +1285,8 @@ void CD3D9Driver::drawHardwareBuffer(SHWBufferLink *_HWBuffer)
 	if (!_HWBuffer)
 		return;
 
+	_IRR_PROFILE("driver: drawHardwareBuffer");
+
 	SHWBufferLink_d3d9 *HWBuffer=(SHWBufferLink_d3d9*)_HWBuffer;
 
 	updateHardwareBuffer(HWBuffer); //check if update is needed
@@ -1402,6 +1419,8 @@ void CD3D9Driver::drawVertexPrimitiveList(const void* vertices,
 	if (!checkPrimitiveCount(primitiveCount))
 		return;
 
+	_IRR_PROFILE("driver: drawVertexPrimitiveList");
+
 	CNullDriver::drawVertexPrimitiveList(vertices, vertexCount, indexList, primitiveCount, vType, pType,iType);
 
 	if (!vertexCount || !primitiveCount)
@@ -80,6 +80,29 @@ CD3D9Texture::CD3D9Texture(IImage* image, CD3D9Driver* driver,
 }
 
 
+//! replaces the image of the texture
+bool CD3D9Texture::replaceImage(IImage* image, u32 flags)
+{
+	if (Texture)
+	{
+		Texture->Release();
+		Texture = 0;
+	}
+
+	HasMipMaps = Driver->getTextureCreationFlag(video::ETCF_CREATE_MIP_MAPS);
+
+	if (!createTexture(flags, image))
+	{
+		os::Printer::log("Could not create DIRECT3D9 Texture.", ELL_WARNING);
+		return false;
+	}
+
+	if (copyTexture(image))
+		regenerateMipMapLevels(0);
+	return true;
+}
+
+
 //! destructor
 CD3D9Texture::~CD3D9Texture()
 {
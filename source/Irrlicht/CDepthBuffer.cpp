@@ -16,7 +16,7 @@ namespace video
 
 //! constructor
 CDepthBuffer::CDepthBuffer(const core::dimension2d<u32>& size)
-: Buffer(0), Size(0,0)
+: Buffer(0), Size(0,0), TileCountX(0), TileCountY(0), GroupCountX(0), GroupCountY(0)
 {
 	#ifdef _DEBUG
 	setDebugName("CDepthBuffer");
@@ -50,6 +50,15 @@ void CDepthBuffer::clear()
 	zMaxValue = IR(zMax);
 
 	memset32 ( Buffer, zMaxValue, TotalSize );
+
+#ifdef SOFTWARE_DRIVER_2_HIERARCHICAL_Z
+	for (u32 i=0; i != TileDepth.size(); ++i)
+		TileDepth[i] = zMax;
+	for (u32 i=0; i != GroupDepth.size(); ++i)
+		GroupDepth[i] = zMax;
+	memset(TileDirty.pointer(), 0, TileDirty.size());
+	memset(GroupDirty.pointer(), 0, GroupDirty.size());
+#endif
 }
 
 
@@ -68,6 +77,22 @@ void CDepthBuffer::setSize(const core::dimension2d<u32>& size)
 	Pitch = size.Width * sizeof ( fp24 );
 	TotalSize = Pitch * size.Height;
 	Buffer = new u8[TotalSize];
+
+#ifdef SOFTWARE_DRIVER_2_HIERARCHICAL_Z
+	const u32 tileSize = 1 << SOFTWARE_DRIVER_2_HIERARCHICAL_Z_TILE_LOG2;
+	const u32 groupSize = 1 << SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2;
+
+	TileCountX = ( size.Width + tileSize - 1 ) >> SOFTWARE_DRIVER_2_HIERARCHICAL_Z_TILE_LOG2;
+	TileCountY = ( size.Height + tileSize - 1 ) >> SOFTWARE_DRIVER_2_HIERARCHICAL_Z_TILE_LOG2;
+	GroupCountX = ( TileCountX + groupSize - 1 ) >> SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2;
+	GroupCountY = ( TileCountY + groupSize - 1 ) >> SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2;
+
+	TileDepth.set_used(TileCountX * TileCountY);
+	TileDirty.set_used(TileCountX * TileCountY);
+	GroupDepth.set_used(GroupCountX * GroupCountY);
+	GroupDirty.set_used(GroupCountX * GroupCountY);
+#endif
+
 	clear ();
 }
 
@@ -79,6 +104,257 @@ const core::dimension2d<u32>& CDepthBuffer::getSize() const
 	return Size;
 }
 
+
+
+//! clips area to the buffer and converts it to an inclusive tile range
+bool CDepthBuffer::getTileRange(const core::rect<s32>& area, s32& x0, s32& y0, s32& x1, s32& y1) const
+{
+	x0 = core::s32_max(area.UpperLeftCorner.X, 0);
+	y0 = core::s32_max(area.UpperLeftCorner.Y, 0);
+	x1 = core::s32_min(area.LowerRightCorner.X, Size.Width) - 1;
+	y1 = core::s32_min(area.LowerRightCorner.Y, Size.Height) - 1;
+
+	if (x1 < x0 || y1 < y0)
+		return false;
+
+	x0 >>= SOFTWARE_DRIVER_2_HIERARCHICAL_Z_TILE_LOG2;
+	y0 >>= SOFTWARE_DRIVER_2_HIERARCHICAL_Z_TILE_LOG2;
+	x1 >>= SOFTWARE_DRIVER_2_HIERARCHICAL_Z_TILE_LOG2;
+	y1 >>= SOFTWARE_DRIVER_2_HIERARCHICAL_Z_TILE_LOG2;
+	return true;
+}
+
+
+
+//! recomputes the farthest depth of a tile
+void CDepthBuffer::refreshTile(u32 tx, u32 ty)
+{
+	const u32 x0 = tx << SOFTWARE_DRIVER_2_HIERARCHICAL_Z_TILE_LOG2;
+	const u32 y0 = ty << SOFTWARE_DRIVER_2_HIERARCHICAL_Z_TILE_LOG2;
+	const u32 x1 = core::min_(x0 + (1 << SOFTWARE_DRIVER_2_HIERARCHICAL_Z_TILE_LOG2), Size.Width);
+	const u32 y1 = core::min_(y0 + (1 << SOFTWARE_DRIVER_2_HIERARCHICAL_Z_TILE_LOG2), Size.Height);
+
+	const fp24* z = (fp24*) ( Buffer + y0 * Pitch );
+	f32 depth = z[x0];
+
+	for (u32 y=y0; y != y1; ++y)
+	{
+		for (u32 x=x0; x != x1; ++x)
+		{
+			if (z[x] < depth)
+				depth = z[x];
+		}
+		z = (fp24*) ( (u8*) z + Pitch );
+	}
+
+	const u32 tile = ty * TileCountX + tx;
+	TileDepth[tile] = depth;
+	TileDirty[tile] = 0;
+}
+
+
+
+//! marks the pixels in area as written
+void CDepthBuffer::markDirty(const core::rect<s32>& area)
+{
+#ifdef SOFTWARE_DRIVER_2_HIERARCHICAL_Z
+	s32 x0, y0, x1, y1;
+	if (!getTileRange(area, x0, y0, x1, y1))
+		return;
+
+	for (s32 ty=y0; ty <= y1; ++ty)
+		memset(&TileDirty[ty * TileCountX + x0], 1, x1 - x0 + 1);
+
+	x0 >>= SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2;
+	y0 >>= SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2;
+	x1 >>= SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2;
+	y1 >>= SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2;
+
+	for (s32 gy=y0; gy <= y1; ++gy)
+		memset(&GroupDirty[gy * GroupCountX + x0], 1, x1 - x0 + 1);
+#endif
+}
+
+
+
+//! returns true if every pixel in area stores a depth closer than w
+bool CDepthBuffer::isOccluded(const core::rect<s32>& area, f32 w)
+{
+#ifdef SOFTWARE_DRIVER_2_HIERARCHICAL_Z
+	s32 x0, y0, x1, y1;
+	if (!getTileRange(area, x0, y0, x1, y1))
+		return false;
+
+	const s32 gx0 = x0 >> SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2;
+	const s32 gy0 = y0 >> SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2;
+	const s32 gx1 = x1 >> SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2;
+	const s32 gy1 = y1 >> SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2;
+
+	for (s32 gy=gy0; gy <= gy1; ++gy)
+	{
+		for (s32 gx=gx0; gx <= gx1; ++gx)
+		{
+			const u32 group = gy * GroupCountX + gx;
+			if (!GroupDirty[group] && GroupDepth[group] > w)
+				continue;
+
+			// tiles of the group, and the part of them inside of area
+			const s32 groupX0 = gx << SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2;
+			const s32 groupY0 = gy << SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2;
+			const s32 groupX1 = core::s32_min(groupX0 + (1 << SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2), TileCountX) - 1;
+			const s32 groupY1 = core::s32_min(groupY0 + (1 << SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2), TileCountY) - 1;
+
+			const s32 tx0 = core::s32_max(x0, groupX0);
+			const s32 ty0 = core::s32_max(y0, groupY0);
+			const s32 tx1 = core::s32_min(x1, groupX1);
+			const s32 ty1 = core::s32_min(y1, groupY1);
+
+			f32 depth = FLT_MAX;
+			for (s32 ty=ty0; ty <= ty1; ++ty)
+			{
+				for (s32 tx=tx0; tx <= tx1; ++tx)
+				{
+					const u32 tile = ty * TileCountX + tx;
+					if (TileDirty[tile])
+						refreshTile(tx, ty);
+					if (TileDepth[tile] <= w)
+						return false;
+					depth = core::min_(depth, TileDepth[tile]);
+				}
+			}
+
+			// all tiles of a dirty group are up to date now
+			if (GroupDirty[group] && tx0 == groupX0 && ty0 == groupY0 && tx1 == groupX1 && ty1 == groupY1)
+			{
+				GroupDepth[group] = depth;
+				GroupDirty[group] = 0;
+			}
+		}
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+
+//! recomputes the farthest depth of a group from its tiles
+void CDepthBuffer::refreshGroup(u32 gx, u32 gy)
+{
+	const u32 x0 = gx << SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2;
+	const u32 y0 = gy << SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2;
+	const u32 x1 = core::min_(x0 + (1 << SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2), TileCountX);
+	const u32 y1 = core::min_(y0 + (1 << SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2), TileCountY);
+
+	f32 depth = FLT_MAX;
+	for (u32 ty=y0; ty != y1; ++ty)
+	{
+		const u32 row = ty * TileCountX;
+		for (u32 tx=x0; tx != x1; ++tx)
+		{
+			// a dirty tile might be closer than its value
+			if (TileDirty[row + tx])
+				return;
+			depth = core::min_(depth, TileDepth[row + tx]);
+		}
+	}
+
+	GroupDepth[gy * GroupCountX + gx] = depth;
+}
+
+
+
+//! raises the coarse depth of the tiles completely covered by a projected triangle
+void CDepthBuffer::updateTriangle(const s4DVertex* a, const s4DVertex* b, const s4DVertex* c)
+{
+#ifdef SOFTWARE_DRIVER_2_HIERARCHICAL_Z
+	const f32 area = ( b->Pos.x - a->Pos.x ) * ( c->Pos.y - a->Pos.y ) -
+					( c->Pos.x - a->Pos.x ) * ( b->Pos.y - a->Pos.y );
+	if ( core::iszero ( area ) )
+		return;
+
+	// edge functions, positive inside of the triangle
+	const s4DVertex* v[4] = { a, b, c, a };
+	const f32 orientation = area > 0.f ? 1.f : -1.f;
+	f32 edgeX[3], edgeY[3], edgeC[3];
+	for (u32 i=0; i != 3; ++i)
+	{
+		edgeX[i] = ( v[i]->Pos.y - v[i+1]->Pos.y ) * orientation;
+		edgeY[i] = ( v[i+1]->Pos.x - v[i]->Pos.x ) * orientation;
+		edgeC[i] = - edgeX[i] * v[i]->Pos.x - edgeY[i] * v[i]->Pos.y;
+	}
+
+	// tiles completely inside of the bounding box
+	const s32 tileSize = 1 << SOFTWARE_DRIVER_2_HIERARCHICAL_Z_TILE_LOG2;
+	s32 x0 = ( core::ceil32 ( core::min_ ( a->Pos.x, b->Pos.x, c->Pos.x ) ) + tileSize - 1 ) >> SOFTWARE_DRIVER_2_HIERARCHICAL_Z_TILE_LOG2;
+	s32 y0 = ( core::ceil32 ( core::min_ ( a->Pos.y, b->Pos.y, c->Pos.y ) ) + tileSize - 1 ) >> SOFTWARE_DRIVER_2_HIERARCHICAL_Z_TILE_LOG2;
+	s32 x1 = ( core::floor32 ( core::max_ ( a->Pos.x, b->Pos.x, c->Pos.x ) ) >> SOFTWARE_DRIVER_2_HIERARCHICAL_Z_TILE_LOG2 ) - 1;
+	s32 y1 = ( core::floor32 ( core::max_ ( a->Pos.y, b->Pos.y, c->Pos.y ) ) >> SOFTWARE_DRIVER_2_HIERARCHICAL_Z_TILE_LOG2 ) - 1;
+
+	x0 = core::s32_max ( x0, 0 );
+	y0 = core::s32_max ( y0, 0 );
+	x1 = core::s32_min ( x1, TileCountX - 1 );
+	y1 = core::s32_min ( y1, TileCountY - 1 );
+	if ( x1 < x0 || y1 < y0 )
+		return;
+
+	// farthest 1/w the triangle leaves behind. interpolation may step a little beyond the vertices
+	const f32 w = core::min_ ( a->Pos.w, b->Pos.w, c->Pos.w ) * 0.999f;
+
+	bool changed = false;
+	for (s32 ty=y0; ty <= y1; ++ty)
+	{
+		// test the tile grown by a pixel, which covers every sample the scanlines could take
+		const f32 py0 = (f32) ( ( ty << SOFTWARE_DRIVER_2_HIERARCHICAL_Z_TILE_LOG2 ) - 1 );
+		const f32 py1 = py0 + (f32) ( tileSize + 1 );
+
+		for (s32 tx=x0; tx <= x1; ++tx)
+		{
+			const f32 px0 = (f32) ( ( tx << SOFTWARE_DRIVER_2_HIERARCHICAL_Z_TILE_LOG2 ) - 1 );
+			const f32 px1 = px0 + (f32) ( tileSize + 1 );
+
+			u32 i;
+			for (i=0; i != 3; ++i)
+			{
+				// corner of the tile with the smallest edge function
+				const f32 e = edgeC[i] + edgeX[i] * ( edgeX[i] < 0.f ? px1 : px0 ) +
+								edgeY[i] * ( edgeY[i] < 0.f ? py1 : py0 );
+				if ( e <= 0.f )
+					break;
+			}
+			if ( i != 3 )
+				continue;
+
+			const u32 tile = ty * TileCountX + tx;
+			if ( !TileDirty[tile] && TileDepth[tile] < w )
+			{
+				TileDepth[tile] = w;
+				changed = true;
+			}
+		}
+	}
+
+	if ( !changed )
+		return;
+
+	x0 >>= SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2;
+	y0 >>= SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2;
+	x1 >>= SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2;
+	y1 >>= SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2;
+
+	for (s32 gy=y0; gy <= y1; ++gy)
+	{
+		for (s32 gx=x0; gx <= x1; ++gx)
+		{
+			if ( !GroupDirty[gy * GroupCountX + gx] && GroupDepth[gy * GroupCountX + gx] < w )
+				refreshGroup(gx, gy);
+		}
+	}
+#endif
+}
+
 // -----------------------------------------------------------------
 
 //! constructor
@@ -6,6 +6,7 @@
 #define __C_Z_BUFFER_H_INCLUDED__
 
 #include "IDepthBuffer.h"
+#include "irrArray.h"
 
 namespace irr
 {
@@ -40,13 +41,42 @@ namespace video
 		//! returns pitch of depthbuffer (in bytes)
 		virtual u32 getPitch() const { return Pitch; }
 
+		//! marks the pixels in area as written
+		virtual void markDirty(const core::rect<s32>& area);
+
+		//! returns true if every pixel in area stores a depth closer than w
+		virtual bool isOccluded(const core::rect<s32>& area, f32 w);
+
+		//! raises the coarse depth of the tiles completely covered by a projected triangle
+		virtual void updateTriangle(const s4DVertex* a, const s4DVertex* b, const s4DVertex* c);
+
 
 	private:
 
+		//! clips area to the buffer and converts it to an inclusive tile range
+		bool getTileRange(const core::rect<s32>& area, s32& x0, s32& y0, s32& x1, s32& y1) const;
+
+		//! recomputes the farthest depth of a tile
+		void refreshTile(u32 tx, u32 ty);
+
+		//! recomputes the farthest depth of a group from its tiles
+		void refreshGroup(u32 gx, u32 gy);
+
 		u8* Buffer;
 		core::dimension2d<u32> Size;
 		u32 TotalSize;
 		u32 Pitch;
+
+		// farthest depth of each tile and of each group of tiles. a lower bound of the
+		// stored 1/w, which stays valid as long as the shaders only write closer depths
+		core::array<f32> TileDepth;
+		core::array<u8> TileDirty;
+		core::array<f32> GroupDepth;
+		core::array<u8> GroupDirty;
+		u32 TileCountX;
+		u32 TileCountY;
+		u32 GroupCountX;
+		u32 GroupCountY;
 	};
 
 
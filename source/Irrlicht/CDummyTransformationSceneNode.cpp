@@ -45,6 +45,19 @@ core::matrix4 CDummyTransformationSceneNode::getRelativeTransformation() const
 	return RelativeTransformationMatrix;
 }
 
+
+//! Updates the absolute position based on the relative and the parents position
+void CDummyTransformationSceneNode::updateAbsolutePosition()
+{
+	if (RelativeTransformationMatrix != UpdatedTransformationMatrix)
+	{
+		UpdatedTransformationMatrix = RelativeTransformationMatrix;
+		setRelativeTransformationChanged();
+	}
+
+	IDummyTransformationSceneNode::updateAbsolutePosition();
+}
+
 //! Creates a clone of this scene node and its children.
 ISceneNode* CDummyTransformationSceneNode::clone(ISceneNode* newParent, ISceneManager* newManager)
 {
@@ -30,6 +30,9 @@ namespace scene
 		//! Returns the relative transformation of the scene node.
 		virtual core::matrix4 getRelativeTransformation() const;
 
+		//! Updates the absolute position based on the relative and the parents position
+		virtual void updateAbsolutePosition();
+
 		//! does nothing.
 		virtual void render() {}
 
@@ -52,6 +55,9 @@ namespace scene
 		virtual void setPosition(const core::vector3df& newpos);
 
 		core::matrix4 RelativeTransformationMatrix;
+		//! matrix of the last absolute position update, the reference
+		//! returned by getRelativeTransformationMatrix() may be written anytime
+		core::matrix4 UpdatedTransformationMatrix;
 		core::aabbox3d<f32> Box;
 	};
 
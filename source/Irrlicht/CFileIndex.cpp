@@ -0,0 +1,283 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CFileIndex.h"
+#include "IFileArchive.h"
+#include "IFileList.h"
+
+namespace irr
+{
+namespace io
+{
+
+namespace
+{
+	const u32 EmptySlot = 0xffffffff;
+	const u32 RemovedSlot = 0xfffffffe;
+
+	inline bool isSlash(fschar_t c)
+	{
+		return c == '/' || c == '\\';
+	}
+
+	//! the character as CFileList::findFile compares it
+	inline u32 normalize(fschar_t c)
+	{
+		return c == '\\' ? '/' : core::locale_lower((u32)c);
+	}
+
+	//! FNV-1a hash of a normalized name
+	u32 hashName(const fschar_t* name, u32 length)
+	{
+		u32 hash = 2166136261u;
+		for (u32 i=0; i<length; ++i)
+		{
+			hash ^= normalize(name[i]);
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	//! compares a name of a file list with a part of a searched name
+	bool equalNames(const path& entry, const fschar_t* name, u32 length)
+	{
+		if (entry.size() != length)
+			return false;
+
+		for (u32 i=0; i<length; ++i)
+		{
+			if (normalize(entry[i]) != normalize(name[i]))
+				return false;
+		}
+		return true;
+	}
+}
+
+
+//! constructor
+CFileIndex::CFileIndex()
+: Used(0), Live(0)
+{
+}
+
+
+//! adds the files of an archive
+void CFileIndex::addArchive(IFileArchive* archive, bool ignorePaths)
+{
+	// reuse the entry of a removed archive
+	u32 id = 0;
+	while (id < Archives.size() && Archives[id].Archive)
+		++id;
+	if (id == Archives.size())
+		Archives.push_back(SArchive());
+
+	SArchive& entry = Archives[id];
+	entry.Archive = archive;
+	entry.List = archive->getFileList();
+	entry.Position = FILE_INDEX_NOT_FOUND;
+	entry.IgnorePaths = ignorePaths;
+
+	const u32 count = entry.List->getFileCount();
+	reserve(count);
+
+	const u32 mask = Slots.size() - 1;
+	for (u32 i=0; i<count; ++i)
+	{
+		const path& name = entry.List->getFullFileName(i);
+		const u32 hash = hashName(name.c_str(), name.size());
+
+		u32 s = hash & mask;
+		while (Slots[s].Archive != EmptySlot)
+			s = (s + 1) & mask;
+
+		Slots[s].Hash = hash;
+		Slots[s].Archive = id;
+		Slots[s].File = i;
+	}
+	Used += count;
+	Live += count;
+}
+
+
+//! removes the files of an archive, does nothing if it is not indexed
+void CFileIndex::removeArchive(const IFileArchive* archive)
+{
+	u32 id = 0;
+	while (id < Archives.size() && Archives[id].Archive != archive)
+		++id;
+	if (id == Archives.size())
+		return;
+
+	SArchive& entry = Archives[id];
+	const u32 count = entry.List->getFileCount();
+	const u32 mask = Slots.size() - 1;
+	for (u32 i=0; i<count; ++i)
+	{
+		const path& name = entry.List->getFullFileName(i);
+		const u32 hash = hashName(name.c_str(), name.size());
+
+		for (u32 s = hash & mask; Slots[s].Archive != EmptySlot; s = (s + 1) & mask)
+		{
+			if (Slots[s].Archive == id && Slots[s].File == i)
+			{
+				Slots[s].Archive = RemovedSlot;
+				--Live;
+				break;
+			}
+		}
+	}
+
+	entry.Archive = 0;
+	entry.List = 0;
+
+	// without files the removed slots can go as well
+	if (!Live)
+	{
+		Slots.clear();
+		Used = 0;
+	}
+}
+
+
+//! sets the priority of the indexed archives
+void CFileIndex::setOrder(const core::array<IFileArchive*>& archives)
+{
+	Unindexed.set_used(0);
+	for (u32 id=0; id<Archives.size(); ++id)
+		Archives[id].Position = FILE_INDEX_NOT_FOUND;
+
+	for (u32 i=0; i<archives.size(); ++i)
+	{
+		u32 id = 0;
+		while (id < Archives.size() && Archives[id].Archive != archives[i])
+			++id;
+
+		if (id < Archives.size())
+			Archives[id].Position = i;
+		else
+			Unindexed.push_back(i);
+	}
+}
+
+
+//! finds a file in the indexed archives
+u32 CFileIndex::findFile(const path& filename, s32& fileIndex) const
+{
+	SMatch match;
+	match.List = 0;
+	match.Position = FILE_INDEX_NOT_FOUND;
+	match.File = -1;
+	match.Ambiguous = false;
+
+	fileIndex = -1;
+	if (!Live)
+		return match.Position;
+
+	// same normalization as CFileList::findFile, but without a copy
+	const fschar_t* name = filename.c_str();
+	u32 length = filename.size();
+	bool isDirectory = false;
+	if (length && isSlash(name[length-1]))
+	{
+		isDirectory = true;
+		--length;
+	}
+
+	u32 nameStart = length;
+	while (nameStart && !isSlash(name[nameStart-1]))
+		--nameStart;
+
+	// archives which ignore paths only know the name after the last slash
+	const u32 hash = hashName(name, length);
+	find(hash, name, length, isDirectory, false, match);
+	find(nameStart ? hashName(name + nameStart, length - nameStart) : hash,
+		name + nameStart, length - nameStart, isDirectory, true, match);
+
+	// Archives which ignore paths can have a name more than once, then
+	// the archive decides as before which of the files it returns.
+	fileIndex = match.Ambiguous ? match.List->findFile(filename) : match.File;
+	return match.Position;
+}
+
+
+//! searches the slots of one hash for a better match
+void CFileIndex::find(u32 hash, const fschar_t* name, u32 length, bool isDirectory,
+	bool ignorePaths, SMatch& match) const
+{
+	const u32 mask = Slots.size() - 1;
+	for (u32 s = hash & mask; Slots[s].Archive != EmptySlot; s = (s + 1) & mask)
+	{
+		const SSlot& slot = Slots[s];
+		if (slot.Hash != hash || slot.Archive == RemovedSlot)
+			continue;
+
+		// the archive with the smallest position wins
+		const SArchive& archive = Archives[slot.Archive];
+		if (archive.IgnorePaths != ignorePaths || archive.Position > match.Position)
+			continue;
+
+		if (archive.List->isDirectory(slot.File) != isDirectory ||
+			!equalNames(archive.List->getFullFileName(slot.File), name, length))
+			continue;
+
+		if (archive.Position == match.Position)
+		{
+			match.Ambiguous = true;
+			continue;
+		}
+
+		match.List = archive.List;
+		match.Position = archive.Position;
+		match.File = (s32)slot.File;
+		match.Ambiguous = false;
+	}
+}
+
+
+//! makes room for more files without a rehash
+void CFileIndex::reserve(u32 count)
+{
+	// at most half of the slots are used, so probing stops soon
+	if ((Used + count) * 2 <= Slots.size())
+		return;
+
+	u32 size = 16;
+	while (size < (Live + count) * 2)
+		size *= 2;
+	rehash(size);
+}
+
+
+//! rebuilds the table without the removed slots
+void CFileIndex::rehash(u32 size)
+{
+	core::array<SSlot> old;
+	old.swap(Slots);
+
+	SSlot empty;
+	empty.Hash = 0;
+	empty.Archive = EmptySlot;
+	empty.File = 0;
+	Slots.set_used(size);
+	for (u32 s=0; s<size; ++s)
+		Slots[s] = empty;
+
+	const u32 mask = size - 1;
+	for (u32 i=0; i<old.size(); ++i)
+	{
+		if (old[i].Archive == EmptySlot || old[i].Archive == RemovedSlot)
+			continue;
+
+		u32 s = old[i].Hash & mask;
+		while (Slots[s].Archive != EmptySlot)
+			s = (s + 1) & mask;
+		Slots[s] = old[i];
+	}
+	Used = Live;
+}
+
+
+} // end namespace io
+} // end namespace irr
+
@@ -0,0 +1,112 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_FILE_INDEX_H_INCLUDED__
+#define __C_FILE_INDEX_H_INCLUDED__
+
+#include "path.h"
+#include "irrArray.h"
+
+namespace irr
+{
+namespace io
+{
+	class IFileArchive;
+	class IFileList;
+
+	//! Returned by CFileIndex::findFile if no indexed archive has the file
+	const u32 FILE_INDEX_NOT_FOUND = 0xffffffff;
+
+	//! Hash table of the files in all archives of a file system.
+	/** Finds a file with one lookup instead of a binary search in each
+	archive. Names are compared like in CFileList::findFile, ignoring the
+	case and either with the full path or only with the file name, depending
+	on the ignorePaths flag of the archive. The table stores no names, it
+	refers to the file lists of the archives. */
+	class CFileIndex
+	{
+	public:
+
+		//! constructor
+		CFileIndex();
+
+		//! adds the files of an archive
+		/** \param archive Archive whose file list does not change while it
+		is indexed. It is not grabbed.
+		\param ignorePaths True if the archive was created with ignorePaths,
+		so its files are found by their name only. */
+		void addArchive(IFileArchive* archive, bool ignorePaths);
+
+		//! removes the files of an archive, does nothing if it is not indexed
+		void removeArchive(const IFileArchive* archive);
+
+		//! sets the priority of the indexed archives
+		/** Has to be called after archives were added, removed or moved.
+		\param archives All archives of the file system, the first one has
+		the highest priority. */
+		void setOrder(const core::array<IFileArchive*>& archives);
+
+		//! finds a file in the indexed archives
+		/** \param filename Name of the file, with a trailing slash a
+		directory is searched.
+		\param fileIndex Receives the index of the file in the file list of
+		the archive.
+		\return Position of the archive with the highest priority which has
+		the file, or FILE_INDEX_NOT_FOUND. */
+		u32 findFile(const path& filename, s32& fileIndex) const;
+
+		//! returns the positions of the archives which are not indexed, in ascending order
+		const core::array<u32>& getUnindexedArchives() const { return Unindexed; }
+
+	private:
+
+		struct SArchive
+		{
+			IFileArchive* Archive;
+			const IFileList* List;
+			u32 Position;
+			bool IgnorePaths;
+		};
+
+		struct SSlot
+		{
+			u32 Hash;
+			//! index in Archives, or EmptySlot or RemovedSlot
+			u32 Archive;
+			u32 File;
+		};
+
+		struct SMatch
+		{
+			const IFileList* List;
+			u32 Position;
+			s32 File;
+			//! the archive has the name more than once
+			bool Ambiguous;
+		};
+
+		//! searches the slots of one hash for a better match
+		void find(u32 hash, const fschar_t* name, u32 length, bool isDirectory,
+			bool ignorePaths, SMatch& match) const;
+
+		//! makes room for more files without a rehash
+		void reserve(u32 count);
+
+		//! rebuilds the table without the removed slots
+		void rehash(u32 size);
+
+		core::array<SArchive> Archives;
+		core::array<SSlot> Slots;
+		core::array<u32> Unindexed;
+		//! slots which are not empty, including removed ones
+		u32 Used;
+		//! slots which refer to a file
+		u32 Live;
+	};
+
+} // end namespace io
+} // end namespace irr
+
+#endif
+
@@ -51,6 +51,11 @@ namespace irr
 namespace io
 {
 
+// Lock of the archive list and the working directory of all file
+// systems. It is recursive, adding an archive opens its file.
+static CMutex FileSystemMutex(true);
+
+
 //! constructor
 CFileSystem::CFileSystem()
 {
@@ -86,6 +91,8 @@ CFileSystem::CFileSystem()
 	ArchiveLoader.push_back(new CArchiveLoaderZIP(this));
 #endif
 
+	// their archives find files with CFileList::findFile
+	BuiltInLoaderCount = ArchiveLoader.size();
 }
 
 
@@ -109,19 +116,67 @@ CFileSystem::~CFileSystem()
 //! opens a file for read access
 IReadFile* CFileSystem::createAndOpenFile(const io::path& filename)
 {
+	// Only the search holds the lock. The entries are opened without it,
+	// they lock the file of their archive for each read.
+	core::array<IFileArchive*> archives;
+	s32 fileIndex = -1;
+	s32 indexed;
+	{
+		CMutexLock lock(FileSystemMutex);
+		indexed = grabFileArchives(filename, archives, fileIndex);
+	}
+
 	IReadFile* file = 0;
-	u32 i;
+	for (u32 i=0; !file && i < archives.size(); ++i)
+	{
+		if ((s32)i == indexed)
+			file = archives[i]->createAndOpenFile((u32)fileIndex);
+		else
+			file = archives[i]->createAndOpenFile(filename);
+	}
 
-	for (i=0; i< FileArchives.size(); ++i)
+	io::path absolutePath;
 	{
-		file = FileArchives[i]->createAndOpenFile(filename);
-		if (file)
-			return file;
+		CMutexLock lock(FileSystemMutex);
+		for (u32 i=0; i < archives.size(); ++i)
+			archives[i]->drop();
+
+		if (!file)
+			absolutePath = getAbsolutePath(filename);
 	}
 
+	if (file)
+		return file;
+
 	// Create the file using an absolute path so that it matches
 	// the scheme used by CNullDriver::getTexture().
-	return createReadFile(getAbsolutePath(filename));
+	return createReadFile(absolutePath);
+}
+
+
+//! grabs the archives which might have the file, in the order to try them
+s32 CFileSystem::grabFileArchives(const io::path& filename, core::array<IFileArchive*>& archives, s32& fileIndex)
+{
+	const u32 found = FileIndex.findFile(filename, fileIndex);
+
+	// archives which are not indexed may come first
+	const core::array<u32>& others = FileIndex.getUnindexedArchives();
+	u32 i;
+	for (i=0; i < others.size() && others[i] < found; ++i)
+		archives.push_back(FileArchives[others[i]]);
+
+	s32 indexed = -1;
+	if (found != FILE_INDEX_NOT_FOUND)
+	{
+		// the archives after it in case the entry could not be opened
+		indexed = (s32)archives.size();
+		for (i=found; i < FileArchives.size(); ++i)
+			archives.push_back(FileArchives[i]);
+	}
+
+	for (i=0; i < archives.size(); ++i)
+		archives[i]->grab();
+	return indexed;
 }
 
 
@@ -193,6 +248,8 @@ IArchiveLoader* CFileSystem::getArchiveLoader(u32 index) const
 //! move the hirarchy of the filesystem. moves sourceIndex relative up or down
 bool CFileSystem::moveFileArchive(u32 sourceIndex, s32 relative)
 {
+	CMutexLock lock(FileSystemMutex);
+
 	bool r = false;
 	const s32 dest = (s32) sourceIndex + relative;
 	const s32 dir = relative < 0 ? -1 : 1;
@@ -209,6 +266,8 @@ bool CFileSystem::moveFileArchive(u32 sourceIndex, s32 relative)
 		FileArchives[s] = t;
 		r = true;
 	}
+	if (r)
+		FileIndex.setOrder(FileArchives);
 	return r;
 }
 
@@ -219,6 +278,8 @@ bool CFileSystem::addFileArchive(const io::path& filename, bool ignoreCase,
 			  const core::stringc& password,
 			  IFileArchive** retArchive)
 {
+	CMutexLock lock(FileSystemMutex);
+
 	IFileArchive* archive = 0;
 	bool ret = false;
 
@@ -306,6 +367,9 @@ bool CFileSystem::addFileArchive(const io::path& filename, bool ignoreCase,
 	if (archive)
 	{
 		FileArchives.push_back(archive);
+		if (i < (s32)BuiltInLoaderCount)
+			FileIndex.addArchive(archive, ignorePaths);
+		FileIndex.setOrder(FileArchives);
 		if (password.size())
 			archive->Password=password;
 		if (retArchive)
@@ -349,6 +413,8 @@ bool CFileSystem::addFileArchive(IReadFile* file, bool ignoreCase,
 		bool ignorePaths, E_FILE_ARCHIVE_TYPE archiveType,
 		const core::stringc& password, IFileArchive** retArchive)
 {
+	CMutexLock lock(FileSystemMutex);
+
 	if (!file || archiveType == EFAT_FOLDER)
 		return false;
 
@@ -412,6 +478,9 @@ bool CFileSystem::addFileArchive(IReadFile* file, bool ignoreCase,
 		if (archive)
 		{
 			FileArchives.push_back(archive);
+			if (i < (s32)BuiltInLoaderCount)
+				FileIndex.addArchive(archive, ignorePaths);
+			FileIndex.setOrder(FileArchives);
 			if (password.size())
 				archive->Password=password;
 			if (retArchive)
@@ -431,6 +500,8 @@ bool CFileSystem::addFileArchive(IReadFile* file, bool ignoreCase,
 //! Adds an archive to the file system.
 bool CFileSystem::addFileArchive(IFileArchive* archive)
 {
+	CMutexLock lock(FileSystemMutex);
+
 	for (u32 i=0; i < FileArchives.size(); ++i)
 	{
 		if (archive == FileArchives[i])
@@ -439,7 +510,9 @@ bool CFileSystem::addFileArchive(IFileArchive* archive)
 			return false;
 		}
 	}
+	// its file lookup is unknown, so it is not indexed
 	FileArchives.push_back(archive);
+	FileIndex.setOrder(FileArchives);
 	return true;
 }
 
@@ -447,11 +520,15 @@ bool CFileSystem::addFileArchive(IFileArchive* archive)
 //! removes an archive from the file system.
 bool CFileSystem::removeFileArchive(u32 index)
 {
+	CMutexLock lock(FileSystemMutex);
+
 	bool ret = false;
 	if (index < FileArchives.size())
 	{
+		FileIndex.removeArchive(FileArchives[index]);
 		FileArchives[index]->drop();
 		FileArchives.erase(index);
+		FileIndex.setOrder(FileArchives);
 		ret = true;
 	}
 	_IRR_IMPLEMENT_MANAGED_MARSHALLING_BUGFIX;
@@ -462,6 +539,8 @@ bool CFileSystem::removeFileArchive(u32 index)
 //! removes an archive from the file system.
 bool CFileSystem::removeFileArchive(const io::path& filename)
 {
+	CMutexLock lock(FileSystemMutex);
+
 	const path absPath = getAbsolutePath(filename);
 	for (u32 i=0; i < FileArchives.size(); ++i)
 	{
@@ -476,6 +555,8 @@ bool CFileSystem::removeFileArchive(const io::path& filename)
 //! Removes an archive from the file system.
 bool CFileSystem::removeFileArchive(const IFileArchive* archive)
 {
+	CMutexLock lock(FileSystemMutex);
+
 	for (u32 i=0; i < FileArchives.size(); ++i)
 	{
 		if (archive == FileArchives[i])
@@ -505,6 +586,8 @@ IFileArchive* CFileSystem::getFileArchive(u32 index)
 //! Returns the string of the current working directory
 const io::path& CFileSystem::getWorkingDirectory()
 {
+	CMutexLock lock(FileSystemMutex);
+
 	EFileSystemType type = FileSystemType;
 
 	if (type != FILESYSTEM_NATIVE)
@@ -575,6 +658,8 @@ const io::path& CFileSystem::getWorkingDirectory()
 //! Changes the current Working Directory to the given string.
 bool CFileSystem::changeWorkingDirectoryTo(const io::path& newDirectory)
 {
+	CMutexLock lock(FileSystemMutex);
+
 	bool success=false;
 
 	if (FileSystemType != FILESYSTEM_NATIVE)
@@ -826,6 +911,8 @@ EFileSystemType CFileSystem::setFileListSystem(EFileSystemType listType)
 //! Creates a list of files and directories in the current working directory
 IFileList* CFileSystem::createFileList()
 {
+	CMutexLock lock(FileSystemMutex);
+
 	CFileList* r = 0;
 	io::path Path = getWorkingDirectory();
 	Path.replace('\\', '/');
@@ -957,8 +1044,15 @@ IFileList* CFileSystem::createEmptyFileList(const io::path& path, bool ignoreCas
 //! determines if a file exists and would be able to be opened.
 bool CFileSystem::existFile(const io::path& filename) const
 {
-	for (u32 i=0; i < FileArchives.size(); ++i)
-		if (FileArchives[i]->getFileList()->findFile(filename)!=-1)
+	CMutexLock lock(FileSystemMutex);
+
+	s32 fileIndex;
+	if (FileIndex.findFile(filename, fileIndex) != FILE_INDEX_NOT_FOUND)
+		return true;
+
+	const core::array<u32>& others = FileIndex.getUnindexedArchives();
+	for (u32 i=0; i < others.size(); ++i)
+		if (FileArchives[others[i]]->getFileList()->findFile(filename)!=-1)
 			return true;
 
 #if defined(_IRR_WINDOWS_CE_PLATFORM_)
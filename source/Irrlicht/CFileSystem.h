@@ -7,6 +7,8 @@
 
 #include "IFileSystem.h"
 #include "irrArray.h"
+#include "CFileIndex.h"
+#include "CThread.h"
 
 namespace irr
 {
@@ -150,6 +152,12 @@ public:
 
 private:
 
+	//! grabs the archives which might have the file, in the order to try them
+	/** \param fileIndex Receives the index of the file in the indexed
+	archive which has it.
+	\return Position of that archive in archives, -1 if there is none. */
+	s32 grabFileArchives(const io::path& filename, core::array<IFileArchive*>& archives, s32& fileIndex);
+
 	// don't expose, needs refactoring
 	bool changeArchivePassword(const path& filename,
 			const core::stringc& password,
@@ -163,6 +171,10 @@ private:
 	core::array<IArchiveLoader*> ArchiveLoader;
 	//! currently attached Archives
 	core::array<IFileArchive*> FileArchives;
+	//! files of the archives from the built-in loaders
+	CFileIndex FileIndex;
+	//! the built-in loaders come first, their archives can be indexed
+	u32 BuiltInLoaderCount;
 };
 
 
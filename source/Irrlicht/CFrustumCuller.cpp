@@ -0,0 +1,260 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CFrustumCuller.h"
+#include "ECullingTypes.h"
+
+#ifdef _IRR_COMPILE_WITH_SSE2_
+#include <emmintrin.h>
+#endif
+
+namespace irr
+{
+namespace scene
+{
+
+//! constructor
+CFrustumCuller::CFrustumCuller()
+: Count(0)
+{
+}
+
+
+//! removes all boxes and sets the frustum they are tested against
+void CFrustumCuller::begin(const SViewFrustum& frustum)
+{
+	Blocks.set_used(0);
+	Count = 0;
+
+	for (u32 i=0; i != SViewFrustum::VF_PLANE_COUNT; ++i)
+		Planes[i] = frustum.planes[i];
+
+	const core::aabbox3d<f32>& box = frustum.getBoundingBox();
+	BoxCenter = box.getCenter();
+	BoxHalfExtent = box.getExtent() * 0.5f;
+}
+
+
+//! adds a box in object space with its absolute transformation
+u32 CFrustumCuller::add(const core::aabbox3d<f32>& box, const core::matrix4& transform, u32 culling)
+{
+	const u32 lane = Count & 3;
+	if (0 == lane)
+	{
+		// empty lanes are never culled
+		Blocks.push_back(SBlock());
+		memset(&Blocks.getLast(), 0, sizeof(SBlock));
+	}
+
+	setLane(Blocks.getLast(), lane, box, transform, culling);
+	return Count++;
+}
+
+
+//! fills a lane of a block
+void CFrustumCuller::setLane(SBlock& block, u32 lane, const core::aabbox3d<f32>& box,
+	const core::matrix4& transform, u32 culling)
+{
+	const core::vector3df halfExtent = box.getExtent() * 0.5f;
+
+	core::vector3df center = box.getCenter();
+	transform.transformVect(center);
+
+	block.CenterX[lane] = center.X;
+	block.CenterY[lane] = center.Y;
+	block.CenterZ[lane] = center.Z;
+
+	// the box stays a parallelepiped in world space, spanned by its transformed half axes
+	core::vector3df axis[3];
+	for (u32 i=0; i != 3; ++i)
+	{
+		axis[i].set(transform[i*4+0], transform[i*4+1], transform[i*4+2]);
+		axis[i] *= i == 0 ? halfExtent.X : i == 1 ? halfExtent.Y : halfExtent.Z;
+
+		block.Axis[i][0][lane] = axis[i].X;
+		block.Axis[i][1][lane] = axis[i].Y;
+		block.Axis[i][2][lane] = axis[i].Z;
+	}
+
+	// bounding sphere around its longest diagonal
+	f32 radius = (axis[0] + axis[1] + axis[2]).getLengthSQ();
+	radius = core::max_(radius, (axis[0] + axis[1] - axis[2]).getLengthSQ());
+	radius = core::max_(radius, (axis[0] - axis[1] + axis[2]).getLengthSQ());
+	radius = core::max_(radius, (axis[0] - axis[1] - axis[2]).getLengthSQ());
+	block.Radius[lane] = core::squareroot(radius);
+
+	const u32 bit = 1 << lane;
+	if (culling & EAC_BOX)
+		block.Box |= bit;
+	if (culling & EAC_FRUSTUM_BOX)
+		block.FrustumBox |= bit;
+	if (culling & EAC_FRUSTUM_SPHERE)
+		block.FrustumSphere |= bit;
+}
+
+
+//! tests one lane of a block
+u32 CFrustumCuller::cullLane(const SBlock& block, u32 lane) const
+{
+	const u32 bit = 1 << lane;
+	const core::vector3df center(block.CenterX[lane], block.CenterY[lane], block.CenterZ[lane]);
+
+	if (block.Box & bit)
+	{
+		// axis aligned box around the transformed box against the box around the frustum
+		for (u32 c=0; c != 3; ++c)
+		{
+			const f32 halfExtent = core::abs_(block.Axis[0][c][lane]) +
+				core::abs_(block.Axis[1][c][lane]) + core::abs_(block.Axis[2][c][lane]);
+			const f32 distance = c == 0 ? center.X - BoxCenter.X : c == 1 ? center.Y - BoxCenter.Y : center.Z - BoxCenter.Z;
+			const f32 frustumHalfExtent = c == 0 ? BoxHalfExtent.X : c == 1 ? BoxHalfExtent.Y : BoxHalfExtent.Z;
+
+			if (core::abs_(distance) > halfExtent + frustumHalfExtent)
+				return bit;
+		}
+	}
+
+	if (block.FrustumBox & bit)
+	{
+		// culled when the corner closest to the inside is in front of a plane
+		for (u32 i=0; i != SViewFrustum::VF_PLANE_COUNT; ++i)
+		{
+			const core::vector3df& n = Planes[i].Normal;
+			f32 radius = 0.f;
+			for (u32 a=0; a != 3; ++a)
+				radius += core::abs_(n.X * block.Axis[a][0][lane] + n.Y * block.Axis[a][1][lane] + n.Z * block.Axis[a][2][lane]);
+
+			if (n.dotProduct(center) + Planes[i].D - radius > core::ROUNDING_ERROR_f32)
+				return bit;
+		}
+	}
+
+	if (block.FrustumSphere & bit)
+	{
+		for (u32 i=0; i != SViewFrustum::VF_PLANE_COUNT; ++i)
+		{
+			if (Planes[i].Normal.dotProduct(center) + Planes[i].D - block.Radius[lane] > core::ROUNDING_ERROR_f32)
+				return bit;
+		}
+	}
+
+	return 0;
+}
+
+
+#ifdef _IRR_COMPILE_WITH_SSE2_
+
+namespace
+{
+	inline __m128 abs_ps(__m128 v)
+	{
+		return _mm_andnot_ps(_mm_set1_ps(-0.f), v);
+	}
+}
+
+//! tests all lanes of a block at once
+u32 CFrustumCuller::cullBlock(const SBlock& block) const
+{
+	const __m128 cx = _mm_loadu_ps(block.CenterX);
+	const __m128 cy = _mm_loadu_ps(block.CenterY);
+	const __m128 cz = _mm_loadu_ps(block.CenterZ);
+
+	__m128 axis[3][3];
+	for (u32 a=0; a != 3; ++a)
+		for (u32 c=0; c != 3; ++c)
+			axis[a][c] = _mm_loadu_ps(block.Axis[a][c]);
+
+	u32 culled = 0;
+
+	if (block.Box)
+	{
+		const __m128 center[3] = { cx, cy, cz };
+		const f32 boxCenter[3] = { BoxCenter.X, BoxCenter.Y, BoxCenter.Z };
+		const f32 boxHalfExtent[3] = { BoxHalfExtent.X, BoxHalfExtent.Y, BoxHalfExtent.Z };
+
+		__m128 outside = _mm_setzero_ps();
+		for (u32 c=0; c != 3; ++c)
+		{
+			const __m128 halfExtent = _mm_add_ps(_mm_add_ps(abs_ps(axis[0][c]), abs_ps(axis[1][c])), abs_ps(axis[2][c]));
+			const __m128 distance = abs_ps(_mm_sub_ps(center[c], _mm_set1_ps(boxCenter[c])));
+			outside = _mm_or_ps(outside, _mm_cmpgt_ps(distance, _mm_add_ps(halfExtent, _mm_set1_ps(boxHalfExtent[c]))));
+		}
+		culled |= _mm_movemask_ps(outside) & block.Box;
+	}
+
+	if (block.FrustumBox | block.FrustumSphere)
+	{
+		const __m128 radius = _mm_loadu_ps(block.Radius);
+		const __m128 epsilon = _mm_set1_ps(core::ROUNDING_ERROR_f32);
+
+		__m128 boxOutside = _mm_setzero_ps();
+		__m128 sphereOutside = _mm_setzero_ps();
+
+		for (u32 i=0; i != SViewFrustum::VF_PLANE_COUNT; ++i)
+		{
+			const __m128 nx = _mm_set1_ps(Planes[i].Normal.X);
+			const __m128 ny = _mm_set1_ps(Planes[i].Normal.Y);
+			const __m128 nz = _mm_set1_ps(Planes[i].Normal.Z);
+
+			const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)),
+				_mm_mul_ps(nz, cz)), _mm_set1_ps(Planes[i].D));
+
+			__m128 boxRadius = _mm_setzero_ps();
+			for (u32 a=0; a != 3; ++a)
+			{
+				boxRadius = _mm_add_ps(boxRadius, abs_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, axis[a][0]),
+					_mm_mul_ps(ny, axis[a][1])), _mm_mul_ps(nz, axis[a][2]))));
+			}
+
+			boxOutside = _mm_or_ps(boxOutside, _mm_cmpgt_ps(_mm_sub_ps(distance, boxRadius), epsilon));
+			sphereOutside = _mm_or_ps(sphereOutside, _mm_cmpgt_ps(_mm_sub_ps(distance, radius), epsilon));
+		}
+
+		culled |= _mm_movemask_ps(boxOutside) & block.FrustumBox;
+		culled |= _mm_movemask_ps(sphereOutside) & block.FrustumSphere;
+	}
+
+	return culled;
+}
+
+#else
+
+//! tests all lanes of a block at once
+u32 CFrustumCuller::cullBlock(const SBlock& block) const
+{
+	u32 culled = 0;
+	for (u32 lane=0; lane != 4; ++lane)
+		culled |= cullLane(block, lane);
+	return culled;
+}
+
+#endif
+
+
+//! tests all added boxes
+void CFrustumCuller::cull()
+{
+	for (u32 i=0; i != Blocks.size(); ++i)
+		Blocks[i].Culled = cullBlock(Blocks[i]);
+}
+
+
+//! tests a single box the same way as a batch does
+bool CFrustumCuller::isCulled(const SViewFrustum& frustum, const core::aabbox3d<f32>& box,
+	const core::matrix4& transform, u32 culling)
+{
+	CFrustumCuller culler;
+	culler.begin(frustum);
+
+	SBlock block;
+	memset(&block, 0, sizeof(SBlock));
+	setLane(block, 0, box, transform, culling);
+
+	return culler.cullLane(block, 0) != 0;
+}
+
+
+} // end namespace scene
+} // end namespace irr
+
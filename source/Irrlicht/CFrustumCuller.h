@@ -0,0 +1,90 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_FRUSTUM_CULLER_H_INCLUDED__
+#define __C_FRUSTUM_CULLER_H_INCLUDED__
+
+#include "IrrCompileConfig.h"
+#include "SViewFrustum.h"
+#include "irrArray.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! Tests many bounding boxes against a view frustum at once.
+	/** The boxes are stored in blocks of four, the tests run on a whole
+	block with SSE2 when available. Each box is culled by the
+	E_CULLING_TYPE bits it was added with, EAC_OCC_QUERY is ignored. */
+	class CFrustumCuller
+	{
+	public:
+
+		//! constructor
+		CFrustumCuller();
+
+		//! removes all boxes and sets the frustum they are tested against
+		void begin(const SViewFrustum& frustum);
+
+		//! adds a box in object space with its absolute transformation
+		/** \return index of the box in this batch */
+		u32 add(const core::aabbox3d<f32>& box, const core::matrix4& transform, u32 culling);
+
+		//! tests all added boxes
+		void cull();
+
+		//! returns the number of boxes added since begin()
+		u32 getCount() const { return Count; }
+
+		//! returns if the box with the given index is outside of the frustum, valid after cull()
+		bool isCulled(u32 index) const
+		{
+			return ( ( Blocks[index >> 2].Culled >> ( index & 3 ) ) & 1 ) != 0;
+		}
+
+		//! tests a single box the same way as a batch does
+		static bool isCulled(const SViewFrustum& frustum, const core::aabbox3d<f32>& box,
+			const core::matrix4& transform, u32 culling);
+
+	private:
+
+		//! four boxes, transformed to world space center and half axes
+		struct SBlock
+		{
+			f32 CenterX[4];
+			f32 CenterY[4];
+			f32 CenterZ[4];
+			f32 Axis[3][3][4];	// half axis, component, box
+			f32 Radius[4];
+
+			u32 Box;			// lanes to test with EAC_BOX
+			u32 FrustumBox;		// lanes to test with EAC_FRUSTUM_BOX
+			u32 FrustumSphere;	// lanes to test with EAC_FRUSTUM_SPHERE
+			u32 Culled;			// result of cull()
+		};
+
+		//! fills a lane of a block
+		static void setLane(SBlock& block, u32 lane, const core::aabbox3d<f32>& box,
+			const core::matrix4& transform, u32 culling);
+
+		//! tests one lane of a block
+		u32 cullLane(const SBlock& block, u32 lane) const;
+
+		//! tests all lanes of a block at once
+		u32 cullBlock(const SBlock& block) const;
+
+		core::array<SBlock> Blocks;
+		u32 Count;
+
+		core::plane3df Planes[SViewFrustum::VF_PLANE_COUNT];
+		core::vector3df BoxCenter;
+		core::vector3df BoxHalfExtent;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
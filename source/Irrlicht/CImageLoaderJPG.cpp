@@ -16,11 +16,6 @@ namespace irr
 namespace video
 {
 
-#ifdef _IRR_COMPILE_WITH_LIBJPEG_
-// Static members
-io::path CImageLoaderJPG::Filename;
-#endif
-
 //! constructor
 CImageLoaderJPG::CImageLoaderJPG()
 {
@@ -56,6 +51,10 @@ bool CImageLoaderJPG::isALoadableFileExtension(const io::path& filename) const
 
         // for longjmp, to return to caller on a fatal error
         jmp_buf setjmp_buffer;
+
+        // name of the file for error-messages, per call as images
+        // may be decoded on several threads
+        const io::path* Filename;
     };
 
 void CImageLoaderJPG::init_source (j_decompress_ptr cinfo)
@@ -113,7 +112,7 @@ void CImageLoaderJPG::output_message(j_common_ptr cinfo)
 	c8 temp1[JMSG_LENGTH_MAX];
 	(*cinfo->err->format_message)(cinfo, temp1);
 	core::stringc errMsg("JPEG FATAL ERROR in ");
-	errMsg += core::stringc(Filename);
+	errMsg += core::stringc(*((irr_jpeg_error_mgr*) cinfo->err)->Filename);
 	os::Printer::log(errMsg.c_str(),temp1, ELL_ERROR);
 }
 #endif // _IRR_COMPILE_WITH_LIBJPEG_
@@ -147,11 +146,17 @@ IImage* CImageLoaderJPG::loadImage(io::IReadFile* file) const
 	if (!file)
 		return 0;
 
-	Filename = file->getFileName();
-
 	u8 **rowPtr=0;
-	u8* input = new u8[file->getSize()];
-	file->read(input, file->getSize());
+
+	// mapped files are decoded in place
+	const u8* input = (const u8*)file->getMappedData();
+	u8* fileBuf = 0;
+	if (!input)
+	{
+		fileBuf = new u8[file->getSize()];
+		file->read(fileBuf, file->getSize());
+		input = fileBuf;
+	}
 
 	// allocate and initialize JPEG decompression object
 	struct jpeg_decompress_struct cinfo;
@@ -163,6 +168,7 @@ IImage* CImageLoaderJPG::loadImage(io::IReadFile* file) const
 	//address which we place into the link field in cinfo.
 
 	cinfo.err = jpeg_std_error(&jerr.pub);
+	jerr.Filename = &file->getFileName();
 	cinfo.err->error_exit = error_exit;
 	cinfo.err->output_message = output_message;
 
@@ -176,7 +182,7 @@ IImage* CImageLoaderJPG::loadImage(io::IReadFile* file) const
 
 		jpeg_destroy_decompress(&cinfo);
 
-		delete [] input;
+		delete [] fileBuf;
 		// if the row pointer was created, we delete it.
 		if (rowPtr)
 			delete [] rowPtr;
@@ -193,7 +199,7 @@ IImage* CImageLoaderJPG::loadImage(io::IReadFile* file) const
 
 	// Set up data pointer
 	jsrc.bytes_in_buffer = file->getSize();
-	jsrc.next_input_byte = (JOCTET*)input;
+	jsrc.next_input_byte = (const JOCTET*)input;
 	cinfo.src = &jsrc;
 
 	jsrc.init_source = init_source;
@@ -286,7 +292,7 @@ IImage* CImageLoaderJPG::loadImage(io::IReadFile* file) const
 		image = new CImage(ECF_R8G8B8,
 				core::dimension2d<u32>(width, height), output);
 
-	delete [] input;
+	delete [] fileBuf;
 
 	return image;
 
@@ -0,0 +1,399 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CInstancedMeshSceneNode.h"
+#include "IVideoDriver.h"
+#include "ISceneManager.h"
+#include "ICameraSceneNode.h"
+#include "IMeshCache.h"
+#include "IAnimatedMesh.h"
+#include "IMaterialRenderer.h"
+#include "IFileSystem.h"
+
+namespace irr
+{
+namespace scene
+{
+
+
+//! constructor
+CInstancedMeshSceneNode::CInstancedMeshSceneNode(IMesh* mesh, ISceneNode* parent, ISceneManager* mgr, s32 id,
+			const core::vector3df& position, const core::vector3df& rotation,
+			const core::vector3df& scale)
+: IInstancedMeshSceneNode(parent, mgr, id, position, rotation, scale), Mesh(0),
+	BoxDirty(false), PassCount(0)
+{
+	#ifdef _DEBUG
+	setDebugName("CInstancedMeshSceneNode");
+	#endif
+
+	setMesh(mesh);
+}
+
+
+//! destructor
+CInstancedMeshSceneNode::~CInstancedMeshSceneNode()
+{
+	if (Mesh)
+		Mesh->drop();
+}
+
+
+//! frame
+void CInstancedMeshSceneNode::OnRegisterSceneNode()
+{
+	if (IsVisible)
+	{
+		if (Mesh && Transforms.size())
+		{
+			video::IVideoDriver* driver = SceneManager->getVideoDriver();
+
+			PassCount = 0;
+			bool transparent = false;
+			bool solid = false;
+
+			for (u32 i=0; i<Materials.size(); ++i)
+			{
+				video::IMaterialRenderer* rnd =
+					driver->getMaterialRenderer(Materials[i].MaterialType);
+
+				if (rnd && rnd->isTransparent())
+					transparent = true;
+				else
+					solid = true;
+			}
+
+			if (solid)
+				SceneManager->registerNodeForRendering(this, scene::ESNRP_SOLID);
+
+			if (transparent)
+				SceneManager->registerNodeForRendering(this, scene::ESNRP_TRANSPARENT);
+		}
+
+		ISceneNode::OnRegisterSceneNode();
+	}
+}
+
+
+//! collects the instances inside the view frustum
+void CInstancedMeshSceneNode::cullInstances()
+{
+	VisibleTransforms.set_used(0);
+	VisibleColors.set_used(0);
+
+	const ICameraSceneNode* camera = SceneManager->getActiveCamera();
+	const u32 culling = AutomaticCullingState & (EAC_BOX | EAC_FRUSTUM_BOX | EAC_FRUSTUM_SPHERE);
+
+	if (!camera || !culling)
+	{
+		VisibleTransforms = Transforms;
+		VisibleColors = Colors;
+		return;
+	}
+
+	// test the boxes of all instances in one batch
+	const core::aabbox3d<f32>& box = Mesh->getBoundingBox();
+	Culler.begin(*camera->getViewFrustum());
+
+	for (u32 i=0; i<Transforms.size(); ++i)
+		Culler.add(box, AbsoluteTransformation * Transforms[i], culling);
+
+	Culler.cull();
+
+	for (u32 i=0; i<Transforms.size(); ++i)
+	{
+		if (!Culler.isCulled(i))
+		{
+			VisibleTransforms.push_back(Transforms[i]);
+			VisibleColors.push_back(Colors[i]);
+		}
+	}
+}
+
+
+//! renders the node.
+void CInstancedMeshSceneNode::render()
+{
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+
+	if (!Mesh || !driver)
+		return;
+
+	++PassCount;
+
+	if (PassCount == 1)
+		cullInstances();
+
+	driver->setTransform(video::ETS_WORLD, AbsoluteTransformation);
+
+	if (VisibleTransforms.size())
+	{
+		const bool isTransparentPass =
+			SceneManager->getSceneNodeRenderPass() == scene::ESNRP_TRANSPARENT;
+
+		for (u32 i=0; i<Mesh->getMeshBufferCount(); ++i)
+		{
+			const IMeshBuffer* mb = Mesh->getMeshBuffer(i);
+			if (!mb)
+				continue;
+
+			const video::SMaterial& material = Materials[i];
+			video::IMaterialRenderer* rnd = driver->getMaterialRenderer(material.MaterialType);
+			const bool transparent = (rnd && rnd->isTransparent());
+
+			if (transparent == isTransparentPass)
+			{
+				driver->setMaterial(material);
+				driver->drawMeshBufferInstanced(mb, VisibleTransforms.const_pointer(),
+					VisibleColors.const_pointer(), VisibleTransforms.size());
+			}
+		}
+	}
+
+	// for debug purposes only:
+	if (DebugDataVisible && PassCount==1)
+	{
+		video::SMaterial m;
+		m.Lighting = false;
+		m.AntiAliasing=0;
+		driver->setMaterial(m);
+
+		if (DebugDataVisible & scene::EDS_BBOX)
+		{
+			driver->draw3DBox(getBoundingBox(), video::SColor(255,255,255,255));
+		}
+		if (DebugDataVisible & scene::EDS_BBOX_BUFFERS)
+		{
+			for (u32 i=0; i<VisibleTransforms.size(); ++i)
+			{
+				core::aabbox3d<f32> box = Mesh->getBoundingBox();
+				VisibleTransforms[i].transformBoxEx(box);
+				driver->draw3DBox(box, video::SColor(255,190,128,128));
+			}
+		}
+	}
+}
+
+
+//! returns the axis aligned bounding box of all instances
+const core::aabbox3d<f32>& CInstancedMeshSceneNode::getBoundingBox() const
+{
+	if (BoxDirty)
+	{
+		BoxDirty = false;
+		Box.reset(0,0,0);
+
+		if (Mesh)
+		{
+			for (u32 i=0; i<Transforms.size(); ++i)
+			{
+				core::aabbox3d<f32> box = Mesh->getBoundingBox();
+				Transforms[i].transformBoxEx(box);
+
+				if (i == 0)
+					Box = box;
+				else
+					Box.addInternalBox(box);
+			}
+		}
+	}
+
+	return Box;
+}
+
+
+//! returns the material based on the zero based index i.
+video::SMaterial& CInstancedMeshSceneNode::getMaterial(u32 i)
+{
+	if (i >= Materials.size())
+		return ISceneNode::getMaterial(i);
+
+	return Materials[i];
+}
+
+
+//! returns amount of materials used by this scene node.
+u32 CInstancedMeshSceneNode::getMaterialCount() const
+{
+	return Materials.size();
+}
+
+
+//! Sets a new mesh
+void CInstancedMeshSceneNode::setMesh(IMesh* mesh)
+{
+	if (mesh)
+	{
+		mesh->grab();
+		if (Mesh)
+			Mesh->drop();
+
+		Mesh = mesh;
+		copyMaterials();
+		BoxDirty = true;
+	}
+}
+
+
+//! Adds an instance
+u32 CInstancedMeshSceneNode::addInstance(const core::matrix4& transform, video::SColor color)
+{
+	Transforms.push_back(transform);
+	Colors.push_back(color);
+	BoxDirty = true;
+
+	return Transforms.size() - 1;
+}
+
+
+//! Removes an instance
+void CInstancedMeshSceneNode::removeInstance(u32 index)
+{
+	if (index >= Transforms.size())
+		return;
+
+	const u32 last = Transforms.size() - 1;
+	Transforms[index] = Transforms[last];
+	Colors[index] = Colors[last];
+	Transforms.set_used(last);
+	Colors.set_used(last);
+	BoxDirty = true;
+}
+
+
+//! Removes all instances
+void CInstancedMeshSceneNode::removeAllInstances()
+{
+	Transforms.clear();
+	Colors.clear();
+	VisibleTransforms.clear();
+	VisibleColors.clear();
+	BoxDirty = true;
+}
+
+
+//! Sets the transformation of an instance, relative to the node
+void CInstancedMeshSceneNode::setInstanceTransform(u32 index, const core::matrix4& transform)
+{
+	if (index >= Transforms.size())
+		return;
+
+	Transforms[index] = transform;
+	BoxDirty = true;
+}
+
+
+void CInstancedMeshSceneNode::copyMaterials()
+{
+	Materials.clear();
+
+	if (Mesh)
+	{
+		video::SMaterial mat;
+
+		for (u32 i=0; i<Mesh->getMeshBufferCount(); ++i)
+		{
+			IMeshBuffer* mb = Mesh->getMeshBuffer(i);
+			if (mb)
+				mat = mb->getMaterial();
+
+			Materials.push_back(mat);
+		}
+	}
+}
+
+
+//! Writes attributes of the scene node.
+void CInstancedMeshSceneNode::serializeAttributes(io::IAttributes* out, io::SAttributeReadWriteOptions* options) const
+{
+	IInstancedMeshSceneNode::serializeAttributes(out, options);
+
+	if (options && (options->Flags&io::EARWF_USE_RELATIVE_PATHS) && options->Filename)
+	{
+		const io::path path = SceneManager->getFileSystem()->getRelativeFilename(
+				SceneManager->getFileSystem()->getAbsolutePath(SceneManager->getMeshCache()->getMeshName(Mesh).getPath()),
+				options->Filename);
+		out->addString("Mesh", path.c_str());
+	}
+	else
+		out->addString("Mesh", SceneManager->getMeshCache()->getMeshName(Mesh).getPath().c_str());
+
+	for (u32 i=0; i<Transforms.size(); ++i)
+	{
+		core::stringc tname = "Transform";
+		tname += (int)(i+1);
+		out->addMatrix(tname.c_str(), Transforms[i]);
+
+		core::stringc cname = "Color";
+		cname += (int)(i+1);
+		out->addColor(cname.c_str(), Colors[i]);
+	}
+}
+
+
+//! Reads attributes of the scene node.
+void CInstancedMeshSceneNode::deserializeAttributes(io::IAttributes* in, io::SAttributeReadWriteOptions* options)
+{
+	io::path oldMeshStr = SceneManager->getMeshCache()->getMeshName(Mesh);
+	io::path newMeshStr = in->getAttributeAsString("Mesh");
+
+	if (newMeshStr != "" && oldMeshStr != newMeshStr)
+	{
+		IMesh* newMesh = 0;
+		IAnimatedMesh* newAnimatedMesh = SceneManager->getMesh(newMeshStr.c_str());
+
+		if (newAnimatedMesh)
+			newMesh = newAnimatedMesh->getMesh(0);
+
+		if (newMesh)
+			setMesh(newMesh);
+	}
+
+	removeAllInstances();
+
+	for (u32 i=1; true; ++i)
+	{
+		core::stringc tname = "Transform";
+		tname += i;
+
+		if (!in->existsAttribute(tname.c_str()))
+			break;
+
+		core::stringc cname = "Color";
+		cname += i;
+
+		addInstance(in->getAttributeAsMatrix(tname.c_str()),
+			in->existsAttribute(cname.c_str()) ? in->getAttributeAsColor(cname.c_str()) : video::SColor(255,255,255,255));
+	}
+
+	IInstancedMeshSceneNode::deserializeAttributes(in, options);
+}
+
+
+//! Creates a clone of this scene node and its children.
+ISceneNode* CInstancedMeshSceneNode::clone(ISceneNode* newParent, ISceneManager* newManager)
+{
+	if (!newParent)
+		newParent = Parent;
+	if (!newManager)
+		newManager = SceneManager;
+
+	CInstancedMeshSceneNode* nb = new CInstancedMeshSceneNode(Mesh, newParent,
+		newManager, ID, RelativeTranslation, RelativeRotation, RelativeScale);
+
+	nb->cloneMembers(this, newManager);
+	nb->Materials = Materials;
+	nb->Transforms = Transforms;
+	nb->Colors = Colors;
+	nb->BoxDirty = true;
+
+	if (newParent)
+		nb->drop();
+	return nb;
+}
+
+
+} // end namespace scene
+} // end namespace irr
+
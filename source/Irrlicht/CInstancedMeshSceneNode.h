@@ -0,0 +1,120 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_INSTANCED_MESH_SCENE_NODE_H_INCLUDED__
+#define __C_INSTANCED_MESH_SCENE_NODE_H_INCLUDED__
+
+#include "IInstancedMeshSceneNode.h"
+#include "IMesh.h"
+#include "CFrustumCuller.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	class CInstancedMeshSceneNode : public IInstancedMeshSceneNode
+	{
+	public:
+
+		//! constructor
+		CInstancedMeshSceneNode(IMesh* mesh, ISceneNode* parent, ISceneManager* mgr, s32 id,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f));
+
+		//! destructor
+		virtual ~CInstancedMeshSceneNode();
+
+		//! frame
+		virtual void OnRegisterSceneNode();
+
+		//! renders the node.
+		virtual void render();
+
+		//! returns the axis aligned bounding box of all instances
+		virtual const core::aabbox3d<f32>& getBoundingBox() const;
+
+		//! returns the material based on the zero based index i.
+		virtual video::SMaterial& getMaterial(u32 i);
+
+		//! returns amount of materials used by this scene node.
+		virtual u32 getMaterialCount() const;
+
+		//! Writes attributes of the scene node.
+		virtual void serializeAttributes(io::IAttributes* out, io::SAttributeReadWriteOptions* options=0) const;
+
+		//! Reads attributes of the scene node.
+		virtual void deserializeAttributes(io::IAttributes* in, io::SAttributeReadWriteOptions* options=0);
+
+		//! Returns type of the scene node
+		virtual ESCENE_NODE_TYPE getType() const { return ESNT_INSTANCED_MESH; }
+
+		//! Sets a new mesh
+		virtual void setMesh(IMesh* mesh);
+
+		//! Returns the current mesh
+		virtual IMesh* getMesh(void) { return Mesh; }
+
+		//! Adds an instance
+		virtual u32 addInstance(const core::matrix4& transform,
+			video::SColor color = video::SColor(255,255,255,255));
+
+		//! Removes an instance
+		virtual void removeInstance(u32 index);
+
+		//! Removes all instances
+		virtual void removeAllInstances();
+
+		//! Get the number of instances
+		virtual u32 getInstanceCount() const { return Transforms.size(); }
+
+		//! Sets the transformation of an instance, relative to the node
+		virtual void setInstanceTransform(u32 index, const core::matrix4& transform);
+
+		//! Get the transformation of an instance, relative to the node
+		virtual const core::matrix4& getInstanceTransform(u32 index) const { return Transforms[index]; }
+
+		//! Sets the color of an instance
+		virtual void setInstanceColor(u32 index, video::SColor color) { Colors[index] = color; }
+
+		//! Get the color of an instance
+		virtual video::SColor getInstanceColor(u32 index) const { return Colors[index]; }
+
+		//! Get the number of instances which passed the culling in the last drawn frame
+		virtual u32 getVisibleInstanceCount() const { return VisibleTransforms.size(); }
+
+		//! Creates a clone of this scene node and its children.
+		virtual ISceneNode* clone(ISceneNode* newParent=0, ISceneManager* newManager=0);
+
+	private:
+
+		void copyMaterials();
+
+		//! collects the instances inside the view frustum
+		void cullInstances();
+
+		core::array<video::SMaterial> Materials;
+		IMesh* Mesh;
+
+		core::array<core::matrix4> Transforms;
+		core::array<video::SColor> Colors;
+
+		//! instances which passed the culling of the current frame
+		core::array<core::matrix4> VisibleTransforms;
+		core::array<video::SColor> VisibleColors;
+		CFrustumCuller Culler;
+
+		//! box of all instances, updated lazily
+		mutable core::aabbox3d<f32> Box;
+		mutable bool BoxDirty;
+
+		s32 PassCount;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
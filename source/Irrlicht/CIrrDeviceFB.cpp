@@ -200,7 +200,7 @@ void CIrrDeviceFB::createDriver()
 		
 	case video::EDT_BURNINGSVIDEO:
 		#ifdef _IRR_COMPILE_WITH_BURNINGSVIDEO_
-		VideoDriver = video::createBurningVideoDriver(CreationParams, FileSystem, this);
+		VideoDriver = video::createBurningVideoDriver(CreationParams, FileSystem, this, JobSystem);
 		#else
 		os::Printer::log("Burning's video driver was not compiled in.", ELL_WARNING);
 		#endif
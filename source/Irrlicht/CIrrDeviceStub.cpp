@@ -11,6 +11,8 @@
 #include "IrrCompileConfig.h"
 #include "CTimer.h"
 #include "CLogger.h"
+#include "CProfiler.h"
+#include "CJobSystem.h"
 #include "irrString.h"
 #include "IRandomizer.h"
 
@@ -20,7 +22,7 @@ namespace irr
 CIrrDeviceStub::CIrrDeviceStub(const SIrrlichtCreationParameters& params)
 : IrrlichtDevice(), VideoDriver(0), GUIEnvironment(0), SceneManager(0),
 	Timer(0), CursorControl(0), UserReceiver(params.EventReceiver),
-	Logger(0), Operator(0), Randomizer(0), FileSystem(0),
+	Logger(0), Profiler(0), JobSystem(0), Operator(0), Randomizer(0), FileSystem(0),
 	InputReceivingSceneManager(0), VideoModeList(0),
 	CreationParams(params), Close(false)
 {
@@ -39,6 +41,22 @@ CIrrDeviceStub::CIrrDeviceStub(const SIrrlichtCreationParameters& params)
 	Logger->setLogLevel(CreationParams.LoggingLevel);
 
 	os::Printer::Logger = Logger;
+
+#ifdef _IRR_COMPILE_WITH_PROFILING_
+	if (CProfiler::Active)
+	{
+		CProfiler::Active->grab();
+		Profiler = CProfiler::Active;
+	}
+	else
+	{
+		CProfiler::Active = new CProfiler();
+		Profiler = CProfiler::Active;
+	}
+#endif
+
+	JobSystem = new CJobSystem(CreationParams.JobThreads);
+
 	Randomizer = createDefaultRandomizer();
 
 	FileSystem = io::createFileSystem();
@@ -83,6 +101,14 @@ CIrrDeviceStub::~CIrrDeviceStub()
 	if (Timer)
 		Timer->drop();
 
+	// after the driver and the scene manager, which may still run jobs
+	if (JobSystem)
+		JobSystem->drop();
+
+	// the profiler resets CProfiler::Active when the last device releases it
+	if (Profiler)
+		Profiler->drop();
+
 	if (Logger->drop())
 		os::Printer::Logger = 0;
 }
@@ -96,7 +122,7 @@ void CIrrDeviceStub::createGUIAndScene()
 	#endif
 
 	// create Scene manager
-	SceneManager = scene::createSceneManager(VideoDriver, FileSystem, CursorControl, GUIEnvironment);
+	SceneManager = scene::createSceneManager(VideoDriver, FileSystem, CursorControl, GUIEnvironment, JobSystem);
 
 	setEventReceiver(UserReceiver);
 }
@@ -259,6 +285,20 @@ ILogger* CIrrDeviceStub::getLogger()
 }
 
 
+//! \return Returns a pointer to the profiler.
+IProfiler* CIrrDeviceStub::getProfiler()
+{
+	return Profiler;
+}
+
+
+//! Returns the job system.
+IJobSystem* CIrrDeviceStub::getJobSystem()
+{
+	return JobSystem;
+}
+
+
 //! Returns the operation system opertator object.
 IOSOperator* CIrrDeviceStub::getOSOperator()
 {
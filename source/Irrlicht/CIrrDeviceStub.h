@@ -15,6 +15,8 @@ namespace irr
 	// lots of prototypes:
 	class ILogger;
 	class CLogger;
+	class IProfiler;
+	class IJobSystem;
 	class IRandomizer;
 
 	namespace gui
@@ -27,7 +29,8 @@ namespace irr
 	namespace scene
 	{
 		ISceneManager* createSceneManager(video::IVideoDriver* driver,
-			io::IFileSystem* fs, gui::ICursorControl* cc, gui::IGUIEnvironment *gui);
+			io::IFileSystem* fs, gui::ICursorControl* cc, gui::IGUIEnvironment *gui,
+			IJobSystem* jobSystem);
 	}
 
 	namespace io
@@ -41,7 +44,7 @@ namespace irr
 				bool fullscreen, io::IFileSystem* io,
 				video::IImagePresenter* presenter);
 		IVideoDriver* createBurningVideoDriver(const irr::SIrrlichtCreationParameters& params,
-				io::IFileSystem* io, video::IImagePresenter* presenter);
+				io::IFileSystem* io, video::IImagePresenter* presenter, IJobSystem* jobSystem);
 		IVideoDriver* createNullDriver(io::IFileSystem* io, const core::dimension2d<u32>& screenSize);
 	}
 
@@ -98,6 +101,12 @@ namespace irr
 		//! Returns a pointer to the logger.
 		virtual ILogger* getLogger();
 
+		//! Returns a pointer to the profiler.
+		virtual IProfiler* getProfiler();
+
+		//! Returns the job system.
+		virtual IJobSystem* getJobSystem();
+
 		//! Provides access to the engine's currently set randomizer.
 		virtual IRandomizer* getRandomizer() const;
 
@@ -157,6 +166,8 @@ namespace irr
 		gui::ICursorControl* CursorControl;
 		IEventReceiver* UserReceiver;
 		CLogger* Logger;
+		IProfiler* Profiler;
+		IJobSystem* JobSystem;
 		IOSOperator* Operator;
 		IRandomizer* Randomizer;
 		io::IFileSystem* FileSystem;
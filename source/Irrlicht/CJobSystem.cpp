@@ -0,0 +1,440 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CJobSystem.h"
+#include "os.h"
+#include "irrMath.h"
+
+#if defined(_IRR_WINDOWS_API_)
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#endif
+
+namespace irr
+{
+
+namespace
+{
+	//! atomically adds value to dest and returns the previous value
+	inline s32 atomicFetchAdd(volatile s32* dest, s32 value)
+	{
+#if defined(_IRR_WINDOWS_API_)
+		return InterlockedExchangeAdd((volatile LONG*)dest, value);
+#else
+		return __sync_fetch_and_add(dest, value);
+#endif
+	}
+
+	// a handle keeps the slot in the low bits and its generation in the high bits
+	const u32 SLOT_BITS = 20;
+	const u32 SLOT_MASK = (1 << SLOT_BITS) - 1;
+	const u32 GENERATION_MASK = 0xfff;
+	const u32 NO_SLOT = 0xffffffff;
+
+	// parallelFor never starts more helper jobs than this
+	const u32 MAX_PARALLEL_FOR_HELPERS = 64;
+}
+
+
+void CJobSystem::SQueue::pushBack(const SReadyJob& job)
+{
+	if (Count == Items.size())
+	{
+		// unroll the ring into a larger array
+		core::array<SReadyJob> items;
+		items.reallocate(Count ? Count * 2 : 16);
+		for (u32 i=0; i<Count; ++i)
+			items.push_back(Items[(Head + i) % Count]);
+		items.set_used(items.allocated_size());
+		Items.swap(items);
+		Head = 0;
+	}
+
+	Items[(Head + Count) % Items.size()] = job;
+	++Count;
+}
+
+
+bool CJobSystem::SQueue::popBack(SReadyJob& job)
+{
+	if (!Count)
+		return false;
+
+	--Count;
+	job = Items[(Head + Count) % Items.size()];
+	return true;
+}
+
+
+bool CJobSystem::SQueue::popFront(SReadyJob& job)
+{
+	if (!Count)
+		return false;
+
+	job = Items[Head];
+	Head = (Head + 1) % Items.size();
+	--Count;
+	return true;
+}
+
+
+//! constructor
+CJobSystem::CJobSystem(u32 threadCount)
+: ThreadCount(0), Threads(0), Starts(0), ThreadIds(0), Queues(0),
+	FreeJob(NO_SLOT), ActiveJobs(0), Waiters(0),
+	ReadyCount(0), Sleeping(0), Registered(0), Quit(false)
+{
+	#ifdef _DEBUG
+	setDebugName("CJobSystem");
+	#endif
+
+	Queues = new SQueue[threadCount + 1];
+
+	if (!threadCount)
+		return;
+
+	Threads = new CThread[threadCount];
+	Starts = new SWorkerStart[threadCount];
+	ThreadIds = new size_t[threadCount];
+
+	for (u32 i=0; i<threadCount; ++i)
+	{
+		Starts[i].System = this;
+		Starts[i].WorkerIndex = i + 1;
+		if (!Threads[i].start(workerEntry, &Starts[i]))
+		{
+			os::Printer::log("Could not start all threads of the job system.", ELL_WARNING);
+			break;
+		}
+		++ThreadCount;
+	}
+
+	// the workers have to know their index before the first job arrives
+	SleepMutex.lock();
+	while (Registered < ThreadCount)
+		WakeCondition.wait(SleepMutex);
+	SleepMutex.unlock();
+}
+
+
+//! destructor
+CJobSystem::~CJobSystem()
+{
+	// jobs may still reference data of their owners
+	wait(0);
+
+	SleepMutex.lock();
+	Quit = true;
+	WakeCondition.broadcast();
+	SleepMutex.unlock();
+
+	delete [] Threads;
+	delete [] Starts;
+	delete [] ThreadIds;
+	delete [] Queues;
+}
+
+
+u32 CJobSystem::getCurrentWorkerIndex() const
+{
+	if (!ThreadCount)
+		return 0;
+
+	const size_t id = CThread::getCurrentId();
+	for (u32 i=0; i<ThreadCount; ++i)
+	{
+		if (ThreadIds[i] == id)
+			return i + 1;
+	}
+	return 0;
+}
+
+
+IJobSystem::JobHandle CJobSystem::addJob(JobFunction func, void* userData,
+		const JobHandle* dependencies, u32 dependencyCount)
+{
+	GraphMutex.lock();
+
+	// all slots taken, run other jobs until one is free again
+	while (FreeJob == NO_SLOT && Jobs.size() > SLOT_MASK)
+	{
+		GraphMutex.unlock();
+		if (!runOne(getCurrentWorkerIndex()))
+			CThread::sleep(0);
+		GraphMutex.lock();
+	}
+
+	u32 slot = FreeJob;
+	if (slot != NO_SLOT)
+	{
+		FreeJob = Jobs[slot].NextFree;
+	}
+	else
+	{
+		slot = Jobs.size();
+		Jobs.push_back(SJob());
+		Jobs[slot].Generation = 1;
+	}
+
+	SJob& job = Jobs[slot];
+	job.Function = func;
+	job.UserData = userData;
+	job.Dependencies = 0;
+	job.NextFree = NO_SLOT;
+	++ActiveJobs;
+
+	for (u32 i=0; i<dependencyCount; ++i)
+	{
+		if (isDoneLocked(dependencies[i]))
+			continue;
+
+		Jobs[dependencies[i] & SLOT_MASK].Dependents.push_back(slot);
+		++job.Dependencies;
+	}
+
+	const JobHandle handle = (job.Generation << SLOT_BITS) | slot;
+	const bool ready = (job.Dependencies == 0);
+
+	GraphMutex.unlock();
+
+	if (ready)
+	{
+		SReadyJob r;
+		r.Function = func;
+		r.UserData = userData;
+		r.Slot = slot;
+		push(r, getCurrentWorkerIndex());
+	}
+
+	// without threads the job runs right away, unless it has to wait
+	if (!ThreadCount)
+	{
+		while (runOne(0))
+			;
+	}
+
+	return handle;
+}
+
+
+bool CJobSystem::isJobDone(JobHandle job) const
+{
+	CMutexLock lock(GraphMutex);
+	return isDoneLocked(job);
+}
+
+
+bool CJobSystem::isDoneLocked(JobHandle job) const
+{
+	if (!job)
+		return true;
+
+	const u32 slot = job & SLOT_MASK;
+	return slot >= Jobs.size() || Jobs[slot].Generation != (job >> SLOT_BITS);
+}
+
+
+void CJobSystem::waitForJob(JobHandle job)
+{
+	if (job)
+		wait(job);
+}
+
+
+void CJobSystem::wait(JobHandle job)
+{
+	const u32 worker = getCurrentWorkerIndex();
+
+	for (;;)
+	{
+		GraphMutex.lock();
+		bool done = job ? isDoneLocked(job) : ActiveJobs == 0;
+		GraphMutex.unlock();
+		if (done)
+			return;
+
+		// help instead of waiting
+		if (runOne(worker))
+			continue;
+
+		// the job runs on another thread, sleep until some job finished
+		GraphMutex.lock();
+		++Waiters;
+		while (!(job ? isDoneLocked(job) : ActiveJobs == 0) && ReadyCount <= 0)
+			DoneCondition.wait(GraphMutex);
+		--Waiters;
+		GraphMutex.unlock();
+	}
+}
+
+
+void CJobSystem::push(const SReadyJob& job, u32 queue)
+{
+	Queues[queue].Mutex.lock();
+	Queues[queue].pushBack(job);
+	Queues[queue].Mutex.unlock();
+
+	atomicFetchAdd(&ReadyCount, 1);
+
+	if (ThreadCount)
+	{
+		SleepMutex.lock();
+		if (Sleeping)
+			WakeCondition.signal();
+		SleepMutex.unlock();
+	}
+}
+
+
+bool CJobSystem::runOne(u32 worker)
+{
+	SReadyJob job;
+	bool found;
+
+	// own queue last in first out, that work is still in the cache
+	Queues[worker].Mutex.lock();
+	found = Queues[worker].popBack(job);
+	Queues[worker].Mutex.unlock();
+
+	// steal the oldest job of another queue
+	for (u32 i=1; !found && i<=ThreadCount; ++i)
+	{
+		SQueue& queue = Queues[(worker + i) % (ThreadCount + 1)];
+		queue.Mutex.lock();
+		found = queue.popFront(job);
+		queue.Mutex.unlock();
+	}
+
+	if (!found)
+		return false;
+
+	atomicFetchAdd(&ReadyCount, -1);
+
+	job.Function(job.UserData);
+	finishJob(job.Slot);
+	return true;
+}
+
+
+void CJobSystem::finishJob(u32 slot)
+{
+	const u32 worker = getCurrentWorkerIndex();
+
+	CMutexLock lock(GraphMutex);
+
+	SJob& job = Jobs[slot];
+	for (u32 i=0; i<job.Dependents.size(); ++i)
+	{
+		SJob& dependent = Jobs[job.Dependents[i]];
+		if (--dependent.Dependencies == 0)
+		{
+			SReadyJob r;
+			r.Function = dependent.Function;
+			r.UserData = dependent.UserData;
+			r.Slot = job.Dependents[i];
+			push(r, worker);
+		}
+	}
+	job.Dependents.set_used(0);
+
+	// a new generation makes old handles of the slot report done
+	job.Generation = (job.Generation & GENERATION_MASK) == GENERATION_MASK ? 1 : job.Generation + 1;
+	job.NextFree = FreeJob;
+	FreeJob = slot;
+	--ActiveJobs;
+
+	if (Waiters)
+		DoneCondition.broadcast();
+}
+
+
+void CJobSystem::parallelFor(u32 count, ParallelForFunction func, void* userData)
+{
+	if (!count)
+		return;
+
+	const u32 worker = getCurrentWorkerIndex();
+
+	if (!ThreadCount || count == 1)
+	{
+		for (u32 i=0; i<count; ++i)
+			func(userData, i, worker);
+		return;
+	}
+
+	SParallelFor pf;
+	pf.System = this;
+	pf.Function = func;
+	pf.UserData = userData;
+	pf.Count = (s32)count;
+	pf.NextIndex = 0;
+
+	// helpers which find the range exhausted just return
+	JobHandle helpers[MAX_PARALLEL_FOR_HELPERS];
+	const u32 helperCount = core::min_(core::min_(ThreadCount, count - 1), MAX_PARALLEL_FOR_HELPERS);
+	for (u32 i=0; i<helperCount; ++i)
+		helpers[i] = addJob(parallelForJob, &pf);
+
+	runParallelFor(&pf, worker);
+
+	for (u32 i=0; i<helperCount; ++i)
+		wait(helpers[i]);
+}
+
+
+void CJobSystem::parallelForJob(void* userData)
+{
+	SParallelFor* pf = (SParallelFor*)userData;
+	runParallelFor(pf, pf->System->getCurrentWorkerIndex());
+}
+
+
+void CJobSystem::runParallelFor(SParallelFor* pf, u32 worker)
+{
+	for (;;)
+	{
+		const s32 index = atomicFetchAdd(&pf->NextIndex, 1);
+		if (index >= pf->Count)
+			break;
+		pf->Function(pf->UserData, (u32)index, worker);
+	}
+}
+
+
+void CJobSystem::workerEntry(void* userData)
+{
+	SWorkerStart* start = (SWorkerStart*)userData;
+	start->System->workerLoop(start->WorkerIndex);
+}
+
+
+void CJobSystem::workerLoop(u32 worker)
+{
+	SleepMutex.lock();
+	ThreadIds[worker - 1] = CThread::getCurrentId();
+	++Registered;
+	WakeCondition.broadcast();
+	SleepMutex.unlock();
+
+	for (;;)
+	{
+		if (runOne(worker))
+			continue;
+
+		SleepMutex.lock();
+		++Sleeping;
+		while (!Quit && ReadyCount <= 0)
+			WakeCondition.wait(SleepMutex);
+		--Sleeping;
+		const bool quit = Quit;
+		SleepMutex.unlock();
+
+		if (quit)
+			break;
+	}
+}
+
+
+} // end namespace irr
+
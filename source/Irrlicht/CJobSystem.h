@@ -0,0 +1,142 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_JOB_SYSTEM_H_INCLUDED__
+#define __C_JOB_SYSTEM_H_INCLUDED__
+
+#include "IJobSystem.h"
+#include "CThread.h"
+#include "irrArray.h"
+
+namespace irr
+{
+
+	//! Work stealing implementation of IJobSystem.
+	/** Queue 0 takes the jobs of threads which are not workers, queue i
+	belongs to worker thread i. The job slots and their dependencies are
+	guarded by one mutex, the queues by one mutex each. */
+	class CJobSystem : public IJobSystem
+	{
+	public:
+
+		//! constructor
+		/** \param threadCount Number of worker threads to start, 0 runs
+		all jobs inline. */
+		CJobSystem(u32 threadCount);
+
+		//! destructor, finishes all jobs and joins the threads
+		virtual ~CJobSystem();
+
+		virtual u32 getWorkerCount() const { return ThreadCount + 1; }
+
+		virtual u32 getCurrentWorkerIndex() const;
+
+		virtual JobHandle addJob(JobFunction func, void* userData,
+			const JobHandle* dependencies=0, u32 dependencyCount=0);
+
+		virtual bool isJobDone(JobHandle job) const;
+
+		virtual void waitForJob(JobHandle job);
+
+		virtual void parallelFor(u32 count, ParallelForFunction func, void* userData);
+
+	private:
+
+		struct SReadyJob
+		{
+			JobFunction Function;
+			void* UserData;
+			u32 Slot;
+		};
+
+		//! double ended queue of ready jobs
+		struct SQueue
+		{
+			SQueue() : Head(0), Count(0) {}
+
+			void pushBack(const SReadyJob& job);
+			bool popBack(SReadyJob& job);
+			bool popFront(SReadyJob& job);
+
+			CMutex Mutex;
+			core::array<SReadyJob> Items;	// ring buffer
+			u32 Head;
+			u32 Count;
+		};
+
+		struct SJob
+		{
+			JobFunction Function;
+			void* UserData;
+			//! slots of the jobs waiting for this one
+			core::array<u32> Dependents;
+			//! unfinished dependencies
+			u32 Dependencies;
+			u32 Generation;
+			//! next free slot while in the free list
+			u32 NextFree;
+		};
+
+		struct SParallelFor
+		{
+			CJobSystem* System;
+			ParallelForFunction Function;
+			void* UserData;
+			s32 Count;
+			volatile s32 NextIndex;
+		};
+
+		struct SWorkerStart
+		{
+			CJobSystem* System;
+			u32 WorkerIndex;
+		};
+
+		//! queues a ready job and wakes a sleeping worker
+		void push(const SReadyJob& job, u32 queue);
+
+		//! runs one ready job, the own queue first, then stealing from the others
+		/** \return false if no job was ready */
+		bool runOne(u32 worker);
+
+		//! releases the slot of a finished job and queues its dependents
+		void finishJob(u32 slot);
+
+		//! true if the job finished, GraphMutex must be locked
+		bool isDoneLocked(JobHandle job) const;
+
+		//! waits for one job, or all jobs if job is 0
+		void wait(JobHandle job);
+
+		static void parallelForJob(void* userData);
+		static void runParallelFor(SParallelFor* pf, u32 worker);
+
+		static void workerEntry(void* userData);
+		void workerLoop(u32 worker);
+
+		u32 ThreadCount;
+		CThread* Threads;
+		SWorkerStart* Starts;
+		size_t* ThreadIds;
+		SQueue* Queues;
+
+		mutable CMutex GraphMutex;
+		CCondition DoneCondition;	// with GraphMutex
+		core::array<SJob> Jobs;
+		u32 FreeJob;
+		u32 ActiveJobs;
+		u32 Waiters;
+
+		CMutex SleepMutex;
+		CCondition WakeCondition;	// with SleepMutex
+		volatile s32 ReadyCount;
+		u32 Sleeping;
+		u32 Registered;
+		bool Quit;
+	};
+
+} // end namespace irr
+
+#endif
+
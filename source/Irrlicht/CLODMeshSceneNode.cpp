@@ -0,0 +1,207 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CLODMeshSceneNode.h"
+#include "ISceneManager.h"
+#include "ICameraSceneNode.h"
+#include "IMeshCache.h"
+#include "IFileSystem.h"
+
+namespace irr
+{
+namespace scene
+{
+
+
+//! constructor
+CLODMeshSceneNode::CLODMeshSceneNode(IAnimatedMesh* mesh, ISceneNode* parent, ISceneManager* mgr, s32 id,
+			const core::vector3df& position, const core::vector3df& rotation,
+			const core::vector3df& scale)
+: CMeshSceneNode(0, parent, mgr, id, position, rotation, scale), LODMesh(0), Level(0)
+{
+	#ifdef _DEBUG
+	setDebugName("CLODMeshSceneNode");
+	#endif
+
+	setLODMesh(mesh);
+}
+
+
+//! destructor
+CLODMeshSceneNode::~CLODMeshSceneNode()
+{
+	if (LODMesh)
+		LODMesh->drop();
+}
+
+
+//! selects the level and registers the node
+void CLODMeshSceneNode::OnRegisterSceneNode()
+{
+	if (IsVisible && LODMesh && LODMesh->getLevelCount())
+	{
+		const ICameraSceneNode* camera = SceneManager->getActiveCamera();
+		if (camera)
+		{
+			const u32 level = LODMesh->selectLevel(getLODValue(camera), Level);
+			if (level != Level)
+				setLevel(level);
+		}
+
+		// too small or too far away, only the children are registered
+		if (Level >= LODMesh->getLevelCount())
+		{
+			ISceneNode::OnRegisterSceneNode();
+			return;
+		}
+	}
+
+	CMeshSceneNode::OnRegisterSceneNode();
+}
+
+
+//! returns the screen size or distance of the node for the metric of the chain
+f32 CLODMeshSceneNode::getLODValue(const ICameraSceneNode* camera) const
+{
+	const core::aabbox3d<f32>& box = LODMesh->getBoundingBox();
+	core::vector3df center = box.getCenter();
+	AbsoluteTransformation.transformVect(center);
+
+	if (LODMesh->Metric == ELM_DISTANCE)
+		return center.getDistanceFrom(camera->getAbsolutePosition());
+
+	const core::vector3df scale = AbsoluteTransformation.getScale();
+	const f32 radius = box.getExtent().getLength() * 0.5f *
+		core::max_(scale.X, scale.Y, scale.Z);
+
+	// w of the center in clip space, the distance along the view direction
+	// for perspective and 1 for orthogonal projections
+	core::vector3df viewCenter;
+	camera->getViewMatrix().transformVect(viewCenter, center);
+	const core::matrix4& projection = camera->getProjectionMatrix();
+	const f32 w = projection[11] * viewCenter.Z + projection[15];
+
+	// the camera is inside the bounding sphere, or it is behind the camera
+	if (w <= radius * core::abs_(projection[11]) + core::ROUNDING_ERROR_f32)
+		return FLT_MAX;
+
+	return radius * projection[5] / w;
+}
+
+
+//! switches to a level, getLevelCount() hides the node
+void CLODMeshSceneNode::setLevel(u32 level)
+{
+	Level = level;
+
+	IMesh* mesh = LODMesh->getLevel(level);
+	if (!mesh)
+		return;
+
+	if (ReadOnlyMaterials || !Mesh || mesh->getMeshBufferCount() != Materials.size())
+	{
+		CMeshSceneNode::setMesh(mesh);
+		return;
+	}
+
+	mesh->grab();
+	Mesh->drop();
+	Mesh = mesh;
+}
+
+
+//! Sets the LOD chain.
+void CLODMeshSceneNode::setLODMesh(IAnimatedMesh* mesh)
+{
+	if (mesh && mesh->getMeshType() == EAMT_LOD)
+	{
+		mesh->grab();
+		if (LODMesh)
+			LODMesh->drop();
+
+		LODMesh = static_cast<SLODMesh*>(mesh);
+		Level = 0;
+		CMeshSceneNode::setMesh(LODMesh->getLevel(0));
+	}
+	else
+	{
+		if (LODMesh)
+			LODMesh->drop();
+
+		LODMesh = 0;
+		Level = 0;
+		if (mesh)
+			CMeshSceneNode::setMesh(mesh->getMesh(0));
+	}
+}
+
+
+//! Writes attributes of the scene node.
+void CLODMeshSceneNode::serializeAttributes(io::IAttributes* out, io::SAttributeReadWriteOptions* options) const
+{
+	CMeshSceneNode::serializeAttributes(out, options);
+
+	if (!LODMesh)
+		return;
+
+	// the chain is stored instead of the shown level
+	io::path path = SceneManager->getMeshCache()->getMeshName(LODMesh).getPath();
+	if (options && (options->Flags&io::EARWF_USE_RELATIVE_PATHS) && options->Filename)
+		path = SceneManager->getFileSystem()->getRelativeFilename(
+			SceneManager->getFileSystem()->getAbsolutePath(path), options->Filename);
+	out->setAttribute("Mesh", path.c_str());
+}
+
+
+//! Reads attributes of the scene node.
+void CLODMeshSceneNode::deserializeAttributes(io::IAttributes* in, io::SAttributeReadWriteOptions* options)
+{
+	const io::path newMeshStr = in->getAttributeAsString("Mesh");
+
+	CMeshSceneNode::deserializeAttributes(in, options);
+
+	// the base class shows the first level, so the chain is always set again
+	if (newMeshStr != "")
+	{
+		IAnimatedMesh* newMesh = SceneManager->getMesh(newMeshStr);
+		if (newMesh)
+			setLODMesh(newMesh);
+	}
+}
+
+
+//! Creates a clone of this scene node and its children.
+ISceneNode* CLODMeshSceneNode::clone(ISceneNode* newParent, ISceneManager* newManager)
+{
+	if (!newParent)
+		newParent = Parent;
+	if (!newManager)
+		newManager = SceneManager;
+
+	CLODMeshSceneNode* nb = new CLODMeshSceneNode(LODMesh, newParent,
+		newManager, ID, RelativeTranslation, RelativeRotation, RelativeScale);
+
+	// show the same level, the materials belong to it
+	if (Mesh)
+	{
+		Mesh->grab();
+		if (nb->Mesh)
+			nb->Mesh->drop();
+		nb->Mesh = Mesh;
+	}
+	nb->Level = Level;
+
+	nb->cloneMembers(this, newManager);
+	nb->ReadOnlyMaterials = ReadOnlyMaterials;
+	nb->Materials = Materials;
+
+	if (newParent)
+		nb->drop();
+	return nb;
+}
+
+
+} // end namespace scene
+} // end namespace irr
+
@@ -0,0 +1,70 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_LOD_MESH_SCENE_NODE_H_INCLUDED__
+#define __C_LOD_MESH_SCENE_NODE_H_INCLUDED__
+
+#include "CMeshSceneNode.h"
+#include "SLODMesh.h"
+
+namespace irr
+{
+namespace scene
+{
+	class ICameraSceneNode;
+
+	//! Mesh scene node which shows one level of a shared LOD chain.
+	/** The level is selected each frame before the node registers itself,
+	by the metric of the chain measured from the active camera. Levels
+	with the same number of mesh buffers as the shown one keep the materials
+	of the node, so changes to the materials survive a switch. */
+	class CLODMeshSceneNode : public CMeshSceneNode
+	{
+	public:
+
+		//! constructor
+		CLODMeshSceneNode(IAnimatedMesh* mesh, ISceneNode* parent, ISceneManager* mgr, s32 id,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f));
+
+		//! destructor
+		virtual ~CLODMeshSceneNode();
+
+		//! selects the level and registers the node
+		virtual void OnRegisterSceneNode();
+
+		//! Writes attributes of the scene node.
+		virtual void serializeAttributes(io::IAttributes* out, io::SAttributeReadWriteOptions* options=0) const;
+
+		//! Reads attributes of the scene node.
+		virtual void deserializeAttributes(io::IAttributes* in, io::SAttributeReadWriteOptions* options=0);
+
+		//! Returns type of the scene node
+		virtual ESCENE_NODE_TYPE getType() const { return ESNT_LOD_MESH; }
+
+		//! Creates a clone of this scene node and its children.
+		virtual ISceneNode* clone(ISceneNode* newParent=0, ISceneManager* newManager=0);
+
+		//! Sets the LOD chain.
+		/** Meshes which are not of type EAMT_LOD are shown without LOD switching. */
+		void setLODMesh(IAnimatedMesh* mesh);
+
+	private:
+
+		//! returns the screen size or distance of the node for the metric of the chain
+		f32 getLODValue(const ICameraSceneNode* camera) const;
+
+		//! switches to a level, getLevelCount() hides the node
+		void setLevel(u32 level);
+
+		SLODMesh* LODMesh;
+		u32 Level;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
@@ -4,17 +4,68 @@
 
 #include "CLimitReadFile.h"
 #include "irrString.h"
+#include "irrMap.h"
 
 namespace irr
 {
 namespace io
 {
 
+namespace
+{
+	struct SSharedFileMutex
+	{
+		SSharedFileMutex() : Users(0) {}
+
+		CMutex Mutex;
+		u32 Users;
+	};
+
+	// mutexes of the files which are shared by read files
+	CMutex SharedFileMutexLock;
+	core::map<const IReadFile*, SSharedFileMutex*> SharedFileMutexes;
+}
+
+
+//! returns the mutex of a file which several read files seek and read
+CMutex* grabSharedFileMutex(const IReadFile* file)
+{
+	CMutexLock lock(SharedFileMutexLock);
+
+	core::map<const IReadFile*, SSharedFileMutex*>::Node* node = SharedFileMutexes.find(file);
+	SSharedFileMutex* shared = node ? node->getValue() : 0;
+	if (!shared)
+	{
+		shared = new SSharedFileMutex;
+		SharedFileMutexes.insert(file, shared);
+	}
+	++shared->Users;
+	return &shared->Mutex;
+}
+
+
+//! releases a mutex returned by grabSharedFileMutex
+void dropSharedFileMutex(const IReadFile* file)
+{
+	CMutexLock lock(SharedFileMutexLock);
+
+	core::map<const IReadFile*, SSharedFileMutex*>::Node* node = SharedFileMutexes.find(file);
+	if (!node)
+		return;
+
+	SSharedFileMutex* shared = node->getValue();
+	if (--shared->Users == 0)
+	{
+		SharedFileMutexes.remove(node);
+		delete shared;
+	}
+}
+
 
 CLimitReadFile::CLimitReadFile(IReadFile* alreadyOpenedFile, long pos,
 		long areaSize, const io::path& name)
 	: Filename(name), AreaStart(0), AreaEnd(0), Pos(0),
-	File(alreadyOpenedFile)
+	File(alreadyOpenedFile), FileMutex(0)
 {
 	#ifdef _DEBUG
 	setDebugName("CLimitReadFile");
@@ -23,6 +74,7 @@ CLimitReadFile::CLimitReadFile(IReadFile* alreadyOpenedFile, long pos,
 	if (File)
 	{
 		File->grab();
+		FileMutex = grabSharedFileMutex(File);
 		AreaStart = pos;
 		AreaEnd = AreaStart + areaSize;
 	}
@@ -32,7 +84,10 @@ CLimitReadFile::CLimitReadFile(IReadFile* alreadyOpenedFile, long pos,
 CLimitReadFile::~CLimitReadFile()
 {
 	if (File)
+	{
+		dropSharedFileMutex(File);
 		File->drop();
+	}
 }
 
 
@@ -47,6 +102,18 @@ s32 CLimitReadFile::read(void* buffer, u32 sizeToRead)
 	s32 toRead = core::s32_min(AreaEnd, r + sizeToRead) - core::s32_max(AreaStart, r);
 	if (toRead < 0)
 		return 0;
+
+	// copy from the mapping, which leaves the shared file alone
+	const c8* data = (const c8*)getMappedData();
+	if (data)
+	{
+		memcpy(buffer, data + Pos, toRead);
+		Pos += toRead;
+		return toRead;
+	}
+
+	// the other entries of the archive read the file as well
+	CMutexLock lock(*FileMutex);
 	File->seek(r);
 	r = File->read(buffer, toRead);
 	Pos += r;
@@ -116,6 +183,17 @@ const io::path& CLimitReadFile::getFileName() const
 }
 
 
+//! returns the area in the mapped data of the file, if it has some
+const void* CLimitReadFile::getMappedData() const
+{
+	const c8* data = File ? (const c8*)File->getMappedData() : 0;
+	if (!data || AreaEnd > File->getSize())
+		return 0;
+
+	return data + AreaStart;
+}
+
+
 IReadFile* createLimitReadFile(const io::path& fileName, IReadFile* alreadyOpenedFile, long pos, long areaSize)
 {
 	return new CLimitReadFile(alreadyOpenedFile, pos, areaSize, fileName);
@@ -7,6 +7,7 @@
 
 #include "IReadFile.h"
 #include "irrString.h"
+#include "CThread.h"
 
 namespace irr
 {
@@ -46,6 +47,9 @@ namespace io
 		//! returns name of file
 		virtual const io::path& getFileName() const;
 
+		//! returns the area in the mapped data of the file, if it has some
+		virtual const void* getMappedData() const;
+
 	private:
 
 		io::path Filename;
@@ -53,8 +57,19 @@ namespace io
 		long AreaEnd;
 		long Pos;
 		IReadFile* File;
+		CMutex* FileMutex;
 	};
 
+	//! returns the mutex of a file which several read files seek and read
+	/** The entries of an archive share the file of the archive and seek
+	it before each read, so no other thread may use the file between the
+	seek and the read. All callers passing the same file get the same
+	mutex. Each call has to be matched by dropSharedFileMutex(). */
+	CMutex* grabSharedFileMutex(const IReadFile* file);
+
+	//! releases a mutex returned by grabSharedFileMutex
+	void dropSharedFileMutex(const IReadFile* file);
+
 } // end namespace io
 } // end namespace irr
 
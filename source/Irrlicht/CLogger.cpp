@@ -8,7 +8,7 @@ namespace irr
 {
 
 	CLogger::CLogger(IEventReceiver* r)
-		: LogLevel(ELL_INFORMATION), Receiver(r)
+		: LogLevel(ELL_INFORMATION), Receiver(r), OwnerThread(CThread::getCurrentId())
 	{
 		#ifdef _DEBUG
 		setDebugName("CLogger");
@@ -33,6 +33,17 @@ namespace irr
 		if (ll < LogLevel)
 			return;
 
+		if (CThread::getCurrentId() != OwnerThread)
+		{
+			SQueuedLog entry;
+			entry.Text = text;
+			entry.Level = ll;
+			QueuedLogMutex.lock();
+			QueuedLogs.push_back(entry);
+			QueuedLogMutex.unlock();
+			return;
+		}
+
 		if (Receiver)
 		{
 			SEvent event;
@@ -97,6 +108,21 @@ namespace irr
 		Receiver = r;
 	}
 
+	//! Logs the texts of other threads, when called by the thread which created the logger
+	void CLogger::processQueuedLogs()
+	{
+		if (CThread::getCurrentId() != OwnerThread)
+			return;
+
+		core::array<SQueuedLog> logs;
+		QueuedLogMutex.lock();
+		logs.swap(QueuedLogs);
+		QueuedLogMutex.unlock();
+
+		for (u32 i=0; i<logs.size(); ++i)
+			log(logs[i].Text.c_str(), logs[i].Level);
+	}
+
 
 } // end namespace irr
 
@@ -9,6 +9,8 @@
 #include "os.h"
 #include "irrString.h"
 #include "IEventReceiver.h"
+#include "irrArray.h"
+#include "CThread.h"
 
 namespace irr
 {
@@ -44,10 +46,24 @@ public:
 	//! Sets a new event receiver
 	void setReceiver(IEventReceiver* r);
 
+	//! Logs the texts of other threads, when called by the thread which created the logger
+	void processQueuedLogs();
+
 private:
 
+	struct SQueuedLog
+	{
+		core::stringc Text;
+		ELOG_LEVEL Level;
+	};
+
 	ELOG_LEVEL LogLevel;
 	IEventReceiver* Receiver;
+
+	//! texts of other threads, the event receiver only runs on the creating thread
+	size_t OwnerThread;
+	CMutex QueuedLogMutex;
+	core::array<SQueuedLog> QueuedLogs;
 };
 
 } // end namespace
@@ -0,0 +1,126 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CMappedReadFile.h"
+#include "IrrCompileConfig.h"
+
+#if defined(_IRR_POSIX_API_) && !defined(_IRR_WCHAR_FILESYSTEM)
+	#define _IRR_MAP_READ_FILES_
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace irr
+{
+namespace io
+{
+
+
+CMappedReadFile::CMappedReadFile(const io::path& fileName, const void* data, long size)
+: Data(data), Size(size), Pos(0), Filename(fileName)
+{
+	#ifdef _DEBUG
+	setDebugName("CMappedReadFile");
+	#endif
+}
+
+
+CMappedReadFile::~CMappedReadFile()
+{
+#ifdef _IRR_MAP_READ_FILES_
+	munmap((void*)Data, Size);
+#endif
+}
+
+
+//! returns how much was read
+s32 CMappedReadFile::read(void* buffer, u32 sizeToRead)
+{
+	s32 amount = static_cast<s32>(sizeToRead);
+	if (Pos + amount > Size)
+		amount -= Pos + amount - Size;
+
+	if (amount <= 0)
+		return 0;
+
+	memcpy(buffer, (const c8*)Data + Pos, amount);
+	Pos += amount;
+	return amount;
+}
+
+
+//! changes position in file, returns true if successful
+//! if relativeMovement==true, the pos is changed relative to current pos,
+//! otherwise from begin of file
+bool CMappedReadFile::seek(long finalPos, bool relativeMovement)
+{
+	if (relativeMovement)
+		finalPos += Pos;
+
+	if (finalPos < 0 || finalPos > Size)
+		return false;
+
+	Pos = finalPos;
+	return true;
+}
+
+
+//! returns size of file
+long CMappedReadFile::getSize() const
+{
+	return Size;
+}
+
+
+//! returns where in the file we are.
+long CMappedReadFile::getPos() const
+{
+	return Pos;
+}
+
+
+//! returns name of file
+const io::path& CMappedReadFile::getFileName() const
+{
+	return Filename;
+}
+
+
+IReadFile* createMappedReadFile(const io::path& fileName)
+{
+#ifdef _IRR_MAP_READ_FILES_
+	if (fileName.size() == 0)
+		return 0;
+
+	const int fd = open(fileName.c_str(), O_RDONLY);
+	if (fd == -1)
+		return 0;
+
+	// pipes and devices are read with CReadFile, empty files can't be mapped
+	struct stat info;
+	void* data = MAP_FAILED;
+	if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 &&
+		(off_t)(long)info.st_size == info.st_size)
+	{
+		data = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+
+	// the mapping stays valid without the descriptor
+	close(fd);
+
+	if (data == MAP_FAILED)
+		return 0;
+
+	return new CMappedReadFile(fileName, data, (long)info.st_size);
+#else
+	return 0;
+#endif
+}
+
+
+} // end namespace io
+} // end namespace irr
+
@@ -0,0 +1,65 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_MAPPED_READ_FILE_H_INCLUDED__
+#define __C_MAPPED_READ_FILE_H_INCLUDED__
+
+#include "IReadFile.h"
+#include "irrString.h"
+
+namespace irr
+{
+namespace io
+{
+
+	/*!
+		Class for reading a real file from disk which is mapped into memory.
+		Reading copies from the mapping, getMappedData() gives direct
+		access to it. The pages are loaded by the operating system when
+		they are touched.
+	*/
+	class CMappedReadFile : public IReadFile
+	{
+	public:
+
+		CMappedReadFile(const io::path& fileName, const void* data, long size);
+
+		virtual ~CMappedReadFile();
+
+		//! returns how much was read
+		virtual s32 read(void* buffer, u32 sizeToRead);
+
+		//! changes position in file, returns true if successful
+		virtual bool seek(long finalPos, bool relativeMovement = false);
+
+		//! returns size of file
+		virtual long getSize() const;
+
+		//! returns where in the file we are.
+		virtual long getPos() const;
+
+		//! returns name of file
+		virtual const io::path& getFileName() const;
+
+		//! returns the mapped content of the file
+		virtual const void* getMappedData() const { return Data; }
+
+	private:
+
+		const void* Data;
+		long Size;
+		long Pos;
+		io::path Filename;
+	};
+
+	//! maps a file into memory
+	/** \return The file, or 0 if it can't be mapped, for example because
+	it is empty, no regular file or the platform has no mmap. */
+	IReadFile* createMappedReadFile(const io::path& fileName);
+
+} // end namespace io
+} // end namespace irr
+
+#endif
+
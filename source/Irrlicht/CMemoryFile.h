@@ -46,6 +46,9 @@ namespace io
 		//! returns name of file
 		virtual const io::path& getFileName() const;
 
+		//! returns the memory of the file
+		virtual const void* getMappedData() const { return Buffer; }
+
 	private:
 
 		void *Buffer;
@@ -0,0 +1,296 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CMeshLoadQueue.h"
+#include "ISceneManager.h"
+#include "IMeshCache.h"
+#include "IMeshLoader.h"
+#include "IAnimatedMesh.h"
+#include "IReadFile.h"
+#include "IVideoDriver.h"
+#include "os.h"
+#include "CProfiler.h"
+
+namespace irr
+{
+namespace scene
+{
+
+//! constructor, starts the worker
+CMeshLoadQueue::CMeshLoadQueue(ISceneManager* smgr, video::IVideoDriver* driver)
+: SceneManager(smgr), Driver(driver), Quit(false), WorkerDone(false)
+{
+	if (!Worker.start(workerMain, this))
+	{
+		os::Printer::log("Could not start the mesh loading thread, meshes are loaded in drawAll.", ELL_WARNING);
+		WorkerDone = true;
+	}
+}
+
+
+//! destructor, waits for the current load and drops all requests
+CMeshLoadQueue::~CMeshLoadQueue()
+{
+	Mutex.lock();
+	Quit = true;
+	Wake.signal();
+	Mutex.unlock();
+
+	// the worker may wait for a texture, which only this thread can create
+	for (;;)
+	{
+		Mutex.lock();
+		const bool done = WorkerDone;
+		Mutex.unlock();
+		if (done)
+			break;
+		if (Driver)
+			Driver->processQueuedCalls();
+		CThread::sleep(1);
+	}
+	Worker.join();
+
+	for (u32 i=0; i<Requests.size(); ++i)
+	{
+		SRequest* request = Requests[i];
+		if (request->File)
+			request->File->drop();
+		if (request->Mesh)
+			request->Mesh->drop();
+		for (u32 c=0; c<request->CallBacks.size(); ++c)
+			request->CallBacks[c]->drop();
+		delete request;
+	}
+}
+
+
+//! adds the callback to the pending request of a file
+bool CMeshLoadQueue::addToPending(const io::path& filename, IMeshLoadCallBack* callback)
+{
+	for (u32 i=0; i<Requests.size(); ++i)
+	{
+		if (Requests[i]->Filename == filename)
+		{
+			if (callback)
+			{
+				callback->grab();
+				Requests[i]->CallBacks.push_back(callback);
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+
+//! adds a request
+void CMeshLoadQueue::add(const io::path& filename, io::IReadFile* file, IAnimatedMesh* mesh,
+		IMeshLoadCallBack* callback)
+{
+	SRequest* request = new SRequest;
+	request->Filename = filename;
+	request->File = file;
+	request->Mesh = file ? 0 : mesh;
+	request->Done = (file == 0);
+	request->TextureCreationFlags = getTextureCreationFlags();
+	if (request->File)
+		request->File->grab();
+	if (request->Mesh)
+		request->Mesh->grab();
+	if (callback)
+	{
+		callback->grab();
+		request->CallBacks.push_back(callback);
+	}
+	Requests.push_back(request);
+
+	if (!file)
+		return;
+
+	Mutex.lock();
+	const bool threaded = !WorkerDone;
+	if (threaded)
+	{
+		Loads.push_back(request);
+		Wake.signal();
+	}
+	Mutex.unlock();
+
+	// no worker, load on the calling thread
+	if (!threaded)
+	{
+		request->Mesh = loadMesh(file);
+		request->Done = true;
+	}
+}
+
+
+//! adds finished meshes to the cache and calls their callbacks
+void CMeshLoadQueue::deliver(IMeshCache* cache)
+{
+	// messages of the loaders on the worker
+	os::Printer::processQueuedLogs();
+
+	if (!Requests.size())
+		return;
+
+	// take the finished requests out first, callbacks may add new ones
+	core::array<SRequest*> finished;
+	Mutex.lock();
+	u32 kept = 0;
+	for (u32 i=0; i<Requests.size(); ++i)
+	{
+		if (Requests[i]->Done)
+			finished.push_back(Requests[i]);
+		else
+			Requests[kept++] = Requests[i];
+	}
+	Mutex.unlock();
+	Requests.set_used(kept);
+
+	for (u32 i=0; i<finished.size(); ++i)
+	{
+		SRequest* request = finished[i];
+
+		if (request->File)
+		{
+			if (request->Mesh)
+			{
+				// getMesh may have loaded the file meanwhile
+				IAnimatedMesh* cached = cache->getMeshByName(request->Filename);
+				if (cached)
+				{
+					cached->grab();
+					request->Mesh->drop();
+					request->Mesh = cached;
+				}
+				else
+				{
+					cache->addMesh(request->Filename, request->Mesh);
+					os::Printer::log("Loaded mesh", request->Filename, ELL_INFORMATION);
+				}
+			}
+			else
+				os::Printer::log("Could not load mesh, file format seems to be unsupported", request->Filename, ELL_ERROR);
+
+			request->File->drop();
+		}
+
+		for (u32 c=0; c<request->CallBacks.size(); ++c)
+		{
+			request->CallBacks[c]->OnMeshLoaded(request->Filename, request->Mesh);
+			request->CallBacks[c]->drop();
+		}
+
+		if (request->Mesh)
+			request->Mesh->drop();
+		delete request;
+	}
+}
+
+
+//! waits until the worker does not use the mesh loaders and blocks it
+void CMeshLoadQueue::lockLoaders()
+{
+	while (!LoaderMutex.tryLock())
+	{
+		if (Driver)
+			Driver->processQueuedCalls();
+		CThread::sleep(1);
+	}
+}
+
+
+//! allows the worker to use the mesh loaders again
+void CMeshLoadQueue::unlockLoaders()
+{
+	LoaderMutex.unlock();
+}
+
+
+//! entry point of the worker
+void CMeshLoadQueue::workerMain(void* data)
+{
+	((CMeshLoadQueue*)data)->workerLoop();
+}
+
+
+//! loads the files of the requests until the queue is destroyed
+void CMeshLoadQueue::workerLoop()
+{
+	Mutex.lock();
+	for (;;)
+	{
+		while (!Quit && !Loads.size())
+			Wake.wait(Mutex);
+		if (Quit)
+			break;
+
+		SRequest* request = Loads[0];
+		Loads.erase(0);
+		Mutex.unlock();
+
+		LoaderMutex.lock();
+		setTextureCreationFlags(request->TextureCreationFlags);
+		IAnimatedMesh* mesh = loadMesh(request->File);
+		LoaderMutex.unlock();
+
+		Mutex.lock();
+		request->Mesh = mesh;
+		request->Done = true;
+	}
+	WorkerDone = true;
+	Mutex.unlock();
+}
+
+
+//! parses a file with the first mesh loader which accepts it
+IAnimatedMesh* CMeshLoadQueue::loadMesh(io::IReadFile* file)
+{
+	_IRR_PROFILE("getMesh: load");
+
+	const io::path& name = file->getFileName();
+
+	// iterate the list in reverse order so user-added loaders can override the built-in ones
+	for (s32 i=(s32)SceneManager->getMeshLoaderCount()-1; i>=0; --i)
+	{
+		IMeshLoader* loader = SceneManager->getMeshLoader(i);
+		if (loader->isALoadableFileExtension(name))
+		{
+			// reset file to avoid side effects of previous calls to createMesh
+			file->seek(0);
+			IAnimatedMesh* mesh = loader->createMesh(file);
+			if (mesh)
+				return mesh;
+		}
+	}
+	return 0;
+}
+
+
+//! returns the texture creation flags of the calling thread
+u32 CMeshLoadQueue::getTextureCreationFlags() const
+{
+	u32 flags = 0;
+	for (u32 flag=video::ETCF_ALWAYS_16_BIT; Driver && flag<=video::ETCF_ALLOW_NON_POWER_2; flag<<=1)
+	{
+		if (Driver->getTextureCreationFlag((video::E_TEXTURE_CREATION_FLAG)flag))
+			flags |= flag;
+	}
+	return flags;
+}
+
+
+//! sets the texture creation flags of the calling thread
+void CMeshLoadQueue::setTextureCreationFlags(u32 flags)
+{
+	// the driver keeps the flags of other threads apart from its own
+	for (u32 flag=video::ETCF_ALWAYS_16_BIT; Driver && flag<=video::ETCF_ALLOW_NON_POWER_2; flag<<=1)
+		Driver->setTextureCreationFlag((video::E_TEXTURE_CREATION_FLAG)flag, (flags & flag) != 0);
+}
+
+
+} // end namespace scene
+} // end namespace irr
+
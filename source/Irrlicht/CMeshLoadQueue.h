@@ -0,0 +1,122 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_MESH_LOAD_QUEUE_H_INCLUDED__
+#define __C_MESH_LOAD_QUEUE_H_INCLUDED__
+
+#include "IMeshLoadCallBack.h"
+#include "CThread.h"
+#include "irrArray.h"
+
+namespace irr
+{
+namespace io
+{
+	class IReadFile;
+} // end namespace io
+namespace video
+{
+	class IVideoDriver;
+} // end namespace video
+namespace scene
+{
+	class ISceneManager;
+	class IMeshCache;
+
+	//! Loads meshes on a worker thread for ISceneManager::getMeshAsync.
+	/** The mesh loaders keep state while they parse, so one worker thread
+	runs the loads one after another and every other use of the loaders
+	has to be enclosed by lockLoaders() and unlockLoaders(). Requests and
+	results are only touched by the thread owning the scene manager, the
+	worker only sees the files and writes the mesh of the current load.
+	Each load starts with the texture creation flags the driver had when
+	it was requested, flags the loader changes only apply to its own
+	texture calls. */
+	class CMeshLoadQueue
+	{
+	public:
+
+		//! constructor, starts the worker
+		CMeshLoadQueue(ISceneManager* smgr, video::IVideoDriver* driver);
+
+		//! destructor, waits for the current load and drops all requests
+		~CMeshLoadQueue();
+
+		//! adds the callback to the pending request of a file
+		/** \return false if no request for the file is pending. */
+		bool addToPending(const io::path& filename, IMeshLoadCallBack* callback);
+
+		//! adds a request
+		/** \param filename Name of the mesh in the cache.
+		\param file File to parse on the worker, the queue grabs it. 0 if
+		the mesh is delivered without loading.
+		\param mesh Mesh to deliver when no file is given. May be 0 for
+		files which could not be opened. */
+		void add(const io::path& filename, io::IReadFile* file, IAnimatedMesh* mesh,
+			IMeshLoadCallBack* callback);
+
+		//! adds finished meshes to the cache and calls their callbacks
+		void deliver(IMeshCache* cache);
+
+		//! returns the number of requests which were not delivered yet
+		u32 getPendingCount() const { return Requests.size(); }
+
+		//! waits until the worker does not use the mesh loaders and blocks it
+		/** Texture calls of the worker are run while waiting, it might
+		need one to finish. */
+		void lockLoaders();
+
+		//! allows the worker to use the mesh loaders again
+		void unlockLoaders();
+
+	private:
+
+		struct SRequest
+		{
+			io::path Filename;
+			io::IReadFile* File;
+			IAnimatedMesh* Mesh;
+			//! texture creation flags of the driver when the request was added
+			u32 TextureCreationFlags;
+			core::array<IMeshLoadCallBack*> CallBacks;
+			bool Done;
+		};
+
+		//! entry point of the worker
+		static void workerMain(void* data);
+
+		//! loads the files of the requests until the queue is destroyed
+		void workerLoop();
+
+		//! parses a file with the first mesh loader which accepts it
+		IAnimatedMesh* loadMesh(io::IReadFile* file);
+
+		//! returns the texture creation flags of the calling thread
+		u32 getTextureCreationFlags() const;
+
+		//! sets the texture creation flags of the calling thread
+		void setTextureCreationFlags(u32 flags);
+
+		ISceneManager* SceneManager;
+		video::IVideoDriver* Driver;
+
+		//! requests in the order they were added, owned by the main thread
+		core::array<SRequest*> Requests;
+
+		//! requests whose file the worker has to load
+		core::array<SRequest*> Loads;
+
+		CMutex Mutex;
+		CCondition Wake;
+		CMutex LoaderMutex;
+		CThread Worker;
+		bool Quit;
+		bool WorkerDone;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
@@ -6,6 +6,8 @@
 #include "SMesh.h"
 #include "CMeshBuffer.h"
 #include "SAnimatedMesh.h"
+#include "CMeshSimplifier.h"
+#include "CDynamicMeshBuffer.h"
 #include "os.h"
 #include "irrMap.h"
 
@@ -760,175 +762,263 @@ IMesh* CMeshManipulator::createMeshUniquePrimitives(IMesh* mesh) const
 }
 
 
-//! Creates a copy of a mesh, which will have identical vertices welded together
-// not yet 32bit
-IMesh* CMeshManipulator::createMeshWelded(IMesh *mesh, f32 tolerance) const
+namespace
 {
-	SMesh* clone = new SMesh();
-	clone->BoundingBox = mesh->getBoundingBox();
+	//! if createMeshWelded merges two vertices
+	inline bool isWeldable(const video::S3DVertex& a, const video::S3DVertex& b, f32 tolerance)
+	{
+		return a.Pos.equals(b.Pos, tolerance) &&
+			a.Normal.equals(b.Normal, tolerance) &&
+			a.TCoords.equals(b.TCoords) &&
+			(a.Color == b.Color);
+	}
 
-	core::array<u16> redirects;
+	inline bool isWeldable(const video::S3DVertex2TCoords& a, const video::S3DVertex2TCoords& b, f32 tolerance)
+	{
+		return a.Pos.equals(b.Pos, tolerance) &&
+			a.Normal.equals(b.Normal, tolerance) &&
+			a.TCoords.equals(b.TCoords) &&
+			a.TCoords2.equals(b.TCoords2) &&
+			(a.Color == b.Color);
+	}
 
-	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
+	inline bool isWeldable(const video::S3DVertexTangents& a, const video::S3DVertexTangents& b, f32 tolerance)
 	{
-		const IMeshBuffer* const mb = mesh->getMeshBuffer(b);
-		// reset redirect list
-		redirects.set_used(mb->getVertexCount());
+		return a.Pos.equals(b.Pos, tolerance) &&
+			a.Normal.equals(b.Normal, tolerance) &&
+			a.TCoords.equals(b.TCoords) &&
+			a.Tangent.equals(b.Tangent, tolerance) &&
+			a.Binormal.equals(b.Binormal, tolerance) &&
+			(a.Color == b.Color);
+	}
 
-		const u16* indices = 0;
-		u32 indexCount = 0;
-		core::array<u16>* outIdx = 0;
+	const u32 InvalidVertex = 0xffffffff;
 
-		switch(mb->getVertexType())
+	//! grid of vertex positions, each cell has a list of its vertices
+	class CWeldGrid
+	{
+	public:
+		CWeldGrid(u32 vertexCount)
 		{
-		case video::EVT_STANDARD:
+			u32 size = 1;
+			while (size < vertexCount * 2)
+				size *= 2;
+
+			Keys.set_used(size);
+			Heads.set_used(size);
+			memset(Heads.pointer(), 0xff, size * sizeof(u32));
+			Next.set_used(vertexCount);
+		}
+
+		//! returns the last vertex added to a cell, InvalidVertex if there is none
+		u32 getFirst(u64 key) const
 		{
-			SMeshBuffer* buffer = new SMeshBuffer();
-			buffer->BoundingBox = mb->getBoundingBox();
-			buffer->Material = mb->getMaterial();
-			clone->addMeshBuffer(buffer);
-			buffer->drop();
+			return Heads[findSlot(key)];
+		}
 
-			video::S3DVertex* v =
-					(video::S3DVertex*)mb->getVertices();
+		//! returns the vertex added to the same cell before
+		u32 getNext(u32 vertex) const
+		{
+			return Next[vertex];
+		}
+
+		void insert(u64 key, u32 vertex)
+		{
+			const u32 slot = findSlot(key);
+			Keys[slot] = key;
+			Next[vertex] = Heads[slot];
+			Heads[slot] = vertex;
+		}
 
-			u32 vertexCount = mb->getVertexCount();
+	private:
+		u32 findSlot(u64 key) const
+		{
+			const u32 mask = Heads.size() - 1;
+			u32 slot = (u32)((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+			while (Heads[slot] != InvalidVertex && Keys[slot] != key)
+				slot = (slot + 1) & mask;
+			return slot;
+		}
 
-			indices = mb->getIndices();
-			indexCount = mb->getIndexCount();
-			outIdx = &buffer->Indices;
+		core::array<u64> Keys;
+		core::array<u32> Heads;
+		core::array<u32> Next;
+	};
+
+	//! finds for each vertex the first vertex before it which it can be welded to
+	/** The cells of the grid are at least twice as large as the tolerance,
+	so the vertices a vertex can be welded to are in the 27 cells around it.
+	\param redirects Receives the new index of each vertex.
+	\param unique Receives the vertices which are kept. */
+	template <class T>
+	void findWeldRedirects(const T* v, u32 vertexCount, f32 tolerance,
+		core::array<u32>& redirects, core::array<u32>& unique)
+	{
+		redirects.set_used(vertexCount);
+		unique.set_used(0);
+		if (!vertexCount)
+			return;
 
-			buffer->Vertices.reallocate(vertexCount);
+		core::aabbox3df box(v[0].Pos);
+		for (u32 i=1; i<vertexCount; ++i)
+			box.addInternalPoint(v[i].Pos);
 
-			for (u32 i=0; i < vertexCount; ++i)
+		// at most 2^20 cells along an axis, so the cell coordinates fit into 21 bits
+		const core::vector3df extent = box.getExtent();
+		f64 cellSize = core::max_((f64)tolerance * 2.0,
+			(f64)core::max_(extent.X, extent.Y, extent.Z) / (1 << 20));
+		if (cellSize <= 0.0)
+			cellSize = 1.0;
+
+		CWeldGrid grid(vertexCount);
+
+		for (u32 i=0; i<vertexCount; ++i)
+		{
+			const s32 x = (s32)floor((v[i].Pos.X - box.MinEdge.X) / cellSize);
+			const s32 y = (s32)floor((v[i].Pos.Y - box.MinEdge.Y) / cellSize);
+			const s32 z = (s32)floor((v[i].Pos.Z - box.MinEdge.Z) / cellSize);
+
+			// the first matching vertex, like a search through all previous vertices
+			u32 match = InvalidVertex;
+			for (s32 cz=z-1; cz<=z+1; ++cz)
+			for (s32 cy=y-1; cy<=y+1; ++cy)
+			for (s32 cx=x-1; cx<=x+1; ++cx)
 			{
-				bool found = false;
-				for (u32 j=0; j < i; ++j)
-				{
-					if ( v[i].Pos.equals( v[j].Pos, tolerance) &&
-						 v[i].Normal.equals( v[j].Normal, tolerance) &&
-						 v[i].TCoords.equals( v[j].TCoords ) &&
-						(v[i].Color == v[j].Color) )
-					{
-						redirects[i] = redirects[j];
-						found = true;
-						break;
-					}
-				}
-				if (!found)
+				if (cx < 0 || cy < 0 || cz < 0)
+					continue;
+
+				const u64 key = (u64)cx | ((u64)cy << 21) | ((u64)cz << 42);
+				for (u32 j=grid.getFirst(key); j!=InvalidVertex; j=grid.getNext(j))
 				{
-					redirects[i] = buffer->Vertices.size();
-					buffer->Vertices.push_back(v[i]);
+					if (j < match && isWeldable(v[i], v[j], tolerance))
+						match = j;
 				}
 			}
-			
-			break;
+
+			if (match != InvalidVertex)
+				redirects[i] = redirects[match];
+			else
+			{
+				redirects[i] = unique.size();
+				unique.push_back(i);
+			}
+
+			grid.insert((u64)x | ((u64)y << 21) | ((u64)z << 42), i);
 		}
-		case video::EVT_2TCOORDS:
+	}
+
+	//! creates a copy of a mesh buffer with identical vertices welded together
+	/** 16 bit buffers are copied into a CMeshBuffer, 32 bit ones into a CDynamicMeshBuffer. */
+	template <class T>
+	IMeshBuffer* createWeldedBuffer(const IMeshBuffer* mb, f32 tolerance)
+	{
+		const T* v = (const T*)mb->getVertices();
+		const u32 indexCount = mb->getIndexCount();
+
+		core::array<u32> redirects;
+		core::array<u32> unique;
+		findWeldRedirects(v, mb->getVertexCount(), tolerance, redirects, unique);
+
+		if (mb->getIndexType() == video::EIT_16BIT)
 		{
-			SMeshBufferLightMap* buffer = new SMeshBufferLightMap();
+			CMeshBuffer<T>* buffer = new CMeshBuffer<T>();
 			buffer->BoundingBox = mb->getBoundingBox();
 			buffer->Material = mb->getMaterial();
-			clone->addMeshBuffer(buffer);
-			buffer->drop();
 
-			video::S3DVertex2TCoords* v =
-					(video::S3DVertex2TCoords*)mb->getVertices();
+			buffer->Vertices.reallocate(unique.size());
+			for (u32 i=0; i<unique.size(); ++i)
+				buffer->Vertices.push_back(v[unique[i]]);
 
-			u32 vertexCount = mb->getVertexCount();
+			const u16* indices = mb->getIndices();
+			buffer->Indices.set_used(indexCount);
+			for (u32 i=0; i<indexCount; ++i)
+				buffer->Indices[i] = (u16)redirects[indices[i]];
 
-			indices = mb->getIndices();
-			indexCount = mb->getIndexCount();
-			outIdx = &buffer->Indices;
+			return buffer;
+		}
 
-			buffer->Vertices.reallocate(vertexCount);
+		CDynamicMeshBuffer* buffer = new CDynamicMeshBuffer(mb->getVertexType(), video::EIT_32BIT);
+		buffer->setBoundingBox(mb->getBoundingBox());
+		buffer->getMaterial() = mb->getMaterial();
 
-			for (u32 i=0; i < vertexCount; ++i)
-			{
-				bool found = false;
-				for (u32 j=0; j < i; ++j)
-				{
-					if ( v[i].Pos.equals( v[j].Pos, tolerance) &&
-						 v[i].Normal.equals( v[j].Normal, tolerance) &&
-						 v[i].TCoords.equals( v[j].TCoords ) &&
-						 v[i].TCoords2.equals( v[j].TCoords2 ) &&
-						(v[i].Color == v[j].Color) )
-					{
-						redirects[i] = redirects[j];
-						found = true;
-						break;
-					}
-				}
-				if (!found)
-				{
-					redirects[i] = buffer->Vertices.size();
-					buffer->Vertices.push_back(v[i]);
-				}
-			}
-			break;
-		}
-		case video::EVT_TANGENTS:
-		{
-			SMeshBufferTangents* buffer = new SMeshBufferTangents();
-			buffer->BoundingBox = mb->getBoundingBox();
-			buffer->Material = mb->getMaterial();
-			clone->addMeshBuffer(buffer);
-			buffer->drop();
+		buffer->getVertexBuffer().reallocate(unique.size());
+		for (u32 i=0; i<unique.size(); ++i)
+			buffer->getVertexBuffer().push_back(v[unique[i]]);
 
-			video::S3DVertexTangents* v =
-					(video::S3DVertexTangents*)mb->getVertices();
+		const u32* indices = (const u32*)mb->getIndices();
+		buffer->getIndexBuffer().reallocate(indexCount);
+		for (u32 i=0; i<indexCount; ++i)
+			buffer->getIndexBuffer().push_back(redirects[indices[i]]);
 
-			u32 vertexCount = mb->getVertexCount();
+		return buffer;
+	}
+}
 
-			indices = mb->getIndices();
-			indexCount = mb->getIndexCount();
-			outIdx = &buffer->Indices;
 
-			buffer->Vertices.reallocate(vertexCount);
+//! Creates a copy of a mesh, which will have identical vertices welded together
+IMesh* CMeshManipulator::createMeshWelded(IMesh *mesh, f32 tolerance) const
+{
+	SMesh* clone = new SMesh();
+	clone->BoundingBox = mesh->getBoundingBox();
+
+	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
+	{
+		const IMeshBuffer* const mb = mesh->getMeshBuffer(b);
+		IMeshBuffer* buffer = 0;
 
-			for (u32 i=0; i < vertexCount; ++i)
-			{
-				bool found = false;
-				for (u32 j=0; j < i; ++j)
-				{
-					if ( v[i].Pos.equals( v[j].Pos, tolerance) &&
-						 v[i].Normal.equals( v[j].Normal, tolerance) &&
-						 v[i].TCoords.equals( v[j].TCoords ) &&
-						 v[i].Tangent.equals( v[j].Tangent, tolerance ) &&
-						 v[i].Binormal.equals( v[j].Binormal, tolerance ) &&
-						(v[i].Color == v[j].Color) )
-					{
-						redirects[i] = redirects[j];
-						found = true;
-						break;
-					}
-				}
-				if (!found)
-				{
-					redirects[i] = buffer->Vertices.size();
-					buffer->Vertices.push_back(v[i]);
-				}
-			}
+		switch(mb->getVertexType())
+		{
+		case video::EVT_STANDARD:
+			buffer = createWeldedBuffer<video::S3DVertex>(mb, tolerance);
+			break;
+		case video::EVT_2TCOORDS:
+			buffer = createWeldedBuffer<video::S3DVertex2TCoords>(mb, tolerance);
+			break;
+		case video::EVT_TANGENTS:
+			buffer = createWeldedBuffer<video::S3DVertexTangents>(mb, tolerance);
 			break;
-		}
 		default:
 			os::Printer::log("Cannot create welded mesh, vertex type unsupported", ELL_ERROR);
 			break;
 		}
 
-		// write the buffer's index list
-		core::array<u16> &Indices = *outIdx;
-
-		Indices.set_used(indexCount);
-		for (u32 i=0; i<indexCount; ++i)
+		if (buffer)
 		{
-			Indices[i] = redirects[ indices[i] ];
+			clone->addMeshBuffer(buffer);
+			buffer->drop();
 		}
 	}
 	return clone;
 }
 
 
+//! Creates a copy of the mesh with fewer triangles, collapsing the edges with the smallest quadric error.
+IMesh* CMeshManipulator::createSimplifiedMesh(IMesh* mesh, f32 targetRatio, f32 maxError) const
+{
+	if (!mesh)
+		return 0;
+
+	SMesh* clone = new SMesh();
+	targetRatio = core::clamp(targetRatio, 0.f, 1.f);
+
+	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
+	{
+		const IMeshBuffer* const mb = mesh->getMeshBuffer(b);
+
+		CMeshSimplifier simplifier(mb);
+		const u32 targetTriangles = core::round32(mb->getIndexCount() / 3 * targetRatio);
+		simplifier.simplify(targetTriangles * 3, maxError);
+
+		IMeshBuffer* buffer = simplifier.createMeshBuffer();
+		clone->addMeshBuffer(buffer);
+		buffer->drop();
+	}
+
+	clone->recalculateBoundingBox();
+	return clone;
+}
+
+
 //! Creates a copy of the mesh, which will only consist of S3DVertexTangents vertices.
 // not yet 32bit
 IMesh* CMeshManipulator::createMeshWithTangents(IMesh* mesh, bool recalculateNormals, bool smooth, bool angleWeighted, bool calculateTangents) const
@@ -75,6 +75,9 @@ public:
 	//! Creates a copy of the mesh, which will have all duplicated vertices removed, i.e. maximal amount of vertices are shared via indexing.
 	virtual IMesh* createMeshWelded(IMesh *mesh, f32 tolerance=core::ROUNDING_ERROR_f32) const;
 
+	//! Creates a copy of the mesh with fewer triangles, collapsing the edges with the smallest quadric error.
+	virtual IMesh* createSimplifiedMesh(IMesh* mesh, f32 targetRatio, f32 maxError=0.f) const;
+
 	//! Returns amount of polygons in mesh.
 	virtual s32 getPolyCount(scene::IMesh* mesh) const;
 
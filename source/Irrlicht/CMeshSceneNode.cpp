@@ -48,6 +48,12 @@ CMeshSceneNode::~CMeshSceneNode()
 //! frame
 void CMeshSceneNode::OnRegisterSceneNode()
 {
+	if (!MeshVisible)
+	{
+		ISceneNode::OnRegisterSceneNode();
+		return;
+	}
+
 	if (IsVisible)
 	{
 		// because this node supports rendering of mixed mode meshes consisting of
@@ -102,7 +108,13 @@ void CMeshSceneNode::OnRegisterSceneNode()
 		// register according to material types counted
 
 		if (solidCount)
-			SceneManager->registerNodeForRendering(this, scene::ESNRP_SOLID);
+		{
+			// the solid mesh buffers are drawn by the scene manager
+			if (Mesh && !Shadow && !DebugDataVisible && SceneManager->isMeshBufferQueueEnabled())
+				registerSolidMeshBuffers();
+			else
+				SceneManager->registerNodeForRendering(this, scene::ESNRP_SOLID);
+		}
 
 		if (transparentCount)
 			SceneManager->registerNodeForRendering(this, scene::ESNRP_TRANSPARENT);
@@ -112,6 +124,29 @@ void CMeshSceneNode::OnRegisterSceneNode()
 }
 
 
+//! submits the solid mesh buffers to the render queue of the scene manager
+void CMeshSceneNode::registerSolidMeshBuffers()
+{
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+
+	// render() is not called in the solid pass, so update the box here
+	Box = Mesh->getBoundingBox();
+
+	for (u32 i=0; i<Mesh->getMeshBufferCount(); ++i)
+	{
+		scene::IMeshBuffer* mb = Mesh->getMeshBuffer(i);
+		if (!mb)
+			continue;
+
+		const video::SMaterial& material = ReadOnlyMaterials ? mb->getMaterial() : Materials[i];
+		video::IMaterialRenderer* rnd = driver->getMaterialRenderer(material.MaterialType);
+
+		if (!rnd || !rnd->isTransparent())
+			SceneManager->registerMeshBufferForRendering(this, mb, material);
+	}
+}
+
+
 //! renders the node.
 void CMeshSceneNode::render()
 {
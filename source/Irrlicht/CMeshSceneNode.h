@@ -85,6 +85,9 @@ namespace scene
 
 		void copyMaterials();
 
+		//! submits the solid mesh buffers to the render queue of the scene manager
+		void registerSolidMeshBuffers();
+
 		core::array<video::SMaterial> Materials;
 		core::aabbox3d<f32> Box;
 		video::SMaterial ReadOnlyMaterial;
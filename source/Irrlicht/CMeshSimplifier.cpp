@@ -0,0 +1,697 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CMeshSimplifier.h"
+#include "CDynamicMeshBuffer.h"
+#include <string.h>
+
+namespace irr
+{
+namespace scene
+{
+
+namespace
+{
+	enum E_VERTEX_KIND
+	{
+		EVK_MANIFOLD = 0,
+		EVK_BORDER,
+		EVK_SEAM,
+		EVK_LOCKED
+	};
+
+	//! if a vertex of the first kind may collapse onto one of the second kind
+	const bool CanCollapseKind[4][4] =
+	{
+		{ true,  true,  true,  true  }, // manifold
+		{ false, true,  false, true  }, // border, along the border
+		{ false, false, true,  true  }, // seam, along the seam
+		{ false, false, false, false }  // locked
+	};
+
+	//! weight of the planes keeping borders and seams in place
+	const f32 EdgeWeight = 10.f;
+
+	const u32 InvalidIndex = 0xffffffff;
+
+	inline u32 floatBits(f32 f)
+	{
+		union { f32 F; u32 U; } bits;
+		bits.F = f;
+		return bits.U;
+	}
+
+	inline u32 hashPosition(const core::vector3df& p)
+	{
+		return (floatBits(p.X) * 73856093) ^ (floatBits(p.Y) * 19349663) ^ (floatBits(p.Z) * 83492791);
+	}
+
+	inline bool isSamePosition(const core::vector3df& a, const core::vector3df& b)
+	{
+		return a.X == b.X && a.Y == b.Y && a.Z == b.Z;
+	}
+}
+
+
+//! constructor
+CMeshSimplifier::CMeshSimplifier(const IMeshBuffer* mb)
+: Source(mb), Scale(1.f)
+{
+	const u32 vertexCount = mb->getVertexCount();
+	const u32 indexCount = mb->getIndexCount() - mb->getIndexCount() % 3;
+	const u16* indices16 = mb->getIndexType() == video::EIT_16BIT ? mb->getIndices() : 0;
+	const u32* indices32 = indices16 ? 0 : (const u32*)mb->getIndices();
+
+	Indices.reallocate(indexCount);
+	for (u32 i=0; i<indexCount; i+=3)
+	{
+		u32 tri[3];
+		for (u32 k=0; k<3; ++k)
+			tri[k] = indices16 ? indices16[i+k] : indices32[i+k];
+
+		if (tri[0] < vertexCount && tri[1] < vertexCount && tri[2] < vertexCount &&
+			tri[0] != tri[1] && tri[0] != tri[2] && tri[1] != tri[2])
+		{
+			Indices.push_back(tri[0]);
+			Indices.push_back(tri[1]);
+			Indices.push_back(tri[2]);
+		}
+	}
+
+	// positions in the unit cube keep the quadrics precise for all mesh sizes
+	Positions.set_used(vertexCount);
+	core::aabbox3df box;
+	for (u32 i=0; i<vertexCount; ++i)
+	{
+		Positions[i] = mb->getPosition(i);
+		if (i)
+			box.addInternalPoint(Positions[i]);
+		else
+			box.reset(Positions[i]);
+	}
+
+	const core::vector3df extent = box.getExtent();
+	const f32 size = core::max_(extent.X, extent.Y, extent.Z);
+	Scale = size > 0.f ? 1.f / size : 1.f;
+	for (u32 i=0; i<vertexCount; ++i)
+		Positions[i] = (Positions[i] - box.MinEdge) * Scale;
+
+	buildPositionRemap();
+	buildAdjacency();
+	classifyVertices();
+	fillQuadrics();
+}
+
+
+//! collapses edges until there are at most targetIndexCount indices
+u32 CMeshSimplifier::simplify(u32 targetIndexCount, f32 maxError)
+{
+	const f32 errorLimit = maxError > 0.f ? (maxError * Scale) * (maxError * Scale) : FLT_MAX;
+
+	while (Indices.size() > targetIndexCount)
+	{
+		buildAdjacency();
+		pickCollapses();
+		if (Collapses.empty())
+			break;
+
+		sortCollapses();
+
+		// a collapse removes two triangles, on borders only one
+		const u32 triangleGoal = (Indices.size() - targetIndexCount) / 3;
+		const u32 edgeGoal = triangleGoal / 2;
+
+		// the errors of a pass are not updated after the collapses, so
+		// the pass ends when they get noticeably larger than expected.
+		// Close to the target this would only add passes over the whole
+		// buffer for a few collapses each.
+		const f32 errorGoal = (edgeGoal < Collapses.size() && triangleGoal * 20 > Indices.size() / 3) ?
+			1.5f * Collapses[CollapseOrder[edgeGoal]].Error : FLT_MAX;
+
+		if (!performCollapses(triangleGoal, errorGoal, errorLimit))
+			break;
+
+		remapIndices();
+	}
+
+	return Indices.size();
+}
+
+
+//! creates a buffer with the remaining triangles and their vertices
+IMeshBuffer* CMeshSimplifier::createMeshBuffer() const
+{
+	const u32 vertexCount = Positions.size();
+
+	// the vertices are ordered by their first use
+	core::array<u32> newIndex;
+	newIndex.set_used(vertexCount);
+	if (vertexCount)
+		memset(newIndex.pointer(), 0xff, vertexCount * sizeof(u32));
+
+	u32 usedCount = 0;
+	for (u32 i=0; i<Indices.size(); ++i)
+	{
+		if (newIndex[Indices[i]] == InvalidIndex)
+			newIndex[Indices[i]] = usedCount++;
+	}
+
+	CDynamicMeshBuffer* buffer = new CDynamicMeshBuffer(Source->getVertexType(),
+		usedCount > 65535 ? video::EIT_32BIT : video::EIT_16BIT);
+	buffer->getMaterial() = Source->getMaterial();
+	buffer->setHardwareMappingHint(Source->getHardwareMappingHint_Vertex(), EBT_VERTEX);
+	buffer->setHardwareMappingHint(Source->getHardwareMappingHint_Index(), EBT_INDEX);
+
+	IVertexBuffer& vertexBuffer = buffer->getVertexBuffer();
+	IIndexBuffer& indexBuffer = buffer->getIndexBuffer();
+	vertexBuffer.reallocate(usedCount);
+	indexBuffer.reallocate(Indices.size());
+
+	const u8* vertices = (const u8*)Source->getVertices();
+	const u32 pitch = video::getVertexPitchFromType(Source->getVertexType());
+
+	u32 written = 0;
+	for (u32 i=0; i<Indices.size(); ++i)
+	{
+		const u32 index = newIndex[Indices[i]];
+		if (index == written)
+		{
+			// the vertex lists copy the full vertex of their type
+			vertexBuffer.push_back(*(const video::S3DVertex*)(vertices + Indices[i] * pitch));
+			++written;
+		}
+		indexBuffer.push_back(index);
+	}
+
+	buffer->recalculateBoundingBox();
+	return buffer;
+}
+
+
+//! welds the vertices with exactly the same position
+void CMeshSimplifier::buildPositionRemap()
+{
+	const u32 vertexCount = Positions.size();
+	Remap.set_used(vertexCount);
+	Wedge.set_used(vertexCount);
+
+	u32 tableSize = 1;
+	while (tableSize < vertexCount + vertexCount / 4)
+		tableSize *= 2;
+
+	core::array<u32> table;
+	table.set_used(tableSize);
+	memset(table.pointer(), 0xff, tableSize * sizeof(u32));
+
+	for (u32 i=0; i<vertexCount; ++i)
+	{
+		u32 h = hashPosition(Positions[i]) & (tableSize - 1);
+		while (table[h] != InvalidIndex && !isSamePosition(Positions[table[h]], Positions[i]))
+			h = (h + 1) & (tableSize - 1);
+
+		if (table[h] == InvalidIndex)
+		{
+			table[h] = i;
+			Remap[i] = i;
+			Wedge[i] = i;
+		}
+		else
+		{
+			const u32 r = table[h];
+			Remap[i] = r;
+			Wedge[i] = Wedge[r];
+			Wedge[r] = i;
+		}
+	}
+}
+
+
+//! builds the outgoing edges of all vertices from the current triangles
+void CMeshSimplifier::buildAdjacency()
+{
+	const u32 vertexCount = Positions.size();
+
+	AdjacencyOffsets.set_used(vertexCount + 1);
+	memset(AdjacencyOffsets.pointer(), 0, (vertexCount + 1) * sizeof(u32));
+
+	for (u32 i=0; i<Indices.size(); ++i)
+		++AdjacencyOffsets[Indices[i] + 1];
+
+	for (u32 i=1; i<=vertexCount; ++i)
+		AdjacencyOffsets[i] += AdjacencyOffsets[i-1];
+
+	// the offsets are advanced while filling and moved back afterwards
+	Adjacency.set_used(Indices.size());
+	for (u32 i=0; i<Indices.size(); i+=3)
+	{
+		for (u32 k=0; k<3; ++k)
+		{
+			SAdjacentEdge& edge = Adjacency[AdjacencyOffsets[Indices[i+k]]++];
+			edge.Next = Indices[i + (k+1) % 3];
+			edge.Prev = Indices[i + (k+2) % 3];
+		}
+	}
+
+	for (u32 i=vertexCount; i>0; --i)
+		AdjacencyOffsets[i] = AdjacencyOffsets[i-1];
+	AdjacencyOffsets[0] = 0;
+}
+
+
+//! returns if a triangle has the edge from a to b
+bool CMeshSimplifier::hasEdge(u32 a, u32 b) const
+{
+	for (u32 k=AdjacencyOffsets[a]; k<AdjacencyOffsets[a+1]; ++k)
+	{
+		if (Adjacency[k].Next == b)
+			return true;
+	}
+	return false;
+}
+
+
+//! sorts the positions into manifold, border, seam and locked ones
+void CMeshSimplifier::classifyVertices()
+{
+	const u32 vertexCount = Positions.size();
+
+	// edges without a reverse edge, a vertex marks more than one edge
+	Loop.set_used(vertexCount);
+	LoopBack.set_used(vertexCount);
+	if (vertexCount)
+	{
+		memset(Loop.pointer(), 0xff, vertexCount * sizeof(u32));
+		memset(LoopBack.pointer(), 0xff, vertexCount * sizeof(u32));
+	}
+
+	for (u32 v=0; v<vertexCount; ++v)
+	{
+		for (u32 k=AdjacencyOffsets[v]; k<AdjacencyOffsets[v+1]; ++k)
+		{
+			const u32 target = Adjacency[k].Next;
+			if (!hasEdge(target, v))
+			{
+				LoopBack[target] = (LoopBack[target] == InvalidIndex) ? v : target;
+				Loop[v] = (Loop[v] == InvalidIndex) ? target : v;
+			}
+		}
+	}
+
+	Kinds.set_used(vertexCount);
+	for (u32 i=0; i<vertexCount; ++i)
+	{
+		if (Remap[i] != i)
+		{
+			// the first vertex of the position comes first
+			Kinds[i] = Kinds[Remap[i]];
+			continue;
+		}
+
+		if (Wedge[i] == i)
+		{
+			const u32 in = LoopBack[i];
+			const u32 out = Loop[i];
+
+			if (in == InvalidIndex && out == InvalidIndex)
+				Kinds[i] = EVK_MANIFOLD;
+			else if (in != InvalidIndex && in != i && out != InvalidIndex && out != i)
+				Kinds[i] = EVK_BORDER;
+			else
+				Kinds[i] = EVK_LOCKED;
+		}
+		else if (Wedge[Wedge[i]] == i)
+		{
+			// the open edges of both sides of a seam run in opposite directions
+			const u32 w = Wedge[i];
+			const u32 a = LoopBack[i];
+			const u32 b = Loop[i];
+			const u32 c = LoopBack[w];
+			const u32 d = Loop[w];
+
+			if (a != InvalidIndex && a != i && b != InvalidIndex && b != i &&
+				c != InvalidIndex && c != w && d != InvalidIndex && d != w &&
+				Remap[a] == Remap[d] && Remap[b] == Remap[c])
+				Kinds[i] = EVK_SEAM;
+			else
+				Kinds[i] = EVK_LOCKED;
+		}
+		else
+			Kinds[i] = EVK_LOCKED;
+	}
+
+	for (u32 i=0; i<vertexCount; ++i)
+	{
+		if (Loop[i] == i)
+			Loop[i] = InvalidIndex;
+		if (LoopBack[i] == i)
+			LoopBack[i] = InvalidIndex;
+	}
+}
+
+
+//! sums the planes of the triangles and of the border and seam edges for each position
+void CMeshSimplifier::fillQuadrics()
+{
+	Quadrics.set_used(Positions.size());
+	if (!Quadrics.empty())
+		memset(Quadrics.pointer(), 0, Quadrics.size() * sizeof(SQuadric));
+
+	for (u32 i=0; i<Indices.size(); i+=3)
+	{
+		const u32 tri[3] = { Indices[i], Indices[i+1], Indices[i+2] };
+		const core::vector3df& p0 = Positions[tri[0]];
+
+		core::vector3df normal = (Positions[tri[1]] - p0).crossProduct(Positions[tri[2]] - p0);
+		const f32 length = normal.getLength();
+		if (length == 0.f)
+			continue;
+		normal /= length;
+
+		// weighted by the area
+		for (u32 k=0; k<3; ++k)
+			addPlane(Quadrics[Remap[tri[k]]], normal, -normal.dotProduct(p0), length * 0.5f);
+
+		for (u32 k=0; k<3; ++k)
+		{
+			const u32 a = tri[k];
+			const u32 b = tri[(k+1) % 3];
+
+			if (hasEdge(b, a))
+				continue;
+
+			// plane through the open edge, perpendicular to the triangle
+			const core::vector3df& pa = Positions[a];
+			const core::vector3df edge = Positions[b] - pa;
+			core::vector3df edgeNormal = edge.crossProduct(normal);
+			const f32 edgeLength = edgeNormal.getLength();
+			if (edgeLength == 0.f)
+				continue;
+			edgeNormal /= edgeLength;
+
+			const f32 d = -edgeNormal.dotProduct(pa);
+			const f32 weight = edge.getLengthSQ() * EdgeWeight;
+			addPlane(Quadrics[Remap[a]], edgeNormal, d, weight);
+			addPlane(Quadrics[Remap[b]], edgeNormal, d, weight);
+		}
+	}
+}
+
+
+//! returns if the vertex from may collapse onto the vertex to
+bool CMeshSimplifier::canCollapse(u32 from, u32 to) const
+{
+	const u8 kind = Kinds[from];
+	if (!CanCollapseKind[kind][Kinds[to]])
+		return false;
+
+	if (kind == EVK_BORDER || kind == EVK_SEAM)
+		return Loop[from] == to || LoopBack[from] == to;
+
+	return true;
+}
+
+
+//! collects the cheaper allowed direction of each edge
+void CMeshSimplifier::pickCollapses()
+{
+	// there are at most as many edges as indices
+	Collapses.set_used(Indices.size());
+	u32 count = 0;
+
+	for (u32 i=0; i<Indices.size(); i+=3)
+	{
+		for (u32 k=0; k<3; ++k)
+		{
+			const u32 i0 = Indices[i+k];
+			const u32 i1 = Indices[i + (k+1) % 3];
+			const u32 r0 = Remap[i0];
+			const u32 r1 = Remap[i1];
+
+			if (r0 == r1)
+				continue;
+
+			// inner edges are in two triangles, take only one of them
+			if (r0 > r1 && hasEdge(i1, i0))
+				continue;
+
+			const bool can0 = canCollapse(i0, i1);
+			const bool can1 = canCollapse(i1, i0);
+			if (!can0 && !can1)
+				continue;
+
+			const f32 error0 = can0 ? getError(Quadrics[r0], Positions[i1]) : FLT_MAX;
+			const f32 error1 = can1 ? getError(Quadrics[r1], Positions[i0]) : FLT_MAX;
+
+			SCollapse& collapse = Collapses[count++];
+			collapse.From = error0 <= error1 ? i0 : i1;
+			collapse.To = error0 <= error1 ? i1 : i0;
+			collapse.Error = core::min_(error0, error1);
+		}
+	}
+
+	Collapses.set_used(count);
+}
+
+
+//! sorts the collapses by their error with a radix sort
+void CMeshSimplifier::sortCollapses()
+{
+	const u32 count = Collapses.size();
+	CollapseOrder.set_used(count);
+	for (u32 i=0; i<count; ++i)
+		CollapseOrder[i] = i;
+
+	// errors are never negative, so their bits sort like the values
+	core::array<u32> keys;
+	keys.set_used(count);
+	for (u32 i=0; i<count; ++i)
+		keys[i] = floatBits(Collapses[i].Error);
+
+	core::array<u32> temp;
+	temp.set_used(count);
+
+	u32 histogram[2048];
+	for (u32 shift=0; shift<32; shift+=11)
+	{
+		memset(histogram, 0, sizeof(histogram));
+		for (u32 i=0; i<count; ++i)
+			++histogram[(keys[i] >> shift) & 2047];
+
+		u32 sum = 0;
+		for (u32 i=0; i<2048; ++i)
+		{
+			const u32 h = histogram[i];
+			histogram[i] = sum;
+			sum += h;
+		}
+
+		for (u32 i=0; i<count; ++i)
+		{
+			const u32 c = CollapseOrder[i];
+			temp[histogram[(keys[c] >> shift) & 2047]++] = c;
+		}
+
+		CollapseOrder.swap(temp);
+	}
+}
+
+
+//! collapses the sorted edges, each position at most once
+u32 CMeshSimplifier::performCollapses(u32 triangleGoal, f32 errorGoal, f32 errorLimit)
+{
+	const u32 vertexCount = Positions.size();
+	CollapseRemap.set_used(vertexCount);
+	for (u32 i=0; i<vertexCount; ++i)
+		CollapseRemap[i] = i;
+
+	CollapseLocked.set_used(vertexCount);
+	memset(CollapseLocked.pointer(), 0, vertexCount);
+
+	u32 edgeCollapses = 0;
+	u32 triangleCollapses = 0;
+
+	for (u32 i=0; i<CollapseOrder.size(); ++i)
+	{
+		const SCollapse& collapse = Collapses[CollapseOrder[i]];
+
+		if (collapse.Error > errorLimit || triangleCollapses >= triangleGoal)
+			break;
+
+		if (collapse.Error > errorGoal && triangleCollapses > triangleGoal / 10)
+			break;
+
+		const u32 i0 = collapse.From;
+		const u32 i1 = collapse.To;
+		const u32 r0 = Remap[i0];
+		const u32 r1 = Remap[i1];
+
+		if (CollapseLocked[r0] || CollapseLocked[r1])
+			continue;
+
+		if (hasTriangleFlips(i0, i1))
+			continue;
+
+		if (Kinds[i0] == EVK_SEAM)
+		{
+			// the other side collapses onto the other vertex of the target
+			const u32 s0 = Wedge[i0];
+			const u32 s1 = (Loop[i0] == i1) ? LoopBack[s0] : Loop[s0];
+
+			if (s1 == InvalidIndex || Remap[s1] != r1)
+				continue;
+
+			CollapseRemap[i0] = i1;
+			CollapseRemap[s0] = s1;
+		}
+		else
+		{
+			u32 w = i0;
+			do
+			{
+				CollapseRemap[w] = i1;
+				w = Wedge[w];
+			} while (w != i0);
+		}
+
+		addQuadric(Quadrics[r1], Quadrics[r0]);
+
+		CollapseLocked[r0] = 1;
+		CollapseLocked[r1] = 1;
+
+		triangleCollapses += (Kinds[i0] == EVK_BORDER) ? 1 : 2;
+		++edgeCollapses;
+	}
+
+	return edgeCollapses;
+}
+
+
+//! returns if a triangle of the vertex from would flip when it is moved onto to
+bool CMeshSimplifier::hasTriangleFlips(u32 from, u32 to) const
+{
+	const core::vector3df& p0 = Positions[from];
+	const core::vector3df& p1 = Positions[to];
+	const u32 r1 = Remap[to];
+
+	u32 w = from;
+	do
+	{
+		for (u32 k=AdjacencyOffsets[w]; k<AdjacencyOffsets[w+1]; ++k)
+		{
+			const u32 a = CollapseRemap[Adjacency[k].Next];
+			const u32 b = CollapseRemap[Adjacency[k].Prev];
+
+			// triangles with the collapsed edge are removed
+			if (Remap[a] == r1 || Remap[b] == r1 || a == b)
+				continue;
+
+			const core::vector3df& pa = Positions[a];
+			const core::vector3df& pb = Positions[b];
+			const core::vector3df n0 = (pa - p0).crossProduct(pb - p0);
+			const core::vector3df n1 = (pa - p1).crossProduct(pb - p1);
+
+			if (n0.dotProduct(n1) <= 0.f)
+				return true;
+		}
+
+		w = Wedge[w];
+	} while (w != from);
+
+	return false;
+}
+
+
+//! applies the collapses of a pass to the triangles and the border and seam loops
+void CMeshSimplifier::remapIndices()
+{
+	u32 written = 0;
+	for (u32 i=0; i<Indices.size(); i+=3)
+	{
+		const u32 a = CollapseRemap[Indices[i]];
+		const u32 b = CollapseRemap[Indices[i+1]];
+		const u32 c = CollapseRemap[Indices[i+2]];
+
+		if (a != b && a != c && b != c)
+		{
+			Indices[written++] = a;
+			Indices[written++] = b;
+			Indices[written++] = c;
+		}
+	}
+	Indices.set_used(written);
+
+	for (u32 i=0; i<Positions.size(); ++i)
+	{
+		// a loop pointing to a vertex collapsed onto i continues behind it
+		if (Loop[i] != InvalidIndex)
+		{
+			const u32 l = Loop[i];
+			const u32 r = CollapseRemap[l];
+			Loop[i] = (r == i) ? Loop[l] : r;
+		}
+
+		if (LoopBack[i] != InvalidIndex)
+		{
+			const u32 l = LoopBack[i];
+			const u32 r = CollapseRemap[l];
+			LoopBack[i] = (r == i) ? LoopBack[l] : r;
+		}
+	}
+}
+
+
+void CMeshSimplifier::addPlane(SQuadric& q, const core::vector3df& normal, f32 d, f32 weight)
+{
+	const f32 aw = normal.X * weight;
+	const f32 bw = normal.Y * weight;
+	const f32 cw = normal.Z * weight;
+
+	q.A00 += normal.X * aw;
+	q.A11 += normal.Y * bw;
+	q.A22 += normal.Z * cw;
+	q.A10 += normal.Y * aw;
+	q.A20 += normal.Z * aw;
+	q.A21 += normal.Z * bw;
+	q.B0 += d * aw;
+	q.B1 += d * bw;
+	q.B2 += d * cw;
+	q.C += d * d * weight;
+	q.W += weight;
+}
+
+
+void CMeshSimplifier::addQuadric(SQuadric& q, const SQuadric& r)
+{
+	q.A00 += r.A00;
+	q.A11 += r.A11;
+	q.A22 += r.A22;
+	q.A10 += r.A10;
+	q.A20 += r.A20;
+	q.A21 += r.A21;
+	q.B0 += r.B0;
+	q.B1 += r.B1;
+	q.B2 += r.B2;
+	q.C += r.C;
+	q.W += r.W;
+}
+
+
+//! weighted mean of the squared distances of a point to the planes of a quadric
+f32 CMeshSimplifier::getError(const SQuadric& q, const core::vector3df& p)
+{
+	const f32 rx = q.A00 * p.X + q.A10 * p.Y + q.A20 * p.Z;
+	const f32 ry = q.A10 * p.X + q.A11 * p.Y + q.A21 * p.Z;
+	const f32 rz = q.A20 * p.X + q.A21 * p.Y + q.A22 * p.Z;
+
+	f32 r = rx * p.X + ry * p.Y + rz * p.Z;
+	r += 2.f * (q.B0 * p.X + q.B1 * p.Y + q.B2 * p.Z);
+	r += q.C;
+
+	return q.W > 0.f ? core::abs_(r) / q.W : 0.f;
+}
+
+
+} // end namespace scene
+} // end namespace irr
+
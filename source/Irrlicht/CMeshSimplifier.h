@@ -0,0 +1,116 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_MESH_SIMPLIFIER_H_INCLUDED__
+#define __C_MESH_SIMPLIFIER_H_INCLUDED__
+
+#include "IMeshBuffer.h"
+#include "irrArray.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! Removes the triangles of a mesh buffer by edge collapses with the smallest quadric error.
+	/** Vertices with the same position are welded for the topology. A
+	collapse moves the triangles of a vertex to a neighbour, so no new
+	vertices are created and all vertex attributes stay valid. Vertices on
+	the border of the buffer only collapse along the border. On seams, where
+	a position has two vertices with different normals or texture coordinates,
+	vertices only collapse along the seam and both sides collapse together.
+	Vertices on corners of seams and borders are never removed. The
+	collapses are done in passes: each pass sorts all edges by their error
+	and collapses the cheapest ones, but every vertex at most once. */
+	class CMeshSimplifier
+	{
+	public:
+
+		//! constructor, the buffer has to stay valid while the simplifier is used
+		CMeshSimplifier(const IMeshBuffer* mb);
+
+		//! collapses edges until there are at most targetIndexCount indices
+		/** \param targetIndexCount Index count to reach.
+		\param maxError Maximal distance between the original and the
+		simplified surface, 0 for no limit.
+		\return Index count of the simplified buffer. */
+		u32 simplify(u32 targetIndexCount, f32 maxError);
+
+		//! creates a buffer with the remaining triangles and their vertices
+		/** 16 bit indices are used if there are few enough vertices. */
+		IMeshBuffer* createMeshBuffer() const;
+
+	private:
+
+		//! error quadric of a vertex, the sum of weighted squared plane distances
+		struct SQuadric
+		{
+			f32 A00, A11, A22, A10, A20, A21;
+			f32 B0, B1, B2, C, W;
+		};
+
+		//! outgoing edge of a vertex in a triangle
+		struct SAdjacentEdge
+		{
+			u32 Next;
+			u32 Prev;
+		};
+
+		struct SCollapse
+		{
+			u32 From;
+			u32 To;
+			f32 Error;
+		};
+
+		void buildPositionRemap();
+		void buildAdjacency();
+		bool hasEdge(u32 a, u32 b) const;
+		void classifyVertices();
+		void fillQuadrics();
+
+		bool canCollapse(u32 from, u32 to) const;
+		void pickCollapses();
+		void sortCollapses();
+		u32 performCollapses(u32 triangleGoal, f32 errorGoal, f32 errorLimit);
+		bool hasTriangleFlips(u32 from, u32 to) const;
+		void remapIndices();
+
+		static void addPlane(SQuadric& q, const core::vector3df& normal, f32 d, f32 weight);
+		static void addQuadric(SQuadric& q, const SQuadric& r);
+		static f32 getError(const SQuadric& q, const core::vector3df& p);
+
+		const IMeshBuffer* Source;
+
+		//! positions scaled into the unit cube
+		core::array<core::vector3df> Positions;
+		core::array<u32> Indices;
+
+		//! first vertex with the same position
+		core::array<u32> Remap;
+		//! next vertex with the same position, circular
+		core::array<u32> Wedge;
+		core::array<u8> Kinds;
+		//! next and previous vertex along a border or seam
+		core::array<u32> Loop;
+		core::array<u32> LoopBack;
+		//! quadrics of the first vertices of the positions
+		core::array<SQuadric> Quadrics;
+
+		core::array<u32> AdjacencyOffsets;
+		core::array<SAdjacentEdge> Adjacency;
+
+		core::array<SCollapse> Collapses;
+		core::array<u32> CollapseOrder;
+		core::array<u32> CollapseRemap;
+		core::array<u8> CollapseLocked;
+
+		f32 Scale;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
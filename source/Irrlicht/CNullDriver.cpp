@@ -4,6 +4,7 @@
 
 #include "CNullDriver.h"
 #include "os.h"
+#include "CProfiler.h"
 #include "CImage.h"
 #include "CAttributes.h"
 #include "IReadFile.h"
@@ -82,7 +83,8 @@ IImageWriter* createImageWriterPPM();
 
 //! constructor
 CNullDriver::CNullDriver(io::IFileSystem* io, const core::dimension2d<u32>& screenSize)
-: FileSystem(io), MeshManipulator(0), ViewPort(0,0,0,0), ScreenSize(screenSize),
+: OwnerThread(CThread::getCurrentId()), QueuedTextureCreationFlags(0), TextureLoadQueue(0),
+	FileSystem(io), MeshManipulator(0), ViewPort(0,0,0,0), ScreenSize(screenSize),
 	PrimitivesDrawn(0), MinVertexCountForVBO(500), TextureCreationFlags(0),
 	OverrideMaterial2DEnabled(false), AllowZWriteOnTransparent(false)
 {
@@ -110,6 +112,7 @@ CNullDriver::CNullDriver(io::IFileSystem* io, const core::dimension2d<u32>& scre
 
 	setTextureCreationFlag(ETCF_ALWAYS_32_BIT, true);
 	setTextureCreationFlag(ETCF_CREATE_MIP_MAPS, true);
+	QueuedTextureCreationFlags = TextureCreationFlags;
 
 	ViewPort = core::rect<s32>(core::position2d<s32>(0,0), core::dimension2di(screenSize));
 
@@ -203,6 +206,9 @@ CNullDriver::CNullDriver(io::IFileSystem* io, const core::dimension2d<u32>& scre
 //! destructor
 CNullDriver::~CNullDriver()
 {
+	// the decoders use the image loaders
+	delete TextureLoadQueue;
+
 	if (DriverAttributes)
 		DriverAttributes->drop();
 
@@ -289,6 +295,9 @@ void CNullDriver::deleteAllTextures()
 	// last set material member. Could be optimized to reduce state changes.
 	setMaterial(SMaterial());
 
+	if (TextureLoadQueue)
+		TextureLoadQueue->cancelAll();
+
 	for (u32 i=0; i<Textures.size(); ++i)
 		Textures[i].Surface->drop();
 
@@ -303,6 +312,7 @@ bool CNullDriver::beginScene(bool backBuffer, bool zBuffer, SColor color,
 {
 	core::clearFPUException();
 	PrimitivesDrawn = 0;
+	processQueuedCalls();
 	return true;
 }
 
@@ -313,6 +323,7 @@ bool CNullDriver::endScene()
 	FPSCounter.registerFrame(os::Timer::getRealTime(), PrimitivesDrawn);
 	updateAllHardwareBuffers();
 	updateAllOcclusionQueries();
+	FrameArena.reset();
 	return true;
 }
 
@@ -364,6 +375,9 @@ void CNullDriver::removeTexture(ITexture* texture)
 	if (!texture)
 		return;
 
+	if (TextureLoadQueue)
+		TextureLoadQueue->cancel(texture);
+
 	for (u32 i=0; i<Textures.size(); ++i)
 	{
 		if (Textures[i].Surface == texture)
@@ -415,9 +429,107 @@ void CNullDriver::renameTexture(ITexture* texture, const io::path& newName)
 }
 
 
+//! Runs the texture calls which other threads wait for.
+void CNullDriver::processQueuedCalls()
+{
+	if (!isOwnerThread())
+		return;
+
+	QueuedCallMutex.lock();
+	while (QueuedCalls.size())
+	{
+		SQueuedCall* call = QueuedCalls[0];
+		QueuedCalls.erase(0);
+		QueuedCallMutex.unlock();
+
+		// the texture is created with the flags of the waiting thread
+		const u32 flags = TextureCreationFlags;
+		TextureCreationFlags = call->TextureCreationFlags;
+
+		ITexture* result = 0;
+		switch (call->Type)
+		{
+		case SQueuedCall::GET_BY_NAME:
+			result = getTexture(*call->Name);
+			break;
+		case SQueuedCall::GET_BY_FILE:
+			result = getTexture(call->File);
+			break;
+		case SQueuedCall::GET_ASYNC:
+			result = getTextureAsync(*call->Name);
+			break;
+		case SQueuedCall::FIND:
+			result = findTexture(*call->Name);
+			break;
+		case SQueuedCall::ADD_IMAGE:
+			result = addTexture(*call->Name, call->Image, call->MipmapData);
+			break;
+		case SQueuedCall::ADD_EMPTY:
+			result = addTexture(call->Size, *call->Name, call->Format);
+			break;
+		case SQueuedCall::NORMAL_MAP:
+			makeNormalMapTexture(call->Texture, call->Amplitude);
+			break;
+		}
+
+		TextureCreationFlags = flags;
+
+		QueuedCallMutex.lock();
+		call->Result = result;
+		call->Done = true;
+		QueuedCallDone.broadcast();
+	}
+	QueuedCallMutex.unlock();
+
+	// upload the images decoded in the background into their placeholders
+	if (TextureLoadQueue)
+	{
+		ITexture* texture;
+		IImage* image;
+		while (TextureLoadQueue->getFinished(texture, image))
+		{
+			if (image)
+			{
+				_IRR_PROFILE("getTexture: upload");
+				if (replaceTextureImage(texture, image))
+					os::Printer::log("Loaded texture", texture->getName());
+				else
+					os::Printer::log("Could not replace placeholder of texture", texture->getName(), ELL_ERROR);
+				image->drop();
+			}
+			else
+				os::Printer::log("Could not load texture", texture->getName(), ELL_ERROR);
+		}
+	}
+
+	// the loaders of other threads log as well
+	os::Printer::processQueuedLogs();
+}
+
+
+//! queues a call for the owning thread and waits until it ran
+ITexture* CNullDriver::runOnOwnerThread(SQueuedCall& call)
+{
+	QueuedCallMutex.lock();
+	call.TextureCreationFlags = QueuedTextureCreationFlags;
+	QueuedCalls.push_back(&call);
+	while (!call.Done)
+		QueuedCallDone.wait(QueuedCallMutex);
+	QueuedCallMutex.unlock();
+	return call.Result;
+}
+
+
 //! loads a Texture
 ITexture* CNullDriver::getTexture(const io::path& filename)
 {
+	if (!isOwnerThread())
+	{
+		SQueuedCall call(SQueuedCall::GET_BY_NAME);
+		call.Name = &filename;
+		return runOnOwnerThread(call);
+	}
+
 	// Identify textures by their absolute filenames if possible.
 	const io::path absolutePath = FileSystem->getAbsolutePath(filename);
 
@@ -472,6 +584,13 @@ ITexture* CNullDriver::getTexture(const io::path& filename)
 //! loads a Texture
 ITexture* CNullDriver::getTexture(io::IReadFile* file)
 {
+	if (!isOwnerThread())
+	{
+		SQueuedCall call(SQueuedCall::GET_BY_FILE);
+		call.File = file;
+		return runOnOwnerThread(call);
+	}
+
 	ITexture* texture = 0;
 
 	if (file)
@@ -497,9 +616,115 @@ ITexture* CNullDriver::getTexture(io::IReadFile* file)
 }
 
 
+//! Loads a texture in the background.
+ITexture* CNullDriver::getTextureAsync(const io::path& filename)
+{
+	if (!isOwnerThread())
+	{
+		SQueuedCall call(SQueuedCall::GET_ASYNC);
+		call.Name = &filename;
+		return runOnOwnerThread(call);
+	}
+
+	// same lookup as getTexture
+	const io::path absolutePath = FileSystem->getAbsolutePath(filename);
+
+	ITexture* texture = findTexture(absolutePath);
+	if (texture)
+		return texture;
+
+	texture = findTexture(filename);
+	if (texture)
+		return texture;
+
+	io::IReadFile* file = FileSystem->createAndOpenFile(absolutePath);
+	if (!file)
+		file = FileSystem->createAndOpenFile(filename);
+
+	if (!file)
+	{
+		os::Printer::log("Could not open file of texture", filename, ELL_WARNING);
+		return 0;
+	}
+
+	texture = findTexture(file->getFileName());
+	if (texture)
+	{
+		file->drop();
+		return texture;
+	}
+
+	if (!TextureLoadQueue)
+	{
+		// leave one processor to the rendering thread
+		const u32 processors = CThread::getProcessorCount();
+		TextureLoadQueue = new CTextureLoadQueue(core::clamp(processors-1, 1u, 4u));
+	}
+
+	if (!TextureLoadQueue->hasWorkers())
+	{
+		texture = getTexture(file);
+		file->drop();
+		return texture;
+	}
+
+	// Read the file on this thread, files in archives share the handle of
+	// the archive. Only the decoding is moved to the workers. Mapped files
+	// are read without the handle and need no copy.
+	io::IReadFile* memFile = 0;
+	if (file->getMappedData())
+	{
+		memFile = file;
+		memFile->grab();
+	}
+	else
+	{
+		const long size = file->getSize();
+		c8* data = size > 0 ? new c8[size] : 0;
+		if (data && file->read(data, size) == size)
+			memFile = FileSystem->createMemoryReadFile(data, size, file->getFileName(), true);
+		else
+			delete [] data;
+	}
+
+	if (!memFile)
+	{
+		os::Printer::log("Could not read file of texture", filename, ELL_WARNING);
+		file->drop();
+		return 0;
+	}
+
+	// a small white texture until the image is decoded
+	IImage* image = new CImage(ECF_A8R8G8B8, core::dimension2d<u32>(2,2));
+	image->fill(SColor(255,255,255,255));
+	texture = createDeviceDependentTexture(image, file->getFileName());
+	image->drop();
+	file->drop();
+
+	if (texture)
+	{
+		addTexture(texture);
+		texture->drop(); // drop it because we created it, one grab too much
+		TextureLoadQueue->add(texture, memFile, SurfaceLoader);
+	}
+	memFile->drop();
+
+	return texture;
+}
+
+
+//! Returns the number of textures which are still decoded in the background.
+u32 CNullDriver::getPendingTextureLoadCount() const
+{
+	return TextureLoadQueue ? TextureLoadQueue->getPendingCount() : 0;
+}
+
+
 //! opens the file and loads it into the surface
 video::ITexture* CNullDriver::loadTextureFromFile(io::IReadFile* file, const io::path& hashName )
 {
+	_IRR_PROFILE("getTexture: load");
+
 	ITexture* texture = 0;
 	IImage* image = createImageFromFile(file);
 
@@ -539,6 +764,13 @@ void CNullDriver::addTexture(video::ITexture* texture)
 //! looks if the image is already loaded
 video::ITexture* CNullDriver::findTexture(const io::path& filename)
 {
+	if (!isOwnerThread())
+	{
+		SQueuedCall call(SQueuedCall::FIND);
+		call.Name = &filename;
+		return runOnOwnerThread(call);
+	}
+
 	SSurface s;
 	SDummyTexture dummy(filename);
 	s.Surface = &dummy;
@@ -554,6 +786,15 @@ video::ITexture* CNullDriver::findTexture(const io::path& filename)
 //! Creates a texture from a loaded IImage.
 ITexture* CNullDriver::addTexture(const io::path& name, IImage* image, void* mipmapData)
 {
+	if (!isOwnerThread())
+	{
+		SQueuedCall call(SQueuedCall::ADD_IMAGE);
+		call.Name = &name;
+		call.Image = image;
+		call.MipmapData = mipmapData;
+		return runOnOwnerThread(call);
+	}
+
 	if ( 0 == name.size() || !image)
 		return 0;
 
@@ -571,6 +812,15 @@ ITexture* CNullDriver::addTexture(const io::path& name, IImage* image, void* mip
 ITexture* CNullDriver::addTexture(const core::dimension2d<u32>& size,
 				  const io::path& name, ECOLOR_FORMAT format)
 {
+	if (!isOwnerThread())
+	{
+		SQueuedCall call(SQueuedCall::ADD_EMPTY);
+		call.Name = &name;
+		call.Size = size;
+		call.Format = format;
+		return runOnOwnerThread(call);
+	}
+
 	if(IImage::isRenderTargetOnlyFormat(format))
 	{
 		os::Printer::log("Could not create ITexture, format only supported for render target textures.", ELL_WARNING);
@@ -601,6 +851,15 @@ ITexture* CNullDriver::createDeviceDependentTexture(IImage* surface, const io::p
 }
 
 
+//! replaces the content of a texture created by createDeviceDependentTexture
+//! THIS METHOD HAS TO BE OVERRIDDEN BY DERIVED DRIVERS WITH OWN TEXTURES
+bool CNullDriver::replaceTextureImage(ITexture* texture, IImage* image)
+{
+	static_cast<SDummyTexture*>(texture)->size = image->getDimension();
+	return true;
+}
+
+
 //! set or reset special render targets
 bool CNullDriver::setRenderTarget(video::E_RENDER_TARGET target, bool clearTarget,
 			bool clearZBuffer, SColor color)
@@ -1129,6 +1388,16 @@ void CNullDriver::makeNormalMapTexture(video::ITexture* texture, f32 amplitude)
 	if (!texture)
 		return;
 
+	// the texture is locked and regenerated by the thread owning it
+	if (!isOwnerThread())
+	{
+		SQueuedCall call(SQueuedCall::NORMAL_MAP);
+		call.Texture = texture;
+		call.Amplitude = amplitude;
+		const_cast<CNullDriver*>(this)->runOnOwnerThread(call);
+		return;
+	}
+
 	if (texture->getColorFormat() != ECF_A1R5G5B5 &&
 		texture->getColorFormat() != ECF_A8R8G8B8 )
 	{
@@ -1277,16 +1546,17 @@ void CNullDriver::setTextureCreationFlag(E_TEXTURE_CREATION_FLAG flag, bool enab
 		setTextureCreationFlag(ETCF_OPTIMIZED_FOR_SPEED, false);
 	}
 
-	// set flag
-	TextureCreationFlags = (TextureCreationFlags & (~flag)) |
-		((((u32)!enabled)-1) & flag);
+	// set flag, other threads only change the flags of their queued calls
+	u32& flags = isOwnerThread() ? TextureCreationFlags : QueuedTextureCreationFlags;
+	flags = (flags & (~flag)) | ((((u32)!enabled)-1) & flag);
 }
 
 
 //! Returns if a texture creation flag is enabled or disabled.
 bool CNullDriver::getTextureCreationFlag(E_TEXTURE_CREATION_FLAG flag) const
 {
-	return (TextureCreationFlags & flag)!=0;
+	const u32 flags = isOwnerThread() ? TextureCreationFlags : QueuedTextureCreationFlags;
+	return (flags & flag)!=0;
 }
 
 
@@ -1520,6 +1790,101 @@ void CNullDriver::drawMeshBuffer(const scene::IMeshBuffer* mb)
 }
 
 
+//! Draws a mesh buffer once for each of several transformations
+void CNullDriver::drawMeshBufferInstanced(const scene::IMeshBuffer* mb,
+		const core::matrix4* transforms, const SColor* colors, u32 instanceCount)
+{
+	if (!mb || !transforms || !instanceCount)
+		return;
+
+	const u32 vertexCount = mb->getVertexCount();
+	const u32 indexCount = mb->getIndexCount();
+	if (!vertexCount || !indexCount)
+		return;
+
+	const core::matrix4 world = getTransform(ETS_WORLD);
+
+	// too large for 16 bit indices, draw each instance on its own
+	const u32 batchSize = 65536 / vertexCount;
+	if (!batchSize)
+	{
+		for (u32 i=0; i<instanceCount; ++i)
+		{
+			setTransform(ETS_WORLD, world * transforms[i]);
+			drawMeshBuffer(mb);
+		}
+		setTransform(ETS_WORLD, world);
+		return;
+	}
+
+	const E_VERTEX_TYPE vType = mb->getVertexType();
+	const u32 pitch = getVertexPitchFromType(vType);
+	const u8* srcVertices = (const u8*)mb->getVertices();
+	const u16* srcIndices16 = mb->getIndexType() == EIT_16BIT ? (const u16*)mb->getIndices() : 0;
+	const u32* srcIndices32 = mb->getIndexType() == EIT_32BIT ? (const u32*)mb->getIndices() : 0;
+
+	for (u32 first=0; first<instanceCount; first+=batchSize)
+	{
+		const u32 count = core::min_(batchSize, instanceCount - first);
+
+		InstanceVertices.set_used(count * vertexCount * pitch);
+		InstanceIndices.set_used(count * indexCount);
+
+		u8* vertices = InstanceVertices.pointer();
+		u16* indices = InstanceIndices.pointer();
+
+		for (u32 i=0; i<count; ++i)
+		{
+			const core::matrix4& m = transforms[first + i];
+			memcpy(vertices, srcVertices, vertexCount * pitch);
+
+			// all vertex types start with the members of S3DVertex
+			for (u32 v=0; v<vertexCount; ++v)
+			{
+				S3DVertex* vertex = (S3DVertex*)(vertices + v * pitch);
+				m.transformVect(vertex->Pos);
+				m.rotateVect(vertex->Normal);
+				vertex->Normal.normalize();
+
+				if (vType == EVT_TANGENTS)
+				{
+					S3DVertexTangents* t = (S3DVertexTangents*)vertex;
+					m.rotateVect(t->Tangent);
+					m.rotateVect(t->Binormal);
+				}
+
+				if (colors)
+				{
+					const SColor& c = colors[first + i];
+					vertex->Color.set(
+						(vertex->Color.getAlpha() * c.getAlpha()) / 255,
+						(vertex->Color.getRed() * c.getRed()) / 255,
+						(vertex->Color.getGreen() * c.getGreen()) / 255,
+						(vertex->Color.getBlue() * c.getBlue()) / 255);
+				}
+			}
+			vertices += vertexCount * pitch;
+
+			const u32 offset = i * vertexCount;
+			if (srcIndices16)
+			{
+				for (u32 j=0; j<indexCount; ++j)
+					indices[j] = (u16)(srcIndices16[j] + offset);
+			}
+			else
+			{
+				for (u32 j=0; j<indexCount; ++j)
+					indices[j] = (u16)(srcIndices32[j] + offset);
+			}
+			indices += indexCount;
+		}
+
+		drawVertexPrimitiveList(InstanceVertices.const_pointer(), count * vertexCount,
+			InstanceIndices.const_pointer(), count * indexCount / 3, vType, scene::EPT_TRIANGLES, EIT_16BIT);
+	}
+}
+
+
 //! Draws the normals of a mesh buffer
 void CNullDriver::drawMeshBufferNormals(const scene::IMeshBuffer* mb, f32 length, SColor color)
 {
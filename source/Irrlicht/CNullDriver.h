@@ -17,6 +17,8 @@
 #include "IMeshBuffer.h"
 #include "IMeshSceneNode.h"
 #include "CFPSCounter.h"
+#include "CThread.h"
+#include "CTextureLoadQueue.h"
 #include "S3DVertex.h"
 #include "SVertexIndex.h"
 #include "SLight.h"
@@ -88,6 +90,12 @@ namespace video
 		//! loads a Texture
 		virtual ITexture* getTexture(io::IReadFile* file);
 
+		//! Loads a texture in the background.
+		virtual ITexture* getTextureAsync(const io::path& filename);
+
+		//! Returns the number of textures which are still decoded in the background.
+		virtual u32 getPendingTextureLoadCount() const;
+
 		//! Returns a texture by index
 		virtual ITexture* getTextureByIndex(u32 index);
 
@@ -250,6 +258,12 @@ namespace video
 		//! very useful method for statistics.
 		virtual u32 getPrimitiveCountDrawn( u32 param = 0 ) const;
 
+		//! Returns the arena for temporary data of the current frame.
+		virtual core::memoryArena* getFrameArena() { return &FrameArena; }
+
+		//! Runs the texture calls which other threads wait for.
+		virtual void processQueuedCalls();
+
 		//! deletes all dynamic lights there are
 		virtual void deleteAllDynamicLights();
 
@@ -372,6 +386,10 @@ namespace video
 		//! Draws a mesh buffer
 		virtual void drawMeshBuffer(const scene::IMeshBuffer* mb);
 
+		//! Draws a mesh buffer once for each of several transformations
+		virtual void drawMeshBufferInstanced(const scene::IMeshBuffer* mb,
+			const core::matrix4* transforms, const SColor* colors, u32 instanceCount);
+
 		//! Draws the normals of a mesh buffer
 		virtual void drawMeshBufferNormals(const scene::IMeshBuffer* mb, f32 length=10.f, SColor color=0xffffffff);
 
@@ -663,6 +681,46 @@ namespace video
 		virtual bool checkDriverReset() {return false;}
 	protected:
 
+		//! a texture call of another thread, run by processQueuedCalls
+		struct SQueuedCall
+		{
+			enum E_CALL
+			{
+				GET_BY_NAME,
+				GET_BY_FILE,
+				GET_ASYNC,
+				FIND,
+				ADD_IMAGE,
+				ADD_EMPTY,
+				NORMAL_MAP
+			};
+
+			SQueuedCall(E_CALL type)
+				: Type(type), Name(0), File(0), Image(0), MipmapData(0),
+				Format(ECF_A8R8G8B8), Texture(0), Amplitude(1.f),
+				TextureCreationFlags(0), Result(0), Done(false) {}
+
+			E_CALL Type;
+			const io::path* Name;
+			io::IReadFile* File;
+			IImage* Image;
+			void* MipmapData;
+			core::dimension2d<u32> Size;
+			ECOLOR_FORMAT Format;
+			ITexture* Texture;
+			f32 Amplitude;
+			//! flags of the calling thread, used while the call runs
+			u32 TextureCreationFlags;
+			ITexture* Result;
+			bool Done;
+		};
+
+		//! true when called from the thread which created the driver
+		bool isOwnerThread() const { return CThread::getCurrentId() == OwnerThread; }
+
+		//! queues a call for the owning thread and waits until it ran
+		ITexture* runOnOwnerThread(SQueuedCall& call);
+
 		//! deletes all textures
 		void deleteAllTextures();
 
@@ -679,6 +737,10 @@ namespace video
 		//! THIS METHOD HAS TO BE OVERRIDDEN BY DERIVED DRIVERS WITH OWN TEXTURES
 		virtual video::ITexture* createDeviceDependentTexture(IImage* surface, const io::path& name, void* mipmapData=0);
 
+		//! replaces the content of a texture created by createDeviceDependentTexture
+		//! THIS METHOD HAS TO BE OVERRIDDEN BY DERIVED DRIVERS WITH OWN TEXTURES
+		virtual bool replaceTextureImage(ITexture* texture, IImage* image);
+
 		//! checks triangle count and print warning if wrong
 		bool checkPrimitiveCount(u32 prmcnt) const;
 
@@ -817,6 +879,25 @@ namespace video
 		//core::array<SHWBufferLink*> HWBufferLinks;
 		core::map< const scene::IMeshBuffer* , SHWBufferLink* > HWBufferMap;
 
+		//! vertices and indices of the instances drawn by drawMeshBufferInstanced
+		core::array<u8> InstanceVertices;
+		core::array<u16> InstanceIndices;
+
+		//! scratch memory of the current frame, reset in endScene
+		core::memoryArena FrameArena;
+
+		//! texture calls of other threads
+		size_t OwnerThread;
+		CMutex QueuedCallMutex;
+		CCondition QueuedCallDone;
+		core::array<SQueuedCall*> QueuedCalls;
+
+		//! texture creation flags of the other threads, shared by all of them
+		u32 QueuedTextureCreationFlags;
+
+		//! decoders of getTextureAsync, created by the first request
+		CTextureLoadQueue* TextureLoadQueue;
+
 		io::IFileSystem* FileSystem;
 
 		//! mesh manipulator
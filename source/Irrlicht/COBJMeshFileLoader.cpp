@@ -80,9 +80,16 @@ IAnimatedMesh* COBJMeshFileLoader::createMesh(io::IReadFile* file)
 	const io::path fullName = file->getFileName();
 	const io::path relPath = FileSystem->getFileDir(fullName)+"/";
 
-	c8* buf = new c8[filesize];
-	memset(buf, 0, filesize);
-	file->read((void*)buf, filesize);
+	// mapped files are parsed in place
+	const c8* buf = (const c8*)file->getMappedData();
+	c8* fileBuf = 0;
+	if (!buf)
+	{
+		fileBuf = new c8[filesize];
+		memset(fileBuf, 0, filesize);
+		file->read((void*)fileBuf, filesize);
+		buf = fileBuf;
+	}
 	const c8* const bufEnd = buf+filesize;
 
 	// Process obj information
@@ -310,7 +317,7 @@ IAnimatedMesh* COBJMeshFileLoader::createMesh(io::IReadFile* file)
 	}
 
 	// Clean up the allocate obj file contents
-	delete [] buf;
+	delete [] fileBuf;
 	// more cleaning up
 	cleanUp();
 	mesh->drop();
@@ -505,8 +512,14 @@ void COBJMeshFileLoader::readMTL(const c8* fileName, const io::path& relPath)
 		return;
 	}
 
-	c8* buf = new c8[filesize];
-	mtlReader->read((void*)buf, filesize);
+	const c8* buf = (const c8*)mtlReader->getMappedData();
+	c8* fileBuf = 0;
+	if (!buf)
+	{
+		fileBuf = new c8[filesize];
+		mtlReader->read((void*)fileBuf, filesize);
+		buf = fileBuf;
+	}
 	const c8* bufEnd = buf+filesize;
 
 	SObjMtl* currMaterial = 0;
@@ -653,7 +666,7 @@ void COBJMeshFileLoader::readMTL(const c8* fileName, const io::path& relPath)
 	if ( currMaterial )
 		Materials.push_back( currMaterial );
 
-	delete [] buf;
+	delete [] fileBuf;
 	mtlReader->drop();
 }
 
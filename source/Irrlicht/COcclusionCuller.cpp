@@ -0,0 +1,290 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "COcclusionCuller.h"
+#include "ICameraSceneNode.h"
+#include "IMesh.h"
+#include "IMeshBuffer.h"
+#include "CProfiler.h"
+
+#ifdef _IRR_COMPILE_WITH_BURNINGSVIDEO_
+#include "SoftwareDriver2_compile_config.h"
+#include "IDepthBuffer.h"
+#endif
+
+namespace irr
+{
+namespace scene
+{
+
+//! constructor
+COcclusionCuller::COcclusionCuller()
+: DepthBuffer(0), Size(256, 128), Near(1.f), Active(false)
+{
+}
+
+
+//! destructor
+COcclusionCuller::~COcclusionCuller()
+{
+	if (DepthBuffer)
+		DepthBuffer->drop();
+}
+
+
+//! sets the size of the depth buffer
+void COcclusionCuller::setSize(const core::dimension2d<u32>& size)
+{
+	Size.set(core::max_(size.Width, 1u), core::max_(size.Height, 1u));
+	if (DepthBuffer)
+		DepthBuffer->setSize(Size);
+}
+
+
+//! clears the depth buffer for a camera
+bool COcclusionCuller::begin(const ICameraSceneNode* camera)
+{
+	Active = false;
+
+#ifdef _IRR_COMPILE_WITH_BURNINGSVIDEO_
+	// orthogonal projections have a constant w, which can't be used as depth
+	if (!camera || camera->isOrthogonal())
+		return false;
+
+	if (!DepthBuffer)
+		DepthBuffer = video::createDepthBuffer(Size);
+
+	DepthBuffer->clear();
+	ViewProjection = camera->getProjectionMatrix() * camera->getViewMatrix();
+	Near = core::max_(camera->getNearValue(), 0.001f);
+	Active = true;
+#endif
+
+	return Active;
+}
+
+
+//! rasterizes the triangles of an occluder mesh
+void COcclusionCuller::addOccluder(const IMesh* mesh, const core::matrix4& transform)
+{
+	if (!Active || !mesh)
+		return;
+
+	_IRR_PROFILE("occlusion: rasterize");
+
+	const core::matrix4 m(ViewProjection * transform);
+	f32 clip[3][4];
+
+	for (u32 b=0; b<mesh->getMeshBufferCount(); ++b)
+	{
+		const IMeshBuffer* mb = mesh->getMeshBuffer(b);
+		const u32 indexCount = mb->getIndexCount();
+		const u16* indices16 = mb->getIndexType() == video::EIT_16BIT ? mb->getIndices() : 0;
+		const u32* indices32 = indices16 ? 0 : (const u32*)mb->getIndices();
+
+		for (u32 i=0; i+2<indexCount; i+=3)
+		{
+			for (u32 k=0; k<3; ++k)
+			{
+				const u32 index = indices16 ? indices16[i+k] : indices32[i+k];
+				m.transformVect(clip[k], mb->getPosition(index));
+			}
+			drawTriangle(clip[0], clip[1], clip[2]);
+		}
+	}
+}
+
+
+//! ends adding occluders
+void COcclusionCuller::end()
+{
+#ifdef _IRR_COMPILE_WITH_BURNINGSVIDEO_
+	// the coarse depth of the tiles is computed on demand by the tests
+	if (Active)
+		DepthBuffer->markDirty(core::rect<s32>(0, 0, Size.Width, Size.Height));
+#endif
+}
+
+
+//! returns if a box in object space is hidden behind the occluders
+bool COcclusionCuller::isOccluded(const core::aabbox3d<f32>& box, const core::matrix4& transform) const
+{
+#ifdef _IRR_COMPILE_WITH_BURNINGSVIDEO_
+	if (!Active)
+		return false;
+
+	const core::matrix4 m(ViewProjection * transform);
+	core::vector3df edges[8];
+	box.getEdges(edges);
+
+	f32 x0 = FLT_MAX, y0 = FLT_MAX, x1 = -FLT_MAX, y1 = -FLT_MAX;
+	f32 nearest = 0.f;
+	for (u32 i=0; i<8; ++i)
+	{
+		f32 clip[4];
+		m.transformVect(clip, edges[i]);
+
+		// a box crossing the near plane covers the whole view
+		if (clip[3] < Near)
+			return false;
+
+		SVertex v;
+		project(v, clip);
+		x0 = core::min_(x0, v.X);
+		y0 = core::min_(y0, v.Y);
+		x1 = core::max_(x1, v.X);
+		y1 = core::max_(y1, v.Y);
+		nearest = core::max_(nearest, v.W);
+	}
+
+	// pixels whose centers may be covered, with one pixel of margin
+	const core::rect<s32> area(core::floor32(x0) - 1, core::floor32(y0) - 1,
+		core::ceil32(x1) + 1, core::ceil32(y1) + 1);
+	return DepthBuffer->isOccluded(area, nearest);
+#else
+	return false;
+#endif
+}
+
+
+//! projects a vertex in clip space to the screen
+void COcclusionCuller::project(SVertex& out, const f32* clip) const
+{
+	const f32 invW = core::reciprocal(clip[3]);
+	out.X = (clip[0] * invW * 0.5f + 0.5f) * Size.Width;
+	out.Y = (0.5f - clip[1] * invW * 0.5f) * Size.Height;
+	out.W = invW;
+}
+
+
+//! clips a triangle in clip space at the near plane and rasterizes it
+void COcclusionCuller::drawTriangle(const f32* a, const f32* b, const f32* c)
+{
+	const f32* in[3] = { a, b, c };
+
+	// clip at the near plane, w >= near, a triangle becomes at most a quad
+	f32 clipped[4][4];
+	u32 count = 0;
+	for (u32 i=0; i<3; ++i)
+	{
+		const f32* p = in[i];
+		const f32* q = in[(i + 1) % 3];
+		const f32 dp = p[3] - Near;
+		const f32 dq = q[3] - Near;
+		if (dp >= 0.f)
+		{
+			for (u32 k=0; k<4; ++k)
+				clipped[count][k] = p[k];
+			++count;
+		}
+		if ((dp >= 0.f) != (dq >= 0.f))
+		{
+			const f32 t = dp / (dp - dq);
+			for (u32 k=0; k<4; ++k)
+				clipped[count][k] = p[k] + (q[k] - p[k]) * t;
+			++count;
+		}
+	}
+
+	if (count < 3)
+		return;
+
+	SVertex v[4];
+	for (u32 i=0; i<count; ++i)
+		project(v[i], clipped[i]);
+
+	rasterize(&v[0], &v[1], &v[2]);
+	if (count == 4)
+		rasterize(&v[0], &v[2], &v[3]);
+}
+
+
+//! rasterizes a triangle in screen space
+void COcclusionCuller::rasterize(const SVertex* a, const SVertex* b, const SVertex* c)
+{
+#ifdef _IRR_COMPILE_WITH_BURNINGSVIDEO_
+	// sort on height, y
+	if (a->Y > b->Y) core::swap(a, b);
+	if (a->Y > c->Y) core::swap(a, c);
+	if (b->Y > c->Y) core::swap(b, c);
+
+	const f32 ca = c->Y - a->Y;
+	if (ca <= 0.f)
+		return;
+
+	// the major edge from a to c, and the two minor edges
+	const f32 majorX = (c->X - a->X) / ca;
+	const f32 majorW = (c->W - a->W) / ca;
+
+	// find if the major edge is left or right of b
+	const f32 bMajorX = a->X + (b->Y - a->Y) * majorX;
+	const bool majorLeft = bMajorX < b->X;
+
+	fp24* buffer = (fp24*)DepthBuffer->lock();
+	const u32 pitch = DepthBuffer->getPitch() / sizeof(fp24);
+	const s32 height = (s32)Size.Height;
+	const s32 width = (s32)Size.Width;
+
+	for (u32 half=0; half<2; ++half)
+	{
+		const SVertex* top = half ? b : a;
+		const SVertex* bottom = half ? c : b;
+		const f32 dy = bottom->Y - top->Y;
+		if (dy <= 0.f)
+			continue;
+
+		const f32 minorX = (bottom->X - top->X) / dy;
+		const f32 minorW = (bottom->W - top->W) / dy;
+
+		// apply top-left fill-convention, top
+		s32 yStart = core::ceil32(top->Y);
+		s32 yEnd = core::ceil32(bottom->Y) - 1;
+		yStart = core::s32_max(yStart, 0);
+		yEnd = core::s32_min(yEnd, height - 1);
+
+		for (s32 y=yStart; y<=yEnd; ++y)
+		{
+			const f32 majorDY = (f32)y - a->Y;
+			const f32 minorDY = (f32)y - top->Y;
+			f32 x[2], w[2];
+			x[majorLeft ? 0 : 1] = a->X + majorDY * majorX;
+			w[majorLeft ? 0 : 1] = a->W + majorDY * majorW;
+			x[majorLeft ? 1 : 0] = top->X + minorDY * minorX;
+			w[majorLeft ? 1 : 0] = top->W + minorDY * minorW;
+
+			const f32 deltaX = x[1] - x[0];
+			if (deltaX <= 0.f)
+				continue;
+
+			// apply top-left fill-convention, left
+			s32 xStart = core::ceil32(x[0]);
+			s32 xEnd = core::ceil32(x[1]) - 1;
+			const f32 slopeW = (w[1] - w[0]) / deltaX;
+			f32 depth = w[0] + ((f32)xStart - x[0]) * slopeW;
+			if (xStart < 0)
+			{
+				depth -= xStart * slopeW;
+				xStart = 0;
+			}
+			xEnd = core::s32_min(xEnd, width - 1);
+
+			fp24* z = buffer + y * pitch;
+			for (s32 i=xStart; i<=xEnd; ++i)
+			{
+				// w buffer, closer is larger
+				if (depth > z[i])
+					z[i] = depth;
+				depth += slopeW;
+			}
+		}
+	}
+
+	DepthBuffer->unlock();
+#endif
+}
+
+
+} // end namespace scene
+} // end namespace irr
+
@@ -0,0 +1,91 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_OCCLUSION_CULLER_H_INCLUDED__
+#define __C_OCCLUSION_CULLER_H_INCLUDED__
+
+#include "IrrCompileConfig.h"
+#include "matrix4.h"
+#include "dimension2d.h"
+
+namespace irr
+{
+namespace video
+{
+	class IDepthBuffer;
+} // end namespace video
+
+namespace scene
+{
+	class ICameraSceneNode;
+	class IMesh;
+
+	//! Tests bounding boxes against a small depth buffer of occluder meshes.
+	/** The occluders are rasterized on the CPU into a depth buffer of
+	Burning's Video, which keeps the farthest depth of its tiles and tile
+	groups. A box is occluded if the depth buffer is closer than the
+	nearest corner of the box everywhere inside of its screen rectangle.
+	Works with every driver, but needs the engine to be compiled with
+	_IRR_COMPILE_WITH_BURNINGSVIDEO_, without it nothing is occluded. */
+	class COcclusionCuller
+	{
+	public:
+
+		//! constructor
+		COcclusionCuller();
+
+		//! destructor
+		~COcclusionCuller();
+
+		//! sets the size of the depth buffer
+		void setSize(const core::dimension2d<u32>& size);
+
+		//! returns the size of the depth buffer
+		const core::dimension2d<u32>& getSize() const { return Size; }
+
+		//! clears the depth buffer for a camera
+		/** \return false if the camera can't be used, orthogonal
+		cameras are not supported. */
+		bool begin(const ICameraSceneNode* camera);
+
+		//! rasterizes the triangles of an occluder mesh
+		void addOccluder(const IMesh* mesh, const core::matrix4& transform);
+
+		//! ends adding occluders
+		void end();
+
+		//! returns if a box in object space is hidden behind the occluders
+		bool isOccluded(const core::aabbox3d<f32>& box, const core::matrix4& transform) const;
+
+	private:
+
+		//! vertex after the projection, x and y in pixels, w is 1/w
+		struct SVertex
+		{
+			f32 X;
+			f32 Y;
+			f32 W;
+		};
+
+		//! clips a triangle in clip space at the near plane and rasterizes it
+		void drawTriangle(const f32* a, const f32* b, const f32* c);
+
+		//! rasterizes a triangle in screen space
+		void rasterize(const SVertex* a, const SVertex* b, const SVertex* c);
+
+		//! projects a vertex in clip space to the screen
+		void project(SVertex& out, const f32* clip) const;
+
+		video::IDepthBuffer* DepthBuffer;
+		core::dimension2d<u32> Size;
+		core::matrix4 ViewProjection;
+		f32 Near;
+		bool Active;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
@@ -152,7 +152,9 @@ void COctreeSceneNode::render()
 			if (DebugDataVisible && !Materials.empty() && PassCount==1)
 			{
 				const core::aabbox3df& box = frust.getBoundingBox();
-				core::array< const core::aabbox3d<f32>* > boxes;
+				core::array< const core::aabbox3d<f32>*,
+					core::irrArenaAllocator<const core::aabbox3d<f32>*> > boxes;
+				boxes.setAllocator(driver->getFrameArena());
 				video::SMaterial m;
 				m.Lighting = false;
 				driver->setMaterial(m);
@@ -218,7 +220,9 @@ void COctreeSceneNode::render()
 			if (DebugDataVisible && !Materials.empty() && PassCount==1)
 			{
 				const core::aabbox3d<float> &box = frust.getBoundingBox();
-				core::array< const core::aabbox3d<f32>* > boxes;
+				core::array< const core::aabbox3d<f32>*,
+					core::irrArenaAllocator<const core::aabbox3d<f32>*> > boxes;
+				boxes.setAllocator(driver->getFrameArena());
 				video::SMaterial m;
 				m.Lighting = false;
 				driver->setMaterial(m);
@@ -266,7 +270,9 @@ void COctreeSceneNode::render()
 			if (DebugDataVisible && !Materials.empty() && PassCount==1)
 			{
 				const core::aabbox3d<float> &box = frust.getBoundingBox();
-				core::array< const core::aabbox3d<f32>* > boxes;
+				core::array< const core::aabbox3d<f32>*,
+					core::irrArenaAllocator<const core::aabbox3d<f32>*> > boxes;
+				boxes.setAllocator(driver->getFrameArena());
 				video::SMaterial m;
 				m.Lighting = false;
 				driver->setMaterial(m);
@@ -16,6 +16,7 @@
 #include "COpenGLNormalMapRenderer.h"
 #include "COpenGLParallaxMapRenderer.h"
 #include "os.h"
+#include "CProfiler.h"
 
 #ifdef _IRR_COMPILE_WITH_OSX_DEVICE_
 #include "MacOSX/CIrrDeviceMacOSX.h"
@@ -1281,6 +1282,8 @@ void COpenGLDriver::drawHardwareBuffer(SHWBufferLink *_HWBuffer)
 	if (!_HWBuffer)
 		return;
 
+	_IRR_PROFILE("driver: drawHardwareBuffer");
+
 	updateHardwareBuffer(_HWBuffer); //check if update is needed
 	_HWBuffer->LastUsed=0; //reset count
 
@@ -1447,6 +1450,8 @@ void COpenGLDriver::drawVertexPrimitiveList(const void* vertices, u32 vertexCoun
 	if (!checkPrimitiveCount(primitiveCount))
 		return;
 
+	_IRR_PROFILE("driver: drawVertexPrimitiveList");
+
 	CNullDriver::drawVertexPrimitiveList(vertices, vertexCount, indexList, primitiveCount, vType, pType, iType);
 
 	if (vertices && !FeatureAvailable[IRR_ARB_vertex_array_bgra] && !FeatureAvailable[IRR_EXT_vertex_array_bgra])
@@ -2512,6 +2517,14 @@ video::ITexture* COpenGLDriver::createDeviceDependentTexture(IImage* surface, co
 }
 
 
+//! replaces the content of a texture created by createDeviceDependentTexture
+bool COpenGLDriver::replaceTextureImage(ITexture* texture, IImage* image)
+{
+	static_cast<COpenGLTexture*>(texture)->replaceImage(image);
+	return true;
+}
+
+
 //! Sets a material. All 3d drawing functions draw geometry now using this material.
 void COpenGLDriver::setMaterial(const SMaterial& material)
 {
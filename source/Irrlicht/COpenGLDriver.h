@@ -425,6 +425,9 @@ namespace video
 		//! returns a device dependent texture from a software surface (IImage)
 		virtual video::ITexture* createDeviceDependentTexture(IImage* surface, const io::path& name, void* mipmapData);
 
+		//! replaces the content of a texture created by createDeviceDependentTexture
+		virtual bool replaceTextureImage(ITexture* texture, IImage* image);
+
 		//! creates a transposed matrix in supplied GLfloat array to pass to OpenGL
 		inline void getGLMatrix(GLfloat gl_matrix[16], const core::matrix4& m);
 		inline void getGLTextureMatrix(GLfloat gl_matrix[16], const core::matrix4& m);
@@ -31,28 +31,9 @@ COpenGLTexture::COpenGLTexture(IImage* origImage, const io::path& name, void* mi
 	setDebugName("COpenGLTexture");
 	#endif
 
-	HasMipMaps = Driver->getTextureCreationFlag(ETCF_CREATE_MIP_MAPS);
-	getImageValues(origImage);
-
 	glGenTextures(1, &TextureName);
 
-	if (ImageSize==TextureSize)
-	{
-		Image = Driver->createImage(ColorFormat, ImageSize);
-		origImage->copyTo(Image);
-	}
-	else
-	{
-		Image = Driver->createImage(ColorFormat, TextureSize);
-		// scale texture
-		origImage->copyToScaling(Image);
-	}
-	uploadTexture(true, mipmapData);
-	if (!KeepImage)
-	{
-		Image->drop();
-		Image=0;
-	}
+	setImage(origImage, mipmapData);
 }
 
 
@@ -297,6 +278,45 @@ void COpenGLTexture::getImageValues(IImage* image)
 }
 
 
+//! creates the texture data from an image
+void COpenGLTexture::setImage(IImage* origImage, void* mipmapData)
+{
+	HasMipMaps = Driver->getTextureCreationFlag(ETCF_CREATE_MIP_MAPS);
+	getImageValues(origImage);
+
+	if (ImageSize==TextureSize)
+	{
+		Image = Driver->createImage(ColorFormat, ImageSize);
+		origImage->copyTo(Image);
+	}
+	else
+	{
+		Image = Driver->createImage(ColorFormat, TextureSize);
+		// scale texture
+		origImage->copyToScaling(Image);
+	}
+	uploadTexture(true, mipmapData);
+	if (!KeepImage)
+	{
+		Image->drop();
+		Image=0;
+	}
+}
+
+
+//! replaces the image of the texture, keeps the OpenGL texture name
+void COpenGLTexture::replaceImage(IImage* image)
+{
+	if (Image)
+	{
+		Image->drop();
+		Image=0;
+	}
+
+	setImage(image, 0);
+}
+
+
 //! copies the the texture into an open gl texture.
 void COpenGLTexture::uploadTexture(bool newTexture, void* mipmapData, u32 level)
 {
@@ -103,6 +103,9 @@ public:
 	//! sets whether this texture is intended to be used as a render target.
 	void setIsRenderTarget(bool isTarget);
 
+	//! replaces the image of the texture, keeps the OpenGL texture name
+	void replaceImage(IImage* image);
+
 protected:
 
 	//! protected constructor with basic setup, no GL texture name created, for derived classes
@@ -118,6 +121,9 @@ protected:
 	//! get important numbers of the image and hw texture
 	void getImageValues(IImage* image);
 
+	//! creates the texture data from an image
+	void setImage(IImage* origImage, void* mipmapData);
+
 	//! copies the texture into an OpenGL texture.
 	/** \param newTexture True if method is called for a newly created texture for the first time. Otherwise call with false to improve memory handling.
 	\param mipmapData Pointer to raw mipmap data, including all necessary mip levels, in the same format as the main texture image.
@@ -0,0 +1,262 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CProfiler.h"
+
+#ifdef _IRR_COMPILE_WITH_PROFILING_
+
+#include "IWriteFile.h"
+#include <stdio.h>
+
+#if defined(_IRR_WINDOWS_API_)
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <pthread.h>
+	#include <sys/time.h>
+#endif
+
+namespace irr
+{
+
+CProfiler* CProfiler::Active = 0;
+
+#if defined(_IRR_WINDOWS_API_)
+
+struct CProfiler::SThreadData
+{
+	DWORD Key;
+	CRITICAL_SECTION Mutex;
+};
+
+#else
+
+struct CProfiler::SThreadData
+{
+	pthread_key_t Key;
+	pthread_mutex_t Mutex;
+};
+
+#endif
+
+
+//! constructor
+CProfiler::CProfiler()
+: Data(new SThreadData), StartTicks(0), TicksPerSecond(1000000), Enabled(false)
+{
+	#ifdef _DEBUG
+	setDebugName("CProfiler");
+	#endif
+
+#if defined(_IRR_WINDOWS_API_)
+	Data->Key = TlsAlloc();
+	InitializeCriticalSection(&Data->Mutex);
+	LARGE_INTEGER freq;
+	if (QueryPerformanceFrequency(&freq))
+		TicksPerSecond = freq.QuadPart;
+#else
+	pthread_key_create(&Data->Key, 0);
+	pthread_mutex_init(&Data->Mutex, 0);
+#endif
+
+	StartTicks = getTicks();
+}
+
+
+//! destructor
+CProfiler::~CProfiler()
+{
+	if (Active == this)
+		Active = 0;
+
+#if defined(_IRR_WINDOWS_API_)
+	TlsFree(Data->Key);
+	DeleteCriticalSection(&Data->Mutex);
+#else
+	pthread_key_delete(Data->Key);
+	pthread_mutex_destroy(&Data->Mutex);
+#endif
+	delete Data;
+
+	for (u32 i=0; i<Buffers.size(); ++i)
+		delete Buffers[i];
+}
+
+
+void CProfiler::setEnabled(bool enable)
+{
+	Enabled = enable;
+}
+
+
+bool CProfiler::isEnabled() const
+{
+	return Enabled;
+}
+
+
+u64 CProfiler::getTicks() const
+{
+#if defined(_IRR_WINDOWS_API_)
+	LARGE_INTEGER ticks;
+	QueryPerformanceCounter(&ticks);
+	return ticks.QuadPart;
+#else
+	timeval tv;
+	gettimeofday(&tv, 0);
+	return (u64)tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+}
+
+
+u64 CProfiler::getTime() const
+{
+	const u64 ticks = getTicks() - StartTicks;
+	if (TicksPerSecond == 1000000)
+		return ticks;
+	// split to avoid the overflow of ticks*1000000
+	return (ticks / TicksPerSecond) * 1000000 + ((ticks % TicksPerSecond) * 1000000) / TicksPerSecond;
+}
+
+
+CProfiler::SThreadBuffer* CProfiler::getThreadBuffer()
+{
+#if defined(_IRR_WINDOWS_API_)
+	SThreadBuffer* buffer = (SThreadBuffer*)TlsGetValue(Data->Key);
+#else
+	SThreadBuffer* buffer = (SThreadBuffer*)pthread_getspecific(Data->Key);
+#endif
+	if (buffer)
+		return buffer;
+
+	// first event of this thread, the buffer lives until the profiler is destroyed
+	buffer = new SThreadBuffer;
+	buffer->Next = 0;
+	buffer->Count = 0;
+
+#if defined(_IRR_WINDOWS_API_)
+	EnterCriticalSection(&Data->Mutex);
+	Buffers.push_back(buffer);
+	LeaveCriticalSection(&Data->Mutex);
+	TlsSetValue(Data->Key, buffer);
+#else
+	pthread_mutex_lock(&Data->Mutex);
+	Buffers.push_back(buffer);
+	pthread_mutex_unlock(&Data->Mutex);
+	pthread_setspecific(Data->Key, buffer);
+#endif
+
+	return buffer;
+}
+
+
+void CProfiler::addEvent(const c8* name, u64 start, u64 end)
+{
+	if (!Enabled)
+		return;
+
+	SThreadBuffer* buffer = getThreadBuffer();
+	SProfileEvent& e = buffer->Events[buffer->Next];
+	e.Name = name;
+	e.Start = start;
+	e.Duration = end > start ? (u32)(end - start) : 0;
+	e.Thread = 0;
+
+	buffer->Next = (buffer->Next + 1) % RING_SIZE;
+	if (buffer->Count < RING_SIZE)
+		++buffer->Count;
+}
+
+
+void CProfiler::getEvents(core::array<SProfileEvent>& outEvents) const
+{
+	outEvents.set_used(0);
+
+#if defined(_IRR_WINDOWS_API_)
+	EnterCriticalSection(&Data->Mutex);
+#else
+	pthread_mutex_lock(&Data->Mutex);
+#endif
+
+	for (u32 t=0; t<Buffers.size(); ++t)
+	{
+		const SThreadBuffer* buffer = Buffers[t];
+		outEvents.reallocate(outEvents.size() + buffer->Count);
+
+		// oldest event first
+		u32 i = (buffer->Next + RING_SIZE - buffer->Count) % RING_SIZE;
+		for (u32 n=0; n<buffer->Count; ++n)
+		{
+			outEvents.push_back(buffer->Events[i]);
+			outEvents.getLast().Thread = t;
+			i = (i + 1) % RING_SIZE;
+		}
+	}
+
+#if defined(_IRR_WINDOWS_API_)
+	LeaveCriticalSection(&Data->Mutex);
+#else
+	pthread_mutex_unlock(&Data->Mutex);
+#endif
+
+	outEvents.sort();
+}
+
+
+void CProfiler::clear()
+{
+#if defined(_IRR_WINDOWS_API_)
+	EnterCriticalSection(&Data->Mutex);
+#else
+	pthread_mutex_lock(&Data->Mutex);
+#endif
+
+	for (u32 i=0; i<Buffers.size(); ++i)
+	{
+		Buffers[i]->Next = 0;
+		Buffers[i]->Count = 0;
+	}
+
+#if defined(_IRR_WINDOWS_API_)
+	LeaveCriticalSection(&Data->Mutex);
+#else
+	pthread_mutex_unlock(&Data->Mutex);
+#endif
+}
+
+
+bool CProfiler::writeChromeTrace(io::IWriteFile* file) const
+{
+	if (!file)
+		return false;
+
+	core::array<SProfileEvent> events;
+	getEvents(events);
+
+	core::stringc out("{\"traceEvents\":[\n");
+	c8 tmp[128];
+	for (u32 i=0; i<events.size(); ++i)
+	{
+		const SProfileEvent& e = events[i];
+
+		out += "{\"name\":\"";
+		for (const c8* c=e.Name; *c; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+				out += '\\';
+			out += *c;
+		}
+		snprintf(tmp, sizeof(tmp), "\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%u,\"pid\":0,\"tid\":%u}%s\n",
+			(unsigned long long)e.Start, e.Duration, e.Thread, i+1 < events.size() ? "," : "");
+		out += tmp;
+	}
+	out += "],\"displayTimeUnit\":\"ms\"}\n";
+
+	return file->write(out.c_str(), out.size()) == (s32)out.size();
+}
+
+} // end namespace irr
+
+#endif // _IRR_COMPILE_WITH_PROFILING_
+
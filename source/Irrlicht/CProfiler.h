@@ -0,0 +1,92 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_PROFILER_H_INCLUDED__
+#define __C_PROFILER_H_INCLUDED__
+
+#include "IrrCompileConfig.h"
+#include "IProfiler.h"
+
+#ifdef _IRR_COMPILE_WITH_PROFILING_
+
+namespace irr
+{
+
+	//! Profiler with a lock free ring buffer per recording thread
+	class CProfiler : public IProfiler
+	{
+	public:
+
+		//! constructor
+		CProfiler();
+
+		//! destructor
+		virtual ~CProfiler();
+
+		//! Enables or disables the recording of events
+		virtual void setEnabled(bool enable);
+
+		//! Returns if events are recorded
+		virtual bool isEnabled() const;
+
+		//! Returns the current time in microseconds since the profiler was created
+		virtual u64 getTime() const;
+
+		//! Records a timed section of the calling thread
+		virtual void addEvent(const c8* name, u64 start, u64 end);
+
+		//! Returns the events of all threads which are still in the ring buffers
+		virtual void getEvents(core::array<SProfileEvent>& outEvents) const;
+
+		//! Removes all recorded events
+		virtual void clear();
+
+		//! Writes the recorded events as JSON in the Chrome trace event format
+		virtual bool writeChromeTrace(io::IWriteFile* file) const;
+
+		//! profiler used by the engine timers, shared by all devices like os::Printer::Logger
+		static CProfiler* Active;
+
+	private:
+
+		//! events kept per thread
+		enum { RING_SIZE = 65536 };
+
+		struct SThreadBuffer
+		{
+			SProfileEvent Events[RING_SIZE];
+			u32 Next;
+			u32 Count;
+		};
+
+		//! returns the buffer of the calling thread, creates it on first use
+		SThreadBuffer* getThreadBuffer();
+
+		//! platform time in platform ticks
+		u64 getTicks() const;
+
+		struct SThreadData;
+		SThreadData* Data;
+
+		core::array<SThreadBuffer*> Buffers;
+		u64 StartTicks;
+		u64 TicksPerSecond;
+		volatile bool Enabled;
+	};
+
+} // end namespace irr
+
+//! Times the enclosing scope with the engine profiler
+#define _IRR_PROFILE_CONCAT2(a, b) a##b
+#define _IRR_PROFILE_CONCAT(a, b) _IRR_PROFILE_CONCAT2(a, b)
+#define _IRR_PROFILE(name) irr::CProfileScope _IRR_PROFILE_CONCAT(profileScope, __LINE__)(irr::CProfiler::Active, name)
+
+#else
+
+#define _IRR_PROFILE(name)
+
+#endif // _IRR_COMPILE_WITH_PROFILING_
+
+#endif
+
@@ -3,6 +3,7 @@
 // For conditions of distribution and use, see copyright notice in irrlicht.h
 
 #include "CReadFile.h"
+#include "CMappedReadFile.h"
 
 namespace irr
 {
@@ -100,6 +101,11 @@ const io::path& CReadFile::getFileName() const
 
 IReadFile* createReadFile(const io::path& fileName)
 {
+	// mapped files can be parsed in place, see IReadFile::getMappedData
+	IReadFile* mapped = createMappedReadFile(fileName);
+	if (mapped)
+		return mapped;
+
 	CReadFile* file = new CReadFile(fileName);
 	if (file->isOpen())
 		return file;
@@ -62,160 +62,204 @@ ISceneNode* CSceneCollisionManager::getSceneNodeFromRayBB(
 
 	core::line3d<f32> truncatableRay(ray);
 
-	getPickedNodeBB((root==0)?SceneManager->getRootSceneNode():root, truncatableRay,
-		idBitMask, noDebugObjects, dist, best);
+	// the spatial index only covers the whole scene
+	ISceneNode* sceneRoot = SceneManager->getRootSceneNode();
+	const bool useIndex = (root==0 || root==sceneRoot);
+
+	getPickedNodeBB(useIndex?sceneRoot:root, truncatableRay,
+		idBitMask, noDebugObjects, dist, best, useIndex);
+
+	if (useIndex)
+	{
+		IndexedNodes.set_used(0);
+		SceneManager->getSpatialIndexNodes(IndexedNodes, ray);
+
+		const core::vector3df rayVector = ray.getVector().normalize();
+		for (u32 i=0; i<IndexedNodes.size(); ++i)
+		{
+			ISceneNode* current = IndexedNodes[i];
+			if (!isVisibleInScene(current, sceneRoot))
+				continue;
+
+			testNodeBB(current, truncatableRay, rayVector, idBitMask, noDebugObjects, dist, best);
+			getPickedNodeBB(current, truncatableRay, idBitMask, noDebugObjects, dist, best, true);
+		}
+	}
 
 	return best;
 }
 
 
-//! recursive method for going through all scene nodes
+//! returns if a node and all its parents up to the root are visible
+bool CSceneCollisionManager::isVisibleInScene(const ISceneNode* node, const ISceneNode* root)
+{
+	for (; node; node = node->getParent())
+	{
+		if (!node->isVisible())
+			return false;
+		if (node == root)
+			return true;
+	}
+	return false;
+}
+
+
+//! goes through all scene nodes below root
 void CSceneCollisionManager::getPickedNodeBB(ISceneNode* root,
 		core::line3df& ray, s32 bits, bool noDebugObjects,
-		f32& outbestdistance, ISceneNode*& outbestnode)
+		f32& outbestdistance, ISceneNode*& outbestnode, bool skipIndexed)
 {
-	const ISceneNodeList& children = root->getChildren();
 	const core::vector3df rayVector = ray.getVector().normalize();
 
-	ISceneNodeList::ConstIterator it = children.begin();
-	for (; it != children.end(); ++it)
+	NodeIterator.reset(root);
+	NodeIterator.next();
+	while (ISceneNode* current = NodeIterator.next())
+	{
+		// nodes of the spatial index are tested after querying it.
+		// Only check the children if this node is visible.
+		if ((skipIndexed && current->getSpatialIndexId() >= 0) || !current->isVisible())
+		{
+			NodeIterator.skipChildren();
+			continue;
+		}
+
+		testNodeBB(current, ray, rayVector, bits, noDebugObjects, outbestdistance, outbestnode);
+	}
+}
+
+
+//! tests the bounding box of a single scene node
+void CSceneCollisionManager::testNodeBB(ISceneNode* current,
+		core::line3df& ray, const core::vector3df& rayVector, s32 bits, bool noDebugObjects,
+		f32& outbestdistance, ISceneNode*& outbestnode)
+{
+	if((noDebugObjects ? !current->isDebugObject() : true) &&
+		(bits==0 || (bits != 0 && (current->getID() & bits))))
 	{
-		ISceneNode* current = *it;
+		// get world to object space transform
+		core::matrix4 worldToObject;
+		if (!current->getAbsoluteTransformation().getInverse(worldToObject))
+			return;
+
+		// transform vector from world space to object space
+		core::line3df objectRay(ray);
+		worldToObject.transformVect(objectRay.start);
+		worldToObject.transformVect(objectRay.end);
+
+		const core::aabbox3df & objectBox = current->getBoundingBox();
 
-		if (current->isVisible())
+		// Do the initial intersection test in object space, since the
+		// object space box test is more accurate.
+		if(objectBox.isPointInside(objectRay.start))
 		{
-			if((noDebugObjects ? !current->isDebugObject() : true) &&
-				(bits==0 || (bits != 0 && (current->getID() & bits))))
+			// use fast bbox intersection to find distance to hitpoint
+			// algorithm from Kay et al., code from gamedev.net
+			const core::vector3df dir = (objectRay.end-objectRay.start).normalize();
+			const core::vector3df minDist = (objectBox.MinEdge - objectRay.start)/dir;
+			const core::vector3df maxDist = (objectBox.MaxEdge - objectRay.start)/dir;
+			const core::vector3df realMin(core::min_(minDist.X, maxDist.X),core::min_(minDist.Y, maxDist.Y),core::min_(minDist.Z, maxDist.Z));
+			const core::vector3df realMax(core::max_(minDist.X, maxDist.X),core::max_(minDist.Y, maxDist.Y),core::max_(minDist.Z, maxDist.Z));
+
+			const f32 minmax = core::min_(realMax.X, realMax.Y, realMax.Z);
+			// nearest distance to intersection
+			const f32 maxmin = core::max_(realMin.X, realMin.Y, realMin.Z);
+
+			const f32 toIntersectionSq = (maxmin>0?maxmin*maxmin:minmax*minmax);
+			if (toIntersectionSq < outbestdistance)
 			{
-				// get world to object space transform
-				core::matrix4 worldToObject;
-				if (!current->getAbsoluteTransformation().getInverse(worldToObject))
-					continue;
+				outbestdistance = toIntersectionSq;
+				outbestnode = current;
 
-				// transform vector from world space to object space
-				core::line3df objectRay(ray);
-				worldToObject.transformVect(objectRay.start);
-				worldToObject.transformVect(objectRay.end);
+				// And we can truncate the ray to stop us hitting further nodes.
+				ray.end = ray.start + (rayVector * sqrtf(toIntersectionSq));
+			}
+		}
+		else
+		if (objectBox.intersectsWithLine(objectRay))
+		{
+			// Now transform into world space, since we need to use world space
+			// scales and distances.
+			core::aabbox3df worldBox(objectBox);
+			current->getAbsoluteTransformation().transformBoxEx(worldBox);
+
+			core::vector3df edges[8];
+			worldBox.getEdges(edges);
+
+			/* We need to check against each of 6 faces, composed of these corners:
+				  /3--------/7
+				 /  |      / |
+				/   |     /  |
+				1---------5  |
+				|   2- - -| -6
+				|  /      |  /
+				|/        | /
+				0---------4/
+
+				Note that we define them as opposite pairs of faces.
+			*/
+			static const s32 faceEdges[6][3] =
+			{
+				{ 0, 1, 5 }, // Front
+				{ 6, 7, 3 }, // Back
+				{ 2, 3, 1 }, // Left
+				{ 4, 5, 7 }, // Right
+				{ 1, 3, 7 }, // Top
+				{ 2, 0, 4 }  // Bottom
+			};
+
+			core::vector3df intersection;
+			core::plane3df facePlane;
+			f32 bestDistToBoxBorder = FLT_MAX;
+			f32 bestToIntersectionSq = FLT_MAX;
+
+            for(s32 face = 0; face < 6; ++face)
+			{
+				facePlane.setPlane(edges[faceEdges[face][0]],
+									edges[faceEdges[face][1]],
+									edges[faceEdges[face][2]]);
 
-				const core::aabbox3df & objectBox = current->getBoundingBox();
+				// Only consider lines that might be entering through this face, since we
+				// already know that the start point is outside the box.
+				if(facePlane.classifyPointRelation(ray.start) != core::ISREL3D_FRONT)
+					continue;
 
-				// Do the initial intersection test in object space, since the
-				// object space box test is more accurate.
-				if(objectBox.isPointInside(objectRay.start))
+				// Don't bother using a limited ray, since we already know that it should be long
+				// enough to intersect with the box.
+				if(facePlane.getIntersectionWithLine(ray.start, rayVector, intersection))
 				{
-					// use fast bbox intersection to find distance to hitpoint
-					// algorithm from Kay et al., code from gamedev.net
-					const core::vector3df dir = (objectRay.end-objectRay.start).normalize();
-					const core::vector3df minDist = (objectBox.MinEdge - objectRay.start)/dir;
-					const core::vector3df maxDist = (objectBox.MaxEdge - objectRay.start)/dir;
-					const core::vector3df realMin(core::min_(minDist.X, maxDist.X),core::min_(minDist.Y, maxDist.Y),core::min_(minDist.Z, maxDist.Z));
-					const core::vector3df realMax(core::max_(minDist.X, maxDist.X),core::max_(minDist.Y, maxDist.Y),core::max_(minDist.Z, maxDist.Z));
-
-					const f32 minmax = core::min_(realMax.X, realMax.Y, realMax.Z);
-					// nearest distance to intersection
-					const f32 maxmin = core::max_(realMin.X, realMin.Y, realMin.Z);
-
-					const f32 toIntersectionSq = (maxmin>0?maxmin*maxmin:minmax*minmax);
-					if (toIntersectionSq < outbestdistance)
+					const f32 toIntersectionSq = ray.start.getDistanceFromSQ(intersection);
+					if(toIntersectionSq < outbestdistance)
 					{
-						outbestdistance = toIntersectionSq;
-						outbestnode = current;
-
-						// And we can truncate the ray to stop us hitting further nodes.
-						ray.end = ray.start + (rayVector * sqrtf(toIntersectionSq));
+						// We have to check that the intersection with this plane is actually
+						// on the box, so need to go back to object space again.
+						worldToObject.transformVect(intersection);
+
+                        // find the closest point on the box borders. Have to do this as exact checks will fail due to floating point problems.
+						f32 distToBorder = core::max_ ( core::min_ (core::abs_(objectBox.MinEdge.X-intersection.X), core::abs_(objectBox.MaxEdge.X-intersection.X)),
+                                                        core::min_ (core::abs_(objectBox.MinEdge.Y-intersection.Y), core::abs_(objectBox.MaxEdge.Y-intersection.Y)),
+                                                        core::min_ (core::abs_(objectBox.MinEdge.Z-intersection.Z), core::abs_(objectBox.MaxEdge.Z-intersection.Z)) );
+                        if ( distToBorder < bestDistToBoxBorder )
+                        {
+                            bestDistToBoxBorder = distToBorder;
+                            bestToIntersectionSq = toIntersectionSq;
+                        }
 					}
 				}
-				else
-				if (objectBox.intersectsWithLine(objectRay))
-				{
-					// Now transform into world space, since we need to use world space
-					// scales and distances.
-					core::aabbox3df worldBox(objectBox);
-					current->getAbsoluteTransformation().transformBoxEx(worldBox);
-
-					core::vector3df edges[8];
-					worldBox.getEdges(edges);
-
-					/* We need to check against each of 6 faces, composed of these corners:
-						  /3--------/7
-						 /  |      / |
-						/   |     /  |
-						1---------5  |
-						|   2- - -| -6
-						|  /      |  /
-						|/        | /
-						0---------4/
-
-						Note that we define them as opposite pairs of faces.
-					*/
-					static const s32 faceEdges[6][3] =
-					{
-						{ 0, 1, 5 }, // Front
-						{ 6, 7, 3 }, // Back
-						{ 2, 3, 1 }, // Left
-						{ 4, 5, 7 }, // Right
-						{ 1, 3, 7 }, // Top
-						{ 2, 0, 4 }  // Bottom
-					};
-
-					core::vector3df intersection;
-					core::plane3df facePlane;
-					f32 bestDistToBoxBorder = FLT_MAX;
-					f32 bestToIntersectionSq = FLT_MAX;
-
-                    for(s32 face = 0; face < 6; ++face)
-					{
-						facePlane.setPlane(edges[faceEdges[face][0]],
-											edges[faceEdges[face][1]],
-											edges[faceEdges[face][2]]);
-
-						// Only consider lines that might be entering through this face, since we
-						// already know that the start point is outside the box.
-						if(facePlane.classifyPointRelation(ray.start) != core::ISREL3D_FRONT)
-							continue;
-
-						// Don't bother using a limited ray, since we already know that it should be long
-						// enough to intersect with the box.
-						if(facePlane.getIntersectionWithLine(ray.start, rayVector, intersection))
-						{
-							const f32 toIntersectionSq = ray.start.getDistanceFromSQ(intersection);
-							if(toIntersectionSq < outbestdistance)
-							{
-								// We have to check that the intersection with this plane is actually
-								// on the box, so need to go back to object space again.
-								worldToObject.transformVect(intersection);
-
-                                // find the closest point on the box borders. Have to do this as exact checks will fail due to floating point problems.
-								f32 distToBorder = core::max_ ( core::min_ (core::abs_(objectBox.MinEdge.X-intersection.X), core::abs_(objectBox.MaxEdge.X-intersection.X)),
-                                                                core::min_ (core::abs_(objectBox.MinEdge.Y-intersection.Y), core::abs_(objectBox.MaxEdge.Y-intersection.Y)),
-                                                                core::min_ (core::abs_(objectBox.MinEdge.Z-intersection.Z), core::abs_(objectBox.MaxEdge.Z-intersection.Z)) );
-                                if ( distToBorder < bestDistToBoxBorder )
-                                {
-                                    bestDistToBoxBorder = distToBorder;
-                                    bestToIntersectionSq = toIntersectionSq;
-                                }
-							}
-						}
-
-						// If the ray could be entering through the first face of a pair, then it can't
-						// also be entering through the opposite face, and so we can skip that face.
-						if (!(face & 0x01))
-							++face;
-					}
 
-					if ( bestDistToBoxBorder < FLT_MAX )
-					{
-                        outbestdistance = bestToIntersectionSq;
-						outbestnode = current;
-
-                        // If we got a hit, we can now truncate the ray to stop us hitting further nodes.
-                        ray.end = ray.start + (rayVector * sqrtf(outbestdistance));
-					}
-				}
+				// If the ray could be entering through the first face of a pair, then it can't
+				// also be entering through the opposite face, and so we can skip that face.
+				if (!(face & 0x01))
+					++face;
 			}
 
-			// Only check the children if this node is visible.
-			getPickedNodeBB(current, ray, bits, noDebugObjects, outbestdistance, outbestnode);
+			if ( bestDistToBoxBorder < FLT_MAX )
+			{
+                outbestdistance = bestToIntersectionSq;
+				outbestnode = current;
+
+                // If we got a hit, we can now truncate the ray to stop us hitting further nodes.
+                ray.end = ray.start + (rayVector * sqrtf(outbestdistance));
+			}
 		}
 	}
 }
@@ -275,12 +319,10 @@ void CSceneCollisionManager::getPickedNodeFromBBAndSelector(
 				core::vector3df & outBestCollisionPoint,
 				core::triangle3df & outBestTriangle)
 {
-	const ISceneNodeList& children = root->getChildren();
-
-	ISceneNodeList::ConstIterator it = children.begin();
-	for (; it != children.end(); ++it)
+	NodeIterator.reset(root);
+	NodeIterator.next();
+	while (ISceneNode* current = NodeIterator.next())
 	{
-		ISceneNode* current = *it;
 		ITriangleSelector * selector = current->getTriangleSelector();
 
 		if (selector && current->isVisible() &&
@@ -320,10 +362,6 @@ void CSceneCollisionManager::getPickedNodeFromBBAndSelector(
 				}
 			}
 		}
-
-		getPickedNodeFromBBAndSelector(current, ray, bits, noDebugObjects,
-						outBestDistanceSquared, outBestNode,
-						outBestCollisionPoint, outBestTriangle);
 	}
 }
 
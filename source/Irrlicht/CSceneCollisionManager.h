@@ -8,6 +8,7 @@
 #include "ISceneCollisionManager.h"
 #include "ISceneManager.h"
 #include "IVideoDriver.h"
+#include "CSceneNodeIterator.h"
 
 namespace irr
 {
@@ -82,12 +83,23 @@ namespace scene
 
 	private:
 
-		//! recursive method for going through all scene nodes
+		//! goes through all scene nodes below root
+		/** \param skipIndexed Skip nodes of the spatial index together with their children. */
 		void getPickedNodeBB(ISceneNode* root, core::line3df& ray, s32 bits,
+					bool bNoDebugObjects,
+					f32& outbestdistance, ISceneNode*& outbestnode,
+					bool skipIndexed=false);
+
+		//! tests the bounding box of a single scene node
+		void testNodeBB(ISceneNode* current, core::line3df& ray,
+					const core::vector3df& rayVector, s32 bits,
 					bool bNoDebugObjects,
 					f32& outbestdistance, ISceneNode*& outbestnode);
 
-		//! recursive method for going through all scene nodes
+		//! returns if a node and all its parents up to the root are visible
+		static bool isVisibleInScene(const ISceneNode* node, const ISceneNode* root);
+
+		//! goes through all scene nodes below root
 		void getPickedNodeFromBBAndSelector(ISceneNode * root,
 						core::line3df & ray,
 						s32 bits,
@@ -148,6 +160,8 @@ namespace scene
 		ISceneManager* SceneManager;
 		video::IVideoDriver* Driver;
 		core::array<core::triangle3df> Triangles; // triangle buffer
+		core::array<ISceneNode*> IndexedNodes; // spatial index query buffer
+		CSceneNodeIterator NodeIterator; // traversal stack of the picking
 	};
 
 
@@ -17,6 +17,8 @@
 #include "ISceneLoader.h"
 
 #include "os.h"
+#include "CProfiler.h"
+#include "CJobSystem.h"
 
 // We need this include for the case of skinned mesh support without
 // any such loader
@@ -140,6 +142,9 @@
 #include "CLightSceneNode.h"
 #include "CBillboardSceneNode.h"
 #include "CMeshSceneNode.h"
+#include "CInstancedMeshSceneNode.h"
+#include "CLODMeshSceneNode.h"
+#include "CStaticBatchSceneNode.h"
 #include "CSkyBoxSceneNode.h"
 #include "CSkyDomeSceneNode.h"
 #include "CParticleSystemSceneNode.h"
@@ -158,6 +163,7 @@
 #include "COctreeTriangleSelector.h"
 #include "CTriangleBBSelector.h"
 #include "CMetaTriangleSelector.h"
+#include "CClusteredLightManager.h"
 #include "CTerrainTriangleSelector.h"
 
 #include "CSceneNodeAnimatorRotation.h"
@@ -181,9 +187,11 @@ namespace scene
 //! constructor
 CSceneManager::CSceneManager(video::IVideoDriver* driver, io::IFileSystem* fs,
 		gui::ICursorControl* cursorControl, IMeshCache* cache,
-		gui::IGUIEnvironment* gui)
+		gui::IGUIEnvironment* gui, IJobSystem* jobSystem)
 : ISceneNode(0, 0), Driver(driver), FileSystem(fs), GUIEnvironment(gui),
-	CursorControl(cursorControl), CollisionManager(0),
+	CursorControl(cursorControl), CollisionManager(0), BatchCulling(false),
+	MeshBufferQueueEnabled(false), JobSystem(jobSystem), TransformJobs(0), OcclusionCulling(false),
+	MeshLoadQueue(0),
 	ActiveCamera(0), ShadowColor(150,0,0,0), AmbientLight(0,0,0,0),
 	MeshCache(cache), CurrentRendertime(ESNRP_NONE), LightManager(0),
 	IRR_XML_FORMAT_SCENE(L"irr_scene"), IRR_XML_FORMAT_NODE(L"node"), IRR_XML_FORMAT_NODE_ATTR_TYPE(L"type")
@@ -212,6 +220,13 @@ CSceneManager::CSceneManager(video::IVideoDriver* driver, io::IFileSystem* fs,
 	if (GUIEnvironment)
 		GUIEnvironment->grab();
 
+	// the transformations are updated with the job system of the device
+	if (JobSystem)
+	{
+		JobSystem->grab();
+		setTransformThreadCount(0);
+	}
+
 	// create mesh cache if not there already
 	if (!MeshCache)
 		MeshCache = new CMeshCache();
@@ -314,7 +329,11 @@ CSceneManager::CSceneManager(video::IVideoDriver* driver, io::IFileSystem* fs,
 //! destructor
 CSceneManager::~CSceneManager()
 {
+	// stop the background loads while the loaders and the driver exist
+	delete MeshLoadQueue;
+
 	clearDeletionList();
+	removeAllOccluders();
 
 	//! force to remove hardwareTextures from the driver
 	//! because Scenes may hold internally data bounded to sceneNodes
@@ -360,6 +379,12 @@ CSceneManager::~CSceneManager()
 	if (LightManager)
 		LightManager->drop();
 
+	if (TransformJobs)
+		TransformJobs->drop();
+
+	if (JobSystem)
+		JobSystem->drop();
+
 	// remove all nodes and animators before dropping the driver
 	// as render targets may be destroyed twice
 
@@ -385,6 +410,11 @@ IAnimatedMesh* CSceneManager::getMesh(const io::path& filename)
 		return 0;
 	}
 
+	_IRR_PROFILE("getMesh: load");
+
+	if (MeshLoadQueue)
+		MeshLoadQueue->lockLoaders();
+
 	// iterate the list in reverse order so user-added loaders can override the built-in ones
 	s32 count = MeshLoaderList.size();
 	for (s32 i=count-1; i>=0; --i)
@@ -403,6 +433,9 @@ IAnimatedMesh* CSceneManager::getMesh(const io::path& filename)
 		}
 	}
 
+	if (MeshLoadQueue)
+		MeshLoadQueue->unlockLoaders();
+
 	file->drop();
 
 	if (!msh)
@@ -425,6 +458,11 @@ IAnimatedMesh* CSceneManager::getMesh(io::IReadFile* file)
 	if (msh)
 		return msh;
 
+	_IRR_PROFILE("getMesh: load");
+
+	if (MeshLoadQueue)
+		MeshLoadQueue->lockLoaders();
+
 	// iterate the list in reverse order so user-added loaders can override the built-in ones
 	s32 count = MeshLoaderList.size();
 	for (s32 i=count-1; i>=0; --i)
@@ -443,6 +481,9 @@ IAnimatedMesh* CSceneManager::getMesh(io::IReadFile* file)
 		}
 	}
 
+	if (MeshLoadQueue)
+		MeshLoadQueue->unlockLoaders();
+
 	if (!msh)
 		os::Printer::log("Could not load mesh, file format seems to be unsupported", file->getFileName(), ELL_ERROR);
 	else
@@ -452,6 +493,78 @@ IAnimatedMesh* CSceneManager::getMesh(io::IReadFile* file)
 }
 
 
+//! Loads a mesh in the background.
+void CSceneManager::getMeshAsync(const io::path& filename, IMeshLoadCallBack* callback)
+{
+	if (!MeshLoadQueue)
+		MeshLoadQueue = new CMeshLoadQueue(this, Driver);
+
+	// share the load of an earlier request
+	if (MeshLoadQueue->addToPending(filename, callback))
+		return;
+
+	IAnimatedMesh* msh = MeshCache->getMeshByName(filename);
+	if (msh)
+	{
+		MeshLoadQueue->add(filename, 0, msh, callback);
+		return;
+	}
+
+	// loaders which change the scene or the mesh cache parse on this thread
+	for (u32 i=0; i<MeshLoaderList.size(); ++i)
+	{
+		if (MeshLoaderList[i]->isALoadableFileExtension(filename) &&
+			!MeshLoaderList[i]->isLoadableOnWorkerThread())
+		{
+			MeshLoadQueue->add(filename, 0, getMesh(filename), callback);
+			return;
+		}
+	}
+
+	io::IReadFile* file = FileSystem->createAndOpenFile(filename);
+	if (!file)
+	{
+		os::Printer::log("Could not load mesh, because file could not be opened: ", filename, ELL_ERROR);
+		MeshLoadQueue->add(filename, 0, 0, callback);
+		return;
+	}
+
+	// Read the file on this thread, files in archives share the handle of
+	// the archive. Only the parsing is moved to the worker. Mapped files
+	// are read without the handle and need no copy.
+	io::IReadFile* memFile = 0;
+	if (file->getMappedData())
+	{
+		memFile = file;
+		memFile->grab();
+	}
+	else
+	{
+		const long size = file->getSize();
+		c8* data = size > 0 ? new c8[size] : 0;
+		if (data && file->read(data, size) == size)
+			memFile = FileSystem->createMemoryReadFile(data, size, file->getFileName(), true);
+		else
+		{
+			delete [] data;
+			os::Printer::log("Could not read mesh file", filename, ELL_ERROR);
+		}
+	}
+	file->drop();
+
+	MeshLoadQueue->add(filename, memFile, 0, callback);
+	if (memFile)
+		memFile->drop();
+}
+
+
+//! Returns the number of background mesh loads which were not delivered yet.
+u32 CSceneManager::getPendingMeshLoadCount() const
+{
+	return MeshLoadQueue ? MeshLoadQueue->getPendingCount() : 0;
+}
+
+
 //! returns the video driver
 video::IVideoDriver* CSceneManager::getVideoDriver()
 {
@@ -610,6 +723,68 @@ IMeshSceneNode* CSceneManager::addMeshSceneNode(IMesh* mesh, ISceneNode* parent,
 }
 
 
+//! adds a scene node for drawing many instances of a static mesh
+//! the returned pointer must not be dropped.
+IInstancedMeshSceneNode* CSceneManager::addInstancedMeshSceneNode(IMesh* mesh, ISceneNode* parent, s32 id,
+	const core::vector3df& position, const core::vector3df& rotation,
+	const core::vector3df& scale, bool alsoAddIfMeshPointerZero)
+{
+	if (!alsoAddIfMeshPointerZero && !mesh)
+		return 0;
+
+	if (!parent)
+		parent = this;
+
+	IInstancedMeshSceneNode* node = new CInstancedMeshSceneNode(mesh, parent, this, id, position, rotation, scale);
+	node->drop();
+
+	return node;
+}
+
+
+//! adds a scene node showing one level of a LOD chain
+//! the returned pointer must not be dropped.
+IMeshSceneNode* CSceneManager::addLODMeshSceneNode(IAnimatedMesh* mesh, ISceneNode* parent, s32 id,
+	const core::vector3df& position, const core::vector3df& rotation,
+	const core::vector3df& scale, bool alsoAddIfMeshPointerZero)
+{
+	if (!alsoAddIfMeshPointerZero && !mesh)
+		return 0;
+
+	if (!parent)
+		parent = this;
+
+	IMeshSceneNode* node = new CLODMeshSceneNode(mesh, parent, this, id, position, rotation, scale);
+	node->drop();
+
+	return node;
+}
+
+
+//! merges the static mesh scene nodes of a subtree into a single scene node
+//! the returned pointer must not be dropped.
+IMeshSceneNode* CSceneManager::addStaticBatchSceneNode(ISceneNode* root, ISceneNode* parent,
+	s32 id, u32 maxChunkVertices, bool hideMergedNodes)
+{
+	core::array<ISceneNode*> mergedNodes;
+	SMesh* mesh = CStaticBatchSceneNode::createBatchMesh(root, maxChunkVertices, mergedNodes);
+	if (!mesh)
+		return 0;
+
+	if (!parent)
+		parent = this;
+
+	IMeshSceneNode* node = new CStaticBatchSceneNode(mesh, parent, this, id);
+	node->drop();
+	mesh->drop();
+
+	if (hideMergedNodes)
+		CStaticBatchSceneNode::hideMergedNodes(root, mergedNodes);
+
+	return node;
+}
+
+
 //! Adds a scene node for rendering a animated water surface mesh.
 ISceneNode* CSceneManager::addWaterSurfaceSceneNode(IMesh* mesh, f32 waveHeight, f32 waveSpeed, f32 waveLength,
 	ISceneNode* parent, s32 id, const core::vector3df& position,
@@ -1171,59 +1346,371 @@ bool CSceneManager::isCulled(const ISceneNode* node) const
 		result = (Driver->getOcclusionQueryResult(const_cast<ISceneNode*>(node))==0);
 	}
 
-	// can be seen by a bounding box ?
-	if (!result && (node->getAutomaticCulling() & scene::EAC_BOX))
+	// can be seen by a bounding box, a bounding sphere or cam pyramid planes ?
+	if (!result && (node->getAutomaticCulling() & (scene::EAC_BOX | scene::EAC_FRUSTUM_SPHERE | scene::EAC_FRUSTUM_BOX)))
 	{
-		core::aabbox3d<f32> tbox = node->getBoundingBox();
-		node->getAbsoluteTransformation().transformBoxEx(tbox);
-		result = !(tbox.intersectsWithBox(cam->getViewFrustum()->getBoundingBox() ));
+		result = CFrustumCuller::isCulled(*cam->getViewFrustum(), node->getBoundingBox(),
+			node->getAbsoluteTransformation(), node->getAutomaticCulling());
 	}
 
-	// can be seen by a bounding sphere
-	if (!result && (node->getAutomaticCulling() & scene::EAC_FRUSTUM_SPHERE))
-	{ // requires bbox diameter
-	}
-
-	// can be seen by cam pyramid planes ?
-	if (!result && (node->getAutomaticCulling() & scene::EAC_FRUSTUM_BOX))
+	// hidden behind the occluders of this frame ?
+	if (!result && OcclusionCulling && node->getAutomaticCulling() != EAC_OFF)
 	{
-		SViewFrustum frust = *cam->getViewFrustum();
+		result = OcclusionCuller.isOccluded(node->getBoundingBox(), node->getAbsoluteTransformation());
+	}
 
-		//transform the frustum to the node's current absolute transformation
-		core::matrix4 invTrans(node->getAbsoluteTransformation(), core::matrix4::EM4CONST_INVERSE);
-		//invTrans.makeInverse();
-		frust.transform(invTrans);
+	_IRR_IMPLEMENT_MANAGED_MARSHALLING_BUGFIX;
+	return result;
+}
 
-		core::vector3df edges[8];
-		node->getBoundingBox().getEdges(edges);
 
-		for (s32 i=0; i<scene::SViewFrustum::VF_PLANE_COUNT; ++i)
+//! registers a node for rendering it at a specific time.
+u32 CSceneManager::registerNodeForRendering(ISceneNode* node, E_SCENE_NODE_RENDER_PASS pass)
+{
+	switch(pass)
+	{
+	case ESNRP_SOLID:
+	case ESNRP_TRANSPARENT:
+	case ESNRP_TRANSPARENT_EFFECT:
+	case ESNRP_AUTOMATIC:
+	case ESNRP_SHADOW:
 		{
-			bool boxInFrustum=false;
-			for (u32 j=0; j<8; ++j)
+			const u32 culling = node->getAutomaticCulling();
+
+			// frustum tests are done for all nodes at once after they registered
+			if (BatchCulling && culling && !(culling & EAC_OCC_QUERY))
 			{
-				if (frust.planes[i].classifyPointRelation(edges[j]) != core::ISREL3D_FRONT)
-				{
-					boxInFrustum=true;
-					break;
-				}
+				CullingNodeEntry e;
+				e.Node = node;
+				e.Pass = pass;
+				e.MeshBuffer = 0;
+				e.Material = 0;
+				CullingNodeList.push_back(e);
+				FrustumCuller.add(node->getBoundingBox(), node->getAbsoluteTransformation(), culling);
+				return 1;
 			}
 
-			if (!boxInFrustum)
+			if (isCulled(node))
 			{
-				result = true;
-				break;
+#ifdef _IRR_SCENEMANAGER_DEBUG
+				s32 index = Parameters.findAttribute ( "calls" );
+				Parameters.setAttribute ( index, Parameters.getAttributeAsInt ( index ) + 1 );
+				index = Parameters.findAttribute ( "culled" );
+				Parameters.setAttribute ( index, Parameters.getAttributeAsInt ( index ) + 1 );
+#endif
+				return 0;
 			}
 		}
+		break;
+	default:
+		break;
 	}
 
-	_IRR_IMPLEMENT_MANAGED_MARSHALLING_BUGFIX;
-	return result;
+	return addToRenderList(node, pass);
 }
 
 
-//! registers a node for rendering it at a specific time.
-u32 CSceneManager::registerNodeForRendering(ISceneNode* node, E_SCENE_NODE_RENDER_PASS pass)
+//! Registers a solid mesh buffer of a node for rendering.
+bool CSceneManager::registerMeshBufferForRendering(ISceneNode* node,
+		const IMeshBuffer* mb, const video::SMaterial& material)
+{
+	if (!node || !mb)
+		return false;
+
+	const u32 culling = node->getAutomaticCulling();
+
+	if (BatchCulling && culling && !(culling & EAC_OCC_QUERY))
+	{
+		CullingNodeEntry e;
+		e.Node = node;
+		e.Pass = ESNRP_SOLID;
+		e.MeshBuffer = mb;
+		e.Material = &material;
+		CullingNodeList.push_back(e);
+		FrustumCuller.add(mb->getBoundingBox(), node->getAbsoluteTransformation(), culling);
+		return true;
+	}
+
+	bool culled = false;
+	if (culling & EAC_OCC_QUERY)
+		culled = isCulled(node);
+
+	const ICameraSceneNode* cam = getActiveCamera();
+	if (!culled && cam && (culling & (EAC_BOX | EAC_FRUSTUM_SPHERE | EAC_FRUSTUM_BOX)))
+	{
+		culled = CFrustumCuller::isCulled(*cam->getViewFrustum(), mb->getBoundingBox(),
+			node->getAbsoluteTransformation(), culling);
+	}
+
+	if (culled)
+	{
+#ifdef _IRR_SCENEMANAGER_DEBUG
+		s32 index = Parameters.findAttribute ( "calls" );
+		Parameters.setAttribute ( index, Parameters.getAttributeAsInt ( index ) + 1 );
+		index = Parameters.findAttribute ( "culled" );
+		Parameters.setAttribute ( index, Parameters.getAttributeAsInt ( index ) + 1 );
+#endif
+		return false;
+	}
+
+	MeshBufferList.push_back(MeshBufferEntry(node, mb, material, camWorldPos));
+	return true;
+}
+
+
+//! culls all nodes registered since drawAll started and adds the visible ones to their render lists
+void CSceneManager::cullRegisteredNodes()
+{
+	_IRR_PROFILE("drawAll: cull");
+	BatchCulling = false;
+
+	FrustumCuller.cull();
+
+	for (u32 i=0; i != CullingNodeList.size(); ++i)
+	{
+		const CullingNodeEntry& e = CullingNodeList[i];
+		if (!FrustumCuller.isCulled(i) && !(OcclusionCulling &&
+			OcclusionCuller.isOccluded(e.MeshBuffer ? e.MeshBuffer->getBoundingBox() : e.Node->getBoundingBox(),
+				e.Node->getAbsoluteTransformation())))
+		{
+			if (e.MeshBuffer)
+				MeshBufferList.push_back(MeshBufferEntry(e.Node, e.MeshBuffer, *e.Material, camWorldPos));
+			else
+				addToRenderList(e.Node, e.Pass);
+		}
+#ifdef _IRR_SCENEMANAGER_DEBUG
+		else
+		{
+			s32 index = Parameters.findAttribute ( "calls" );
+			Parameters.setAttribute ( index, Parameters.getAttributeAsInt ( index ) + 1 );
+			index = Parameters.findAttribute ( "culled" );
+			Parameters.setAttribute ( index, Parameters.getAttributeAsInt ( index ) + 1 );
+		}
+#endif
+	}
+
+	CullingNodeList.set_used(0);
+}
+
+
+//! updates the boxes of the spatial index and removes nodes which left the scene
+void CSceneManager::updateSpatialIndex()
+{
+	// nodes which were moved to another parent are still in the scene
+	for (u32 i=0; i<RemovedSpatialIndexNodes.size(); ++i)
+	{
+		ISceneNode* node = RemovedSpatialIndexNodes[i];
+		if (!isInScene(node))
+			removeFromSpatialIndex(node);
+		node->drop();
+	}
+	RemovedSpatialIndexNodes.set_used(0);
+
+	// only refits the nodes whose absolute transformation changed
+	for (s32 id=0; id<SpatialIndex.getIdCount(); ++id)
+		SpatialIndex.update(id);
+}
+
+
+//! returns true if the node is part of the scene graph of this scene manager
+bool CSceneManager::isInScene(ISceneNode* node)
+{
+	while (node->getParent())
+		node = node->getParent();
+	return node == this;
+}
+
+
+//! remembers the indexed nodes of a subtree removed from the scene
+void CSceneManager::OnSubtreeRemoved(ISceneNode* node)
+{
+	if (!SpatialIndex.getLeafCount())
+		return;
+
+	core::array<ISceneNode*> stack;
+	stack.push_back(node);
+	while (!stack.empty())
+	{
+		ISceneNode* n = stack.getLast();
+		stack.erase(stack.size()-1);
+
+		const s32 id = n->getSpatialIndexId();
+		if (id >= 0 && SpatialIndex.getNode(id) == n)
+		{
+			n->grab();
+			RemovedSpatialIndexNodes.push_back(n);
+		}
+
+		for (u32 i=0; i<n->getChildCount(); ++i)
+			stack.push_back(n->getChild(i));
+	}
+}
+
+
+//! registers the nodes of the spatial index which may be visible
+void CSceneManager::registerSpatialIndexNodes()
+{
+	SpatialIndexNodes.set_used(0);
+	if (ActiveCamera)
+		SpatialIndex.getNodes(SpatialIndexNodes, *ActiveCamera->getViewFrustum());
+	else
+		SpatialIndex.getNodes(SpatialIndexNodes);
+
+	for (u32 i=0; i<SpatialIndexNodes.size(); ++i)
+	{
+		ISceneNode* node = SpatialIndexNodes[i];
+
+		// the parents have to be visible and still be part of this scene
+		const ISceneNode* parent = node->getParent();
+		while (parent && parent != this && parent->isVisible())
+			parent = parent->getParent();
+
+		if (parent == this && IsVisible)
+			node->OnRegisterSceneNode();
+	}
+}
+
+
+//! removes all nodes from the spatial index
+void CSceneManager::clearSpatialIndex()
+{
+	for (u32 i=0; i<RemovedSpatialIndexNodes.size(); ++i)
+		RemovedSpatialIndexNodes[i]->drop();
+	RemovedSpatialIndexNodes.clear();
+
+	for (s32 id=0; id<SpatialIndex.getIdCount(); ++id)
+	{
+		ISceneNode* node = SpatialIndex.getNode(id);
+		if (node)
+			node->setSpatialIndexId(-1);
+	}
+
+	SpatialIndex.clear();
+}
+
+
+//! Adds a scene node to the spatial index of the scene manager.
+void CSceneManager::addToSpatialIndex(ISceneNode* node)
+{
+	if (!node || node == this || node->getSpatialIndexId() >= 0 || !isInScene(node))
+		return;
+
+	node->setSpatialIndexId(SpatialIndex.insert(node));
+}
+
+
+//! Removes a scene node from the spatial index.
+void CSceneManager::removeFromSpatialIndex(ISceneNode* node)
+{
+	if (!node)
+		return;
+
+	const s32 id = node->getSpatialIndexId();
+	if (id < 0 || SpatialIndex.getNode(id) != node)
+		return;
+
+	node->setSpatialIndexId(-1);
+	SpatialIndex.remove(id);
+}
+
+
+//! Get the scene nodes of the spatial index which may be inside a view frustum.
+void CSceneManager::getSpatialIndexNodes(core::array<ISceneNode*>& outNodes,
+	const SViewFrustum& frustum) const
+{
+	SpatialIndex.getNodes(outNodes, frustum);
+}
+
+
+//! Get the scene nodes of the spatial index which may intersect a box.
+void CSceneManager::getSpatialIndexNodes(core::array<ISceneNode*>& outNodes,
+	const core::aabbox3d<f32>& box) const
+{
+	SpatialIndex.getNodes(outNodes, box);
+}
+
+
+//! Get the scene nodes of the spatial index which may intersect a line.
+void CSceneManager::getSpatialIndexNodes(core::array<ISceneNode*>& outNodes,
+	const core::line3d<f32>& ray) const
+{
+	SpatialIndex.getNodes(outNodes, ray);
+}
+
+
+//! Adds an occluder for the software occlusion culling.
+void CSceneManager::addOccluder(ISceneNode* node, IMesh* mesh)
+{
+	if (!node || !mesh)
+		return;
+
+	node->grab();
+	mesh->grab();
+
+	OccluderEntry e;
+	e.Node = node;
+	e.Mesh = mesh;
+	Occluders.push_back(e);
+}
+
+
+//! Removes the occluders of a scene node.
+void CSceneManager::removeOccluder(ISceneNode* node)
+{
+	for (s32 i=(s32)Occluders.size()-1; i>=0; --i)
+	{
+		if (Occluders[i].Node == node)
+		{
+			Occluders[i].Node->drop();
+			Occluders[i].Mesh->drop();
+			Occluders.erase(i);
+		}
+	}
+}
+
+
+//! Removes all occluders, disables the software occlusion culling.
+void CSceneManager::removeAllOccluders()
+{
+	for (u32 i=0; i<Occluders.size(); ++i)
+	{
+		Occluders[i].Node->drop();
+		Occluders[i].Mesh->drop();
+	}
+	Occluders.clear();
+	OcclusionCulling = false;
+}
+
+
+//! Sets the size of the depth buffer of the software occlusion culling.
+void CSceneManager::setOcclusionBufferSize(const core::dimension2d<u32>& size)
+{
+	OcclusionCuller.setSize(size);
+}
+
+
+//! rasterizes the occluders for the active camera
+void CSceneManager::renderOccluders()
+{
+	_IRR_PROFILE("drawAll: occluders");
+
+	OcclusionCulling = OcclusionCuller.begin(ActiveCamera);
+	if (!OcclusionCulling)
+		return;
+
+	for (u32 i=0; i<Occluders.size(); ++i)
+	{
+		const OccluderEntry& e = Occluders[i];
+		if (e.Node->isTrulyVisible())
+			OcclusionCuller.addOccluder(e.Mesh, e.Node->getAbsoluteTransformation());
+	}
+
+	OcclusionCuller.end();
+}
+
+
+//! adds a node which passed culling to the list of its render pass
+u32 CSceneManager::addToRenderList(ISceneNode* node, E_SCENE_NODE_RENDER_PASS pass)
 {
 	u32 taken = 0;
 
@@ -1249,9 +1736,8 @@ u32 CSceneManager::registerNodeForRendering(ISceneNode* node, E_SCENE_NODE_RENDE
 		break;
 
 	case ESNRP_LIGHT:
-		// TODO: Point Light culling..
-		// Lighting model in irrlicht has to be redone..
-		//if (!isCulled(node))
+		// lights outside the view may still reach visible nodes, so they are not culled.
+		// The light manager from createClusteredLightManager() picks the lights per node.
 		{
 			LightList.push_back(node);
 			taken = 1;
@@ -1263,28 +1749,18 @@ u32 CSceneManager::registerNodeForRendering(ISceneNode* node, E_SCENE_NODE_RENDE
 		taken = 1;
 		break;
 	case ESNRP_SOLID:
-		if (!isCulled(node))
-		{
-			SolidNodeList.push_back(node);
-			taken = 1;
-		}
+		SolidNodeList.push_back(DefaultNodeEntry(node, camWorldPos));
+		taken = 1;
 		break;
 	case ESNRP_TRANSPARENT:
-		if (!isCulled(node))
-		{
-			TransparentNodeList.push_back(TransparentNodeEntry(node, camWorldPos));
-			taken = 1;
-		}
+		TransparentNodeList.push_back(TransparentNodeEntry(node, camWorldPos));
+		taken = 1;
 		break;
 	case ESNRP_TRANSPARENT_EFFECT:
-		if (!isCulled(node))
-		{
-			TransparentEffectNodeList.push_back(TransparentNodeEntry(node, camWorldPos));
-			taken = 1;
-		}
+		TransparentEffectNodeList.push_back(TransparentNodeEntry(node, camWorldPos));
+		taken = 1;
 		break;
 	case ESNRP_AUTOMATIC:
-		if (!isCulled(node))
 		{
 			const u32 count = node->getMaterialCount();
 
@@ -1306,17 +1782,14 @@ u32 CSceneManager::registerNodeForRendering(ISceneNode* node, E_SCENE_NODE_RENDE
 			// not transparent, register as solid
 			if (!taken)
 			{
-				SolidNodeList.push_back(node);
+				SolidNodeList.push_back(DefaultNodeEntry(node, camWorldPos));
 				taken = 1;
 			}
 		}
 		break;
 	case ESNRP_SHADOW:
-		if (!isCulled(node))
-		{
-			ShadowNodeList.push_back(node);
-			taken = 1;
-		}
+		ShadowNodeList.push_back(node);
+		taken = 1;
 		break;
 
 	case ESNRP_NONE: // ignore this one
@@ -1338,6 +1811,139 @@ u32 CSceneManager::registerNodeForRendering(ISceneNode* node, E_SCENE_NODE_RENDE
 }
 
 
+namespace
+{
+	//! spreads the bits of a pointer over the upper bits of the result
+	inline u32 hashPointer(const void* p, u32 bits)
+	{
+		return (u32)(((u64)(size_t)p * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+	}
+
+	//! render state part of a sort key, the most expensive state changes in the upper bits
+	u64 getMaterialSortKey(const video::SMaterial& material)
+	{
+		// switching the material renderer is the most expensive, then the first texture
+		u64 key = (u64)(material.MaterialType & 0x3FF) << 54;
+		key |= (u64)hashPointer(material.getTexture(0), 20) << 34;
+
+		u32 textures = 0;
+		for (u32 i=1; i<video::MATERIAL_MAX_TEXTURES; ++i)
+			textures = textures * 31 + hashPointer(material.getTexture(i), 10);
+		key |= (u64)(textures & 0x3FF) << 24;
+
+		const u32 flags = (material.ZBuffer & 7) |
+			(material.ZWriteEnable << 3) |
+			(material.BackfaceCulling << 4) |
+			(material.FrontfaceCulling << 5) |
+			(material.Lighting << 6) |
+			(material.Wireframe << 7);
+		key |= (u64)flags << 16;
+
+		return key;
+	}
+
+	//! lowest 16 bits of a sort key, front to back inside equal render states
+	u64 getDistanceSortKey(const core::vector3df& position, const core::vector3df& camera)
+	{
+		// the upper bits of a positive float sort like the float
+		core::inttofloat distance;
+		distance.f = position.getDistanceFromSQ(camera);
+		return distance.u >> 16;
+	}
+
+	//! stable sort on the 64 bit SortKey member, skips bytes which are equal in all keys
+	template <class T>
+	void radixSort(core::array<T>& list, core::array<T>& buffer)
+	{
+		const u32 size = list.size();
+		if (size < 2)
+			return;
+
+		buffer.set_used(size);
+		T* src = list.pointer();
+		T* dst = buffer.pointer();
+
+		for (u32 shift=0; shift<64; shift+=8)
+		{
+			u32 count[256];
+			memset(count, 0, sizeof(count));
+			for (u32 i=0; i<size; ++i)
+				++count[(src[i].SortKey >> shift) & 0xFF];
+
+			if (count[(src[0].SortKey >> shift) & 0xFF] == size)
+				continue;
+
+			u32 offset = 0;
+			for (u32 i=0; i<256; ++i)
+			{
+				const u32 c = count[i];
+				count[i] = offset;
+				offset += c;
+			}
+
+			for (u32 i=0; i<size; ++i)
+				dst[count[(src[i].SortKey >> shift) & 0xFF]++] = src[i];
+
+			core::swap(src, dst);
+		}
+
+		if (src != list.pointer())
+			memcpy(list.pointer(), src, size * sizeof(T));
+	}
+
+	//! subtrees and per worker iterators of the parallel transformation update
+	struct STransformJob
+	{
+		ISceneNode* const* Tasks;
+		CSceneNodeIterator* Iterators;
+	};
+
+	//! thread pool job, updates the absolute transformations of one visible subtree
+	void updateTransformsJob(void* userData, u32 index, u32 workerIndex)
+	{
+		const STransformJob* job = (const STransformJob*)userData;
+		CSceneNodeIterator& it = job->Iterators[workerIndex];
+
+		it.reset(job->Tasks[index]);
+		while (ISceneNode* node = it.next())
+		{
+			if (!node->isVisible())
+			{
+				it.skipChildren();
+				continue;
+			}
+
+			// not virtual, overrides may touch shared data like meshes.
+			// They run in OnAnimate, which also catches the changes they make.
+			node->ISceneNode::updateAbsolutePosition();
+		}
+	}
+}
+
+
+//! sort key of a solid node
+CSceneManager::DefaultNodeEntry::DefaultNodeEntry(ISceneNode* n, const core::vector3df& camera)
+	: Node(n), SortKey(0)
+{
+	if (n->getMaterialCount())
+		SortKey = getMaterialSortKey(n->getMaterial(0));
+
+	SortKey |= getDistanceSortKey(n->getAbsoluteTransformation().getTranslation(), camera);
+}
+
+
+//! sort key of a queued mesh buffer
+CSceneManager::MeshBufferEntry::MeshBufferEntry(ISceneNode* n, const IMeshBuffer* mb,
+		const video::SMaterial& material, const core::vector3df& camera)
+	: Node(n), MeshBuffer(mb), Material(&material)
+{
+	core::vector3df center = mb->getBoundingBox().getCenter();
+	n->getAbsoluteTransformation().transformVect(center);
+
+	SortKey = getMaterialSortKey(material) | getDistanceSortKey(center, camera);
+}
+
+
 //! This method is called just before the rendering process of the whole scene.
 //! draws all scene nodes
 void CSceneManager::drawAll()
@@ -1345,6 +1951,12 @@ void CSceneManager::drawAll()
 	if (!Driver)
 		return;
 
+	_IRR_PROFILE("drawAll");
+
+	// hand out the meshes loaded in the background before the scene is used
+	if (MeshLoadQueue)
+		MeshLoadQueue->deliver(MeshCache);
+
 #ifdef _IRR_SCENEMANAGER_DEBUG
 	// reset attributes
 	Parameters.setAttribute ( "culled", 0 );
@@ -1367,8 +1979,19 @@ void CSceneManager::drawAll()
 	// TODO: This should not use an attribute here but a real parameter when necessary (too slow!)
 	Driver->setAllowZWriteOnTransparent(Parameters.getAttributeAsBool( ALLOW_ZWRITE_ON_TRANSPARENT) );
 
+	// update the transformations changed since the last frame in parallel,
+	// the animators then only have to update the nodes they moved
+	if (TransformJobs)
+		updateTransformsParallel();
+
 	// do animations and other stuff.
-	OnAnimate(os::Timer::getTime());
+	{
+		_IRR_PROFILE("drawAll: animate");
+		OnAnimate(os::Timer::getTime());
+	}
+
+	if (SpatialIndex.getLeafCount())
+		updateSpatialIndex();
 
 	/*!
 		First Scene Node for prerendering should be the active camera
@@ -1381,14 +2004,32 @@ void CSceneManager::drawAll()
 		camWorldPos = ActiveCamera->getAbsolutePosition();
 	}
 
-	// let all nodes register themselves
-	OnRegisterSceneNode();
+	// the occluders have to be in the depth buffer before the nodes are culled
+	if (ActiveCamera && !Occluders.empty())
+		renderOccluders();
+
+	// let all nodes register themselves, then cull them together
+	BatchCulling = ActiveCamera != 0;
+	if (BatchCulling)
+		FrustumCuller.begin(*ActiveCamera->getViewFrustum());
+
+	{
+		_IRR_PROFILE("drawAll: register");
+		OnRegisterSceneNode();
+
+		if (SpatialIndex.getLeafCount())
+			registerSpatialIndexNodes();
+	}
+
+	if (BatchCulling)
+		cullRegisteredNodes();
 
 	if (LightManager)
 		LightManager->OnPreRender(LightList);
 
 	//render camera scenes
 	{
+		_IRR_PROFILE("drawAll: camera");
 		CurrentRendertime = ESNRP_CAMERA;
 		Driver->getOverrideMaterial().Enabled = ((Driver->getOverrideMaterial().EnablePasses & CurrentRendertime) != 0);
 
@@ -1406,6 +2047,7 @@ void CSceneManager::drawAll()
 
 	//render lights scenes
 	{
+		_IRR_PROFILE("drawAll: lights");
 		CurrentRendertime = ESNRP_LIGHT;
 		Driver->getOverrideMaterial().Enabled = ((Driver->getOverrideMaterial().EnablePasses & CurrentRendertime) != 0);
 
@@ -1420,7 +2062,8 @@ void CSceneManager::drawAll()
 			if (ActiveCamera)
 				camWorldPos = ActiveCamera->getAbsolutePosition();
 
-			core::array<DistanceNodeEntry> SortedLights;
+			core::array<DistanceNodeEntry, core::irrArenaAllocator<DistanceNodeEntry> > SortedLights;
+			SortedLights.setAllocator(Driver->getFrameArena());
 			SortedLights.set_used(LightList.size());
 			for (s32 light = (s32)LightList.size() - 1; light >= 0; --light)
 				SortedLights[light].setNodeAndDistanceFromPosition(LightList[light], camWorldPos);
@@ -1450,6 +2093,7 @@ void CSceneManager::drawAll()
 
 	// render skyboxes
 	{
+		_IRR_PROFILE("drawAll: sky boxes");
 		CurrentRendertime = ESNRP_SKY_BOX;
 		Driver->getOverrideMaterial().Enabled = ((Driver->getOverrideMaterial().EnablePasses & CurrentRendertime) != 0);
 
@@ -1479,10 +2123,12 @@ void CSceneManager::drawAll()
 
 	// render default objects
 	{
+		_IRR_PROFILE("drawAll: solid");
 		CurrentRendertime = ESNRP_SOLID;
 		Driver->getOverrideMaterial().Enabled = ((Driver->getOverrideMaterial().EnablePasses & CurrentRendertime) != 0);
 
-		SolidNodeList.sort(); // sort by textures
+		// sort by render states
+		radixSort(SolidNodeList, SolidNodeSortBuffer);
 
 		if (LightManager)
 		{
@@ -1502,16 +2148,20 @@ void CSceneManager::drawAll()
 		}
 
 #ifdef _IRR_SCENEMANAGER_DEBUG
-		Parameters.setAttribute("drawn_solid", (s32) SolidNodeList.size() );
+		Parameters.setAttribute("drawn_solid", (s32) (SolidNodeList.size() + MeshBufferList.size()) );
 #endif
 		SolidNodeList.set_used(0);
 
+		if (!MeshBufferList.empty())
+			drawMeshBufferQueue();
+
 		if (LightManager)
 			LightManager->OnRenderPassPostRender(CurrentRendertime);
 	}
 
 	// render shadows
 	{
+		_IRR_PROFILE("drawAll: shadows");
 		CurrentRendertime = ESNRP_SHADOW;
 		Driver->getOverrideMaterial().Enabled = ((Driver->getOverrideMaterial().EnablePasses & CurrentRendertime) != 0);
 
@@ -1544,6 +2194,7 @@ void CSceneManager::drawAll()
 
 	// render transparent objects.
 	{
+		_IRR_PROFILE("drawAll: transparent");
 		CurrentRendertime = ESNRP_TRANSPARENT;
 		Driver->getOverrideMaterial().Enabled = ((Driver->getOverrideMaterial().EnablePasses & CurrentRendertime) != 0);
 
@@ -1577,6 +2228,7 @@ void CSceneManager::drawAll()
 
 	// render transparent effect objects.
 	{
+		_IRR_PROFILE("drawAll: transparent effect");
 		CurrentRendertime = ESNRP_TRANSPARENT_EFFECT;
 		Driver->getOverrideMaterial().Enabled = ((Driver->getOverrideMaterial().EnablePasses & CurrentRendertime) != 0);
 
@@ -1610,10 +2262,139 @@ void CSceneManager::drawAll()
 
 	LightList.set_used(0);
 	clearDeletionList();
+	OcclusionCulling = false;
 
 	CurrentRendertime = ESNRP_NONE;
 }
 
+
+//! draws the sorted mesh buffer queue
+void CSceneManager::drawMeshBufferQueue()
+{
+	radixSort(MeshBufferList, MeshBufferSortBuffer);
+
+	ISceneNode* node = 0;
+	const video::SMaterial* material = 0;
+
+	for (u32 i=0; i<MeshBufferList.size(); ++i)
+	{
+		const MeshBufferEntry& e = MeshBufferList[i];
+
+		if (e.Node != node)
+		{
+			if (LightManager && node)
+				LightManager->OnNodePostRender(node);
+
+			node = e.Node;
+			Driver->setTransform(video::ETS_WORLD, node->getAbsoluteTransformation());
+
+			// the light manager may have changed the lights, so set the material again
+			if (LightManager)
+			{
+				LightManager->OnNodePreRender(node);
+				material = 0;
+			}
+		}
+
+		// neighbours in the sorted queue often share the material, or an equal one
+		if (!material || (e.Material != material && *e.Material != *material))
+		{
+			material = e.Material;
+			Driver->setMaterial(*material);
+		}
+
+		Driver->drawMeshBuffer(e.MeshBuffer);
+	}
+
+	if (LightManager && node)
+		LightManager->OnNodePostRender(node);
+
+	MeshBufferList.set_used(0);
+}
+
+
+//! updates the absolute transformations of all visible nodes with the job system
+void CSceneManager::updateTransformsParallel()
+{
+	_IRR_PROFILE("drawAll: transforms");
+
+	// split the scene graph breadth first until there are enough
+	// independent subtrees to keep all workers busy
+	const u32 minTasks = TransformJobs->getWorkerCount() * 4;
+
+	TransformTasks.set_used(0);
+	TransformTasks.push_back(this);
+
+	bool split = true;
+	while (split && TransformTasks.size() < minTasks)
+	{
+		split = false;
+		TransformTaskBuffer.set_used(0);
+
+		for (u32 i=0; i<TransformTasks.size(); ++i)
+		{
+			ISceneNode* node = TransformTasks[i];
+			const u32 childCount = node->getChildCount();
+			if (!childCount)
+			{
+				TransformTaskBuffer.push_back(node);
+				continue;
+			}
+
+			node->ISceneNode::updateAbsolutePosition();
+
+			for (u32 c=0; c<childCount; ++c)
+			{
+				if (node->getChild(c)->isVisible())
+					TransformTaskBuffer.push_back(node->getChild(c));
+			}
+			split = true;
+		}
+
+		TransformTasks.swap(TransformTaskBuffer);
+	}
+
+	STransformJob job;
+	job.Tasks = TransformTasks.const_pointer();
+	job.Iterators = TransformIterators.pointer();
+	TransformJobs->parallelFor(TransformTasks.size(), updateTransformsJob, &job);
+}
+
+
+//! Sets the number of threads which update the absolute transformations.
+void CSceneManager::setTransformThreadCount(u32 count)
+{
+	IJobSystem* jobs = 0;
+	if (count > 1)
+	{
+		jobs = new CJobSystem(count - 1);
+	}
+	else if (count == 0 && JobSystem && JobSystem->getWorkerCount() > 1)
+	{
+		jobs = JobSystem;
+		jobs->grab();
+	}
+
+	if (TransformJobs)
+		TransformJobs->drop();
+	TransformJobs = jobs;
+
+	TransformIterators.clear();
+	if (TransformJobs)
+	{
+		for (u32 i=0; i<TransformJobs->getWorkerCount(); ++i)
+			TransformIterators.push_back(CSceneNodeIterator());
+	}
+}
+
+
+//! Returns the number of threads which update the absolute transformations.
+u32 CSceneManager::getTransformThreadCount() const
+{
+	return TransformJobs ? TransformJobs->getWorkerCount() : 1;
+}
+
+
 void CSceneManager::setLightManager(ILightManager* lightManager)
 {
 	if (lightManager)
@@ -1625,6 +2406,13 @@ void CSceneManager::setLightManager(ILightManager* lightManager)
 }
 
 
+//! Creates a light manager which only enables the lights reaching each node.
+ILightManager* CSceneManager::createClusteredLightManager(u32 tilesX, u32 tilesY, u32 slices)
+{
+	return new CClusteredLightManager(this, tilesX, tilesY, slices);
+}
+
+
 //! Sets the color of stencil buffers shadows drawn by the scene manager.
 void CSceneManager::setShadowColor(video::SColor color)
 {
@@ -1732,7 +2520,12 @@ void CSceneManager::addExternalMeshLoader(IMeshLoader* externalLoader)
 		return;
 
 	externalLoader->grab();
+
+	if (MeshLoadQueue)
+		MeshLoadQueue->lockLoaders();
 	MeshLoaderList.push_back(externalLoader);
+	if (MeshLoadQueue)
+		MeshLoadQueue->unlockLoaders();
 }
 
 
@@ -1886,17 +2679,10 @@ ISceneNode* CSceneManager::getSceneNodeFromName(const char* name, ISceneNode* st
 	if (start == 0)
 		start = getRootSceneNode();
 
-	if (!strcmp(start->getName(),name))
-		return start;
-
-	ISceneNode* node = 0;
-
-	const ISceneNodeList& list = start->getChildren();
-	ISceneNodeList::ConstIterator it = list.begin();
-	for (; it!=list.end(); ++it)
+	CSceneNodeIterator it(start);
+	while (ISceneNode* node = it.next())
 	{
-		node = getSceneNodeFromName(name, *it);
-		if (node)
+		if (!strcmp(node->getName(),name))
 			return node;
 	}
 
@@ -1910,17 +2696,10 @@ ISceneNode* CSceneManager::getSceneNodeFromId(s32 id, ISceneNode* start)
 	if (start == 0)
 		start = getRootSceneNode();
 
-	if (start->getID() == id)
-		return start;
-
-	ISceneNode* node = 0;
-
-	const ISceneNodeList& list = start->getChildren();
-	ISceneNodeList::ConstIterator it = list.begin();
-	for (; it!=list.end(); ++it)
+	CSceneNodeIterator it(start);
+	while (ISceneNode* node = it.next())
 	{
-		node = getSceneNodeFromId(id, *it);
-		if (node)
+		if (node->getID() == id)
 			return node;
 	}
 
@@ -1934,17 +2713,10 @@ ISceneNode* CSceneManager::getSceneNodeFromType(scene::ESCENE_NODE_TYPE type, IS
 	if (start == 0)
 		start = getRootSceneNode();
 
-	if (start->getType() == type || ESNT_ANY == type)
-		return start;
-
-	ISceneNode* node = 0;
-
-	const ISceneNodeList& list = start->getChildren();
-	ISceneNodeList::ConstIterator it = list.begin();
-	for (; it!=list.end(); ++it)
+	CSceneNodeIterator it(start);
+	while (ISceneNode* node = it.next())
 	{
-		node = getSceneNodeFromType(type, *it);
-		if (node)
+		if (node->getType() == type || ESNT_ANY == type)
 			return node;
 	}
 
@@ -1958,15 +2730,11 @@ void CSceneManager::getSceneNodesFromType(ESCENE_NODE_TYPE type, core::array<sce
 	if (start == 0)
 		start = getRootSceneNode();
 
-	if (start->getType() == type || ESNT_ANY == type)
-		outNodes.push_back(start);
-
-	const ISceneNodeList& list = start->getChildren();
-	ISceneNodeList::ConstIterator it = list.begin();
-
-	for (; it!=list.end(); ++it)
+	CSceneNodeIterator it(start);
+	while (ISceneNode* node = it.next())
 	{
-		getSceneNodesFromType(type, outNodes, *it);
+		if (node->getType() == type || ESNT_ANY == type)
+			outNodes.push_back(node);
 	}
 }
 
@@ -1988,6 +2756,8 @@ bool CSceneManager::postEventFromUser(const SEvent& event)
 //! Removes all children of this scene node
 void CSceneManager::removeAll()
 {
+	clearSpatialIndex();
+	removeAllOccluders();
 	ISceneNode::removeAll();
 	setActiveCamera(0);
 	// Make sure the driver is reset, might need a more complex method at some point
@@ -2027,7 +2797,7 @@ IMeshCache* CSceneManager::getMeshCache()
 //! Creates a new scene manager.
 ISceneManager* CSceneManager::createNewSceneManager(bool cloneContent)
 {
-	CSceneManager* manager = new CSceneManager(Driver, FileSystem, CursorControl, MeshCache, GUIEnvironment);
+	CSceneManager* manager = new CSceneManager(Driver, FileSystem, CursorControl, MeshCache, GUIEnvironment, JobSystem);
 
 	if (cloneContent)
 		manager->cloneMembers(this, manager);
@@ -2433,6 +3203,7 @@ void CSceneManager::deserializeAttributes(io::IAttributes* in, io::SAttributeRea
 	RelativeTranslation.set(0,0,0);
 	RelativeRotation.set(0,0,0);
 	RelativeScale.set(1,1,1);
+	RelativeTransformationChanged = true;
 	IsVisible = true;
 	AutomaticCullingState = scene::EAC_BOX;
 	DebugDataVisible = scene::EDS_OFF;
@@ -2511,9 +3282,9 @@ IMeshWriter* CSceneManager::createMeshWriter(EMESH_WRITER_TYPE type)
 // creates a scenemanager
 ISceneManager* createSceneManager(video::IVideoDriver* driver,
 		io::IFileSystem* fs, gui::ICursorControl* cursorcontrol,
-		gui::IGUIEnvironment *guiEnvironment)
+		gui::IGUIEnvironment *guiEnvironment, IJobSystem* jobSystem)
 {
-	return new CSceneManager(driver, fs, cursorcontrol, 0, guiEnvironment );
+	return new CSceneManager(driver, fs, cursorcontrol, 0, guiEnvironment, jobSystem);
 }
 
 
@@ -13,6 +13,12 @@
 #include "IMeshLoader.h"
 #include "CAttributes.h"
 #include "ILightManager.h"
+#include "CFrustumCuller.h"
+#include "COcclusionCuller.h"
+#include "CSceneNodeBVH.h"
+#include "IJobSystem.h"
+#include "CMeshLoadQueue.h"
+#include "CSceneNodeIterator.h"
 
 namespace irr
 {
@@ -36,7 +42,7 @@ namespace scene
 		//! constructor
 		CSceneManager(video::IVideoDriver* driver, io::IFileSystem* fs,
 			gui::ICursorControl* cursorControl, IMeshCache* cache = 0,
-			gui::IGUIEnvironment *guiEnvironment = 0);
+			gui::IGUIEnvironment *guiEnvironment = 0, IJobSystem* jobSystem = 0);
 
 		//! destructor
 		virtual ~CSceneManager();
@@ -47,6 +53,12 @@ namespace scene
 		//! gets an animateable mesh. loads it if needed. returned pointer must not be dropped.
 		virtual IAnimatedMesh* getMesh(io::IReadFile* file);
 
+		//! Loads a mesh in the background.
+		virtual void getMeshAsync(const io::path& filename, IMeshLoadCallBack* callback);
+
+		//! Returns the number of background mesh loads which were not delivered yet.
+		virtual u32 getPendingMeshLoadCount() const;
+
 		//! Returns an interface to the mesh cache which is shared beween all existing scene managers.
 		virtual IMeshCache* getMeshCache();
 
@@ -95,6 +107,27 @@ namespace scene
 			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f),
 			bool alsoAddIfMeshPointerZero=false);
 
+		//! adds a scene node for drawing many instances of a static mesh
+		//! the returned pointer must not be dropped.
+		virtual IInstancedMeshSceneNode* addInstancedMeshSceneNode(IMesh* mesh, ISceneNode* parent=0, s32 id=-1,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f),
+			bool alsoAddIfMeshPointerZero=false);
+
+		//! adds a scene node showing one level of a LOD chain
+		//! the returned pointer must not be dropped.
+		virtual IMeshSceneNode* addLODMeshSceneNode(IAnimatedMesh* mesh, ISceneNode* parent=0, s32 id=-1,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f),
+			bool alsoAddIfMeshPointerZero=false);
+
+		//! merges the static mesh scene nodes of a subtree into a single scene node
+		//! the returned pointer must not be dropped.
+		virtual IMeshSceneNode* addStaticBatchSceneNode(ISceneNode* root, ISceneNode* parent=0,
+			s32 id=-1, u32 maxChunkVertices=16384, bool hideMergedNodes=true);
+
 		//! Adds a scene node for rendering a animated water surface mesh.
 		virtual ISceneNode* addWaterSurfaceSceneNode(IMesh* mesh, f32 waveHeight, f32 waveSpeed, f32 wlenght, ISceneNode* parent=0, s32 id=-1,
 			const core::vector3df& position = core::vector3df(0,0,0),
@@ -110,6 +143,22 @@ namespace scene
 		//! registers a node for rendering it at a specific time.
 		virtual u32 registerNodeForRendering(ISceneNode* node, E_SCENE_NODE_RENDER_PASS pass = ESNRP_AUTOMATIC);
 
+		//! Enables or disables the mesh buffer render queue.
+		virtual void setMeshBufferQueueEnabled(bool enable) { MeshBufferQueueEnabled = enable; }
+
+		//! Returns if the mesh buffer render queue is enabled.
+		virtual bool isMeshBufferQueueEnabled() const { return MeshBufferQueueEnabled; }
+
+		//! Registers a solid mesh buffer of a node for rendering.
+		virtual bool registerMeshBufferForRendering(ISceneNode* node,
+			const IMeshBuffer* mb, const video::SMaterial& material);
+
+		//! Sets the number of threads which update the absolute transformations.
+		virtual void setTransformThreadCount(u32 count);
+
+		//! Returns the number of threads which update the absolute transformations.
+		virtual u32 getTransformThreadCount() const;
+
 		//! draws all scene nodes
 		virtual void drawAll();
 
@@ -509,6 +558,9 @@ namespace scene
 		//! Register a custom callbacks manager which gets callbacks during scene rendering.
 		virtual void setLightManager(ILightManager* lightManager);
 
+		//! Creates a light manager which only enables the lights reaching each node.
+		virtual ILightManager* createClusteredLightManager(u32 tilesX=16, u32 tilesY=9, u32 slices=24);
+
 		//! Get current render time.
 		virtual E_SCENE_NODE_RENDER_PASS getCurrentRendertime() const { return CurrentRendertime; }
 
@@ -521,6 +573,41 @@ namespace scene
 		//! returns if node is culled
 		virtual bool isCulled(const ISceneNode* node) const;
 
+		//! Adds a scene node to the spatial index of the scene manager.
+		virtual void addToSpatialIndex(ISceneNode* node);
+
+		//! Removes a scene node from the spatial index.
+		virtual void removeFromSpatialIndex(ISceneNode* node);
+
+		//! Get the scene nodes of the spatial index which may be inside a view frustum.
+		virtual void getSpatialIndexNodes(core::array<ISceneNode*>& outNodes,
+			const SViewFrustum& frustum) const;
+
+		//! Get the scene nodes of the spatial index which may intersect a box.
+		virtual void getSpatialIndexNodes(core::array<ISceneNode*>& outNodes,
+			const core::aabbox3d<f32>& box) const;
+
+		//! Get the scene nodes of the spatial index which may intersect a line.
+		virtual void getSpatialIndexNodes(core::array<ISceneNode*>& outNodes,
+			const core::line3d<f32>& ray) const;
+
+		//! Adds an occluder for the software occlusion culling.
+		virtual void addOccluder(ISceneNode* node, IMesh* mesh);
+
+		//! Removes the occluders of a scene node.
+		virtual void removeOccluder(ISceneNode* node);
+
+		//! Removes all occluders, disables the software occlusion culling.
+		virtual void removeAllOccluders();
+
+		//! Sets the size of the depth buffer of the software occlusion culling.
+		virtual void setOcclusionBufferSize(const core::dimension2d<u32>& size);
+
+	protected:
+
+		//! remembers the indexed nodes of a subtree removed from the scene
+		virtual void OnSubtreeRemoved(ISceneNode* node);
+
 	private:
 
 		//! clears the deletion list
@@ -529,23 +616,75 @@ namespace scene
 		//! writes a scene node
 		void writeSceneNode(io::IXMLWriter* writer, ISceneNode* node, ISceneUserDataSerializer* userDataSerializer, const fschar_t* currentPath=0, bool init=false);
 
+		//! adds a node which passed culling to the list of its render pass
+		u32 addToRenderList(ISceneNode* node, E_SCENE_NODE_RENDER_PASS pass);
+
+		//! culls all nodes registered since drawAll started and adds the visible ones to their render lists
+		void cullRegisteredNodes();
+
+		//! updates the boxes of the spatial index and removes nodes which left the scene
+		void updateSpatialIndex();
+
+		//! returns true if the node is part of the scene graph of this scene manager
+		bool isInScene(ISceneNode* node);
+
+		//! registers the nodes of the spatial index which may be visible
+		void registerSpatialIndexNodes();
+
+		//! removes all nodes from the spatial index
+		void clearSpatialIndex();
+
+		//! rasterizes the occluders for the active camera
+		void renderOccluders();
+
+		//! draws the sorted mesh buffer queue
+		void drawMeshBufferQueue();
+
+		//! updates the absolute transformations of all visible nodes with the thread pool
+		void updateTransformsParallel();
+
+		//! node waiting for the batched culling
+		struct CullingNodeEntry
+		{
+			ISceneNode* Node;
+			E_SCENE_NODE_RENDER_PASS Pass;
+
+			//! mesh buffer and material for the queue, 0 for nodes
+			const IMeshBuffer* MeshBuffer;
+			const video::SMaterial* Material;
+		};
+
+		//! sort on render states, then front to back
 		struct DefaultNodeEntry
 		{
-			DefaultNodeEntry(ISceneNode* n) :
-				Node(n), TextureValue(0)
+			DefaultNodeEntry(ISceneNode* n, const core::vector3df& camera);
+
+			bool operator < (const DefaultNodeEntry& other) const
 			{
-				if (n->getMaterialCount())
-					TextureValue = (n->getMaterial(0).getTexture(0));
+				return (SortKey < other.SortKey);
 			}
 
-			bool operator < (const DefaultNodeEntry& other) const
+			ISceneNode* Node;
+
+			//! material renderer, textures, material flags and distance, most significant first
+			u64 SortKey;
+		};
+
+		//! mesh buffer of the queue, sorted like the solid nodes
+		struct MeshBufferEntry
+		{
+			MeshBufferEntry(ISceneNode* n, const IMeshBuffer* mb,
+				const video::SMaterial& material, const core::vector3df& camera);
+
+			bool operator < (const MeshBufferEntry& other) const
 			{
-				return (TextureValue < other.TextureValue);
+				return (SortKey < other.SortKey);
 			}
 
 			ISceneNode* Node;
-			private:
-			void* TextureValue;
+			const IMeshBuffer* MeshBuffer;
+			const video::SMaterial* Material;
+			u64 SortKey;
 		};
 
 		//! sort on distance (center) to camera
@@ -614,9 +753,47 @@ namespace scene
 		core::array<ISceneNode*> ShadowNodeList;
 		core::array<ISceneNode*> SkyBoxList;
 		core::array<DefaultNodeEntry> SolidNodeList;
+		core::array<DefaultNodeEntry> SolidNodeSortBuffer;
+		core::array<MeshBufferEntry> MeshBufferList;
+		core::array<MeshBufferEntry> MeshBufferSortBuffer;
 		core::array<TransparentNodeEntry> TransparentNodeList;
 		core::array<TransparentNodeEntry> TransparentEffectNodeList;
 
+		//! nodes registered during drawAll, culled together before rendering
+		core::array<CullingNodeEntry> CullingNodeList;
+		CFrustumCuller FrustumCuller;
+		bool BatchCulling;
+		bool MeshBufferQueueEnabled;
+
+		//! job system of the device, shared with new scene managers
+		IJobSystem* JobSystem;
+
+		//! workers and subtrees of the parallel transformation update
+		IJobSystem* TransformJobs;
+		core::array<ISceneNode*> TransformTasks;
+		core::array<ISceneNode*> TransformTaskBuffer;
+		core::array<CSceneNodeIterator> TransformIterators;
+
+		//! meshes rasterized for the software occlusion culling, with their nodes
+		struct OccluderEntry
+		{
+			ISceneNode* Node;
+			IMesh* Mesh;
+		};
+
+		core::array<OccluderEntry> Occluders;
+		COcclusionCuller OcclusionCuller;
+		bool OcclusionCulling;
+
+		//! optional index of nodes which are only registered when they may be visible
+		CSceneNodeBVH SpatialIndex;
+		core::array<ISceneNode*> SpatialIndexNodes;
+		//! indexed nodes removed from the scene since the last update, grabbed
+		core::array<ISceneNode*> RemovedSpatialIndexNodes;
+
+		//! background loads of getMeshAsync, created by the first request
+		CMeshLoadQueue* MeshLoadQueue;
+
 		core::array<IMeshLoader*> MeshLoaderList;
 		core::array<ISceneLoader*> SceneLoaderList;
 		core::array<ISceneNode*> DeletionList;
@@ -0,0 +1,512 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CSceneNodeBVH.h"
+
+namespace irr
+{
+namespace scene
+{
+
+//! constructor
+CSceneNodeBVH::CSceneNodeBVH()
+: Root(-1), FreeList(-1), LeafCount(0)
+{
+}
+
+
+//! destructor
+CSceneNodeBVH::~CSceneNodeBVH()
+{
+	clear();
+}
+
+
+//! world space box of a scene node
+core::aabbox3d<f32> CSceneNodeBVH::getWorldBox(const ISceneNode* node)
+{
+	const core::aabbox3d<f32>& box = node->getBoundingBox();
+	const core::matrix4& m = node->getAbsoluteTransformation();
+
+	core::vector3df center = box.getCenter();
+	m.transformVect(center);
+
+	// extent of the transformed half axes along each world axis
+	const core::vector3df h = box.getExtent() * 0.5f;
+	const core::vector3df extent(
+		core::abs_(m[0]) * h.X + core::abs_(m[4]) * h.Y + core::abs_(m[8]) * h.Z,
+		core::abs_(m[1]) * h.X + core::abs_(m[5]) * h.Y + core::abs_(m[9]) * h.Z,
+		core::abs_(m[2]) * h.X + core::abs_(m[6]) * h.Y + core::abs_(m[10]) * h.Z);
+
+	return core::aabbox3d<f32>(center - extent, center + extent);
+}
+
+
+//! half surface area, cost of a box for the insertion
+f32 CSceneNodeBVH::getArea(const core::aabbox3d<f32>& box)
+{
+	const core::vector3df e = box.getExtent();
+	return e.X * e.Y + e.Y * e.Z + e.Z * e.X;
+}
+
+
+s32 CSceneNodeBVH::allocateNode()
+{
+	s32 id;
+	if (FreeList != -1)
+	{
+		id = FreeList;
+		FreeList = Nodes[id].Parent;
+	}
+	else
+	{
+		id = (s32)Nodes.size();
+		Nodes.push_back(SNode());
+	}
+
+	SNode& n = Nodes[id];
+	n.Node = 0;
+	n.Revision = 0;
+	n.Parent = -1;
+	n.Child[0] = -1;
+	n.Child[1] = -1;
+	n.Height = 0;
+	return id;
+}
+
+
+void CSceneNodeBVH::freeNode(s32 id)
+{
+	Nodes[id].Node = 0;
+	Nodes[id].Parent = FreeList;
+	Nodes[id].Height = -1;
+	FreeList = id;
+}
+
+
+//! adds a scene node
+s32 CSceneNodeBVH::insert(ISceneNode* node)
+{
+	const s32 leaf = allocateNode();
+
+	// the margin avoids reinsertions for small movements and animations
+	core::aabbox3d<f32> box = getWorldBox(node);
+	const core::vector3df margin = box.getExtent() * 0.1f;
+	box.MinEdge -= margin;
+	box.MaxEdge += margin;
+
+	Nodes[leaf].Box = box;
+	Nodes[leaf].Node = node;
+	Nodes[leaf].Revision = node->getAbsoluteTransformationRevision();
+	node->grab();
+
+	insertLeaf(leaf);
+	++LeafCount;
+	return leaf;
+}
+
+
+//! removes the leaf with the given id
+void CSceneNodeBVH::remove(s32 id)
+{
+	ISceneNode* node = getNode(id);
+	if (!node)
+		return;
+
+	removeLeaf(id);
+	freeNode(id);
+	--LeafCount;
+	node->drop();
+}
+
+
+//! removes all leaves
+void CSceneNodeBVH::clear()
+{
+	for (u32 i=0; i<Nodes.size(); ++i)
+	{
+		if (Nodes[i].Height == 0 && Nodes[i].Node)
+			Nodes[i].Node->drop();
+	}
+
+	Nodes.clear();
+	Root = -1;
+	FreeList = -1;
+	LeafCount = 0;
+}
+
+
+//! updates the box of a leaf from its node
+bool CSceneNodeBVH::update(s32 id)
+{
+	ISceneNode* node = getNode(id);
+	if (!node)
+		return false;
+
+	const u32 revision = node->getAbsoluteTransformationRevision();
+	if (revision == Nodes[id].Revision)
+		return false;
+	Nodes[id].Revision = revision;
+
+	core::aabbox3d<f32> box = getWorldBox(node);
+	if (box.isFullInside(Nodes[id].Box))
+		return false;
+
+	const core::vector3df margin = box.getExtent() * 0.1f;
+	box.MinEdge -= margin;
+	box.MaxEdge += margin;
+
+	removeLeaf(id);
+	Nodes[id].Box = box;
+	insertLeaf(id);
+	return true;
+}
+
+
+void CSceneNodeBVH::insertLeaf(s32 leaf)
+{
+	if (Root == -1)
+	{
+		Root = leaf;
+		Nodes[Root].Parent = -1;
+		return;
+	}
+
+	// find the sibling which increases the surface area the least
+	const core::aabbox3d<f32> leafBox = Nodes[leaf].Box;
+	s32 index = Root;
+	while (Nodes[index].Height > 0)
+	{
+		const SNode& n = Nodes[index];
+
+		core::aabbox3d<f32> combined(n.Box);
+		combined.addInternalBox(leafBox);
+
+		const f32 area = getArea(n.Box);
+		const f32 combinedArea = getArea(combined);
+
+		// cost of a new parent for this node and the leaf
+		const f32 cost = 2.f * combinedArea;
+
+		// cost of pushing the leaf further down the tree
+		const f32 inheritanceCost = 2.f * (combinedArea - area);
+
+		f32 childCost[2];
+		for (u32 i=0; i<2; ++i)
+		{
+			const SNode& child = Nodes[n.Child[i]];
+			core::aabbox3d<f32> box(child.Box);
+			box.addInternalBox(leafBox);
+
+			if (child.Height == 0)
+				childCost[i] = getArea(box) + inheritanceCost;
+			else
+				childCost[i] = getArea(box) - getArea(child.Box) + inheritanceCost;
+		}
+
+		if (cost < childCost[0] && cost < childCost[1])
+			break;
+
+		index = childCost[0] < childCost[1] ? n.Child[0] : n.Child[1];
+	}
+
+	const s32 sibling = index;
+
+	// new parent of the sibling and the leaf
+	const s32 oldParent = Nodes[sibling].Parent;
+	const s32 newParent = allocateNode();
+	Nodes[newParent].Parent = oldParent;
+	Nodes[newParent].Box = leafBox;
+	Nodes[newParent].Box.addInternalBox(Nodes[sibling].Box);
+	Nodes[newParent].Height = Nodes[sibling].Height + 1;
+	Nodes[newParent].Child[0] = sibling;
+	Nodes[newParent].Child[1] = leaf;
+	Nodes[sibling].Parent = newParent;
+	Nodes[leaf].Parent = newParent;
+
+	if (oldParent != -1)
+	{
+		if (Nodes[oldParent].Child[0] == sibling)
+			Nodes[oldParent].Child[0] = newParent;
+		else
+			Nodes[oldParent].Child[1] = newParent;
+	}
+	else
+		Root = newParent;
+
+	// refit and balance the ancestors
+	index = Nodes[leaf].Parent;
+	while (index != -1)
+	{
+		index = balance(index);
+
+		SNode& n = Nodes[index];
+		n.Height = 1 + core::max_(Nodes[n.Child[0]].Height, Nodes[n.Child[1]].Height);
+		n.Box = Nodes[n.Child[0]].Box;
+		n.Box.addInternalBox(Nodes[n.Child[1]].Box);
+
+		index = n.Parent;
+	}
+}
+
+
+void CSceneNodeBVH::removeLeaf(s32 leaf)
+{
+	if (leaf == Root)
+	{
+		Root = -1;
+		return;
+	}
+
+	const s32 parent = Nodes[leaf].Parent;
+	const s32 grandParent = Nodes[parent].Parent;
+	const s32 sibling = Nodes[parent].Child[0] == leaf ? Nodes[parent].Child[1] : Nodes[parent].Child[0];
+
+	if (grandParent != -1)
+	{
+		// replace the parent by the sibling
+		if (Nodes[grandParent].Child[0] == parent)
+			Nodes[grandParent].Child[0] = sibling;
+		else
+			Nodes[grandParent].Child[1] = sibling;
+		Nodes[sibling].Parent = grandParent;
+		freeNode(parent);
+
+		s32 index = grandParent;
+		while (index != -1)
+		{
+			index = balance(index);
+
+			SNode& n = Nodes[index];
+			n.Height = 1 + core::max_(Nodes[n.Child[0]].Height, Nodes[n.Child[1]].Height);
+			n.Box = Nodes[n.Child[0]].Box;
+			n.Box.addInternalBox(Nodes[n.Child[1]].Box);
+
+			index = n.Parent;
+		}
+	}
+	else
+	{
+		Root = sibling;
+		Nodes[sibling].Parent = -1;
+		freeNode(parent);
+	}
+}
+
+
+//! rotates the subtree at id if it is unbalanced, returns its new root
+s32 CSceneNodeBVH::balance(s32 a)
+{
+	if (Nodes[a].Height < 2)
+		return a;
+
+	const s32 b = Nodes[a].Child[0];
+	const s32 c = Nodes[a].Child[1];
+	const s32 diff = Nodes[c].Height - Nodes[b].Height;
+
+	if (diff > 1 || diff < -1)
+	{
+		// the higher child moves up, a becomes its child
+		const s32 up = diff > 1 ? c : b;
+		const s32 other = diff > 1 ? b : c;
+
+		const s32 f = Nodes[up].Child[0];
+		const s32 g = Nodes[up].Child[1];
+
+		Nodes[up].Child[0] = a;
+		Nodes[up].Parent = Nodes[a].Parent;
+		Nodes[a].Parent = up;
+
+		if (Nodes[up].Parent != -1)
+		{
+			SNode& p = Nodes[Nodes[up].Parent];
+			if (p.Child[0] == a)
+				p.Child[0] = up;
+			else
+				p.Child[1] = up;
+		}
+		else
+			Root = up;
+
+		// the higher grandchild stays below up, the other one replaces up below a
+		const s32 keep = Nodes[f].Height > Nodes[g].Height ? f : g;
+		const s32 move = keep == f ? g : f;
+
+		Nodes[up].Child[1] = keep;
+		if (diff > 1)
+			Nodes[a].Child[1] = move;
+		else
+			Nodes[a].Child[0] = move;
+		Nodes[move].Parent = a;
+
+		Nodes[a].Box = Nodes[other].Box;
+		Nodes[a].Box.addInternalBox(Nodes[move].Box);
+		Nodes[a].Height = 1 + core::max_(Nodes[other].Height, Nodes[move].Height);
+
+		Nodes[up].Box = Nodes[a].Box;
+		Nodes[up].Box.addInternalBox(Nodes[keep].Box);
+		Nodes[up].Height = 1 + core::max_(Nodes[a].Height, Nodes[keep].Height);
+
+		return up;
+	}
+
+	return a;
+}
+
+
+//! appends all leaves below id
+void CSceneNodeBVH::getSubtreeNodes(core::array<ISceneNode*>& outNodes, s32 id) const
+{
+	const u32 bottom = Stack.size();
+	Stack.push_back(id);
+
+	while (Stack.size() > bottom)
+	{
+		const SNode& n = Nodes[Stack.getLast()];
+		Stack.set_used(Stack.size()-1);
+
+		if (n.Height == 0)
+			outNodes.push_back(n.Node);
+		else
+		{
+			Stack.push_back(n.Child[1]);
+			Stack.push_back(n.Child[0]);
+		}
+	}
+}
+
+
+//! appends the nodes of all leaves whose box may intersect the frustum
+void CSceneNodeBVH::getNodes(core::array<ISceneNode*>& outNodes, const SViewFrustum& frustum) const
+{
+	if (Root == -1)
+		return;
+
+	// pairs of node and the planes its box is not completely inside of
+	Stack.set_used(0);
+	Stack.push_back(Root);
+	Stack.push_back((1 << SViewFrustum::VF_PLANE_COUNT) - 1);
+
+	while (Stack.size())
+	{
+		const s32 id = Stack[Stack.size()-2];
+		s32 planes = Stack.getLast();
+		Stack.set_used(Stack.size()-2);
+
+		const SNode& n = Nodes[id];
+		const core::vector3df center = n.Box.getCenter();
+		const core::vector3df h = n.Box.getExtent() * 0.5f;
+
+		bool outside = false;
+		for (u32 i=0; i != SViewFrustum::VF_PLANE_COUNT; ++i)
+		{
+			if (!(planes & (1 << i)))
+				continue;
+
+			const core::plane3df& p = frustum.planes[i];
+			const f32 distance = p.Normal.dotProduct(center) + p.D;
+			const f32 radius = core::abs_(p.Normal.X) * h.X + core::abs_(p.Normal.Y) * h.Y + core::abs_(p.Normal.Z) * h.Z;
+
+			// the frustum is behind its planes
+			if (distance - radius > core::ROUNDING_ERROR_f32)
+			{
+				outside = true;
+				break;
+			}
+			if (distance + radius < 0.f)
+				planes &= ~(1 << i);
+		}
+
+		if (outside)
+			continue;
+
+		if (0 == planes)
+			getSubtreeNodes(outNodes, id);
+		else if (n.Height == 0)
+			outNodes.push_back(n.Node);
+		else
+		{
+			Stack.push_back(n.Child[1]);
+			Stack.push_back(planes);
+			Stack.push_back(n.Child[0]);
+			Stack.push_back(planes);
+		}
+	}
+}
+
+
+//! appends the nodes of all leaves whose box intersects a box
+void CSceneNodeBVH::getNodes(core::array<ISceneNode*>& outNodes, const core::aabbox3d<f32>& box) const
+{
+	if (Root == -1)
+		return;
+
+	Stack.set_used(0);
+	Stack.push_back(Root);
+
+	while (Stack.size())
+	{
+		const SNode& n = Nodes[Stack.getLast()];
+		Stack.set_used(Stack.size()-1);
+
+		if (!n.Box.intersectsWithBox(box))
+			continue;
+
+		if (n.Height == 0)
+			outNodes.push_back(n.Node);
+		else
+		{
+			Stack.push_back(n.Child[1]);
+			Stack.push_back(n.Child[0]);
+		}
+	}
+}
+
+
+//! appends the nodes of all leaves whose box intersects a line
+void CSceneNodeBVH::getNodes(core::array<ISceneNode*>& outNodes, const core::line3d<f32>& line) const
+{
+	if (Root == -1)
+		return;
+
+	const core::vector3df middle = line.getMiddle();
+	const core::vector3df vect = line.getVector().normalize();
+	const f32 halfLength = (f32)(line.getLength() * 0.5);
+
+	Stack.set_used(0);
+	Stack.push_back(Root);
+
+	while (Stack.size())
+	{
+		const SNode& n = Nodes[Stack.getLast()];
+		Stack.set_used(Stack.size()-1);
+
+		if (!n.Box.intersectsWithLine(middle, vect, halfLength))
+			continue;
+
+		if (n.Height == 0)
+			outNodes.push_back(n.Node);
+		else
+		{
+			Stack.push_back(n.Child[1]);
+			Stack.push_back(n.Child[0]);
+		}
+	}
+}
+
+
+//! appends the nodes of all leaves
+void CSceneNodeBVH::getNodes(core::array<ISceneNode*>& outNodes) const
+{
+	if (Root == -1)
+		return;
+
+	Stack.set_used(0);
+	getSubtreeNodes(outNodes, Root);
+}
+
+
+} // end namespace scene
+} // end namespace irr
+
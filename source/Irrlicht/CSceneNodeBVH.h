@@ -0,0 +1,123 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_SCENE_NODE_BVH_H_INCLUDED__
+#define __C_SCENE_NODE_BVH_H_INCLUDED__
+
+#include "ISceneNode.h"
+#include "SViewFrustum.h"
+#include "irrArray.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! Dynamic bounding volume hierarchy of scene nodes.
+	/** Every leaf holds a scene node with its world space bounding box,
+	enlarged by a margin. The box is only recalculated when the absolute
+	transformation of the node changed, and the node is only reinserted
+	when it leaves the enlarged box. Insertion picks the
+	sibling with the smallest surface area increase and the tree is kept
+	balanced by rotations, so queries visit about log(n) inner nodes. The
+	leaves grab their scene nodes. */
+	class CSceneNodeBVH
+	{
+	public:
+
+		//! constructor
+		CSceneNodeBVH();
+
+		//! destructor
+		~CSceneNodeBVH();
+
+		//! adds a scene node
+		/** \return id of the leaf, stays valid until the node is removed */
+		s32 insert(ISceneNode* node);
+
+		//! removes the leaf with the given id
+		void remove(s32 id);
+
+		//! removes all leaves
+		void clear();
+
+		//! updates the box of a leaf from its node if the node moved
+		/** \return true if the leaf had to be reinserted */
+		bool update(s32 id);
+
+		//! returns the node of a leaf, 0 if the id is not a leaf
+		ISceneNode* getNode(s32 id) const
+		{
+			return (id >= 0 && id < (s32)Nodes.size() && Nodes[id].Height == 0) ? Nodes[id].Node : 0;
+		}
+
+		//! returns the upper bound of all leaf ids
+		s32 getIdCount() const { return (s32)Nodes.size(); }
+
+		//! returns the number of leaves
+		u32 getLeafCount() const { return LeafCount; }
+
+		//! appends the nodes of all leaves whose box may intersect the frustum
+		void getNodes(core::array<ISceneNode*>& outNodes, const SViewFrustum& frustum) const;
+
+		//! appends the nodes of all leaves whose box intersects a box
+		void getNodes(core::array<ISceneNode*>& outNodes, const core::aabbox3d<f32>& box) const;
+
+		//! appends the nodes of all leaves whose box intersects a line
+		void getNodes(core::array<ISceneNode*>& outNodes, const core::line3d<f32>& line) const;
+
+		//! appends the nodes of all leaves
+		void getNodes(core::array<ISceneNode*>& outNodes) const;
+
+	private:
+
+		struct SNode
+		{
+			//! enlarged world box for leaves, union of the children else
+			core::aabbox3d<f32> Box;
+
+			//! leaf node, 0 for inner nodes
+			ISceneNode* Node;
+
+			//! absolute transformation revision of the leaf node when its box was set
+			u32 Revision;
+
+			//! parent, or next free node while in the free list
+			s32 Parent;
+			s32 Child[2];
+
+			//! 0 for leaves, -1 for free nodes
+			s32 Height;
+		};
+
+		//! world space box of a scene node
+		static core::aabbox3d<f32> getWorldBox(const ISceneNode* node);
+
+		//! half surface area, cost of a box for the insertion
+		static f32 getArea(const core::aabbox3d<f32>& box);
+
+		s32 allocateNode();
+		void freeNode(s32 id);
+
+		void insertLeaf(s32 leaf);
+		void removeLeaf(s32 leaf);
+
+		//! rotates the subtree at id if it is unbalanced, returns its new root
+		s32 balance(s32 id);
+
+		//! appends all leaves below id
+		void getSubtreeNodes(core::array<ISceneNode*>& outNodes, s32 id) const;
+
+		core::array<SNode> Nodes;
+		mutable core::array<s32> Stack;
+		s32 Root;
+		s32 FreeList;
+		u32 LeafCount;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
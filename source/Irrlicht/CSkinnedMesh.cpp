@@ -9,6 +9,7 @@
 #include "CBoneSceneNode.h"
 #include "IAnimatedMeshSceneNode.h"
 #include "os.h"
+#include "CProfiler.h"
 
 namespace irr
 {
@@ -96,6 +97,8 @@ void CSkinnedMesh::animateMesh(f32 frame, f32 blend)
 	if (!HasAnimation || LastAnimatedFrame==frame)
 		return;
 
+	_IRR_PROFILE("skinning: animateMesh");
+
 	LastAnimatedFrame=frame;
 	SkinnedLastFrame=false;
 
@@ -450,6 +453,8 @@ void CSkinnedMesh::skinMesh()
 	if (!HasAnimation || SkinnedLastFrame)
 		return;
 
+	_IRR_PROFILE("skinning: skinMesh");
+
 	//----------------
 	// This is marked as "Temp!".  A shiny dubloon to whomever can tell me why.
 	buildAllGlobalAnimatedMatrices();
@@ -253,6 +253,14 @@ ITexture* CSoftwareDriver::createDeviceDependentTexture(IImage* surface, const i
 }
 
 
+//! replaces the content of a texture created by createDeviceDependentTexture
+bool CSoftwareDriver::replaceTextureImage(ITexture* texture, IImage* image)
+{
+	static_cast<CSoftwareTexture*>(texture)->replaceImage(image);
+	return true;
+}
+
+
 //! sets a render target
 bool CSoftwareDriver::setRenderTarget(video::ITexture* texture, bool clearBackBuffer,
 								bool clearZBuffer, SColor color)
@@ -13,6 +13,13 @@
 #include "S3DVertex.h"
 #include "S4DVertex.h"
 #include "CBlit.h"
+#include "CBurningTileRasterizer.h"
+#include "CJobSystem.h"
+#include "CProfiler.h"
+
+#ifdef SOFTWARE_DRIVER_2_SSE2
+#include <emmintrin.h>
+#endif
 
 
 #define MAT_TEXTURE(tex) ( (video::CSoftwareTexture2*) Material.org.getTexture ( tex ) )
@@ -332,11 +339,12 @@ struct program1
 }
 
 //! constructor
-CBurningVideoDriver::CBurningVideoDriver(const irr::SIrrlichtCreationParameters& params, io::IFileSystem* io, video::IImagePresenter* presenter)
+CBurningVideoDriver::CBurningVideoDriver(const irr::SIrrlichtCreationParameters& params, io::IFileSystem* io,
+		video::IImagePresenter* presenter, IJobSystem* jobSystem)
 : CNullDriver(io, params.WindowSize), BackBuffer(0), Presenter(presenter),
 	WindowId(0), SceneSourceRect(0),
 	RenderTargetTexture(0), RenderTargetSurface(0), CurrentShader(0),
-	 DepthBuffer(0), StencilBuffer ( 0 ),
+	 TileRasterizer(0), DepthBuffer(0), StencilBuffer ( 0 ),
 	 CurrentOut ( 12 * 2, 128 ), Temp ( 12 * 2, 128 )
 {
 	#ifdef _DEBUG
@@ -368,36 +376,33 @@ CBurningVideoDriver::CBurningVideoDriver(const irr::SIrrlichtCreationParameters&
 	// create triangle renderers
 
 	irr::memset32 ( BurningShader, 0, sizeof ( BurningShader ) );
-	//BurningShader[ETR_FLAT] = createTRFlat2(DepthBuffer);
-	//BurningShader[ETR_FLAT_WIRE] = createTRFlatWire2(DepthBuffer);
-	BurningShader[ETR_GOURAUD] = createTriangleRendererGouraud2(this);
-	BurningShader[ETR_GOURAUD_ALPHA] = createTriangleRendererGouraudAlpha2(this );
-	BurningShader[ETR_GOURAUD_ALPHA_NOZ] = createTRGouraudAlphaNoZ2(this );
-	//BurningShader[ETR_GOURAUD_WIRE] = createTriangleRendererGouraudWire2(DepthBuffer);
-	//BurningShader[ETR_TEXTURE_FLAT] = createTriangleRendererTextureFlat2(DepthBuffer);
-	//BurningShader[ETR_TEXTURE_FLAT_WIRE] = createTriangleRendererTextureFlatWire2(DepthBuffer);
-	BurningShader[ETR_TEXTURE_GOURAUD] = createTriangleRendererTextureGouraud2(this);
-	BurningShader[ETR_TEXTURE_GOURAUD_LIGHTMAP_M1] = createTriangleRendererTextureLightMap2_M1(this);
-	BurningShader[ETR_TEXTURE_GOURAUD_LIGHTMAP_M2] = createTriangleRendererTextureLightMap2_M2(this);
-	BurningShader[ETR_TEXTURE_GOURAUD_LIGHTMAP_M4] = createTriangleRendererGTextureLightMap2_M4(this);
-	BurningShader[ETR_TEXTURE_LIGHTMAP_M4] = createTriangleRendererTextureLightMap2_M4(this);
-	BurningShader[ETR_TEXTURE_GOURAUD_LIGHTMAP_ADD] = createTriangleRendererTextureLightMap2_Add(this);
-	BurningShader[ETR_TEXTURE_GOURAUD_DETAIL_MAP] = createTriangleRendererTextureDetailMap2(this);
-
-	BurningShader[ETR_TEXTURE_GOURAUD_WIRE] = createTriangleRendererTextureGouraudWire2(this);
-	BurningShader[ETR_TEXTURE_GOURAUD_NOZ] = createTRTextureGouraudNoZ2(this);
-	BurningShader[ETR_TEXTURE_GOURAUD_ADD] = createTRTextureGouraudAdd2(this);
-	BurningShader[ETR_TEXTURE_GOURAUD_ADD_NO_Z] = createTRTextureGouraudAddNoZ2(this);
-	BurningShader[ETR_TEXTURE_GOURAUD_VERTEX_ALPHA] = createTriangleRendererTextureVertexAlpha2 ( this );
-
-	BurningShader[ETR_TEXTURE_GOURAUD_ALPHA] = createTRTextureGouraudAlpha(this );
-	BurningShader[ETR_TEXTURE_GOURAUD_ALPHA_NOZ] = createTRTextureGouraudAlphaNoZ( this );
-
-	BurningShader[ETR_NORMAL_MAP_SOLID] = createTRNormalMap ( this );
-	BurningShader[ETR_STENCIL_SHADOW] = createTRStencilShadow ( this );
-	BurningShader[ETR_TEXTURE_BLEND] = createTRTextureBlend( this );
-
-	BurningShader[ETR_REFERENCE] = createTriangleRendererReference ( this );
+
+	// the shader workers grab the depth and stencil buffer
+	IJobSystem* jobs = 0;
+	if ( params.RasterizerThreads > 1 )
+	{
+		jobs = new CJobSystem ( params.RasterizerThreads - 1 );
+	}
+	else if ( params.RasterizerThreads == 0 && jobSystem && jobSystem->getWorkerCount() > 1 )
+	{
+		jobs = jobSystem;
+		jobs->grab();
+	}
+
+	if ( jobs )
+	{
+		TileRasterizer = new CBurningTileRasterizer ( this, jobs );
+		jobs->drop();
+	}
+
+	for ( u32 i = 0; i != ETR2_COUNT; ++i )
+	{
+		if ( TileRasterizer )
+			BurningShader[i] = TileRasterizer->createRecorder ( (EBurningFFShader) i );
+
+		if ( 0 == BurningShader[i] )
+			BurningShader[i] = createBurningShader ( (EBurningFFShader) i, this );
+	}
 
 
 	// add the same renderer for all solid types
@@ -449,6 +454,8 @@ CBurningVideoDriver::CBurningVideoDriver(const irr::SIrrlichtCreationParameters&
 //! destructor
 CBurningVideoDriver::~CBurningVideoDriver()
 {
+	flushTileRasterizer();
+
 	// delete Backbuffer
 	if (BackBuffer)
 		BackBuffer->drop();
@@ -461,6 +468,9 @@ CBurningVideoDriver::~CBurningVideoDriver()
 			BurningShader[i]->drop();
 	}
 
+	if (TileRasterizer)
+		TileRasterizer->drop();
+
 	// delete Additional buffer
 	if (StencilBuffer)
 		StencilBuffer->drop();
@@ -606,6 +616,14 @@ void CBurningVideoDriver::setCurrentShader()
 
 
 
+//! waits until all queued triangles are rasterized
+void CBurningVideoDriver::flushTileRasterizer()
+{
+	if (TileRasterizer)
+		TileRasterizer->flush();
+}
+
+
 //! queries the features of the driver, returns true if feature is available
 bool CBurningVideoDriver::queryFeature(E_VIDEO_DRIVER_FEATURE feature) const
 {
@@ -688,6 +706,7 @@ bool CBurningVideoDriver::beginScene(bool backBuffer, bool zBuffer,
 		core::rect<s32>* sourceRect)
 {
 	CNullDriver::beginScene(backBuffer, zBuffer, color, videoData, sourceRect);
+	flushTileRasterizer();
 	WindowId = videoData.D3D9.HWnd;
 	SceneSourceRect = sourceRect;
 
@@ -706,6 +725,7 @@ bool CBurningVideoDriver::beginScene(bool backBuffer, bool zBuffer,
 bool CBurningVideoDriver::endScene()
 {
 	CNullDriver::endScene();
+	flushTileRasterizer();
 
 	return Presenter->present(BackBuffer, WindowId, SceneSourceRect);
 }
@@ -721,6 +741,8 @@ bool CBurningVideoDriver::setRenderTarget(video::ITexture* texture, bool clearBa
 		return false;
 	}
 
+	flushTileRasterizer();
+
 	if (RenderTargetTexture)
 		RenderTargetTexture->drop();
 
@@ -752,6 +774,8 @@ bool CBurningVideoDriver::setRenderTarget(video::ITexture* texture, bool clearBa
 //! sets a render target
 void CBurningVideoDriver::setRenderTarget(video::CImage* image)
 {
+	flushTileRasterizer();
+
 	if (RenderTargetSurface)
 		RenderTargetSurface->drop();
 
@@ -1171,75 +1195,12 @@ const SVSize CBurningVideoDriver::vSize[] =
 
 
 /*!
-	fill a cache line with transformed, light and clipp test triangles
+	texture coordinates, texture transform and tangent space light vector of a cache line.
+	expects the vertex in LightSpace.
 */
-void CBurningVideoDriver::VertexCache_fill(const u32 sourceIndex, const u32 destIndex)
+void CBurningVideoDriver::VertexCache_fillTexture ( s4DVertex *dest, const u8 *source )
 {
-	u8 * source;
-	s4DVertex *dest;
-
-	source = (u8*) VertexCache.vertices + ( sourceIndex * vSize[VertexCache.vType].Pitch );
-
-	// it's a look ahead so we never hit it..
-	// but give priority...
-	//VertexCache.info[ destIndex ].hit = hitCount;
-
-	// store info
-	VertexCache.info[ destIndex ].index = sourceIndex;
-	VertexCache.info[ destIndex ].hit = 0;
-
-	// destination Vertex
-	dest = (s4DVertex *) ( (u8*) VertexCache.mem.data + ( destIndex << ( SIZEOF_SVERTEX_LOG2 + 1  ) ) );
-
-	// transform Model * World * Camera * Projection * NDCSpace matrix
 	const S3DVertex *base = ((S3DVertex*) source );
-	Transformation [ ETS_CURRENT].transformVect ( &dest->Pos.x, base->Pos );
-
-	//mhm ;-) maybe no goto
-	if ( VertexCache.vType == 4 ) goto clipandproject;
-
-
-#if defined (SOFTWARE_DRIVER_2_LIGHTING) || defined ( SOFTWARE_DRIVER_2_TEXTURE_TRANSFORM )
-
-	// vertex normal in light space
-	if ( Material.org.Lighting || (LightSpace.Flags & VERTEXTRANSFORM) )
-	{
-		if ( TransformationFlag[ETS_WORLD] & ETF_IDENTITY )
-		{
-			LightSpace.normal.set ( base->Normal.X, base->Normal.Y, base->Normal.Z, 1.f );
-			LightSpace.vertex.set ( base->Pos.X, base->Pos.Y, base->Pos.Z, 1.f );
-		}
-		else
-		{
-			Transformation[ETS_WORLD].rotateVect ( &LightSpace.normal.x, base->Normal );
-
-			// vertex in light space
-			if ( LightSpace.Flags & ( POINTLIGHT | FOG | SPECULAR | VERTEXTRANSFORM) )
-				Transformation[ETS_WORLD].transformVect ( &LightSpace.vertex.x, base->Pos );
-		}
-
-		if ( LightSpace.Flags & NORMALIZE )
-			LightSpace.normal.normalize_xyz();
-
-	}
-
-#endif
-
-#if defined ( SOFTWARE_DRIVER_2_USE_VERTEX_COLOR )
-	// apply lighting model
-	#if defined (SOFTWARE_DRIVER_2_LIGHTING)
-		if ( Material.org.Lighting )
-		{
-			lightVertex ( dest, base->Color.color );
-		}
-		else
-		{
-			dest->Color[0].setA8R8G8B8 ( base->Color.color );
-		}
-	#else
-		dest->Color[0].setA8R8G8B8 ( base->Color.color );
-	#endif
-#endif
 
 	// Texture Transform
 #if !defined ( SOFTWARE_DRIVER_2_TEXTURE_TRANSFORM )
@@ -1455,6 +1416,81 @@ void CBurningVideoDriver::VertexCache_fill(const u32 sourceIndex, const u32 dest
 
 
 #endif
+}
+
+
+/*!
+	fill a cache line with transformed, light and clipp test triangles
+*/
+void CBurningVideoDriver::VertexCache_fill(const u32 sourceIndex, const u32 destIndex)
+{
+	u8 * source;
+	s4DVertex *dest;
+
+	source = (u8*) VertexCache.vertices + ( sourceIndex * vSize[VertexCache.vType].Pitch );
+
+	// it's a look ahead so we never hit it..
+	// but give priority...
+	//VertexCache.info[ destIndex ].hit = hitCount;
+
+	// store info
+	VertexCache.info[ destIndex ].index = sourceIndex;
+	VertexCache.info[ destIndex ].hit = 0;
+
+	// destination Vertex
+	dest = (s4DVertex *) ( (u8*) VertexCache.mem.data + ( destIndex << ( SIZEOF_SVERTEX_LOG2 + 1  ) ) );
+
+	// transform Model * World * Camera * Projection * NDCSpace matrix
+	const S3DVertex *base = ((S3DVertex*) source );
+	Transformation [ ETS_CURRENT].transformVect ( &dest->Pos.x, base->Pos );
+
+	//mhm ;-) maybe no goto
+	if ( VertexCache.vType == 4 ) goto clipandproject;
+
+
+#if defined (SOFTWARE_DRIVER_2_LIGHTING) || defined ( SOFTWARE_DRIVER_2_TEXTURE_TRANSFORM )
+
+	// vertex normal in light space
+	if ( Material.org.Lighting || (LightSpace.Flags & VERTEXTRANSFORM) )
+	{
+		if ( TransformationFlag[ETS_WORLD] & ETF_IDENTITY )
+		{
+			LightSpace.normal.set ( base->Normal.X, base->Normal.Y, base->Normal.Z, 1.f );
+			LightSpace.vertex.set ( base->Pos.X, base->Pos.Y, base->Pos.Z, 1.f );
+		}
+		else
+		{
+			Transformation[ETS_WORLD].rotateVect ( &LightSpace.normal.x, base->Normal );
+
+			// vertex in light space
+			if ( LightSpace.Flags & ( POINTLIGHT | FOG | SPECULAR | VERTEXTRANSFORM) )
+				Transformation[ETS_WORLD].transformVect ( &LightSpace.vertex.x, base->Pos );
+		}
+
+		if ( LightSpace.Flags & NORMALIZE )
+			LightSpace.normal.normalize_xyz();
+
+	}
+
+#endif
+
+#if defined ( SOFTWARE_DRIVER_2_USE_VERTEX_COLOR )
+	// apply lighting model
+	#if defined (SOFTWARE_DRIVER_2_LIGHTING)
+		if ( Material.org.Lighting )
+		{
+			lightVertex ( dest, base->Color.color );
+		}
+		else
+		{
+			dest->Color[0].setA8R8G8B8 ( base->Color.color );
+		}
+	#else
+		dest->Color[0].setA8R8G8B8 ( base->Color.color );
+	#endif
+#endif
+
+	VertexCache_fillTexture ( dest, source );
 
 clipandproject:
 	dest[0].flag = dest[1].flag = vSize[VertexCache.vType].Format;
@@ -1471,6 +1507,396 @@ clipandproject:
 	//return dest;
 }
 
+#ifdef SOFTWARE_DRIVER_2_SSE2
+
+/*
+	four vertices in SoA layout, one lane per vertex.
+	every operation mirrors the scalar sVec4 code in the same order,
+	so the results are identical to VertexCache_fill.
+*/
+struct sVec3x4
+{
+	__m128 x, y, z;
+
+	void set ( const sVec4 &v )
+	{
+		x = _mm_set1_ps ( v.x );
+		y = _mm_set1_ps ( v.y );
+		z = _mm_set1_ps ( v.z );
+	}
+
+	// x * M[0] + y * M[4] + z * M[8]
+	void rotate ( const core::matrix4 &m, const sVec3x4 &v )
+	{
+		const f32 *M = m.pointer();
+		x = rotateRow ( M + 0, v );
+		y = rotateRow ( M + 1, v );
+		z = rotateRow ( M + 2, v );
+	}
+
+	// x * M[0] + y * M[4] + z * M[8] + M[12]
+	void transform ( const core::matrix4 &m, const sVec3x4 &v )
+	{
+		const f32 *M = m.pointer();
+		x = _mm_add_ps ( rotateRow ( M + 0, v ), _mm_set1_ps ( M[12] ) );
+		y = _mm_add_ps ( rotateRow ( M + 1, v ), _mm_set1_ps ( M[13] ) );
+		z = _mm_add_ps ( rotateRow ( M + 2, v ), _mm_set1_ps ( M[14] ) );
+	}
+
+	static __m128 rotateRow ( const f32 *M, const sVec3x4 &v )
+	{
+		return _mm_add_ps ( _mm_add_ps (	_mm_mul_ps ( v.x, _mm_set1_ps ( M[0] ) ),
+											_mm_mul_ps ( v.y, _mm_set1_ps ( M[4] ) ) ),
+											_mm_mul_ps ( v.z, _mm_set1_ps ( M[8] ) ) );
+	}
+
+	void store ( f32 dest[3][4] ) const
+	{
+		_mm_storeu_ps ( dest[0], x );
+		_mm_storeu_ps ( dest[1], y );
+		_mm_storeu_ps ( dest[2], z );
+	}
+
+	__m128 dot_xyz ( const sVec3x4 &other ) const
+	{
+		return _mm_add_ps ( _mm_add_ps ( _mm_mul_ps ( x, other.x ), _mm_mul_ps ( y, other.y ) ), _mm_mul_ps ( z, other.z ) );
+	}
+
+	__m128 get_length_xyz_square () const
+	{
+		return dot_xyz ( *this );
+	}
+
+	void mul ( const __m128 s )
+	{
+		x = _mm_mul_ps ( x, s );
+		y = _mm_mul_ps ( y, s );
+		z = _mm_mul_ps ( z, s );
+	}
+
+	void normalize_xyz ()
+	{
+		mul ( _mm_div_ps ( _mm_set1_ps ( 1.f ), _mm_sqrt_ps ( get_length_xyz_square () ) ) );
+	}
+
+	// this += v0 * v1
+	void mulAdd ( const sVec3x4 &v0, const sVec3 &v1 )
+	{
+		x = _mm_add_ps ( x, _mm_mul_ps ( v0.x, _mm_set1_ps ( v1.r ) ) );
+		y = _mm_add_ps ( y, _mm_mul_ps ( v0.y, _mm_set1_ps ( v1.g ) ) );
+		z = _mm_add_ps ( z, _mm_mul_ps ( v0.z, _mm_set1_ps ( v1.b ) ) );
+	}
+
+	// lanes in mask: this += other * v
+	void mulAdd ( const sVec3 &other, const __m128 v, const __m128 mask )
+	{
+		x = select ( mask, _mm_add_ps ( x, _mm_mul_ps ( _mm_set1_ps ( other.r ), v ) ), x );
+		y = select ( mask, _mm_add_ps ( y, _mm_mul_ps ( _mm_set1_ps ( other.g ), v ) ), y );
+		z = select ( mask, _mm_add_ps ( z, _mm_mul_ps ( _mm_set1_ps ( other.b ), v ) ), z );
+	}
+
+	static __m128 select ( const __m128 mask, const __m128 a, const __m128 b )
+	{
+		return _mm_or_ps ( _mm_and_ps ( mask, a ), _mm_andnot_ps ( mask, b ) );
+	}
+};
+
+/*!
+	fill up to four cache lines at once. position transform, clip test,
+	light space and the lighting model run on the SoA staging block,
+	texture coordinates and projection stay per vertex.
+*/
+void CBurningVideoDriver::VertexCache_fill4 ( const u32 *sourceIndex, const u32 *destIndex, const u32 count )
+{
+	const u8 * source[4];
+	const S3DVertex * base[4];
+	s4DVertex * dest[4];
+	u32 i;
+
+	// unused lanes repeat the last vertex
+	for ( i = 0; i != 4; ++i )
+	{
+		const u32 k = core::min_ ( i, count - 1 );
+		source[i] = (u8*) VertexCache.vertices + ( sourceIndex[k] * vSize[VertexCache.vType].Pitch );
+		base[i] = (const S3DVertex*) source[i];
+		dest[i] = (s4DVertex *) ( (u8*) VertexCache.mem.data + ( destIndex[k] << ( SIZEOF_SVERTEX_LOG2 + 1  ) ) );
+	}
+
+	// staging block, object space position
+	sVec3x4 pos;
+	pos.x = _mm_setr_ps ( base[0]->Pos.X, base[1]->Pos.X, base[2]->Pos.X, base[3]->Pos.X );
+	pos.y = _mm_setr_ps ( base[0]->Pos.Y, base[1]->Pos.Y, base[2]->Pos.Y, base[3]->Pos.Y );
+	pos.z = _mm_setr_ps ( base[0]->Pos.Z, base[1]->Pos.Z, base[2]->Pos.Z, base[3]->Pos.Z );
+
+	// transform Model * World * Camera * Projection * NDCSpace matrix
+	const f32 *M = Transformation [ ETS_CURRENT ].pointer();
+	__m128 hx = _mm_add_ps ( sVec3x4::rotateRow ( M + 0, pos ), _mm_set1_ps ( M[12] ) );
+	__m128 hy = _mm_add_ps ( sVec3x4::rotateRow ( M + 1, pos ), _mm_set1_ps ( M[13] ) );
+	__m128 hz = _mm_add_ps ( sVec3x4::rotateRow ( M + 2, pos ), _mm_set1_ps ( M[14] ) );
+	__m128 hw = _mm_add_ps ( sVec3x4::rotateRow ( M + 3, pos ), _mm_set1_ps ( M[15] ) );
+
+	// clip test, bit i of mask[p] is plane p of lane i
+	const __m128 sign = _mm_set1_ps ( -0.f );
+	u32 clip[6];
+	clip[0] = _mm_movemask_ps ( _mm_cmple_ps ( hz, hw ) );
+	clip[1] = _mm_movemask_ps ( _mm_cmple_ps ( _mm_xor_ps ( hz, sign ), hw ) );
+	clip[2] = _mm_movemask_ps ( _mm_cmple_ps ( hx, hw ) );
+	clip[3] = _mm_movemask_ps ( _mm_cmple_ps ( _mm_xor_ps ( hx, sign ), hw ) );
+	clip[4] = _mm_movemask_ps ( _mm_cmple_ps ( hy, hw ) );
+	clip[5] = _mm_movemask_ps ( _mm_cmple_ps ( _mm_xor_ps ( hy, sign ), hw ) );
+
+	// back to the vertices
+	_MM_TRANSPOSE4_PS ( hx, hy, hz, hw );
+	_mm_storeu_ps ( &dest[0]->Pos.x, hx );
+	_mm_storeu_ps ( &dest[1]->Pos.x, hy );
+	_mm_storeu_ps ( &dest[2]->Pos.x, hz );
+	_mm_storeu_ps ( &dest[3]->Pos.x, hw );
+
+#if defined (SOFTWARE_DRIVER_2_LIGHTING) || defined ( SOFTWARE_DRIVER_2_TEXTURE_TRANSFORM )
+	// vertex normal and vertex in light space
+	sVec3x4 normal;
+	sVec3x4 vertex;
+	bool lightSpace = false;
+	bool lightSpaceVertex = false;
+	f32 stageNormal[3][4];
+	f32 stageVertex[3][4];
+
+	if ( VertexCache.vType != 4 && ( Material.org.Lighting || (LightSpace.Flags & VERTEXTRANSFORM) ) )
+	{
+		normal.x = _mm_setr_ps ( base[0]->Normal.X, base[1]->Normal.X, base[2]->Normal.X, base[3]->Normal.X );
+		normal.y = _mm_setr_ps ( base[0]->Normal.Y, base[1]->Normal.Y, base[2]->Normal.Y, base[3]->Normal.Y );
+		normal.z = _mm_setr_ps ( base[0]->Normal.Z, base[1]->Normal.Z, base[2]->Normal.Z, base[3]->Normal.Z );
+
+		lightSpace = true;
+		if ( TransformationFlag[ETS_WORLD] & ETF_IDENTITY )
+		{
+			vertex = pos;
+			lightSpaceVertex = true;
+		}
+		else
+		{
+			normal.rotate ( Transformation[ETS_WORLD], normal );
+
+			if ( LightSpace.Flags & ( POINTLIGHT | FOG | SPECULAR | VERTEXTRANSFORM) )
+			{
+				vertex.transform ( Transformation[ETS_WORLD], pos );
+				lightSpaceVertex = true;
+			}
+			else
+			{
+				// not needed, keep what the scalar path would see
+				vertex.set ( LightSpace.vertex );
+			}
+		}
+
+		if ( LightSpace.Flags & NORMALIZE )
+			normal.normalize_xyz();
+
+		normal.store ( stageNormal );
+		vertex.store ( stageVertex );
+	}
+#endif
+
+#if defined ( SOFTWARE_DRIVER_2_USE_VERTEX_COLOR ) && defined (SOFTWARE_DRIVER_2_LIGHTING)
+	// apply lighting model
+	sVec3 dColor;
+	f32 color[3][4];
+
+	if ( VertexCache.vType != 4 && Material.org.Lighting )
+	{
+		dColor = LightSpace.Global_AmbientLight;
+		dColor.add ( Material.EmissiveColor );
+
+		if ( Lights.size () )
+		{
+			sVec3 ambient;
+			sVec3x4 diffuse;
+			sVec3x4 specular;
+
+			// the universe started in darkness..
+			ambient.set ( 0.f, 0.f, 0.f );
+			diffuse.x = diffuse.y = diffuse.z = _mm_setzero_ps ();
+			specular.x = specular.y = specular.z = _mm_setzero_ps ();
+
+			const __m128 zero = _mm_setzero_ps ();
+			const __m128 one = _mm_set1_ps ( 1.f );
+
+			for ( i = 0; i!= LightSpace.Light.size (); ++i )
+			{
+				const SBurningShaderLight &light = LightSpace.Light[i];
+
+				if ( !light.LightIsOn )
+					continue;
+
+				// accumulate ambient
+				ambient.add ( light.AmbientColor );
+
+				switch ( light.Type )
+				{
+					case video::ELT_SPOT:
+					case video::ELT_POINT:
+					{
+						// surface to light
+						sVec3x4 vp;
+						vp.x = _mm_sub_ps ( _mm_set1_ps ( light.pos.x ), vertex.x );
+						vp.y = _mm_sub_ps ( _mm_set1_ps ( light.pos.y ), vertex.y );
+						vp.z = _mm_sub_ps ( _mm_set1_ps ( light.pos.z ), vertex.z );
+
+						__m128 len = vp.get_length_xyz_square();
+						__m128 mask = _mm_cmpnlt_ps ( _mm_set1_ps ( light.radius ), len );
+						if ( 0 == _mm_movemask_ps ( mask ) )
+							continue;
+
+						len = _mm_div_ps ( one, _mm_sqrt_ps ( len ) );
+
+						//angle between normal and light vector
+						vp.mul ( len );
+						__m128 dot = normal.dot_xyz ( vp );
+						mask = _mm_and_ps ( mask, _mm_cmpnlt_ps ( dot, zero ) );
+
+						const __m128 attenuation = _mm_add_ps ( _mm_set1_ps ( light.constantAttenuation ),
+							_mm_sub_ps ( one, _mm_mul_ps ( len, _mm_set1_ps ( light.linearAttenuation ) ) ) );
+
+						// diffuse component
+						diffuse.mulAdd ( light.DiffuseColor, _mm_mul_ps ( _mm_mul_ps ( _mm_set1_ps ( 3.f ), dot ), attenuation ), mask );
+
+						if ( !(LightSpace.Flags & SPECULAR) )
+							continue;
+
+						// surface to view
+						sVec3x4 lightHalf;
+						lightHalf.x = _mm_sub_ps ( _mm_set1_ps ( LightSpace.campos.x ), vertex.x );
+						lightHalf.y = _mm_sub_ps ( _mm_set1_ps ( LightSpace.campos.y ), vertex.y );
+						lightHalf.z = _mm_sub_ps ( _mm_set1_ps ( LightSpace.campos.z ), vertex.z );
+						lightHalf.normalize_xyz();
+						lightHalf.x = _mm_add_ps ( lightHalf.x, vp.x );
+						lightHalf.y = _mm_add_ps ( lightHalf.y, vp.y );
+						lightHalf.z = _mm_add_ps ( lightHalf.z, vp.z );
+						lightHalf.normalize_xyz();
+
+						// specular
+						dot = normal.dot_xyz ( lightHalf );
+						mask = _mm_and_ps ( mask, _mm_cmpnlt_ps ( dot, zero ) );
+						specular.mulAdd ( light.SpecularColor, _mm_mul_ps ( dot, attenuation ), mask );
+					} break;
+
+					case video::ELT_DIRECTIONAL:
+					{
+						//angle between normal and light vector
+						sVec3x4 dir;
+						dir.set ( light.pos );
+						const __m128 dot = normal.dot_xyz ( dir );
+
+						// diffuse component
+						diffuse.mulAdd ( light.DiffuseColor, dot, _mm_cmpnlt_ps ( dot, zero ) );
+					} break;
+					default:
+						break;
+				}
+			}
+
+			// sum up lights
+			dColor.mulAdd ( ambient, Material.AmbientColor );
+
+			sVec3x4 sum;
+			sum.x = _mm_set1_ps ( dColor.r );
+			sum.y = _mm_set1_ps ( dColor.g );
+			sum.z = _mm_set1_ps ( dColor.b );
+			sum.mulAdd ( diffuse, Material.DiffuseColor );
+			sum.mulAdd ( specular, Material.SpecularColor );
+
+			sum.store ( color );
+		}
+		else
+		{
+			for ( i = 0; i != 4; ++i )
+			{
+				color[0][i] = dColor.r;
+				color[1][i] = dColor.g;
+				color[2][i] = dColor.b;
+			}
+		}
+	}
+#endif
+
+	// per vertex: texture coordinates, flags and projection
+	for ( i = 0; i != count; ++i )
+	{
+		VertexCache.info[ destIndex[i] ].index = sourceIndex[i];
+		VertexCache.info[ destIndex[i] ].hit = 0;
+
+		s4DVertex *d = dest[i];
+
+		if ( VertexCache.vType != 4 )
+		{
+#if defined (SOFTWARE_DRIVER_2_LIGHTING) || defined ( SOFTWARE_DRIVER_2_TEXTURE_TRANSFORM )
+			if ( lightSpace )
+			{
+				LightSpace.normal.set ( stageNormal[0][i], stageNormal[1][i], stageNormal[2][i], 1.f );
+				if ( lightSpaceVertex )
+					LightSpace.vertex.set ( stageVertex[0][i], stageVertex[1][i], stageVertex[2][i], 1.f );
+			}
+#endif
+
+#if defined ( SOFTWARE_DRIVER_2_USE_VERTEX_COLOR )
+	#if defined (SOFTWARE_DRIVER_2_LIGHTING)
+			if ( Material.org.Lighting )
+			{
+				sVec3 c ( color[0][i], color[1][i], color[2][i] );
+				c.saturate ( d->Color[0], base[i]->Color.color );
+			}
+			else
+			{
+				d->Color[0].setA8R8G8B8 ( base[i]->Color.color );
+			}
+	#else
+			d->Color[0].setA8R8G8B8 ( base[i]->Color.color );
+	#endif
+#endif
+
+			VertexCache_fillTexture ( d, source[i] );
+		}
+
+		d[0].flag = d[1].flag = vSize[VertexCache.vType].Format;
+
+		// test vertex
+		d[0].flag |=	( ( clip[0] >> i ) & 1 )		|
+						( ( clip[1] >> i ) & 1 ) << 1	|
+						( ( clip[2] >> i ) & 1 ) << 2	|
+						( ( clip[3] >> i ) & 1 ) << 3	|
+						( ( clip[4] >> i ) & 1 ) << 4	|
+						( ( clip[5] >> i ) & 1 ) << 5;
+
+		// to DC Space, project homogenous vertex
+		if ( (d[0].flag & VERTEX4D_CLIPMASK ) == VERTEX4D_INSIDE )
+		{
+			ndc_2_dc_and_project2 ( (const s4DVertex**) &d, 1 );
+		}
+	}
+}
+
+#endif // SOFTWARE_DRIVER_2_SSE2
+
+
+/*!
+	fill several cache lines
+*/
+void CBurningVideoDriver::VertexCache_fillBlock ( const u32 *sourceIndex, const u32 *destIndex, const u32 count )
+{
+	u32 i;
+#ifdef SOFTWARE_DRIVER_2_SSE2
+	for ( i = 0; i < count; i += 4 )
+	{
+		VertexCache_fill4 ( sourceIndex + i, destIndex + i, core::min_ ( count - i, 4u ) );
+	}
+#else
+	for ( i = 0; i != count; ++i )
+	{
+		VertexCache_fill ( sourceIndex[i], destIndex[i] );
+	}
+#endif
+}
+
 //
 
 REALINLINE s4DVertex * CBurningVideoDriver::VertexCache_getVertex ( const u32 sourceIndex )
@@ -1568,6 +1994,10 @@ REALINLINE void CBurningVideoDriver::VertexCache_get(const s4DVertex ** face)
 		}
 
 		// fill new
+		u32 fillSource[VERTEXCACHE_ELEMENT];
+		u32 fillDest[VERTEXCACHE_ELEMENT];
+		u32 fillCount = 0;
+
 		for ( i = 0; i!= fillIndex; ++i )
 		{
 			if ( info[i].hit != VERTEXCACHE_MISS )
@@ -1577,13 +2007,17 @@ REALINLINE void CBurningVideoDriver::VertexCache_get(const s4DVertex ** face)
 			{
 				if ( 0 == VertexCache.info[dIndex].hit )
 				{
-					VertexCache_fill ( info[i].index, dIndex );
+					fillSource[fillCount] = info[i].index;
+					fillDest[fillCount] = dIndex;
+					fillCount += 1;
 					VertexCache.info[dIndex].hit += 1;
 					info[i].hit = dIndex;
 					break;
 				}
 			}
 		}
+
+		VertexCache_fillBlock ( fillSource, fillDest, fillCount );
 	}
 
 	const u32 i0 = core::if_c_a_else_0 ( VertexCache.pType != scene::EPT_TRIANGLE_FAN, VertexCache.indicesRun );
@@ -1626,22 +2060,26 @@ REALINLINE void CBurningVideoDriver::VertexCache_get(const s4DVertex ** face)
 REALINLINE void CBurningVideoDriver::VertexCache_getbypass ( s4DVertex ** face )
 {
 	const u32 i0 = core::if_c_a_else_0 ( VertexCache.pType != scene::EPT_TRIANGLE_FAN, VertexCache.indicesRun );
+	const u32 fillDest[3] = { 0, 1, 2 };
+	u32 fillSource[3];
 
 	if ( VertexCache.iType == 1 )
 	{
 		const u16 *p = (const u16 *) VertexCache.indices;
-		VertexCache_fill ( p[ i0    ], 0 );
-		VertexCache_fill ( p[ VertexCache.indicesRun + 1], 1 );
-		VertexCache_fill ( p[ VertexCache.indicesRun + 2], 2 );
+		fillSource[0] = p[ i0    ];
+		fillSource[1] = p[ VertexCache.indicesRun + 1];
+		fillSource[2] = p[ VertexCache.indicesRun + 2];
 	}
 	else
 	{
 		const u32 *p = (const u32 *) VertexCache.indices;
-		VertexCache_fill ( p[ i0    ], 0 );
-		VertexCache_fill ( p[ VertexCache.indicesRun + 1], 1 );
-		VertexCache_fill ( p[ VertexCache.indicesRun + 2], 2 );
+		fillSource[0] = p[ i0    ];
+		fillSource[1] = p[ VertexCache.indicesRun + 1];
+		fillSource[2] = p[ VertexCache.indicesRun + 2];
 	}
 
+	VertexCache_fillBlock ( fillSource, fillDest, 3 );
+
 	VertexCache.indicesRun += VertexCache.primitivePitch;
 
 	face[0] = (s4DVertex *) ( (u8*) VertexCache.mem.data + ( 0 << ( SIZEOF_SVERTEX_LOG2 + 1  ) ) );
@@ -1733,6 +2171,50 @@ void CBurningVideoDriver::VertexCache_reset ( const void* vertices, u32 vertexCo
 }
 
 
+//! rasterizes a projected triangle unless the coarse depth tiles hide it
+void CBurningVideoDriver::drawTriangle ( const s4DVertex *a, const s4DVertex *b, const s4DVertex *c )
+{
+#ifdef SOFTWARE_DRIVER_2_HIERARCHICAL_Z
+	if ( 0 == DepthBuffer )
+	{
+		CurrentShader->drawTriangle ( a, b, c );
+		return;
+	}
+
+	// screen area of the triangle, the scanlines never leave it
+	const core::rect<s32> area (
+		core::floor32 ( core::min_ ( a->Pos.x, b->Pos.x, c->Pos.x ) ),
+		core::floor32 ( core::min_ ( a->Pos.y, b->Pos.y, c->Pos.y ) ),
+		core::ceil32 ( core::max_ ( a->Pos.x, b->Pos.x, c->Pos.x ) ) + 1,
+		core::ceil32 ( core::max_ ( a->Pos.y, b->Pos.y, c->Pos.y ) ) + 1
+		);
+
+	const bool depthTest = CurrentShader->hasDepthTest ();
+	if ( depthTest )
+	{
+		// closest 1/w of the triangle. interpolation may step a little beyond the vertices
+		const f32 w = core::max_ ( a->Pos.w, b->Pos.w, c->Pos.w ) * 1.001f;
+		if ( DepthBuffer->isOccluded ( area, w ) )
+			return;
+	}
+
+	CurrentShader->drawTriangle ( a, b, c );
+
+	// a depth tested triangle which writes all its fragments only moves the
+	// stored depth closer, otherwise read it back
+	if ( CurrentShader->hasDepthWrite () )
+	{
+		if ( depthTest && CurrentShader->hasFullDepthWrite () )
+			DepthBuffer->updateTriangle ( a, b, c );
+		else
+			DepthBuffer->markDirty ( area );
+	}
+#else
+	CurrentShader->drawTriangle ( a, b, c );
+#endif
+}
+
+
 void CBurningVideoDriver::drawVertexPrimitiveList(const void* vertices, u32 vertexCount,
 				const void* indexList, u32 primitiveCount,
 				E_VERTEX_TYPE vType, scene::E_PRIMITIVE_TYPE pType, E_INDEX_TYPE iType)
@@ -1741,6 +2223,8 @@ void CBurningVideoDriver::drawVertexPrimitiveList(const void* vertices, u32 vert
 	if (!checkPrimitiveCount(primitiveCount))
 		return;
 
+	_IRR_PROFILE("driver: drawVertexPrimitiveList");
+
 	CNullDriver::drawVertexPrimitiveList(vertices, vertexCount, indexList, primitiveCount, vType, pType, iType);
 
 	// These calls would lead to crashes due to wrong index usage.
@@ -1753,6 +2237,10 @@ void CBurningVideoDriver::drawVertexPrimitiveList(const void* vertices, u32 vert
 	if ( 0 == CurrentShader )
 		return;
 
+	// shaders which can't be tiled draw immediately
+	if ( !CurrentShader->canRenderTiled () )
+		flushTileRasterizer();
+
 	VertexCache_reset ( vertices, vertexCount, indexList, primitiveCount, vType, pType, iType );
 
 	const s4DVertex * face[3];
@@ -1796,11 +2284,11 @@ void CBurningVideoDriver::drawVertexPrimitiveList(const void* vertices, u32 vert
 
 				lodLevel = s32_log2_f32 ( texelarea2 ( face, m ) * dc_area  );
 				CurrentShader->setTextureParam(m, tex, lodLevel );
-				select_polygon_mipmap2 ( (s4DVertex**) face, m, tex->getSize() );
+				select_polygon_mipmap2 ( (s4DVertex**) face, m, tex->getMipMapSurface ( lodLevel )->getDimension() );
 			}
 
 			// rasterize
-			CurrentShader->drawTriangle ( face[0] + 1, face[1] + 1, face[2] + 1 );
+			drawTriangle ( face[0] + 1, face[1] + 1, face[2] + 1 );
 			continue;
 		}
 
@@ -1871,7 +2359,7 @@ void CBurningVideoDriver::drawVertexPrimitiveList(const void* vertices, u32 vert
 
 			lodLevel = s32_log2_f32 ( texelarea ( CurrentOut.data, m ) * dc_area );
 			CurrentShader->setTextureParam(m, tex, lodLevel );
-			select_polygon_mipmap ( CurrentOut.data, vOut, m, tex->getSize() );
+			select_polygon_mipmap ( CurrentOut.data, vOut, m, tex->getMipMapSurface ( lodLevel )->getDimension() );
 		}
 
 
@@ -1879,7 +2367,7 @@ void CBurningVideoDriver::drawVertexPrimitiveList(const void* vertices, u32 vert
 		for ( g = 0; g <= vOut - 6; g += 2 )
 		{
 			// rasterize
-			CurrentShader->drawTriangle ( CurrentOut.data + 0 + 1,
+			drawTriangle ( CurrentOut.data + 0 + 1,
 							CurrentOut.data + g + 3,
 							CurrentOut.data + g + 5);
 		}
@@ -2201,6 +2689,8 @@ void CBurningVideoDriver::draw2DImage(const video::ITexture* texture, const core
 			return;
 		}
 
+		flushTileRasterizer();
+
 #if 0
 		// 2d methods don't use viewPort
 		core::position2di dest = destPos;
@@ -2239,6 +2729,8 @@ void CBurningVideoDriver::draw2DImage(const video::ITexture* texture, const core
 			return;
 		}
 
+		flushTileRasterizer();
+
 	if (useAlphaChannelOfTexture)
 		StretchBlit(BLITTER_TEXTURE_ALPHA_BLEND, RenderTargetSurface, &destRect, &sourceRect,
 			    ((CSoftwareTexture2*)texture)->getImage(), (colors ? colors[0].color : 0));
@@ -2253,6 +2745,7 @@ void CBurningVideoDriver::draw2DLine(const core::position2d<s32>& start,
 					const core::position2d<s32>& end,
 					SColor color)
 {
+	flushTileRasterizer();
 	drawLine(BackBuffer, start, end, color );
 }
 
@@ -2260,6 +2753,7 @@ void CBurningVideoDriver::draw2DLine(const core::position2d<s32>& start,
 //! Draws a pixel
 void CBurningVideoDriver::drawPixel(u32 x, u32 y, const SColor & color)
 {
+	flushTileRasterizer();
 	BackBuffer->setPixel(x, y, color, true);
 }
 
@@ -2268,6 +2762,8 @@ void CBurningVideoDriver::drawPixel(u32 x, u32 y, const SColor & color)
 void CBurningVideoDriver::draw2DRectangle(SColor color, const core::rect<s32>& pos,
 									 const core::rect<s32>* clip)
 {
+	flushTileRasterizer();
+
 	if (clip)
 	{
 		core::rect<s32> p(pos);
@@ -2304,6 +2800,8 @@ void CBurningVideoDriver::OnResize(const core::dimension2d<u32>& size)
 
 	if (ScreenSize != realSize)
 	{
+		flushTileRasterizer();
+
 		if (ViewPort.getWidth() == (s32)ScreenSize.Width &&
 			ViewPort.getHeight() == (s32)ScreenSize.Height)
 		{
@@ -2475,6 +2973,9 @@ void CBurningVideoDriver::draw3DLine(const core::vector3df& start,
 	line = BurningShader [ ETR_TEXTURE_GOURAUD_WIRE ];
 	line->setRenderTarget(RenderTargetSurface, ViewPort);
 
+	// lines are drawn immediately
+	flushTileRasterizer();
+
 	// to DC Space, project homogenous vertex
 	ndc_2_dc_and_project ( CurrentOut.data + 1, CurrentOut.data, vOut );
 
@@ -2554,6 +3055,8 @@ ITexture* CBurningVideoDriver::addRenderTargetTexture(const core::dimension2d<u3
 //! Clears the DepthBuffer.
 void CBurningVideoDriver::clearZBuffer()
 {
+	flushTileRasterizer();
+
 	if (DepthBuffer)
 		DepthBuffer->clear();
 }
@@ -2565,6 +3068,8 @@ IImage* CBurningVideoDriver::createScreenShot(video::ECOLOR_FORMAT format, video
 	if (target != video::ERT_FRAME_BUFFER)
 		return 0;
 
+	flushTileRasterizer();
+
 	if (BackBuffer)
 	{
 		IImage* tmp = createImage(BackBuffer->getColorFormat(), BackBuffer->getDimension());
@@ -2588,6 +3093,14 @@ ITexture* CBurningVideoDriver::createDeviceDependentTexture(IImage* surface, con
 }
 
 
+//! replaces the content of a texture created by createDeviceDependentTexture
+bool CBurningVideoDriver::replaceTextureImage(ITexture* texture, IImage* image)
+{
+	static_cast<CSoftwareTexture2*>(texture)->replaceImage(image);
+	return true;
+}
+
+
 //! Returns the maximum amount of primitives (mostly vertices) which
 //! the device is able to render with one drawIndexedTriangleList
 //! call.
@@ -2665,6 +3178,9 @@ void CBurningVideoDriver::drawStencilShadow(bool clearStencilBuffer, video::SCol
 {
 	if (!StencilBuffer)
 		return;
+
+	flushTileRasterizer();
+
 	// draw a shadow rectangle covering the entire screen using stencil buffer
 	const u32 h = RenderTargetSurface->getDimension().Height;
 	const u32 w = RenderTargetSurface->getDimension().Width;
@@ -2707,10 +3223,11 @@ namespace video
 {
 
 //! creates a video driver
-IVideoDriver* createBurningVideoDriver(const irr::SIrrlichtCreationParameters& params, io::IFileSystem* io, video::IImagePresenter* presenter)
+IVideoDriver* createBurningVideoDriver(const irr::SIrrlichtCreationParameters& params, io::IFileSystem* io,
+		video::IImagePresenter* presenter, IJobSystem* jobSystem)
 {
 	#ifdef _IRR_COMPILE_WITH_BURNINGSVIDEO_
-	return new CBurningVideoDriver(params, io, presenter);
+	return new CBurningVideoDriver(params, io, presenter, jobSystem);
 	#else
 	return 0;
 	#endif // _IRR_COMPILE_WITH_BURNINGSVIDEO_
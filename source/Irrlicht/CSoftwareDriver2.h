@@ -15,14 +15,19 @@
 
 namespace irr
 {
+	class IJobSystem;
+
 namespace video
 {
+	class CBurningTileRasterizer;
+
 	class CBurningVideoDriver : public CNullDriver
 	{
 	public:
 
 		//! constructor
-		CBurningVideoDriver(const irr::SIrrlichtCreationParameters& params, io::IFileSystem* io, video::IImagePresenter* presenter);
+		CBurningVideoDriver(const irr::SIrrlichtCreationParameters& params, io::IFileSystem* io,
+			video::IImagePresenter* presenter, IJobSystem* jobSystem);
 
 		//! destructor
 		virtual ~CBurningVideoDriver();
@@ -179,6 +184,9 @@ namespace video
 		//! THIS METHOD HAS TO BE OVERRIDDEN BY DERIVED DRIVERS WITH OWN TEXTURES
 		virtual video::ITexture* createDeviceDependentTexture(IImage* surface, const io::path& name, void* mipmapData=0);
 
+		//! replaces the content of a texture created by createDeviceDependentTexture
+		virtual bool replaceTextureImage(ITexture* texture, IImage* image);
+
 		video::CImage* BackBuffer;
 		video::IImagePresenter* Presenter;
 
@@ -195,6 +203,15 @@ namespace video
 		IBurningShader* CurrentShader;
 		IBurningShader* BurningShader[ETR2_COUNT];
 
+		//! distributes the triangles to several threads, 0 if single threaded
+		CBurningTileRasterizer* TileRasterizer;
+
+		//! waits until all queued triangles are rasterized
+		void flushTileRasterizer();
+
+		//! rasterizes a projected triangle unless the coarse depth tiles hide it
+		void drawTriangle ( const s4DVertex *a, const s4DVertex *b, const s4DVertex *c );
+
 		IDepthBuffer* DepthBuffer;
 		IStencilBuffer* StencilBuffer;
 
@@ -242,6 +259,11 @@ namespace video
 		void VertexCache_getbypass ( s4DVertex ** face );
 
 		void VertexCache_fill ( const u32 sourceIndex,const u32 destIndex );
+		void VertexCache_fillBlock ( const u32 *sourceIndex, const u32 *destIndex, const u32 count );
+		void VertexCache_fillTexture ( s4DVertex *dest, const u8 *source );
+#ifdef SOFTWARE_DRIVER_2_SSE2
+		void VertexCache_fill4 ( const u32 *sourceIndex, const u32 *destIndex, const u32 count );
+#endif
 		s4DVertex * VertexCache_getVertex ( const u32 sourceIndex );
 
 
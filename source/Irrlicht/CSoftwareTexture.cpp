@@ -16,12 +16,33 @@ namespace video
 //! constructor
 CSoftwareTexture::CSoftwareTexture(IImage* image, const io::path& name,
 		bool renderTarget, void* mipmapData)
-: ITexture(name), Texture(0), IsRenderTarget(renderTarget)
+: ITexture(name), Image(0), Texture(0), IsRenderTarget(renderTarget)
 {
 	#ifdef _DEBUG
 	setDebugName("CSoftwareTexture");
 	#endif
 
+	setImage(image);
+}
+
+
+//! replaces the image of the texture
+void CSoftwareTexture::replaceImage(IImage* image)
+{
+	if (Image)
+		Image->drop();
+	if (Texture)
+		Texture->drop();
+	Image = 0;
+	Texture = 0;
+
+	setImage(image);
+}
+
+
+//! copies an image into the texture
+void CSoftwareTexture::setImage(IImage* image)
+{
 	if (image)
 	{
 		OrigSize = image->getDimension();
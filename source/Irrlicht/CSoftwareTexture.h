@@ -61,7 +61,14 @@ public:
 	//! is it a render target?
 	virtual bool isRenderTarget() const;
 
+	//! replaces the image of the texture
+	void replaceImage(IImage* image);
+
 private:
+
+	//! copies an image into the texture
+	void setImage(IImage* image);
+
 	CImage* Image;
 	CImage* Texture;
 	core::dimension2d<u32> OrigSize;
@@ -30,6 +30,39 @@ CSoftwareTexture2::CSoftwareTexture2(IImage* image, const io::path& name,
 
 	memset32 ( MipMap, 0, sizeof ( MipMap ) );
 
+	setImage(image, mipmapData);
+}
+
+
+//! destructor
+CSoftwareTexture2::~CSoftwareTexture2()
+{
+	for ( s32 i = 0; i!= SOFTWARE_DRIVER_2_MIPMAPPING_MAX; ++i )
+	{
+		if ( MipMap[i] )
+			MipMap[i]->drop();
+	}
+}
+
+
+//! replaces the image of the texture, keeps the flags
+void CSoftwareTexture2::replaceImage(IImage* image)
+{
+	for ( s32 i = 0; i!= SOFTWARE_DRIVER_2_MIPMAPPING_MAX; ++i )
+	{
+		if ( MipMap[i] )
+			MipMap[i]->drop();
+	}
+	memset32 ( MipMap, 0, sizeof ( MipMap ) );
+	MipMapLOD = 0;
+
+	setImage(image, 0);
+}
+
+
+//! creates the mip map levels from an image
+void CSoftwareTexture2::setImage(IImage* image, void* mipmapData)
+{
 	if (image)
 	{
 		OrigSize = image->getDimension();
@@ -54,7 +87,7 @@ CSoftwareTexture2::CSoftwareTexture2(IImage* image, const io::path& name,
 		else
 		{
 			char buf[256];
-			core::stringw showName ( name );
+			core::stringw showName ( getName().getPath() );
 			snprintf ( buf, 256, "Burningvideo: Warning Texture %ls reformat %dx%d -> %dx%d,%d",
 							showName.c_str(),
 							OrigSize.Width, OrigSize.Height, optSize.Width, optSize.Height,
@@ -74,17 +107,6 @@ CSoftwareTexture2::CSoftwareTexture2(IImage* image, const io::path& name,
 }
 
 
-//! destructor
-CSoftwareTexture2::~CSoftwareTexture2()
-{
-	for ( s32 i = 0; i!= SOFTWARE_DRIVER_2_MIPMAPPING_MAX; ++i )
-	{
-		if ( MipMap[i] )
-			MipMap[i]->drop();
-	}
-}
-
-
 //! Regenerates the mip map levels of the texture. Useful after locking and
 //! modifying the texture
 void CSoftwareTexture2::regenerateMipMapLevels(void* mipmapData)
@@ -32,6 +32,9 @@ public:
 	};
 	CSoftwareTexture2(IImage* surface, const io::path& name, u32 flags, void* mipmapData=0);
 
+	//! replaces the image of the texture, keeps the flags
+	void replaceImage(IImage* image);
+
 	//! destructor
 	virtual ~CSoftwareTexture2();
 
@@ -81,6 +84,16 @@ public:
 		return MipMap[MipMapLOD];
 	}
 
+	//! returns the mipmap surface lock() would select for a lod level.
+	/** Unlike lock() this doesn't change the current mipmap level, so it
+	can be called from several rasterizer threads at once. */
+	CImage* getMipMapSurface(s32 lodLevel) const
+	{
+		if (Flags & GEN_MIPMAP)
+			return MipMap[core::s32_clamp(lodLevel + SOFTWARE_DRIVER_2_MIPMAPPING_LOD_BIAS, 0, SOFTWARE_DRIVER_2_MIPMAPPING_MAX - 1)];
+		return MipMap[MipMapLOD];
+	}
+
 
 	//! returns driver type of texture (=the driver, who created the texture)
 	virtual E_DRIVER_TYPE getDriverType() const
@@ -123,6 +136,9 @@ public:
 	}
 
 private:
+	//! creates the mip map levels from an image
+	void setImage(IImage* image, void* mipmapData);
+
 	f32 OrigImageDataSizeInPixels;
 	core::dimension2d<u32> OrigSize;
 
@@ -106,7 +106,7 @@ const core::aabbox3d<f32>& CSphereSceneNode::getBoundingBox() const
 
 void CSphereSceneNode::OnRegisterSceneNode()
 {
-	if (IsVisible)
+	if (IsVisible && MeshVisible)
 		SceneManager->registerNodeForRendering(this);
 
 	ISceneNode::OnRegisterSceneNode();
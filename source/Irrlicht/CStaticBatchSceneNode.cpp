@@ -0,0 +1,370 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CStaticBatchSceneNode.h"
+#include "IVideoDriver.h"
+#include "ISceneManager.h"
+#include "ICameraSceneNode.h"
+#include "IMaterialRenderer.h"
+#include "CMeshBuffer.h"
+
+namespace irr
+{
+namespace scene
+{
+
+namespace
+{
+	//! a mesh buffer of a merged node
+	struct SBatchPiece
+	{
+		ISceneNode* Node;
+		const IMeshBuffer* MeshBuffer;
+		core::vector3df Center;
+	};
+
+	//! mesh buffers with equal material and vertex type
+	struct SBatchGroup
+	{
+		video::SMaterial Material;
+		video::E_VERTEX_TYPE VertexType;
+		core::array<u32> Pieces;
+	};
+
+	//! piece sorted by its center along one axis
+	struct SBatchSortEntry
+	{
+		f32 Key;
+		u32 Piece;
+
+		bool operator < (const SBatchSortEntry& other) const
+		{
+			return Key < other.Key;
+		}
+	};
+
+	void transformVertex(video::S3DVertex& v, const core::matrix4& m)
+	{
+		m.transformVect(v.Pos);
+		m.rotateVect(v.Normal);
+		v.Normal.normalize();
+	}
+
+	void transformVertex(video::S3DVertex2TCoords& v, const core::matrix4& m)
+	{
+		transformVertex((video::S3DVertex&)v, m);
+	}
+
+	void transformVertex(video::S3DVertexTangents& v, const core::matrix4& m)
+	{
+		transformVertex((video::S3DVertex&)v, m);
+		m.rotateVect(v.Tangent);
+		v.Tangent.normalize();
+		m.rotateVect(v.Binormal);
+		v.Binormal.normalize();
+	}
+
+	//! appends the pieces with world space vertices to a new chunk
+	template <class T>
+	IMeshBuffer* createChunk(const SBatchGroup& group, const core::array<SBatchPiece>& pieces,
+		const SBatchSortEntry* entries, u32 count)
+	{
+		CMeshBuffer<T>* chunk = new CMeshBuffer<T>();
+		chunk->Material = group.Material;
+
+		for (u32 i=0; i<count; ++i)
+		{
+			const SBatchPiece& piece = pieces[entries[i].Piece];
+			const IMeshBuffer* mb = piece.MeshBuffer;
+			const u32 first = chunk->getVertexCount();
+
+			chunk->append(mb->getVertices(), mb->getVertexCount(), mb->getIndices(), mb->getIndexCount());
+
+			const core::matrix4& m = piece.Node->getAbsoluteTransformation();
+			for (u32 v=first; v<chunk->Vertices.size(); ++v)
+				transformVertex(chunk->Vertices[v], m);
+		}
+
+		chunk->recalculateBoundingBox();
+		chunk->setHardwareMappingHint(EHM_STATIC);
+		return chunk;
+	}
+
+	//! splits a group at the median of the longest axis until the chunks are small enough
+	void splitGroup(SMesh* mesh, const SBatchGroup& group, const core::array<SBatchPiece>& pieces,
+		SBatchSortEntry* entries, u32 count, u32 maxChunkVertices)
+	{
+		u32 vertexCount = 0;
+		core::aabbox3d<f32> centers(pieces[entries[0].Piece].Center);
+		for (u32 i=0; i<count; ++i)
+		{
+			vertexCount += pieces[entries[i].Piece].MeshBuffer->getVertexCount();
+			centers.addInternalPoint(pieces[entries[i].Piece].Center);
+		}
+
+		if (vertexCount > maxChunkVertices && count > 1)
+		{
+			const core::vector3df extent = centers.getExtent();
+			const u32 axis = (extent.X >= extent.Y && extent.X >= extent.Z) ? 0 : (extent.Y >= extent.Z ? 1 : 2);
+
+			core::array<SBatchSortEntry> sorted;
+			sorted.set_used(count);
+			for (u32 i=0; i<count; ++i)
+			{
+				const core::vector3df& c = pieces[entries[i].Piece].Center;
+				sorted[i].Key = axis == 0 ? c.X : (axis == 1 ? c.Y : c.Z);
+				sorted[i].Piece = entries[i].Piece;
+			}
+			sorted.sort();
+
+			for (u32 i=0; i<count; ++i)
+				entries[i] = sorted[i];
+
+			const u32 half = count / 2;
+			splitGroup(mesh, group, pieces, entries, half, maxChunkVertices);
+			splitGroup(mesh, group, pieces, entries + half, count - half, maxChunkVertices);
+			return;
+		}
+
+		IMeshBuffer* chunk = 0;
+		switch (group.VertexType)
+		{
+		case video::EVT_STANDARD:
+			chunk = createChunk<video::S3DVertex>(group, pieces, entries, count);
+			break;
+		case video::EVT_2TCOORDS:
+			chunk = createChunk<video::S3DVertex2TCoords>(group, pieces, entries, count);
+			break;
+		case video::EVT_TANGENTS:
+			chunk = createChunk<video::S3DVertexTangents>(group, pieces, entries, count);
+			break;
+		}
+
+		mesh->addMeshBuffer(chunk);
+		chunk->drop();
+	}
+
+	//! collects the mesh buffers of all mesh scene nodes below node
+	void collectPieces(ISceneNode* node, core::array<SBatchPiece>& pieces,
+		core::array<SBatchGroup>& groups, core::array<ISceneNode*>& mergedNodes,
+		u32 maxChunkVertices)
+	{
+		if (!node->isVisible())
+			return;
+
+		node->updateAbsolutePosition();
+
+		const ESCENE_NODE_TYPE type = node->getType();
+		IMesh* mesh = (type == ESNT_MESH || type == ESNT_CUBE || type == ESNT_SPHERE) ?
+			static_cast<IMeshSceneNode*>(node)->getMesh() : 0;
+
+		// only merge nodes whose mesh buffers fit completely into chunks
+		bool merge = mesh && mesh->getMeshBufferCount();
+		for (u32 i=0; merge && i<mesh->getMeshBufferCount(); ++i)
+		{
+			const IMeshBuffer* mb = mesh->getMeshBuffer(i);
+			merge = mb && mb->getIndexType() == video::EIT_16BIT &&
+				mb->getVertexCount() <= maxChunkVertices;
+		}
+
+		if (merge)
+		{
+			for (u32 i=0; i<mesh->getMeshBufferCount(); ++i)
+			{
+				const IMeshBuffer* mb = mesh->getMeshBuffer(i);
+				if (!mb->getIndexCount())
+					continue;
+
+				const video::SMaterial& material = node->getMaterial(i);
+
+				u32 g = 0;
+				while (g < groups.size() &&
+					(groups[g].VertexType != mb->getVertexType() || groups[g].Material != material))
+					++g;
+
+				if (g == groups.size())
+				{
+					groups.push_back(SBatchGroup());
+					groups[g].Material = material;
+					groups[g].VertexType = mb->getVertexType();
+				}
+
+				SBatchPiece piece;
+				piece.Node = node;
+				piece.MeshBuffer = mb;
+
+				core::aabbox3d<f32> box = mb->getBoundingBox();
+				node->getAbsoluteTransformation().transformBoxEx(box);
+				piece.Center = box.getCenter();
+
+				groups[g].Pieces.push_back(pieces.size());
+				pieces.push_back(piece);
+			}
+
+			mergedNodes.push_back(node);
+		}
+
+		for (u32 i=0; i<node->getChildCount(); ++i)
+			collectPieces(node->getChild(i), pieces, groups, mergedNodes, maxChunkVertices);
+	}
+
+	//! hides the merged nodes of a subtree, returns true if all its nodes were merged
+	bool hideMergedSubtree(ISceneNode* node, core::array<ISceneNode*>& mergedNodes)
+	{
+		bool allMerged = true;
+		for (u32 i=0; i<node->getChildCount(); ++i)
+		{
+			if (!hideMergedSubtree(node->getChild(i), mergedNodes))
+				allMerged = false;
+		}
+
+		if (mergedNodes.binary_search(node) == -1)
+			return false;
+
+		// invisibility would hide the children which were not merged
+		if (allMerged)
+			node->setVisible(false);
+		else
+			static_cast<IMeshSceneNode*>(node)->setMeshVisible(false);
+		return allMerged;
+	}
+
+} // end anonymous namespace
+
+
+//! constructor
+CStaticBatchSceneNode::CStaticBatchSceneNode(IMesh* mesh, ISceneNode* parent, ISceneManager* mgr, s32 id)
+: CMeshSceneNode(mesh, parent, mgr, id)
+{
+	#ifdef _DEBUG
+	setDebugName("CStaticBatchSceneNode");
+	#endif
+}
+
+
+//! renders the visible chunks
+void CStaticBatchSceneNode::render()
+{
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+	const ICameraSceneNode* camera = SceneManager->getActiveCamera();
+	const u32 culling = AutomaticCullingState & (EAC_BOX | EAC_FRUSTUM_BOX | EAC_FRUSTUM_SPHERE);
+
+	// shadows and debug data need the full mesh
+	if (!Mesh || !driver || !camera || !culling || Shadow || DebugDataVisible)
+	{
+		CMeshSceneNode::render();
+		return;
+	}
+
+	++PassCount;
+
+	if (PassCount == 1)
+	{
+		Culler.begin(*camera->getViewFrustum());
+		for (u32 i=0; i<Mesh->getMeshBufferCount(); ++i)
+		{
+			const IMeshBuffer* mb = Mesh->getMeshBuffer(i);
+			Culler.add(mb ? mb->getBoundingBox() : Mesh->getBoundingBox(), AbsoluteTransformation, culling);
+		}
+		Culler.cull();
+	}
+
+	driver->setTransform(video::ETS_WORLD, AbsoluteTransformation);
+	Box = Mesh->getBoundingBox();
+
+	const bool isTransparentPass =
+		SceneManager->getSceneNodeRenderPass() == scene::ESNRP_TRANSPARENT;
+
+	for (u32 i=0; i<Mesh->getMeshBufferCount(); ++i)
+	{
+		IMeshBuffer* mb = Mesh->getMeshBuffer(i);
+		if (!mb || Culler.isCulled(i))
+			continue;
+
+		const video::SMaterial& material = ReadOnlyMaterials ? mb->getMaterial() : Materials[i];
+		video::IMaterialRenderer* rnd = driver->getMaterialRenderer(material.MaterialType);
+		const bool transparent = (rnd && rnd->isTransparent());
+
+		if (transparent == isTransparentPass)
+		{
+			driver->setMaterial(material);
+			driver->drawMeshBuffer(mb);
+		}
+	}
+}
+
+
+//! Creates a clone of this scene node and its children.
+ISceneNode* CStaticBatchSceneNode::clone(ISceneNode* newParent, ISceneManager* newManager)
+{
+	if (!newParent)
+		newParent = Parent;
+	if (!newManager)
+		newManager = SceneManager;
+
+	CStaticBatchSceneNode* nb = new CStaticBatchSceneNode(Mesh, newParent, newManager, ID);
+
+	nb->cloneMembers(this, newManager);
+	nb->ReadOnlyMaterials = ReadOnlyMaterials;
+	nb->Materials = Materials;
+
+	if (newParent)
+		nb->drop();
+	return nb;
+}
+
+
+//! merges the mesh scene nodes below a node into a mesh with world space vertices
+SMesh* CStaticBatchSceneNode::createBatchMesh(ISceneNode* root, u32 maxChunkVertices,
+	core::array<ISceneNode*>& mergedNodes)
+{
+	if (!root)
+		return 0;
+
+	maxChunkVertices = core::clamp(maxChunkVertices, 1u, 65535u);
+
+	core::array<SBatchPiece> pieces;
+	core::array<SBatchGroup> groups;
+	collectPieces(root, pieces, groups, mergedNodes, maxChunkVertices);
+
+	if (pieces.empty())
+		return 0;
+
+	SMesh* mesh = new SMesh();
+	core::array<SBatchSortEntry> entries;
+
+	for (u32 g=0; g<groups.size(); ++g)
+	{
+		const SBatchGroup& group = groups[g];
+
+		entries.set_used(group.Pieces.size());
+		for (u32 i=0; i<group.Pieces.size(); ++i)
+		{
+			entries[i].Key = 0.f;
+			entries[i].Piece = group.Pieces[i];
+		}
+
+		splitGroup(mesh, group, pieces, entries.pointer(), entries.size(), maxChunkVertices);
+	}
+
+	mesh->recalculateBoundingBox();
+	mesh->setHardwareMappingHint(EHM_STATIC);
+	return mesh;
+}
+
+
+//! stops the merged nodes below a node from drawing their meshes
+void CStaticBatchSceneNode::hideMergedNodes(ISceneNode* root, core::array<ISceneNode*>& mergedNodes)
+{
+	if (!root || mergedNodes.empty())
+		return;
+
+	mergedNodes.sort();
+	hideMergedSubtree(root, mergedNodes);
+}
+
+
+} // end namespace scene
+} // end namespace irr
+
@@ -0,0 +1,62 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_STATIC_BATCH_SCENE_NODE_H_INCLUDED__
+#define __C_STATIC_BATCH_SCENE_NODE_H_INCLUDED__
+
+#include "CMeshSceneNode.h"
+#include "CFrustumCuller.h"
+#include "SMesh.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! Mesh scene node drawing static geometry merged from many mesh scene nodes.
+	/** The mesh has one or more mesh buffers, called chunks, for each
+	material of the merged nodes. Its vertices are in world space. The
+	chunks are culled one by one before they are drawn. */
+	class CStaticBatchSceneNode : public CMeshSceneNode
+	{
+	public:
+
+		//! constructor
+		CStaticBatchSceneNode(IMesh* mesh, ISceneNode* parent, ISceneManager* mgr, s32 id);
+
+		//! renders the visible chunks
+		virtual void render();
+
+		//! Creates a clone of this scene node and its children.
+		virtual ISceneNode* clone(ISceneNode* newParent=0, ISceneManager* newManager=0);
+
+		//! merges the mesh scene nodes below a node into a mesh with world space vertices
+		/** Mesh buffers with equal materials and vertex types are merged.
+		Each such group is split along the longest axis of its mesh buffers
+		until a chunk has at most maxChunkVertices vertices.
+		\param root Root of the subtree to merge, it is merged as well.
+		\param maxChunkVertices Maximal vertex count of a chunk, at most 65535.
+		\param mergedNodes The merged nodes are appended to this array.
+		\return The new mesh, or 0 if no mesh buffer could be merged. */
+		static SMesh* createBatchMesh(ISceneNode* root, u32 maxChunkVertices,
+			core::array<ISceneNode*>& mergedNodes);
+
+		//! stops the merged nodes below a node from drawing their meshes
+		/** Merged nodes whose subtree was merged completely are made
+		invisible. The others stay visible for their children and only
+		stop drawing their own mesh.
+		\param root Root of the subtree passed to createBatchMesh().
+		\param mergedNodes The merged nodes, the array gets sorted. */
+		static void hideMergedNodes(ISceneNode* root, core::array<ISceneNode*>& mergedNodes);
+
+	private:
+
+		CFrustumCuller Culler;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
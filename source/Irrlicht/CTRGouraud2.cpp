@@ -85,6 +85,13 @@ public:
 	//! draws an indexed triangle list
 	virtual void drawTriangle ( const s4DVertex *a,const s4DVertex *b,const s4DVertex *c );
 
+#ifdef CMP_W
+	virtual bool hasDepthTest () const { return true; }
+#endif
+#if !defined ( WRITE_W ) && !defined ( WRITE_Z )
+	virtual bool hasDepthWrite () const { return false; }
+#endif
+
 
 private:
 	void scanline_bilinear ();
@@ -135,6 +142,10 @@ void CTRGouraud2::scanline_bilinear ()
 	sVec2 slopeT[BURNING_MATERIAL_MAX_TEXTURES];
 #endif
 
+	// scanline belongs to another tile
+	if ( !ownsScanline ( line.y ) )
+		return;
+
 	// apply top-left fill-convention, left
 	xStart = core::ceil32( line.x[0] );
 	xEnd = core::ceil32( line.x[1] ) - 1;
@@ -253,6 +264,11 @@ void CTRGouraud2::scanline_bilinear ()
 
 void CTRGouraud2::drawTriangle ( const s4DVertex *a,const s4DVertex *b,const s4DVertex *c )
 {
+#ifdef SOFTWARE_DRIVER_2_HALFSPACE
+	rasterizeHalfSpace ( a, b, c, line, (tScanLine) &CTRGouraud2::scanline_bilinear );
+	return;
+#endif
+
 	// sort on height, y
 	if ( a->Pos.y > b->Pos.y ) swapVertexPointer(&a, &b);
 	if ( a->Pos.y > c->Pos.y ) swapVertexPointer(&a, &c);
@@ -86,6 +86,13 @@ public:
 	//! draws an indexed triangle list
 	virtual void drawTriangle ( const s4DVertex *a,const s4DVertex *b,const s4DVertex *c );
 
+#ifdef CMP_W
+	virtual bool hasDepthTest () const { return true; }
+#endif
+#if !defined ( WRITE_W ) && !defined ( WRITE_Z )
+	virtual bool hasDepthWrite () const { return false; }
+#endif
+
 
 private:
 	void scanline_bilinear ();
@@ -141,6 +148,10 @@ void CTRGouraudAlpha2::scanline_bilinear ()
 	sVec2 slopeT[1];
 #endif
 
+	// scanline belongs to another tile
+	if ( !ownsScanline ( line.y ) )
+		return;
+
 	// apply top-left fill-convention, left
 	xStart = core::ceil32( line.x[0] );
 	xEnd = core::ceil32( line.x[1] ) - 1;
@@ -267,6 +278,11 @@ void CTRGouraudAlpha2::scanline_bilinear ()
 
 void CTRGouraudAlpha2::drawTriangle ( const s4DVertex *a,const s4DVertex *b,const s4DVertex *c )
 {
+#ifdef SOFTWARE_DRIVER_2_HALFSPACE
+	rasterizeHalfSpace ( a, b, c, line, (tScanLine) &CTRGouraudAlpha2::scanline_bilinear );
+	return;
+#endif
+
 	// sort on height, y
 	if ( F32_A_GREATER_B ( a->Pos.y , b->Pos.y ) ) swapVertexPointer(&a, &b);
 	if ( F32_A_GREATER_B ( b->Pos.y , c->Pos.y ) ) swapVertexPointer(&b, &c);
@@ -86,6 +86,10 @@ public:
 	//! draws an indexed triangle list
 	virtual void drawTriangle ( const s4DVertex *a,const s4DVertex *b,const s4DVertex *c );
 
+#if !defined ( WRITE_W ) && !defined ( WRITE_Z )
+	virtual bool hasDepthWrite () const { return false; }
+#endif
+
 
 private:
 	void scanline_bilinear ();
@@ -137,6 +141,10 @@ void CTRGouraudAlphaNoZ2::scanline_bilinear ()
 	sVec2 slopeT[BURNING_MATERIAL_MAX_TEXTURES];
 #endif
 
+	// scanline belongs to another tile
+	if ( !ownsScanline ( line.y ) )
+		return;
+
 	// apply top-left fill-convention, left
 	xStart = core::ceil32( line.x[0] );
 	xEnd = core::ceil32( line.x[1] ) - 1;
@@ -266,6 +274,11 @@ void CTRGouraudAlphaNoZ2::scanline_bilinear ()
 
 void CTRGouraudAlphaNoZ2::drawTriangle ( const s4DVertex *a,const s4DVertex *b,const s4DVertex *c )
 {
+#ifdef SOFTWARE_DRIVER_2_HALFSPACE
+	rasterizeHalfSpace ( a, b, c, line, (tScanLine) &CTRGouraudAlphaNoZ2::scanline_bilinear );
+	return;
+#endif
+
 	// sort on height, y
 	if ( F32_A_GREATER_B ( a->Pos.y , b->Pos.y ) ) swapVertexPointer(&a, &b);
 	if ( F32_A_GREATER_B ( b->Pos.y , c->Pos.y ) ) swapVertexPointer(&b, &c);
@@ -85,6 +85,10 @@ public:
 
 	//! draws an indexed triangle list
 	virtual void drawTriangle ( const s4DVertex *a,const s4DVertex *b,const s4DVertex *c );
+
+#if !defined ( WRITE_W ) && !defined ( WRITE_Z )
+	virtual bool hasDepthWrite () const { return false; }
+#endif
 	virtual void setParam ( u32 index, f32 value);
 
 private:
@@ -168,6 +172,10 @@ void CTRStencilShadow::fragment_zfail_decr ()
 	sVec3 slopeL[BURNING_MATERIAL_MAX_TANGENT];
 #endif
 
+	// scanline belongs to another tile
+	if ( !ownsScanline ( line.y ) )
+		return;
+
 	// apply top-left fill-convention, left
 	xStart = core::ceil32( line.x[0] );
 	xEnd = core::ceil32( line.x[1] ) - 1;
@@ -325,6 +333,10 @@ void CTRStencilShadow::fragment_zfail_incr()
 	sVec3 slopeL[BURNING_MATERIAL_MAX_TANGENT];
 #endif
 
+	// scanline belongs to another tile
+	if ( !ownsScanline ( line.y ) )
+		return;
+
 	// apply top-left fill-convention, left
 	xStart = core::ceil32( line.x[0] );
 	xEnd = core::ceil32( line.x[1] ) - 1;
@@ -441,6 +453,11 @@ void CTRStencilShadow::fragment_zfail_incr()
 
 void CTRStencilShadow::drawTriangle ( const s4DVertex *a,const s4DVertex *b,const s4DVertex *c )
 {
+#ifdef SOFTWARE_DRIVER_2_HALFSPACE
+	rasterizeHalfSpace ( a, b, c, line, (tScanLine) fragmentShader );
+	return;
+#endif
+
 	// sort on height, y
 	if ( F32_A_GREATER_B ( a->Pos.y , b->Pos.y ) ) swapVertexPointer(&a, &b);
 	if ( F32_A_GREATER_B ( b->Pos.y , c->Pos.y ) ) swapVertexPointer(&b, &c);
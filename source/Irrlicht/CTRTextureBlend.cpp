@@ -254,6 +254,10 @@ void CTRTextureBlend::fragment_dst_color_src_alpha ()
 	sVec2 slopeT[BURNING_MATERIAL_MAX_TEXTURES];
 #endif
 
+	// scanline belongs to another tile
+	if ( !ownsScanline ( line.y ) )
+		return;
+
 	// apply top-left fill-convention, left
 	xStart = core::ceil32( line.x[0] );
 	xEnd = core::ceil32( line.x[1] ) - 1;
@@ -438,6 +442,10 @@ void CTRTextureBlend::fragment_src_color_src_alpha ()
 	sVec2 slopeT[BURNING_MATERIAL_MAX_TEXTURES];
 #endif
 
+	// scanline belongs to another tile
+	if ( !ownsScanline ( line.y ) )
+		return;
+
 	// apply top-left fill-convention, left
 	xStart = core::ceil32( line.x[0] );
 	xEnd = core::ceil32( line.x[1] ) - 1;
@@ -618,6 +626,10 @@ void CTRTextureBlend::fragment_one_one_minus_src_alpha()
 	sVec2 slopeT[BURNING_MATERIAL_MAX_TEXTURES];
 #endif
 
+	// scanline belongs to another tile
+	if ( !ownsScanline ( line.y ) )
+		return;
+
 	// apply top-left fill-convention, left
 	xStart = core::ceil32( line.x[0] );
 	xEnd = core::ceil32( line.x[1] ) - 1;
@@ -815,6 +827,10 @@ void CTRTextureBlend::fragment_one_minus_dst_alpha_one ()
 	sVec2 slopeT[BURNING_MATERIAL_MAX_TEXTURES];
 #endif
 
+	// scanline belongs to another tile
+	if ( !ownsScanline ( line.y ) )
+		return;
+
 	// apply top-left fill-convention, left
 	xStart = core::ceil32( line.x[0] );
 	xEnd = core::ceil32( line.x[1] ) - 1;
@@ -1011,6 +1027,10 @@ void CTRTextureBlend::fragment_src_alpha_one ()
 	sVec2 slopeT[BURNING_MATERIAL_MAX_TEXTURES];
 #endif
 
+	// scanline belongs to another tile
+	if ( !ownsScanline ( line.y ) )
+		return;
+
 	// apply top-left fill-convention, left
 	xStart = core::ceil32( line.x[0] );
 	xEnd = core::ceil32( line.x[1] ) - 1;
@@ -1238,6 +1258,10 @@ void CTRTextureBlend::fragment_dst_color_one_minus_dst_alpha ()
 	sVec2 slopeT[BURNING_MATERIAL_MAX_TEXTURES];
 #endif
 
+	// scanline belongs to another tile
+	if ( !ownsScanline ( line.y ) )
+		return;
+
 	// apply top-left fill-convention, left
 	xStart = core::ceil32( line.x[0] );
 	xEnd = core::ceil32( line.x[1] ) - 1;
@@ -1434,6 +1458,10 @@ void CTRTextureBlend::fragment_dst_color_zero ()
 	sVec2 slopeT[BURNING_MATERIAL_MAX_TEXTURES];
 #endif
 
+	// scanline belongs to another tile
+	if ( !ownsScanline ( line.y ) )
+		return;
+
 	// apply top-left fill-convention, left
 	xStart = core::ceil32( line.x[0] );
 	xEnd = core::ceil32( line.x[1] ) - 1;
@@ -1628,6 +1656,10 @@ void CTRTextureBlend::fragment_dst_color_one ()
 	sVec2 slopeT[BURNING_MATERIAL_MAX_TEXTURES];
 #endif
 
+	// scanline belongs to another tile
+	if ( !ownsScanline ( line.y ) )
+		return;
+
 	// apply top-left fill-convention, left
 	xStart = core::ceil32( line.x[0] );
 	xEnd = core::ceil32( line.x[1] ) - 1;
@@ -1825,6 +1857,10 @@ void CTRTextureBlend::fragment_zero_one_minus_scr_color ()
 	sVec2 slopeT[BURNING_MATERIAL_MAX_TEXTURES];
 #endif
 
+	// scanline belongs to another tile
+	if ( !ownsScanline ( line.y ) )
+		return;
+
 	// apply top-left fill-convention, left
 	xStart = core::ceil32( line.x[0] );
 	xEnd = core::ceil32( line.x[1] ) - 1;
@@ -1995,6 +2031,11 @@ void CTRTextureBlend::drawTriangle ( const s4DVertex *a,const s4DVertex *b,const
 	if ( 0 == fragmentShader )
 		return;
 
+#ifdef SOFTWARE_DRIVER_2_HALFSPACE
+	rasterizeHalfSpace ( a, b, c, line, (tScanLine) fragmentShader );
+	return;
+#endif
+
 	// sort on height, y
 	if ( F32_A_GREATER_B ( a->Pos.y , b->Pos.y ) ) swapVertexPointer(&a, &b);
 	if ( F32_A_GREATER_B ( b->Pos.y , c->Pos.y ) ) swapVertexPointer(&b, &c);
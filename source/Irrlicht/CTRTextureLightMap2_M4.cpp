@@ -84,6 +84,13 @@ public:
 	//! draws an indexed triangle list
 	virtual void drawTriangle ( const s4DVertex *a,const s4DVertex *b,const s4DVertex *c );
 
+#ifdef CMP_W
+	virtual bool hasDepthTest () const { return true; }
+#endif
+#if !defined ( WRITE_W ) && !defined ( WRITE_Z )
+	virtual bool hasDepthWrite () const { return false; }
+#endif
+
 
 private:
 
@@ -114,6 +121,10 @@ REALINLINE void CTRTextureLightMap2_M4::scanline_bilinear2_mag ()
 	tVideoSample *dst;
 	fp24 *z;
 
+	// scanline belongs to another tile
+	if ( !ownsScanline ( line.y ) )
+		return;
+
 	// apply top-left fill-convention, left
 	const s32 xStart = irr::core::ceil32( line.x[0] );
 	const s32 xEnd = irr::core::ceil32( line.x[1] ) - 1;
@@ -262,6 +273,10 @@ REALINLINE void CTRTextureLightMap2_M4::scanline_bilinear2_min ()
 	s32 i;
 
 
+	// scanline belongs to another tile
+	if ( !ownsScanline ( line.y ) )
+		return;
+
 	// apply top-left fill-convention, left
 	xStart = core::ceil32( line.x[0] );
 	xEnd = core::ceil32( line.x[1] ) - 1;
@@ -387,6 +402,11 @@ void CTRTextureLightMap2_M4::drawTriangle ( const s4DVertex *a,const s4DVertex *
 
 void CTRTextureLightMap2_M4::drawTriangle_Min ( const s4DVertex *a,const s4DVertex *b,const s4DVertex *c )
 {
+#ifdef SOFTWARE_DRIVER_2_HALFSPACE
+	rasterizeHalfSpace ( a, b, c, line, (tScanLine) &CTRTextureLightMap2_M4::scanline_bilinear2_min );
+	return;
+#endif
+
 	sScanConvertData scan;
 
 	// sort on height, y
@@ -760,6 +780,11 @@ void CTRTextureLightMap2_M4::drawTriangle ( const s4DVertex *a,const s4DVertex *
 #endif
 
 {
+#ifdef SOFTWARE_DRIVER_2_HALFSPACE
+	rasterizeHalfSpace ( a, b, c, line, (tScanLine) &CTRTextureLightMap2_M4::scanline_bilinear2_mag );
+	return;
+#endif
+
 	sScanConvertData scan;
 
 	// sort on height, y
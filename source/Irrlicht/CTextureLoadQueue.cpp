@@ -0,0 +1,245 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CTextureLoadQueue.h"
+#include "IImageLoader.h"
+#include "IImage.h"
+#include "IReadFile.h"
+#include "os.h"
+#include "CProfiler.h"
+
+namespace irr
+{
+namespace video
+{
+
+//! constructor, starts the workers
+CTextureLoadQueue::CTextureLoadQueue(u32 threadCount)
+: Workers(0), WorkerCount(0), Quit(false)
+{
+	if (!threadCount)
+		threadCount = 1;
+
+	Workers = new CThread[threadCount];
+	for (; WorkerCount<threadCount; ++WorkerCount)
+	{
+		if (!Workers[WorkerCount].start(workerMain, this))
+			break;
+	}
+
+	if (!WorkerCount)
+		os::Printer::log("Could not start the texture loading threads.", ELL_ERROR);
+}
+
+
+//! destructor, waits for the running jobs and drops all results
+CTextureLoadQueue::~CTextureLoadQueue()
+{
+	Mutex.lock();
+	Quit = true;
+	Wake.broadcast();
+	Mutex.unlock();
+
+	delete [] Workers;
+
+	for (u32 i=0; i<Jobs.size(); ++i)
+		deleteJob(Jobs[i]);
+}
+
+
+//! adds a job decoding a file for a texture
+void CTextureLoadQueue::add(ITexture* texture, io::IReadFile* file, const core::array<IImageLoader*>& loaders)
+{
+	SJob* job = new SJob;
+	job->Texture = texture;
+	job->File = file;
+	job->File->grab();
+	job->Loaders = loaders;
+	job->Image = 0;
+	job->State = EJS_QUEUED;
+
+	CMutexLock lock(Mutex);
+	Jobs.push_back(job);
+	Wake.signal();
+}
+
+
+//! takes the oldest finished job
+bool CTextureLoadQueue::getFinished(ITexture*& texture, IImage*& image)
+{
+	CMutexLock lock(Mutex);
+	for (u32 i=0; i<Jobs.size(); )
+	{
+		SJob* job = Jobs[i];
+		if (job->State == EJS_DISCARDED)
+		{
+			Jobs.erase(i);
+			deleteJob(job);
+			continue;
+		}
+		if (job->State != EJS_DONE)
+		{
+			++i;
+			continue;
+		}
+
+		texture = job->Texture;
+		image = job->Image;
+		job->Image = 0;
+		Jobs.erase(i);
+		deleteJob(job);
+		return true;
+	}
+	return false;
+}
+
+
+//! removes all jobs of a texture
+void CTextureLoadQueue::cancel(ITexture* texture)
+{
+	CMutexLock lock(Mutex);
+	for (u32 i=0; i<Jobs.size(); )
+	{
+		SJob* job = Jobs[i];
+		if (job->Texture != texture)
+		{
+			++i;
+		}
+		else if (job->State == EJS_DECODING)
+		{
+			// getFinished deletes it when the worker is done
+			job->State = EJS_CANCELLED;
+			job->Texture = 0;
+			++i;
+		}
+		else if (job->State != EJS_CANCELLED)
+		{
+			Jobs.erase(i);
+			deleteJob(job);
+		}
+		else
+			++i;
+	}
+}
+
+
+//! removes all jobs
+void CTextureLoadQueue::cancelAll()
+{
+	CMutexLock lock(Mutex);
+	u32 kept = 0;
+	for (u32 i=0; i<Jobs.size(); ++i)
+	{
+		SJob* job = Jobs[i];
+		if (job->State == EJS_DECODING || job->State == EJS_CANCELLED)
+		{
+			job->State = EJS_CANCELLED;
+			job->Texture = 0;
+			Jobs[kept++] = job;
+		}
+		else
+			deleteJob(job);
+	}
+	Jobs.set_used(kept);
+}
+
+
+//! returns the number of jobs which were not taken with getFinished
+u32 CTextureLoadQueue::getPendingCount() const
+{
+	CMutexLock lock(Mutex);
+	u32 count = 0;
+	for (u32 i=0; i<Jobs.size(); ++i)
+	{
+		if (Jobs[i]->State != EJS_CANCELLED && Jobs[i]->State != EJS_DISCARDED)
+			++count;
+	}
+	return count;
+}
+
+
+//! entry point of the workers
+void CTextureLoadQueue::workerMain(void* data)
+{
+	((CTextureLoadQueue*)data)->workerLoop();
+}
+
+
+//! decodes queued jobs until the queue is destroyed
+void CTextureLoadQueue::workerLoop()
+{
+	Mutex.lock();
+	for (;;)
+	{
+		SJob* job = 0;
+		while (!Quit)
+		{
+			for (u32 i=0; i<Jobs.size(); ++i)
+			{
+				if (Jobs[i]->State == EJS_QUEUED)
+				{
+					job = Jobs[i];
+					break;
+				}
+			}
+			if (job)
+				break;
+			Wake.wait(Mutex);
+		}
+		if (Quit)
+			break;
+
+		job->State = EJS_DECODING;
+		Mutex.unlock();
+
+		IImage* image = 0;
+		{
+			_IRR_PROFILE("getTexture: decode");
+
+			// same order as CNullDriver::createImageFromFile, first by
+			// extension, then by content
+			io::IReadFile* file = job->File;
+			s32 i;
+			for (i=job->Loaders.size()-1; i>=0 && !image; --i)
+			{
+				if (job->Loaders[i]->isALoadableFileExtension(file->getFileName()))
+				{
+					file->seek(0);
+					image = job->Loaders[i]->loadImage(file);
+				}
+			}
+			for (i=job->Loaders.size()-1; i>=0 && !image; --i)
+			{
+				file->seek(0);
+				if (job->Loaders[i]->isALoadableFileFormat(file))
+				{
+					file->seek(0);
+					image = job->Loaders[i]->loadImage(file);
+				}
+			}
+		}
+
+		// the file may share its archive with the main thread, so
+		// cancelled jobs are deleted there as well
+		Mutex.lock();
+		job->Image = image;
+		job->State = (job->State == EJS_CANCELLED) ? EJS_DISCARDED : EJS_DONE;
+	}
+	Mutex.unlock();
+}
+
+
+//! frees a job which no worker uses
+void CTextureLoadQueue::deleteJob(SJob* job)
+{
+	if (job->Image)
+		job->Image->drop();
+	job->File->drop();
+	delete job;
+}
+
+
+} // end namespace video
+} // end namespace irr
+
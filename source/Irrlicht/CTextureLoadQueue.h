@@ -0,0 +1,107 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_TEXTURE_LOAD_QUEUE_H_INCLUDED__
+#define __C_TEXTURE_LOAD_QUEUE_H_INCLUDED__
+
+#include "CThread.h"
+#include "irrArray.h"
+
+namespace irr
+{
+namespace io
+{
+	class IReadFile;
+} // end namespace io
+namespace video
+{
+	class ITexture;
+	class IImage;
+	class IImageLoader;
+
+	//! Decodes images on worker threads for IVideoDriver::getTextureAsync.
+	/** The image loaders only read the file they get, so any number of
+	them can run at once. The queue does not grab the textures, the driver
+	has to cancel the jobs of textures it removes. */
+	class CTextureLoadQueue
+	{
+	public:
+
+		//! constructor, starts the workers
+		CTextureLoadQueue(u32 threadCount);
+
+		//! destructor, waits for the running jobs and drops all results
+		~CTextureLoadQueue();
+
+		//! adds a job decoding a file for a texture
+		/** \param texture Texture which receives the image.
+		\param file File to decode, the queue grabs it.
+		\param loaders Image loaders to try, in reverse order. The loaders
+		must stay alive until the queue is destroyed. */
+		void add(ITexture* texture, io::IReadFile* file, const core::array<IImageLoader*>& loaders);
+
+		//! takes the oldest finished job
+		/** \param texture Receives the texture of the job.
+		\param image Receives the decoded image, which the caller has to
+		drop, or 0 if the file could not be decoded.
+		\return false if no job is finished. */
+		bool getFinished(ITexture*& texture, IImage*& image);
+
+		//! removes all jobs of a texture
+		void cancel(ITexture* texture);
+
+		//! removes all jobs
+		void cancelAll();
+
+		//! returns the number of jobs which were not taken with getFinished
+		u32 getPendingCount() const;
+
+		//! returns false if no worker could be started
+		bool hasWorkers() const { return WorkerCount != 0; }
+
+	private:
+
+		enum E_JOB_STATE
+		{
+			EJS_QUEUED,
+			EJS_DECODING,
+			EJS_DONE,
+			EJS_CANCELLED,
+			//! cancelled while decoding, deleted on the main thread
+			EJS_DISCARDED
+		};
+
+		struct SJob
+		{
+			ITexture* Texture;
+			io::IReadFile* File;
+			core::array<IImageLoader*> Loaders;
+			IImage* Image;
+			E_JOB_STATE State;
+		};
+
+		//! entry point of the workers
+		static void workerMain(void* data);
+
+		//! decodes queued jobs until the queue is destroyed
+		void workerLoop();
+
+		//! frees a job which no worker uses
+		static void deleteJob(SJob* job);
+
+		//! jobs in the order they were added
+		core::array<SJob*> Jobs;
+
+		mutable CMutex Mutex;
+		CCondition Wake;
+		CThread* Workers;
+		u32 WorkerCount;
+		bool Quit;
+	};
+
+} // end namespace video
+} // end namespace irr
+
+#endif
+
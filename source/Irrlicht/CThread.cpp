@@ -0,0 +1,323 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CThread.h"
+
+#if defined(_IRR_WINDOWS_API_)
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <pthread.h>
+	#include <unistd.h>
+#endif
+
+namespace irr
+{
+
+#if defined(_IRR_WINDOWS_API_)
+
+CMutex::CMutex(bool recursive)
+{
+	CRITICAL_SECTION* cs = new CRITICAL_SECTION;
+	InitializeCriticalSection(cs);
+	Handle = cs;
+}
+
+CMutex::~CMutex()
+{
+	DeleteCriticalSection((CRITICAL_SECTION*)Handle);
+	delete (CRITICAL_SECTION*)Handle;
+}
+
+void CMutex::lock()
+{
+	EnterCriticalSection((CRITICAL_SECTION*)Handle);
+}
+
+void CMutex::unlock()
+{
+	LeaveCriticalSection((CRITICAL_SECTION*)Handle);
+}
+
+bool CMutex::tryLock()
+{
+	return TryEnterCriticalSection((CRITICAL_SECTION*)Handle) != 0;
+}
+
+
+#if (_WIN32_WINNT >= 0x0600) && !defined(_IRR_WINDOWS_CE_PLATFORM_)
+
+CCondition::CCondition()
+{
+	CONDITION_VARIABLE* cv = new CONDITION_VARIABLE;
+	InitializeConditionVariable(cv);
+	Handle = cv;
+}
+
+CCondition::~CCondition()
+{
+	delete (CONDITION_VARIABLE*)Handle;
+}
+
+void CCondition::wait(CMutex& mutex)
+{
+	SleepConditionVariableCS((CONDITION_VARIABLE*)Handle, (CRITICAL_SECTION*)mutex.Handle, INFINITE);
+}
+
+void CCondition::signal()
+{
+	WakeConditionVariable((CONDITION_VARIABLE*)Handle);
+}
+
+void CCondition::broadcast()
+{
+	WakeAllConditionVariable((CONDITION_VARIABLE*)Handle);
+}
+
+#else
+
+// Condition variables need Windows Vista and are missing on Windows CE.
+// Count the waiters and wake them through a semaphore instead. A thread
+// starting to wait after a signal may take the wake up of an earlier one,
+// which is fine as all waits check their condition in a loop.
+struct SSemaphoreCondition
+{
+	CRITICAL_SECTION Lock;
+	HANDLE Semaphore;
+	LONG Waiters;
+};
+
+CCondition::CCondition()
+{
+	SSemaphoreCondition* c = new SSemaphoreCondition;
+	InitializeCriticalSection(&c->Lock);
+	c->Semaphore = CreateSemaphore(NULL, 0, 0x7fffffff, NULL);
+	c->Waiters = 0;
+	Handle = c;
+}
+
+CCondition::~CCondition()
+{
+	SSemaphoreCondition* c = (SSemaphoreCondition*)Handle;
+	CloseHandle(c->Semaphore);
+	DeleteCriticalSection(&c->Lock);
+	delete c;
+}
+
+void CCondition::wait(CMutex& mutex)
+{
+	SSemaphoreCondition* c = (SSemaphoreCondition*)Handle;
+	EnterCriticalSection(&c->Lock);
+	++c->Waiters;
+	LeaveCriticalSection(&c->Lock);
+
+	mutex.unlock();
+	WaitForSingleObject(c->Semaphore, INFINITE);
+	mutex.lock();
+}
+
+void CCondition::signal()
+{
+	SSemaphoreCondition* c = (SSemaphoreCondition*)Handle;
+	EnterCriticalSection(&c->Lock);
+	if (c->Waiters)
+	{
+		--c->Waiters;
+		ReleaseSemaphore(c->Semaphore, 1, NULL);
+	}
+	LeaveCriticalSection(&c->Lock);
+}
+
+void CCondition::broadcast()
+{
+	SSemaphoreCondition* c = (SSemaphoreCondition*)Handle;
+	EnterCriticalSection(&c->Lock);
+	if (c->Waiters)
+	{
+		ReleaseSemaphore(c->Semaphore, c->Waiters, NULL);
+		c->Waiters = 0;
+	}
+	LeaveCriticalSection(&c->Lock);
+}
+
+#endif
+
+#else
+
+CMutex::CMutex(bool recursive)
+{
+	pthread_mutex_t* m = new pthread_mutex_t;
+	if (recursive)
+	{
+		pthread_mutexattr_t attr;
+		pthread_mutexattr_init(&attr);
+		pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+		pthread_mutex_init(m, &attr);
+		pthread_mutexattr_destroy(&attr);
+	}
+	else
+		pthread_mutex_init(m, 0);
+	Handle = m;
+}
+
+CMutex::~CMutex()
+{
+	pthread_mutex_destroy((pthread_mutex_t*)Handle);
+	delete (pthread_mutex_t*)Handle;
+}
+
+void CMutex::lock()
+{
+	pthread_mutex_lock((pthread_mutex_t*)Handle);
+}
+
+void CMutex::unlock()
+{
+	pthread_mutex_unlock((pthread_mutex_t*)Handle);
+}
+
+bool CMutex::tryLock()
+{
+	return pthread_mutex_trylock((pthread_mutex_t*)Handle) == 0;
+}
+
+
+CCondition::CCondition()
+{
+	pthread_cond_t* c = new pthread_cond_t;
+	pthread_cond_init(c, 0);
+	Handle = c;
+}
+
+CCondition::~CCondition()
+{
+	pthread_cond_destroy((pthread_cond_t*)Handle);
+	delete (pthread_cond_t*)Handle;
+}
+
+void CCondition::wait(CMutex& mutex)
+{
+	pthread_cond_wait((pthread_cond_t*)Handle, (pthread_mutex_t*)mutex.Handle);
+}
+
+void CCondition::signal()
+{
+	pthread_cond_signal((pthread_cond_t*)Handle);
+}
+
+void CCondition::broadcast()
+{
+	pthread_cond_broadcast((pthread_cond_t*)Handle);
+}
+
+#endif
+
+
+//! entry point of the threads, keeps the platform types out of the header
+struct SThreadEntry
+{
+#if defined(_IRR_WINDOWS_API_)
+	static unsigned long __stdcall run(void* data)
+#else
+	static void* run(void* data)
+#endif
+	{
+		CThread* thread = (CThread*)data;
+		thread->Function(thread->UserData);
+		return 0;
+	}
+};
+
+
+CThread::CThread()
+: Handle(0), Function(0), UserData(0)
+{
+}
+
+
+CThread::~CThread()
+{
+	join();
+}
+
+
+bool CThread::start(ThreadFunction func, void* userData)
+{
+	if (Handle)
+		return false;
+
+	Function = func;
+	UserData = userData;
+
+#if defined(_IRR_WINDOWS_API_)
+	HANDLE thread = CreateThread(NULL, 0, SThreadEntry::run, this, 0, NULL);
+	if (!thread)
+		return false;
+	Handle = thread;
+#else
+	pthread_t* thread = new pthread_t;
+	if (pthread_create(thread, 0, SThreadEntry::run, this))
+	{
+		delete thread;
+		return false;
+	}
+	Handle = thread;
+#endif
+	return true;
+}
+
+
+void CThread::join()
+{
+	if (!Handle)
+		return;
+
+#if defined(_IRR_WINDOWS_API_)
+	WaitForSingleObject((HANDLE)Handle, INFINITE);
+	CloseHandle((HANDLE)Handle);
+#else
+	pthread_join(*(pthread_t*)Handle, 0);
+	delete (pthread_t*)Handle;
+#endif
+	Handle = 0;
+}
+
+
+size_t CThread::getCurrentId()
+{
+#if defined(_IRR_WINDOWS_API_)
+	return (size_t)GetCurrentThreadId();
+#else
+	return (size_t)pthread_self();
+#endif
+}
+
+
+void CThread::sleep(u32 milliseconds)
+{
+#if defined(_IRR_WINDOWS_API_)
+	Sleep(milliseconds);
+#else
+	usleep(milliseconds * 1000);
+#endif
+}
+
+
+u32 CThread::getProcessorCount()
+{
+#if defined(_IRR_WINDOWS_API_)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors ? (u32)info.dwNumberOfProcessors : 1;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (u32)count : 1;
+#else
+	return 1;
+#endif
+}
+
+
+} // end namespace irr
+
@@ -0,0 +1,136 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef __C_THREAD_H_INCLUDED__
+#define __C_THREAD_H_INCLUDED__
+
+#include "irrTypes.h"
+
+namespace irr
+{
+
+	//! Mutex for the engine internal threads.
+	class CMutex
+	{
+	public:
+
+		//! constructor
+		/** \param recursive The thread holding the mutex may lock it
+		again, it has to unlock it as often. Critical sections on Windows
+		are always recursive. */
+		CMutex(bool recursive=false);
+		~CMutex();
+
+		void lock();
+		void unlock();
+
+		//! locks the mutex if no other thread holds it
+		/** \return true if the mutex was locked. */
+		bool tryLock();
+
+	private:
+
+		friend class CCondition;
+
+		// not copyable
+		CMutex(const CMutex&);
+		CMutex& operator=(const CMutex&);
+
+		void* Handle;
+	};
+
+
+	//! Locks a mutex for the lifetime of the object.
+	class CMutexLock
+	{
+	public:
+
+		CMutexLock(CMutex& mutex) : Mutex(mutex) { Mutex.lock(); }
+		~CMutexLock() { Mutex.unlock(); }
+
+	private:
+
+		CMutexLock(const CMutexLock&);
+		CMutexLock& operator=(const CMutexLock&);
+
+		CMutex& Mutex;
+	};
+
+
+	//! Condition variable to wait on together with a CMutex.
+	class CCondition
+	{
+	public:
+
+		CCondition();
+		~CCondition();
+
+		//! unlocks the mutex, waits for a signal and locks it again
+		/** Spurious wake ups are possible, so always wait in a loop which
+		checks the actual condition. */
+		void wait(CMutex& mutex);
+
+		//! wakes one waiting thread
+		void signal();
+
+		//! wakes all waiting threads
+		void broadcast();
+
+	private:
+
+		CCondition(const CCondition&);
+		CCondition& operator=(const CCondition&);
+
+		void* Handle;
+	};
+
+
+	//! A thread running one function.
+	class CThread
+	{
+	public:
+
+		typedef void (*ThreadFunction)(void* userData);
+
+		CThread();
+
+		//! joins the thread if it was started
+		~CThread();
+
+		//! starts the thread
+		/** \return false if the thread could not be created. */
+		bool start(ThreadFunction func, void* userData);
+
+		//! waits until the thread function returned
+		void join();
+
+		//! returns true if start was called without join
+		bool isStarted() const { return Handle != 0; }
+
+		//! returns an id of the calling thread
+		/** Only useful to compare it with the id of another thread. */
+		static size_t getCurrentId();
+
+		//! suspends the calling thread for some milliseconds
+		static void sleep(u32 milliseconds);
+
+		//! returns the number of processors which are online, at least 1
+		static u32 getProcessorCount();
+
+	private:
+
+		friend struct SThreadEntry;
+
+		CThread(const CThread&);
+		CThread& operator=(const CThread&);
+
+		void* Handle;
+		ThreadFunction Function;
+		void* UserData;
+	};
+
+} // end namespace irr
+
+#endif
+
@@ -15,6 +15,7 @@ extern "C" void bz_internal_error(int errorCode)
 #ifdef __IRR_COMPILE_WITH_ZIP_ARCHIVE_LOADER_
 
 #include "CFileList.h"
+#include "CLimitReadFile.h"
 #include "CReadFile.h"
 #include "coreutil.h"
 
@@ -138,7 +139,7 @@ bool CArchiveLoaderZIP::isALoadableFileFormat(io::IReadFile* file) const
 // -----------------------------------------------------------------------------
 
 CZipReader::CZipReader(IReadFile* file, bool ignoreCase, bool ignorePaths, bool isGZip)
- : CFileList((file ? file->getFileName() : io::path("")), ignoreCase, ignorePaths), File(file), IsGZip(isGZip)
+ : CFileList((file ? file->getFileName() : io::path("")), ignoreCase, ignorePaths), File(file), FileMutex(0), IsGZip(isGZip)
 {
 	#ifdef _DEBUG
 	setDebugName("CZipReader");
@@ -147,6 +148,7 @@ CZipReader::CZipReader(IReadFile* file, bool ignoreCase, bool ignorePaths, bool
 	if (File)
 	{
 		File->grab();
+		FileMutex = grabSharedFileMutex(File);
 
 		// load file entries
 		if (IsGZip)
@@ -161,7 +163,10 @@ CZipReader::CZipReader(IReadFile* file, bool ignoreCase, bool ignorePaths, bool
 CZipReader::~CZipReader()
 {
 	if (File)
+	{
+		dropSharedFileMutex(File);
 		File->drop();
+	}
 }
 
 
@@ -498,6 +503,456 @@ namespace
 }
 #endif
 
+
+// -----------------------------------------------------------------------------
+// streamed zip entries
+// -----------------------------------------------------------------------------
+
+namespace
+{
+	// compressed bytes read from the archive at once
+	const u32 ZIP_STREAM_INPUT_SIZE = 32768;
+}
+
+//! constructor
+CZipStreamReadFile::CZipStreamReadFile(IReadFile* source, long offset, long compressedSize,
+		long uncompressedSize, E_METHOD method, const io::path& name)
+: Filename(name), Source(source), SourceMutex(0), SourceStart(offset), SourceSize(compressedSize),
+	SourcePos(0), Size(uncompressedSize), Pos(0), Method(method), Stream(0),
+	Input(0), InputNext(0), InputAvail(0), Finished(false), CheckpointInterval(0)
+{
+	#ifdef _DEBUG
+	setDebugName("CZipStreamReadFile");
+	#endif
+
+	Source->grab();
+	SourceMutex = grabSharedFileMutex(Source);
+	Input = new u8[ZIP_STREAM_INPUT_SIZE];
+	Stream = createStream();
+
+	// spread the checkpoints over the file, but not too close together
+	if (Method == EM_DEFLATE)
+		CheckpointInterval = core::max_(Size / (long)ZIP_STREAM_CHECKPOINTS, (long)ZIP_STREAM_MIN_SIZE / 4);
+}
+
+
+//! destructor
+CZipStreamReadFile::~CZipStreamReadFile()
+{
+	for (u32 i=0; i<Checkpoints.size(); ++i)
+		deleteStream(Checkpoints[i].Stream);
+
+	deleteStream(Stream);
+	delete [] Input;
+	dropSharedFileMutex(Source);
+	Source->drop();
+}
+
+
+void* CZipStreamReadFile::createStream()
+{
+	switch (Method)
+	{
+	case EM_DEFLATE:
+		#ifdef _IRR_COMPILE_WITH_ZLIB_
+		{
+			z_stream* stream = new z_stream;
+			memset(stream, 0, sizeof(z_stream));
+
+			// wbits < 0 indicates no zlib header inside the data.
+			if (inflateInit2(stream, -MAX_WBITS) == Z_OK)
+				return stream;
+			delete stream;
+		}
+		#endif
+		break;
+	case EM_BZIP2:
+		#ifdef _IRR_COMPILE_WITH_BZIP2_
+		{
+			bz_stream* stream = new bz_stream;
+			memset(stream, 0, sizeof(bz_stream));
+			if (BZ2_bzDecompressInit(stream, 0, 0) == BZ_OK)
+				return stream;
+			delete stream;
+		}
+		#endif
+		break;
+	case EM_LZMA:
+		#ifdef _IRR_COMPILE_WITH_LZMA_
+		{
+			// the data starts with a version and the size of the properties
+			u8 header[4+LZMA_PROPS_SIZE];
+			CMutexLock lock(*SourceMutex);
+			Source->seek(SourceStart);
+			if (SourceSize < (long)sizeof(header) || Source->read(header, sizeof(header)) != sizeof(header))
+				break;
+
+			const u32 propSize = (header[3]<<8) + header[2];
+			if (propSize != LZMA_PROPS_SIZE)
+				break;
+			SourceStart += sizeof(header);
+			SourceSize -= sizeof(header);
+
+			// a dictionary larger than the whole file is never filled
+			u8* props = header + 4;
+			const u32 dictSize = props[1] | (props[2]<<8) | (props[3]<<16) | ((u32)props[4]<<24);
+			if (dictSize > (u32)Size)
+			{
+				const u32 size = core::max_((u32)Size, (u32)4096);
+				props[1] = (u8)size;
+				props[2] = (u8)(size >> 8);
+				props[3] = (u8)(size >> 16);
+				props[4] = (u8)(size >> 24);
+			}
+
+			CLzmaDec* stream = new CLzmaDec;
+			LzmaDec_Construct(stream);
+			if (LzmaDec_Allocate(stream, props, propSize, &lzmaAlloc) == SZ_OK)
+			{
+				LzmaDec_Init(stream);
+				return stream;
+			}
+			delete stream;
+		}
+		#endif
+		break;
+	}
+
+	return 0;
+}
+
+
+void CZipStreamReadFile::deleteStream(void* stream)
+{
+	if (!stream)
+		return;
+
+	switch (Method)
+	{
+	case EM_DEFLATE:
+		#ifdef _IRR_COMPILE_WITH_ZLIB_
+		inflateEnd((z_stream*)stream);
+		delete (z_stream*)stream;
+		#endif
+		break;
+	case EM_BZIP2:
+		#ifdef _IRR_COMPILE_WITH_BZIP2_
+		BZ2_bzDecompressEnd((bz_stream*)stream);
+		delete (bz_stream*)stream;
+		#endif
+		break;
+	case EM_LZMA:
+		#ifdef _IRR_COMPILE_WITH_LZMA_
+		LzmaDec_Free((CLzmaDec*)stream, &lzmaAlloc);
+		delete (CLzmaDec*)stream;
+		#endif
+		break;
+	}
+}
+
+
+//! goes back to the start of the entry
+bool CZipStreamReadFile::restart()
+{
+	Pos = 0;
+	SourcePos = 0;
+	InputAvail = 0;
+	Finished = true;
+
+	switch (Method)
+	{
+	case EM_DEFLATE:
+		#ifdef _IRR_COMPILE_WITH_ZLIB_
+		if (inflateReset((z_stream*)Stream) != Z_OK)
+			return false;
+		#endif
+		break;
+	case EM_BZIP2:
+		#ifdef _IRR_COMPILE_WITH_BZIP2_
+		{
+			// bzip2 has no reset
+			bz_stream* stream = (bz_stream*)Stream;
+			BZ2_bzDecompressEnd(stream);
+			memset(stream, 0, sizeof(bz_stream));
+			if (BZ2_bzDecompressInit(stream, 0, 0) != BZ_OK)
+				return false;
+		}
+		#endif
+		break;
+	case EM_LZMA:
+		#ifdef _IRR_COMPILE_WITH_LZMA_
+		LzmaDec_Init((CLzmaDec*)Stream);
+		#endif
+		break;
+	}
+
+	Finished = false;
+	return true;
+}
+
+
+//! decompresses up to size bytes at the current position
+u32 CZipStreamReadFile::decompress(u8* dest, u32 size)
+{
+	u32 done = 0;
+
+	while (done < size && !Finished)
+	{
+		if (!InputAvail)
+		{
+			const u32 toRead = (u32)core::min_(SourceSize - SourcePos, (long)ZIP_STREAM_INPUT_SIZE);
+			// the other entries of the archive read the file as well
+			CMutexLock lock(*SourceMutex);
+			Source->seek(SourceStart + SourcePos);
+			const s32 r = toRead ? Source->read(Input, toRead) : 0;
+			if (r <= 0)
+			{
+				os::Printer::log("Unexpected end of compressed data", Filename, ELL_ERROR);
+				Finished = true;
+				break;
+			}
+			SourcePos += r;
+			InputNext = Input;
+			InputAvail = r;
+		}
+
+		const u32 inputBefore = InputAvail;
+		u32 produced = 0;
+		bool end = false;
+		bool error = false;
+
+		switch (Method)
+		{
+		case EM_DEFLATE:
+			#ifdef _IRR_COMPILE_WITH_ZLIB_
+			{
+				z_stream* stream = (z_stream*)Stream;
+				stream->next_in = InputNext;
+				stream->avail_in = InputAvail;
+				stream->next_out = dest + done;
+				stream->avail_out = size - done;
+				const int err = inflate(stream, Z_NO_FLUSH);
+				produced = (size - done) - stream->avail_out;
+				InputNext = stream->next_in;
+				InputAvail = stream->avail_in;
+				end = (err == Z_STREAM_END);
+				error = (err != Z_OK && err != Z_STREAM_END && err != Z_BUF_ERROR);
+			}
+			#endif
+			break;
+		case EM_BZIP2:
+			#ifdef _IRR_COMPILE_WITH_BZIP2_
+			{
+				bz_stream* stream = (bz_stream*)Stream;
+				stream->next_in = (char*)InputNext;
+				stream->avail_in = InputAvail;
+				stream->next_out = (char*)dest + done;
+				stream->avail_out = size - done;
+				const int err = BZ2_bzDecompress(stream);
+				produced = (size - done) - stream->avail_out;
+				InputNext = (u8*)stream->next_in;
+				InputAvail = stream->avail_in;
+				end = (err == BZ_STREAM_END);
+				error = (err != BZ_OK && err != BZ_STREAM_END);
+			}
+			#endif
+			break;
+		case EM_LZMA:
+			#ifdef _IRR_COMPILE_WITH_LZMA_
+			{
+				SizeT outSize = size - done;
+				SizeT inSize = InputAvail;
+				ELzmaStatus status;
+				const SRes err = LzmaDec_DecodeToBuf((CLzmaDec*)Stream, dest + done, &outSize,
+						InputNext, &inSize, LZMA_FINISH_ANY, &status);
+				produced = (u32)outSize;
+				InputNext += inSize;
+				InputAvail -= (u32)inSize;
+				end = (status == LZMA_STATUS_FINISHED_WITH_MARK);
+				error = (err != SZ_OK);
+			}
+			#endif
+			break;
+		}
+
+		done += produced;
+
+		if (error)
+			os::Printer::log("Error decompressing", Filename, ELL_ERROR);
+
+		// also stop if the decompressor neither consumed nor produced anything
+		if (end || error || (!produced && InputAvail == inputBefore))
+			Finished = true;
+	}
+
+	Pos += done;
+	return done;
+}
+
+
+//! stores the decompressor state at the current position
+void CZipStreamReadFile::addCheckpoint()
+{
+	#ifdef _IRR_COMPILE_WITH_ZLIB_
+	if (Finished || !Pos || Checkpoints.size() >= ZIP_STREAM_CHECKPOINTS ||
+		(!Checkpoints.empty() && Checkpoints.getLast().Pos >= Pos))
+		return;
+
+	z_stream* copy = new z_stream;
+	if (inflateCopy(copy, (z_stream*)Stream) != Z_OK)
+	{
+		delete copy;
+		return;
+	}
+
+	SCheckpoint checkpoint;
+	checkpoint.Stream = copy;
+	checkpoint.Pos = Pos;
+	// the unused input is read again after restoring
+	checkpoint.SourcePos = SourcePos - InputAvail;
+	Checkpoints.push_back(checkpoint);
+	#endif
+}
+
+
+//! decompresses and discards data up to a position
+bool CZipStreamReadFile::skipTo(long pos)
+{
+	u8 buffer[4096];
+	while (Pos < pos)
+	{
+		const u32 toRead = (u32)core::min_(pos - Pos, (long)sizeof(buffer));
+		if (read(buffer, toRead) != (s32)toRead)
+			return false;
+	}
+	return true;
+}
+
+
+//! returns how much was read
+s32 CZipStreamReadFile::read(void* buffer, u32 sizeToRead)
+{
+	if (!Stream || Pos >= Size)
+		return 0;
+
+	const u32 toRead = (u32)core::min_((long)sizeToRead, Size - Pos);
+	u8* dest = (u8*)buffer;
+	u32 done = 0;
+
+	while (done < toRead && !Finished)
+	{
+		// stop at the next checkpoint position to store the state there
+		u32 chunk = toRead - done;
+		if (CheckpointInterval)
+			chunk = (u32)core::min_((long)chunk, (Pos / CheckpointInterval + 1) * CheckpointInterval - Pos);
+
+		const u32 r = decompress(dest + done, chunk);
+		done += r;
+
+		if (CheckpointInterval && (Pos % CheckpointInterval) == 0)
+			addCheckpoint();
+
+		if (r < chunk)
+			break;
+	}
+
+	return (s32)done;
+}
+
+
+//! changes position in file, returns true if successful
+bool CZipStreamReadFile::seek(long finalPos, bool relativeMovement)
+{
+	const long pos = relativeMovement ? Pos + finalPos : finalPos;
+	if (!Stream || pos < 0 || pos > Size)
+		return false;
+
+	if (pos == Pos)
+		return true;
+
+	// the last checkpoint before the target
+	s32 checkpoint = -1;
+	for (u32 i=0; i<Checkpoints.size() && Checkpoints[i].Pos <= pos; ++i)
+		checkpoint = i;
+
+	if (checkpoint != -1 && (pos < Pos || Checkpoints[checkpoint].Pos > Pos))
+	{
+		#ifdef _IRR_COMPILE_WITH_ZLIB_
+		const SCheckpoint& c = Checkpoints[checkpoint];
+		z_stream* stream = (z_stream*)Stream;
+		inflateEnd(stream);
+		if (inflateCopy(stream, (z_stream*)c.Stream) != Z_OK)
+		{
+			// the stream is unusable now
+			delete stream;
+			Stream = 0;
+			return false;
+		}
+		Pos = c.Pos;
+		SourcePos = c.SourcePos;
+		InputAvail = 0;
+		Finished = false;
+		#endif
+	}
+	else if (pos < Pos)
+	{
+		if (!restart())
+			return false;
+	}
+
+	return skipTo(pos);
+}
+
+
+//! returns size of file
+long CZipStreamReadFile::getSize() const
+{
+	return Size;
+}
+
+
+//! returns where in the file we are.
+long CZipStreamReadFile::getPos() const
+{
+	return Pos;
+}
+
+
+//! returns name of file
+const io::path& CZipStreamReadFile::getFileName() const
+{
+	return Filename;
+}
+
+
+//! opens a compressed entry as CZipStreamReadFile
+IReadFile* CZipReader::createStreamReadFile(u32 index, IReadFile* decrypted, CZipStreamReadFile::E_METHOD method)
+{
+	const SZipFileEntry &e = FileInfo[Files[index].ID];
+
+	CZipStreamReadFile* file;
+	if (decrypted)
+	{
+		file = new CZipStreamReadFile(decrypted, 0, decrypted->getSize(),
+			e.header.DataDescriptor.UncompressedSize, method, Files[index].FullName);
+		decrypted->drop();
+	}
+	else
+	{
+		file = new CZipStreamReadFile(File, e.Offset, e.header.DataDescriptor.CompressedSize,
+			e.header.DataDescriptor.UncompressedSize, method, Files[index].FullName);
+	}
+
+	if (!file->isValid())
+	{
+		os::Printer::log("Could not set up decompression", Files[index].FullName, ELL_ERROR);
+		file->drop();
+		return 0;
+	}
+
+	return file;
+}
+
 //! opens a file by index
 IReadFile* CZipReader::createAndOpenFile(u32 index)
 {
@@ -530,6 +985,7 @@ IReadFile* CZipReader::createAndOpenFile(u32 index)
 	if ((e.header.GeneralBitFlag & ZIP_FILE_ENCRYPTED) && (e.header.CompressionMethod == 99))
 	{
 		os::Printer::log("Reading encrypted file.");
+		CMutexLock lock(*FileMutex);
 		u8 salt[16]={0};
 		const u16 saltSize = (((e.header.Sig & 0x00ff0000) >>16)+1)*4;
 		File->seek(e.Offset);
@@ -617,6 +1073,11 @@ IReadFile* CZipReader::createAndOpenFile(u32 index)
   			#ifdef _IRR_COMPILE_WITH_ZLIB_
 
 			const u32 uncompressedSize = e.header.DataDescriptor.UncompressedSize;
+
+			// large files are decompressed while they are read
+			if (uncompressedSize >= ZIP_STREAM_MIN_SIZE)
+				return createStreamReadFile(index, decrypted, CZipStreamReadFile::EM_DEFLATE);
+
 			c8* pBuf = new c8[ uncompressedSize ];
 			if (!pBuf)
 			{
@@ -640,6 +1101,7 @@ IReadFile* CZipReader::createAndOpenFile(u32 index)
 				}
 
 				//memset(pcData, 0, decryptedSize);
+				CMutexLock lock(*FileMutex);
 				File->seek(e.Offset);
 				File->read(pcData, decryptedSize);
 			}
@@ -691,6 +1153,10 @@ IReadFile* CZipReader::createAndOpenFile(u32 index)
   			#ifdef _IRR_COMPILE_WITH_BZIP2_
 
 			const u32 uncompressedSize = e.header.DataDescriptor.UncompressedSize;
+
+			if (uncompressedSize >= ZIP_STREAM_MIN_SIZE)
+				return createStreamReadFile(index, decrypted, CZipStreamReadFile::EM_BZIP2);
+
 			c8* pBuf = new c8[ uncompressedSize ];
 			if (!pBuf)
 			{
@@ -714,6 +1180,7 @@ IReadFile* CZipReader::createAndOpenFile(u32 index)
 				}
 
 				//memset(pcData, 0, decryptedSize);
+				CMutexLock lock(*FileMutex);
 				File->seek(e.Offset);
 				File->read(pcData, decryptedSize);
 			}
@@ -763,6 +1230,10 @@ IReadFile* CZipReader::createAndOpenFile(u32 index)
   			#ifdef _IRR_COMPILE_WITH_LZMA_
 
 			u32 uncompressedSize = e.header.DataDescriptor.UncompressedSize;
+
+			if (uncompressedSize >= ZIP_STREAM_MIN_SIZE)
+				return createStreamReadFile(index, decrypted, CZipStreamReadFile::EM_LZMA);
+
 			c8* pBuf = new c8[ uncompressedSize ];
 			if (!pBuf)
 			{
@@ -786,6 +1257,7 @@ IReadFile* CZipReader::createAndOpenFile(u32 index)
 				}
 
 				//memset(pcData, 0, decryptedSize);
+				CMutexLock lock(*FileMutex);
 				File->seek(e.Offset);
 				File->read(pcData, decryptedSize);
 			}
@@ -14,6 +14,7 @@
 #include "irrString.h"
 #include "IFileSystem.h"
 #include "CFileList.h"
+#include "CThread.h"
 
 namespace irr
 {
@@ -24,6 +25,10 @@ namespace io
 	// the fields crc-32, compressed size and uncompressed size are set to
 	// zero in the local header
 	const s16 ZIP_INFO_IN_DATA_DESCRIPTOR =	0x0008;
+	// entries which decompress to at least this size are decompressed while reading
+	const u32 ZIP_STREAM_MIN_SIZE = 0x100000;
+	// decompressor states kept by a streamed deflate entry for backward seeks
+	const u32 ZIP_STREAM_CHECKPOINTS = 32;
 
 // byte-align structures
 #include "irrpack.h"
@@ -172,6 +177,99 @@ namespace io
 		io::IFileSystem* FileSystem;
 	};
 
+	//! Read file which decompresses an archive entry while it is read.
+	/** Only a small input buffer and the state of the decompressor are
+	kept in memory. Forward seeks decompress and discard the skipped data,
+	backward seeks start again from the beginning of the entry. Deflated
+	entries keep copies of the decompressor state at up to
+	ZIP_STREAM_CHECKPOINTS positions, so a backward seek only has to
+	decompress from the nearest one. */
+	class CZipStreamReadFile : public IReadFile
+	{
+	public:
+
+		enum E_METHOD
+		{
+			EM_DEFLATE = 0,
+			EM_BZIP2,
+			EM_LZMA
+		};
+
+		//! constructor
+		/** \param source File which contains the compressed data, grabbed.
+		\param offset Start of the compressed data in source.
+		\param compressedSize Size of the compressed data.
+		\param uncompressedSize Size of the file after decompression. */
+		CZipStreamReadFile(IReadFile* source, long offset, long compressedSize,
+			long uncompressedSize, E_METHOD method, const io::path& name);
+
+		//! destructor
+		virtual ~CZipStreamReadFile();
+
+		//! returns false if the decompressor could not be set up
+		bool isValid() const { return Stream != 0; }
+
+		//! returns how much was read
+		virtual s32 read(void* buffer, u32 sizeToRead);
+
+		//! changes position in file, returns true if successful
+		virtual bool seek(long finalPos, bool relativeMovement = false);
+
+		//! returns size of file
+		virtual long getSize() const;
+
+		//! returns where in the file we are.
+		virtual long getPos() const;
+
+		//! returns name of file
+		virtual const io::path& getFileName() const;
+
+	private:
+
+		struct SCheckpoint
+		{
+			//! copy of the z_stream
+			void* Stream;
+			long Pos;
+			long SourcePos;
+		};
+
+		//! creates the decompressor
+		void* createStream();
+		void deleteStream(void* stream);
+
+		//! goes back to the start of the entry
+		bool restart();
+
+		//! decompresses up to size bytes at the current position
+		/** \return number of bytes written to dest, 0 at the end or on errors */
+		u32 decompress(u8* dest, u32 size);
+
+		//! decompresses and discards data up to a position
+		bool skipTo(long pos);
+
+		void addCheckpoint();
+
+		io::path Filename;
+		IReadFile* Source;
+		CMutex* SourceMutex;
+		long SourceStart;
+		long SourceSize;
+		long SourcePos;
+		long Size;
+		long Pos;
+		E_METHOD Method;
+		void* Stream;
+
+		u8* Input;
+		u8* InputNext;
+		u32 InputAvail;
+		bool Finished;
+
+		core::array<SCheckpoint> Checkpoints;
+		long CheckpointInterval;
+	};
+
 /*!
 	Zip file Reader written April 2002 by N.Gebhardt.
 */
@@ -210,7 +308,12 @@ namespace io
 
 		bool scanCentralDirectoryHeader();
 
+		//! opens a compressed entry as CZipStreamReadFile
+		/** \param decrypted Decrypted data of the entry, dropped here. */
+		IReadFile* createStreamReadFile(u32 index, IReadFile* decrypted, CZipStreamReadFile::E_METHOD method);
+
 		IReadFile* File;
+		CMutex* FileMutex;
 
 		// holds extended info about files
 		core::array<SZipFileEntry> FileInfo;
@@ -36,6 +36,9 @@ namespace video
 		Driver = driver;
 		RenderTarget = 0;
 		ColorMask = COLOR_BRIGHT_WHITE;
+		TileIndex = 0;
+		TileCount = 1;
+		TileWorker = false;
 		DepthBuffer = (CDepthBuffer*) driver->getDepthBuffer ();
 		if ( DepthBuffer )
 			DepthBuffer->grab();
@@ -50,15 +53,19 @@ namespace video
 	//! destructor
 	IBurningShader::~IBurningShader()
 	{
-		if (RenderTarget)
-			RenderTarget->drop();
-
 		if (DepthBuffer)
 			DepthBuffer->drop();
 
 		if (Stencil)
 			Stencil->drop();
 
+		// a tile worker doesn't own render target and textures
+		if (TileWorker)
+			return;
+
+		if (RenderTarget)
+			RenderTarget->drop();
+
 		for ( u32 i = 0; i != BURNING_MATERIAL_MAX_TEXTURES; ++i )
 		{
 			if ( IT[i].Texture )
@@ -69,6 +76,12 @@ namespace video
 	//! sets a render target
 	void IBurningShader::setRenderTarget(video::IImage* surface, const core::rect<s32>& viewPort)
 	{
+		if (TileWorker)
+		{
+			RenderTarget = (video::CImage* ) surface;
+			return;
+		}
+
 		if (RenderTarget)
 			RenderTarget->drop();
 
@@ -89,31 +102,351 @@ namespace video
 	{
 		sInternalTexture *it = &IT[stage];
 
-		if ( it->Texture)
+		if ( it->Texture && !TileWorker )
 			it->Texture->drop();
 
 		it->Texture = texture;
 
 		if ( it->Texture)
 		{
-			it->Texture->grab();
+			if ( !TileWorker )
+				it->Texture->grab();
 
 			// select mignify and magnify ( lodLevel )
 			//SOFTWARE_DRIVER_2_MIPMAPPING_LOD_BIAS
 			it->lodLevel = lodLevel;
-			it->data = (tVideoSample*) it->Texture->lock(ETLM_READ_ONLY,
-				core::s32_clamp ( lodLevel + SOFTWARE_DRIVER_2_MIPMAPPING_LOD_BIAS, 0, SOFTWARE_DRIVER_2_MIPMAPPING_MAX - 1 ));
+			CImage* mip = it->Texture->getMipMapSurface ( lodLevel );
+			it->data = (tVideoSample*) mip->lock();
+
+			// lock() also switches the current mipmap level of the texture,
+			// tile workers share the texture and must leave it alone
+			if ( !TileWorker )
+				it->Texture->lock(ETLM_READ_ONLY,
+					core::s32_clamp ( lodLevel + SOFTWARE_DRIVER_2_MIPMAPPING_LOD_BIAS, 0, SOFTWARE_DRIVER_2_MIPMAPPING_MAX - 1 ));
 
 			// prepare for optimal fixpoint
-			it->pitchlog2 = s32_log2_s32 ( it->Texture->getPitch() );
+			it->pitchlog2 = s32_log2_s32 ( mip->getPitch() );
 
-			const core::dimension2d<u32> &dim = it->Texture->getSize();
+			const core::dimension2d<u32> &dim = mip->getDimension();
 			it->textureXMask = s32_to_fixPoint ( dim.Width - 1 ) & FIX_POINT_UNSIGNED_MASK;
 			it->textureYMask = s32_to_fixPoint ( dim.Height - 1 ) & FIX_POINT_UNSIGNED_MASK;
 		}
 	}
 
 
+	namespace
+	{
+		//! screen space plane of one value of sScanLineData
+		struct SHalfSpacePlane
+		{
+			f32 *start;
+			f32 *end;
+			f32 value;		// at the first vertex
+			f32 dx;
+			f32 dy;
+		};
+
+		//! screen space gradients of a triangle
+		struct SHalfSpaceSetup
+		{
+			f32 invArea;
+			f32 x1, y1;		// second vertex relative to the first
+			f32 x2, y2;		// third vertex relative to the first
+		};
+
+		//! edge function, positive inside of the triangle
+		struct SHalfSpaceEdge
+		{
+			s64 origin;		// at pixel 0,0
+			s64 dx;			// step to the next pixel in x
+			s64 dy;			// step to the next pixel in y
+			s64 bias;		// pixel is inside if value >= bias
+
+			s64 get ( s32 x, s32 y ) const
+			{
+				return origin + dx * x + dy * y;
+			}
+		};
+
+		// max. number of interpolated floats per scanline end
+		const u32 HALFSPACE_MAX_PLANES = 1 + 4 * MATERIAL_MAX_COLORS + 2 * BURNING_MATERIAL_MAX_TEXTURES + 3 * BURNING_MATERIAL_MAX_TANGENT;
+
+		// sub pixel precision of the edge functions
+		const s32 HALFSPACE_SUBPIXEL_LOG2 = 4;
+
+		const s32 HALFSPACE_BLOCK = 1 << SOFTWARE_DRIVER_2_HALFSPACE_BLOCK_LOG2;
+
+		//! adds the planes of count consecutive floats
+		inline void addPlanes ( SHalfSpacePlane *plane, u32 &planes, f32 *start, f32 *end,
+			const f32 *va, const f32 *vb, const f32 *vc, u32 count, const SHalfSpaceSetup &setup )
+		{
+			for ( u32 i = 0; i != count; ++i )
+			{
+				SHalfSpacePlane &p = plane[planes++];
+				const f32 ba = vb[i] - va[i];
+				const f32 ca = vc[i] - va[i];
+				p.start = start + i;
+				p.end = end + i;
+				p.value = va[i];
+				p.dx = ( ba * setup.y2 - ca * setup.y1 ) * setup.invArea;
+				p.dy = ( ca * setup.x1 - ba * setup.x2 ) * setup.invArea;
+			}
+		}
+	}
+
+
+	//! rasterizes a triangle by evaluating its edge functions over pixel blocks
+	void IBurningShader::rasterizeHalfSpace ( const s4DVertex *a, const s4DVertex *b, const s4DVertex *c,
+		sScanLineData &line, tScanLine scanline )
+	{
+		// snap to the sub pixel grid
+		const f32 scale = (f32) ( 1 << HALFSPACE_SUBPIXEL_LOG2 );
+		s32 X[3];
+		s32 Y[3];
+		X[0] = core::round32 ( a->Pos.x * scale ); Y[0] = core::round32 ( a->Pos.y * scale );
+		X[1] = core::round32 ( b->Pos.x * scale ); Y[1] = core::round32 ( b->Pos.y * scale );
+		X[2] = core::round32 ( c->Pos.x * scale ); Y[2] = core::round32 ( c->Pos.y * scale );
+
+		// edges need a consistent winding
+		const s64 area = (s64) ( X[1] - X[0] ) * ( Y[2] - Y[0] ) - (s64) ( Y[1] - Y[0] ) * ( X[2] - X[0] );
+		if ( 0 == area )
+			return;
+
+		if ( area < 0 )
+		{
+			core::swap ( X[1], X[2] );
+			core::swap ( Y[1], Y[2] );
+		}
+
+		SHalfSpaceEdge edge[3];
+		for ( u32 i = 0; i != 3; ++i )
+		{
+			const u32 j = i == 2 ? 0 : i + 1;
+			const s64 ex = X[j] - X[i];
+			const s64 ey = Y[j] - Y[i];
+
+			// E(p) = ex * ( p.y - Y[i] ) - ey * ( p.x - X[i] ), pixel centers on integer positions
+			edge[i].dx = -ey << HALFSPACE_SUBPIXEL_LOG2;
+			edge[i].dy = ex << HALFSPACE_SUBPIXEL_LOG2;
+			edge[i].origin = ey * X[i] - ex * Y[i];
+
+			// top-left fill convention, pixels on left and top edges are inside
+			const bool topLeft = ey < 0 || ( ey == 0 && ex > 0 );
+			edge[i].bias = topLeft ? 0 : 1;
+		}
+
+		// bounding box, clipped to the render target
+		const core::dimension2d<u32> &dim = RenderTarget->getDimension();
+		const s32 round = ( 1 << HALFSPACE_SUBPIXEL_LOG2 ) - 1;
+		s32 minX = ( core::s32_min ( X[0], core::s32_min ( X[1], X[2] ) ) + round ) >> HALFSPACE_SUBPIXEL_LOG2;
+		s32 minY = ( core::s32_min ( Y[0], core::s32_min ( Y[1], Y[2] ) ) + round ) >> HALFSPACE_SUBPIXEL_LOG2;
+		s32 maxX = core::s32_max ( X[0], core::s32_max ( X[1], X[2] ) ) >> HALFSPACE_SUBPIXEL_LOG2;
+		s32 maxY = core::s32_max ( Y[0], core::s32_max ( Y[1], Y[2] ) ) >> HALFSPACE_SUBPIXEL_LOG2;
+
+		minX = core::s32_max ( minX, 0 );
+		minY = core::s32_max ( minY, 0 );
+		maxX = core::s32_min ( maxX, (s32) dim.Width - 1 );
+		maxY = core::s32_min ( maxY, (s32) dim.Height - 1 );
+
+		if ( minX > maxX || minY > maxY )
+			return;
+
+		// planes of the interpolated values, relative to the first vertex
+		SHalfSpaceSetup setup;
+		setup.x1 = b->Pos.x - a->Pos.x;
+		setup.y1 = b->Pos.y - a->Pos.y;
+		setup.x2 = c->Pos.x - a->Pos.x;
+		setup.y2 = c->Pos.y - a->Pos.y;
+		setup.invArea = setup.x1 * setup.y2 - setup.x2 * setup.y1;
+		if ( 0.f == setup.invArea )
+			return;
+		setup.invArea = core::reciprocal ( setup.invArea );
+
+		SHalfSpacePlane plane[HALFSPACE_MAX_PLANES];
+		u32 planes = 0;
+		u32 size;
+
+#if defined ( SOFTWARE_DRIVER_2_USE_WBUFFER ) || defined ( SOFTWARE_DRIVER_2_PERSPECTIVE_CORRECT )
+		addPlanes ( plane, planes, &line.w[0], &line.w[1], &a->Pos.w, &b->Pos.w, &c->Pos.w, 1, setup );
+#else
+		addPlanes ( plane, planes, &line.z[0], &line.z[1], &a->Pos.z, &b->Pos.z, &c->Pos.z, 1, setup );
+#endif
+
+#ifdef SOFTWARE_DRIVER_2_USE_VERTEX_COLOR
+		size = core::min_ ( ( a->flag & VERTEX4D_FORMAT_MASK_COLOR ) >> 20, MATERIAL_MAX_COLORS );
+		for ( u32 i = 0; i != size; ++i )
+			addPlanes ( plane, planes, &line.c[i][0].x, &line.c[i][1].x, &a->Color[i].x, &b->Color[i].x, &c->Color[i].x, 4, setup );
+#endif
+
+		size = core::min_ ( ( a->flag & VERTEX4D_FORMAT_MASK_TEXTURE ) >> 16, BURNING_MATERIAL_MAX_TEXTURES );
+		for ( u32 i = 0; i != size; ++i )
+			addPlanes ( plane, planes, &line.t[i][0].x, &line.t[i][1].x, &a->Tex[i].x, &b->Tex[i].x, &c->Tex[i].x, 2, setup );
+
+		size = core::min_ ( ( a->flag & VERTEX4D_FORMAT_MASK_BUMP ) >> 24, BURNING_MATERIAL_MAX_TANGENT );
+		for ( u32 i = 0; i != size; ++i )
+			addPlanes ( plane, planes, &line.l[i][0].x, &line.l[i][1].x, &a->LightTangent[i].x, &b->LightTangent[i].x, &c->LightTangent[i].x, 3, setup );
+
+		// covered run of each row of the current block row
+		s32 runStart[HALFSPACE_BLOCK];
+		s32 runEnd[HALFSPACE_BLOCK];
+
+		const s32 blockEnd = HALFSPACE_BLOCK - 1;
+
+		for ( s32 by = minY & ~blockEnd; by <= maxY; by += HALFSPACE_BLOCK )
+		{
+			// block rows never cross a scanline tile
+			if ( !ownsScanline ( by ) )
+				continue;
+
+			const s32 y0 = core::s32_max ( by, minY );
+			const s32 y1 = core::s32_min ( by + blockEnd, maxY );
+
+			for ( s32 r = 0; r != HALFSPACE_BLOCK; ++r )
+				runStart[r] = -1;
+
+			for ( s32 bx = minX & ~blockEnd; bx <= maxX; bx += HALFSPACE_BLOCK )
+			{
+				const s32 x0 = core::s32_max ( bx, minX );
+				const s32 x1 = core::s32_min ( bx + blockEnd, maxX );
+
+				// trivial reject and accept, edge functions are linear so the
+				// extremes are at the corners
+				u32 accept = 0;
+				u32 e;
+				for ( e = 0; e != 3; ++e )
+				{
+					const SHalfSpaceEdge &E = edge[e];
+					const s64 c0 = E.get ( x0, y0 );
+					const s64 c1 = E.get ( x1, y0 );
+					const s64 c2 = E.get ( x0, y1 );
+					const s64 c3 = E.get ( x1, y1 );
+
+					const s64 hi = core::max_ ( core::max_ ( c0, c1 ), core::max_ ( c2, c3 ) );
+					if ( hi < E.bias )
+						break;
+
+					const s64 lo = core::min_ ( core::min_ ( c0, c1 ), core::min_ ( c2, c3 ) );
+					if ( lo >= E.bias )
+						accept += 1;
+				}
+
+				// block is outside of one edge
+				if ( e != 3 )
+					continue;
+
+				for ( s32 y = y0; y <= y1; ++y )
+				{
+					s32 first = x0;
+					s32 last = x1;
+
+					if ( accept != 3 )
+					{
+						// partially covered, test the pixels of the row
+						s64 w0 = edge[0].get ( x0, y );
+						s64 w1 = edge[1].get ( x0, y );
+						s64 w2 = edge[2].get ( x0, y );
+
+						first = -1;
+						for ( s32 x = x0; x <= x1; ++x )
+						{
+							if ( w0 >= edge[0].bias && w1 >= edge[1].bias && w2 >= edge[2].bias )
+							{
+								if ( first < 0 )
+									first = x;
+								last = x;
+							}
+							else if ( first >= 0 )
+							{
+								// a convex run has ended
+								break;
+							}
+
+							w0 += edge[0].dx;
+							w1 += edge[1].dx;
+							w2 += edge[2].dx;
+						}
+
+						if ( first < 0 )
+							continue;
+					}
+
+					// the rows of a triangle are convex, the runs of the blocks join up
+					s32 &start = runStart[y - by];
+					if ( start < 0 )
+						start = first;
+					runEnd[y - by] = last;
+				}
+			}
+
+			// hand the runs to the shader
+			for ( s32 y = y0; y <= y1; ++y )
+			{
+				const s32 xStart = runStart[y - by];
+				if ( xStart < 0 )
+					continue;
+
+				const s32 xEnd = runEnd[y - by] + 1;
+				const f32 fx = (f32) xStart - a->Pos.x;
+				const f32 fy = (f32) y - a->Pos.y;
+				const f32 dx = (f32) ( xEnd - xStart );
+
+				for ( u32 i = 0; i != planes; ++i )
+				{
+					const SHalfSpacePlane &p = plane[i];
+					const f32 v = p.value + p.dx * fx + p.dy * fy;
+					*p.start = v;
+					*p.end = v + p.dx * dx;
+				}
+
+				line.y = y;
+				line.x[0] = (f32) xStart;
+				line.x[1] = (f32) xEnd;
+				(this->*scanline) ();
+			}
+		}
+	}
+
+
+	//! creates the triangle renderer for a shader type
+	IBurningShader* createBurningShader(EBurningFFShader type, CBurningVideoDriver* driver)
+	{
+		switch ( type )
+		{
+			//case ETR_FLAT: return createTRFlat2(driver);
+			//case ETR_FLAT_WIRE: return createTRFlatWire2(driver);
+			case ETR_GOURAUD: return createTriangleRendererGouraud2(driver);
+			case ETR_GOURAUD_ALPHA: return createTriangleRendererGouraudAlpha2(driver);
+			case ETR_GOURAUD_ALPHA_NOZ: return createTRGouraudAlphaNoZ2(driver);
+			//case ETR_GOURAUD_WIRE: return createTriangleRendererGouraudWire2(driver);
+			//case ETR_TEXTURE_FLAT: return createTriangleRendererTextureFlat2(driver);
+			//case ETR_TEXTURE_FLAT_WIRE: return createTriangleRendererTextureFlatWire2(driver);
+			case ETR_TEXTURE_GOURAUD: return createTriangleRendererTextureGouraud2(driver);
+			case ETR_TEXTURE_GOURAUD_LIGHTMAP_M1: return createTriangleRendererTextureLightMap2_M1(driver);
+			case ETR_TEXTURE_GOURAUD_LIGHTMAP_M2: return createTriangleRendererTextureLightMap2_M2(driver);
+			case ETR_TEXTURE_GOURAUD_LIGHTMAP_M4: return createTriangleRendererGTextureLightMap2_M4(driver);
+			case ETR_TEXTURE_LIGHTMAP_M4: return createTriangleRendererTextureLightMap2_M4(driver);
+			case ETR_TEXTURE_GOURAUD_LIGHTMAP_ADD: return createTriangleRendererTextureLightMap2_Add(driver);
+			case ETR_TEXTURE_GOURAUD_DETAIL_MAP: return createTriangleRendererTextureDetailMap2(driver);
+
+			case ETR_TEXTURE_GOURAUD_WIRE: return createTriangleRendererTextureGouraudWire2(driver);
+			case ETR_TEXTURE_GOURAUD_NOZ: return createTRTextureGouraudNoZ2(driver);
+			case ETR_TEXTURE_GOURAUD_ADD: return createTRTextureGouraudAdd2(driver);
+			case ETR_TEXTURE_GOURAUD_ADD_NO_Z: return createTRTextureGouraudAddNoZ2(driver);
+			case ETR_TEXTURE_GOURAUD_VERTEX_ALPHA: return createTriangleRendererTextureVertexAlpha2(driver);
+
+			case ETR_TEXTURE_GOURAUD_ALPHA: return createTRTextureGouraudAlpha(driver);
+			case ETR_TEXTURE_GOURAUD_ALPHA_NOZ: return createTRTextureGouraudAlphaNoZ(driver);
+
+			case ETR_NORMAL_MAP_SOLID: return createTRNormalMap(driver);
+			case ETR_STENCIL_SHADOW: return createTRStencilShadow(driver);
+			case ETR_TEXTURE_BLEND: return createTRTextureBlend(driver);
+
+			case ETR_REFERENCE: return createTriangleRendererReference(driver);
+			default: return 0;
+		}
+	}
+
+
 } // end namespace video
 } // end namespace irr
 
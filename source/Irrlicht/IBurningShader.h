@@ -144,8 +144,45 @@ namespace video
 
 		virtual void setMaterial ( const SBurningShaderMaterial &material ) {};
 
+		//! rasterize only the scanline tiles index, index + count, index + 2*count, ..
+		void setTile ( u32 index, u32 count )
+		{
+			TileIndex = index;
+			TileCount = count;
+		}
+
+		//! true if the shader honors the scanline clip and may run on a tile worker
+		virtual bool canRenderTiled () const { return true; }
+
+		//! true if the shader fills the triangle and discards every fragment behind the stored depth
+		/** Lets the driver skip triangles hidden by the coarse depth tiles. */
+		virtual bool hasDepthTest () const { return false; }
+
+		//! false if the shader never writes the depth buffer
+		virtual bool hasDepthWrite () const { return true; }
+
+		//! true if every fragment passing the depth test also writes its depth
+		/** Only triangles of such shaders may raise the coarse depth of the
+		tiles they cover. An alpha test leaves the old depth behind its holes. */
+		virtual bool hasFullDepthWrite () const { return true; }
+
+		//! shader instance of a tile worker. doesn't reference count render target and textures
+		void setTileWorker ( bool worker ) { TileWorker = worker; }
+
 	protected:
 
+		//! scanline function of a shader, draws the span set up in its line data
+		typedef void (IBurningShader::*tScanLine) ();
+
+		//! rasterizes a triangle by evaluating its edge functions over pixel blocks
+		/** Blocks outside of the triangle are rejected as a whole, blocks
+		inside of it need no per pixel edge test. The covered run of each row
+		is handed to scanline, with the values in line evaluated from their
+		screen space planes. Follows the top-left fill convention of the
+		scanline rasterizers. */
+		void rasterizeHalfSpace ( const s4DVertex *a, const s4DVertex *b, const s4DVertex *c,
+			sScanLineData &line, tScanLine scanline );
+
 		CBurningVideoDriver *Driver;
 
 		video::CImage* RenderTarget;
@@ -155,6 +192,16 @@ namespace video
 
 		sInternalTexture IT[ BURNING_MATERIAL_MAX_TEXTURES ];
 
+		//! true if scanline y lies in one of the tiles of this shader instance
+		inline bool ownsScanline ( s32 y ) const
+		{
+			return ( ( (u32) y >> SOFTWARE_DRIVER_2_TILE_HEIGHT_LOG2 ) % TileCount ) == TileIndex;
+		}
+
+		u32 TileIndex;
+		u32 TileCount;
+		bool TileWorker;
+
 		static const tFixPointu dithermask[ 4 * 4];
 	};
 
@@ -192,6 +239,9 @@ namespace video
 
 	IBurningShader* createTriangleRendererReference(CBurningVideoDriver* driver);
 
+	//! creates the triangle renderer for a shader type, 0 if the type has no renderer
+	IBurningShader* createBurningShader(EBurningFFShader type, CBurningVideoDriver* driver);
+
 
 
 } // end namespace video
@@ -7,6 +7,7 @@
 
 #include "IReferenceCounted.h"
 #include "dimension2d.h"
+#include "rect.h"
 #include "S4DVertex.h"
 
 namespace irr
@@ -38,6 +39,19 @@ namespace video
 		//! returns pitch of depthbuffer (in bytes)
 		virtual u32 getPitch() const = 0;
 
+		//! marks the pixels in area as written
+		/** Their coarse depth is recomputed by the next occlusion query. */
+		virtual void markDirty(const core::rect<s32>& area) = 0;
+
+		//! returns true if every pixel in area stores a depth closer than w
+		/** Conservative, may return false for an occluded area. */
+		virtual bool isOccluded(const core::rect<s32>& area, f32 w) = 0;
+
+		//! raises the coarse depth of the tiles completely covered by a projected triangle
+		/** Only for triangles drawn with a depth test, which never moves
+		the stored depth farther away. */
+		virtual void updateTriangle(const s4DVertex* a, const s4DVertex* b, const s4DVertex* c) = 0;
+
 	};
 
 
@@ -925,7 +925,7 @@ void CIrrDeviceMacOSX::createDriver()
 
 		case video::EDT_BURNINGSVIDEO:
 		#ifdef _IRR_COMPILE_WITH_BURNINGSVIDEO_
-			VideoDriver = video::createBurningVideoDriver(CreationParams, FileSystem, this);
+			VideoDriver = video::createBurningVideoDriver(CreationParams, FileSystem, this, JobSystem);
 			SoftwareRendererType = 1;
 		#else
 			os::Printer::log("Burning's video driver was not compiled in.", ELL_ERROR);
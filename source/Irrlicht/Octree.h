@@ -127,8 +127,9 @@ public:
 	}
 
 	//! for debug purposes only, collects the bounding boxes of the tree
+	template <class TAlloc>
 	void getBoundingBoxes(const core::aabbox3d<f32>& box,
-		core::array< const core::aabbox3d<f32>* >&outBoxes) const
+		core::array< const core::aabbox3d<f32>*, TAlloc >&outBoxes) const
 	{
 		Root->getBoundingBoxes(box, outBoxes);
 	}
@@ -355,8 +356,9 @@ private:
 		}
 
 		//! for debug purposes only, collects the bounding boxes of the node
+		template <class TAlloc>
 		void getBoundingBoxes(const core::aabbox3d<f32>& box,
-			core::array< const core::aabbox3d<f32>* >&outBoxes) const
+			core::array< const core::aabbox3d<f32>*, TAlloc >&outBoxes) const
 		{
 			if (Box.intersectsWithBox(box))
 			{
@@ -93,6 +93,37 @@
 
 #define SOFTWARE_DRIVER_2_MIPMAPPING_SCALE (8/SOFTWARE_DRIVER_2_MIPMAPPING_MAX)
 
+// height of the scanline tiles the multithreaded rasterizer hands out, 2^n lines
+#define SOFTWARE_DRIVER_2_TILE_HEIGHT_LOG2	4
+
+// queued triangles after which the multithreaded rasterizer flushes
+#define SOFTWARE_DRIVER_2_TILE_TRIANGLE_BUDGET	16384
+
+// rasterize with edge functions over 2^n x 2^n pixel blocks instead of walking the triangle edges.
+// cheaper for small triangles. a block row must not cross a scanline tile
+//#define SOFTWARE_DRIVER_2_HALFSPACE
+#define SOFTWARE_DRIVER_2_HALFSPACE_BLOCK_LOG2	3
+
+#if SOFTWARE_DRIVER_2_HALFSPACE_BLOCK_LOG2 > SOFTWARE_DRIVER_2_TILE_HEIGHT_LOG2
+	#error "half-space blocks must not be higher than the scanline tiles"
+#endif
+
+// keep the farthest depth of 2^n x 2^n pixel tiles and of 2^n x 2^n tile groups next to the depth buffer.
+// triangles behind all tiles they touch are rejected before setup. needs the w-buffer
+#define SOFTWARE_DRIVER_2_HIERARCHICAL_Z
+#define SOFTWARE_DRIVER_2_HIERARCHICAL_Z_TILE_LOG2	3
+#define SOFTWARE_DRIVER_2_HIERARCHICAL_Z_GROUP_LOG2	3
+
+#ifndef SOFTWARE_DRIVER_2_USE_WBUFFER
+	#undef SOFTWARE_DRIVER_2_HIERARCHICAL_Z
+#endif
+
+// transform, light and clip test the vertex cache four vertices at a time with SSE2
+// define SOFTWARE_DRIVER_2_NO_SSE2 to use the scalar code path only
+#if !defined ( SOFTWARE_DRIVER_2_NO_SSE2 ) && ( defined ( __SSE2__ ) || defined ( _M_X64 ) || ( defined ( _M_IX86_FP ) && _M_IX86_FP >= 2 ) )
+	#define SOFTWARE_DRIVER_2_SSE2
+#endif
+
 #ifndef REALINLINE
 	#ifdef _MSC_VER
 		#define REALINLINE __forceinline
@@ -3,6 +3,7 @@
 // For conditions of distribution and use, see copyright notice in irrlicht.h
 
 #include "os.h"
+#include "CLogger.h"
 #include "irrString.h"
 #include "IrrCompileConfig.h"
 #include "irrMath.h"
@@ -194,6 +195,13 @@ namespace os
 			Logger->log(message, hint.c_str(), ll);
 	}
 
+	void Printer::processQueuedLogs()
+	{
+		// the devices only set their CLogger
+		if (Logger)
+			((CLogger*)Logger)->processQueuedLogs();
+	}
+
 	// our Randomizer is not really os specific, so we
 	// code one for all, which should work on every platform the same,
 	// which is desireable.
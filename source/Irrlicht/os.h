@@ -39,6 +39,8 @@ namespace os
 		static void log(const wchar_t* message, ELOG_LEVEL ll = ELL_INFORMATION);
 		static void log(const c8* message, const c8* hint, ELOG_LEVEL ll = ELL_INFORMATION);
 		static void log(const c8* message, const io::path& hint, ELOG_LEVEL ll = ELL_INFORMATION);
+		// logs the messages of other threads, call it from the thread owning the device
+		static void processQueuedLogs();
 		static ILogger* Logger;
 	};
 